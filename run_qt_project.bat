@@ -8,7 +8,10 @@ echo Using CMake to generate build files...
 if not exist build mkdir build
 cd build
 
-cmake .. -G "MinGW Makefiles"
+REM Qt安装目录，可在运行前用环境变量QT_DIR覆盖
+if "%QT_DIR%"=="" set QT_DIR=d:/Software/QT/6.7.2/mingw_64
+
+cmake .. -G "MinGW Makefiles" -DCMAKE_PREFIX_PATH=%QT_DIR%
 
 echo Building project...
 mingw32-make
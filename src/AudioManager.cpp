@@ -200,6 +200,7 @@ void AudioSpectrumAnalyzer::processAudioData()
     }
     
     buffer.resize(bytesRead);
+    emit audioCaptured(buffer, m_audioSource->format().sampleRate(), m_audioSource->format().channelCount());
     processBuffer(buffer);
 }
 
@@ -45,6 +45,9 @@ signals:
     
     // 音频可用性变化信号
     void audioAvailable(bool available);
+    
+    // 采集到的原始PCM数据（16位有符号），供录制和预录缓存使用
+    void audioCaptured(const QByteArray &pcm, int sampleRate, int channelCount);
 
 private slots:
     void processAudioData();
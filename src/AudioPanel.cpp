@@ -263,6 +263,8 @@ AudioPanel::AudioPanel(QWidget *parent)
             m_volumeSlider, SLOT(setMuted(bool)));
     connect(m_audioAnalyzer, SIGNAL(audioAvailable(bool)),
             this, SLOT(updateUI()));
+    connect(m_audioAnalyzer, SIGNAL(audioCaptured(const QByteArray&, int, int)),
+            this, SIGNAL(audioCaptured(const QByteArray&, int, int)));
     
     connect(m_volumeSlider, SIGNAL(volumeChanged(float)),
             this, SLOT(onVolumeChanged(float)));
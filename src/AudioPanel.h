@@ -66,6 +66,10 @@ public:
     void stopAudio();
     bool hasAudioSupport() const;
 
+signals:
+    // 转发采集到的原始PCM数据
+    void audioCaptured(const QByteArray &pcm, int sampleRate, int channelCount);
+
 private slots:
     void updateSpectrum(const QList<float> &data);
     void onVolumeChanged(float volume);
@@ -0,0 +1,447 @@
+#include "AviMjpegSink.h"
+#include "FrameConvert.h"
+#include "dbgout.h"
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+    const quint32 AVIF_HASINDEX = 0x10;
+    const quint32 AVIIF_KEYFRAME = 0x10;
+
+    void putFourcc(QByteArray &out, const char *fourcc)
+    {
+        out.append(fourcc, 4);
+    }
+
+    void putU32(QByteArray &out, quint32 value)
+    {
+        char bytes[4];
+        qToLittleEndian(value, bytes);
+        out.append(bytes, 4);
+    }
+
+    void putU16(QByteArray &out, quint16 value)
+    {
+        char bytes[2];
+        qToLittleEndian(value, bytes);
+        out.append(bytes, 2);
+    }
+}
+
+AviMjpegSink::AviMjpegSink(const QString &filePath, double nominalFps)
+    : m_filePath(filePath),
+      m_nominalFps(nominalFps > 0 ? nominalFps : 30.0),
+      m_buffer(nullptr),
+      m_bufferUsed(0),
+      m_fileSize(0),
+      m_diskBytes(0),
+      m_frameCount(0),
+      m_maxFrameBytes(0),
+      m_firstPtsUs(-1),
+      m_lastPtsUs(-1),
+      m_warnedTranscode(false),
+      m_hasAudio(false),
+      m_audioSampleRate(0),
+      m_audioChannels(0),
+      m_audioBytes(0),
+      m_maxAudioChunk(0)
+{
+}
+
+AviMjpegSink::~AviMjpegSink()
+{
+    close();
+}
+
+bool AviMjpegSink::open()
+{
+    m_file.setFileName(m_filePath);
+    // 自己做大块缓冲，关闭QFile内部缓冲避免二次拷贝
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    m_indexFile.setFileName(m_filePath + ".idx.tmp");
+    if (!m_indexFile.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        m_error = m_indexFile.errorString();
+        m_file.close();
+        return false;
+    }
+
+    if (!m_ptsIndex.open(m_filePath)) {
+        m_error = m_ptsIndex.errorString();
+        m_indexFile.close();
+        m_file.close();
+        return false;
+    }
+
+    m_buffer = static_cast<char*>(qMallocAligned(WRITE_BLOCK_SIZE, 4096));
+    m_bufferUsed = 0;
+    m_fileSize = 0;
+    m_diskBytes = 0;
+    m_frameCount = 0;
+    m_maxFrameBytes = 0;
+    m_firstPtsUs = -1;
+    m_lastPtsUs = -1;
+    m_hasAudio = false;
+    m_audioBytes = 0;
+    m_maxAudioChunk = 0;
+    m_indexBuffer.clear();
+    m_indexBuffer.reserve(64 * 1024);
+
+    // 先占位写入文件头，关闭时回填
+    const QByteArray placeholder(HEADER_SIZE, '\0');
+    return append(placeholder.constData(), placeholder.size());
+}
+
+bool AviMjpegSink::writeFrame(const FramePacket &packet)
+{
+    if (!m_buffer) {
+        m_error = "文件未打开";
+        return false;
+    }
+
+    if (packet.isAudio()) {
+        // 音频格式在文件头中只能有一种，以第一个音频包为准
+        if (!m_hasAudio) {
+            m_hasAudio = true;
+            m_audioSampleRate = packet.sampleRate;
+            m_audioChannels = qMax(1, packet.channelCount);
+        } else if (packet.sampleRate != m_audioSampleRate || qMax(1, packet.channelCount) != m_audioChannels) {
+            return true;
+        }
+        if (!writeChunk("01wb", packet, packet.data)) {
+            return false;
+        }
+        m_audioBytes += packet.data.size();
+        m_maxAudioChunk = qMax(m_maxAudioChunk, quint32(packet.data.size()));
+        return true;
+    }
+
+    QByteArray jpeg = packet.data;
+    if (packet.format != FramePixelFormat::MJPEG) {
+        // 摄像头后端未提供JPEG原始数据时退回到编码，功能可用但失去直通的意义
+        if (!m_warnedTranscode) {
+            logToConsole("警告：收到非MJPEG帧（" + pixelFormatName(packet.format) + "），MJPEG录制将重新编码");
+            m_warnedTranscode = true;
+        }
+        jpeg = packetToJpeg(packet);
+        if (jpeg.isEmpty()) {
+            m_error = "帧编码为JPEG失败";
+            return false;
+        }
+    }
+
+    if (m_frameCount == 0) {
+        m_frameSize = packet.size;
+        m_firstPtsUs = packet.ptsUs;
+    }
+    if (!writeChunk("00dc", packet, jpeg)) {
+        return false;
+    }
+    m_lastPtsUs = packet.ptsUs;
+    m_frameCount++;
+    m_maxFrameBytes = qMax(m_maxFrameBytes, quint32(jpeg.size()));
+    return true;
+}
+
+bool AviMjpegSink::writeChunk(const char *fourcc, const FramePacket &packet, const QByteArray &payload)
+{
+    const quint32 size = quint32(payload.size());
+    const qint64 chunkSize = 8 + size + (size & 1);
+    const qint64 indexBytes = qint64(m_indexFile.size() + m_indexBuffer.size()) + 16 + 8;
+    if (m_fileSize + chunkSize + indexBytes > MAX_FILE_SIZE) {
+        m_error = "AVI文件超过2GB上限";
+        return false;
+    }
+
+    const qint64 chunkOffset = m_fileSize;
+    QByteArray chunkHeader;
+    putFourcc(chunkHeader, fourcc);
+    putU32(chunkHeader, size);
+    if (!append(chunkHeader.constData(), chunkHeader.size()) ||
+        !append(payload.constData(), size)) {
+        return false;
+    }
+    if (size & 1) {
+        const char pad = 0;
+        if (!append(&pad, 1)) {
+            return false;
+        }
+    }
+
+    // idx1偏移相对于'movi'四字符码所在位置
+    putFourcc(m_indexBuffer, fourcc);
+    putU32(m_indexBuffer, AVIIF_KEYFRAME);
+    putU32(m_indexBuffer, quint32(chunkOffset - (HEADER_SIZE - 4)));
+    putU32(m_indexBuffer, size);
+    if (m_indexBuffer.size() >= 64 * 1024 && !flushIndex()) {
+        return false;
+    }
+
+    // .pts索引只记录视频帧
+    if (!packet.isAudio() && !m_ptsIndex.append(packet, chunkOffset + 8, size)) {
+        m_error = m_ptsIndex.errorString();
+        return false;
+    }
+    return true;
+}
+
+void AviMjpegSink::close()
+{
+    if (!m_buffer) {
+        return;
+    }
+
+    if (!finalize()) {
+        logToConsole("AVI文件收尾失败: " + m_error);
+    }
+
+    qFreeAligned(m_buffer);
+    m_buffer = nullptr;
+    m_file.close();
+    m_indexFile.close();
+    m_indexFile.remove();
+    m_ptsIndex.close();
+}
+
+QString AviMjpegSink::errorString() const
+{
+    return m_error;
+}
+
+qint64 AviMjpegSink::bytesWritten() const
+{
+    return m_diskBytes;
+}
+
+QStringList AviMjpegSink::outputFiles() const
+{
+    return QStringList() << m_filePath << PtsIndexWriter::indexPathFor(m_filePath);
+}
+
+quint32 AviMjpegSink::frameCount() const
+{
+    return m_frameCount;
+}
+
+bool AviMjpegSink::append(const char *data, qint64 size)
+{
+    while (size > 0) {
+        const qint64 chunk = qMin(size, WRITE_BLOCK_SIZE - m_bufferUsed);
+        memcpy(m_buffer + m_bufferUsed, data, size_t(chunk));
+        m_bufferUsed += chunk;
+        m_fileSize += chunk;
+        data += chunk;
+        size -= chunk;
+        if (m_bufferUsed == WRITE_BLOCK_SIZE && !flushBuffer()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AviMjpegSink::flushBuffer()
+{
+    if (m_bufferUsed == 0) {
+        return true;
+    }
+    const qint64 written = m_file.write(m_buffer, m_bufferUsed);
+    if (written != m_bufferUsed) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_diskBytes += written;
+    m_bufferUsed = 0;
+    return true;
+}
+
+bool AviMjpegSink::flushIndex()
+{
+    if (m_indexBuffer.isEmpty()) {
+        return true;
+    }
+    if (m_indexFile.write(m_indexBuffer) != m_indexBuffer.size()) {
+        m_error = m_indexFile.errorString();
+        return false;
+    }
+    m_indexBuffer.resize(0);
+    return true;
+}
+
+bool AviMjpegSink::finalize()
+{
+    const qint64 moviEnd = m_fileSize;
+
+    // 追加idx1索引块
+    if (!flushIndex()) {
+        return false;
+    }
+    QByteArray idxHeader;
+    putFourcc(idxHeader, "idx1");
+    putU32(idxHeader, quint32(m_indexFile.size()));
+    if (!append(idxHeader.constData(), idxHeader.size())) {
+        return false;
+    }
+    m_indexFile.seek(0);
+    QByteArray chunk;
+    while (!(chunk = m_indexFile.read(WRITE_BLOCK_SIZE)).isEmpty()) {
+        if (!append(chunk.constData(), chunk.size())) {
+            return false;
+        }
+    }
+    if (!flushBuffer()) {
+        return false;
+    }
+
+    // 回填文件头
+    const QByteArray header = buildHeader();
+    QByteArray moviHeader;
+    putFourcc(moviHeader, "LIST");
+    putU32(moviHeader, quint32(moviEnd - (HEADER_SIZE - 4)));
+    putFourcc(moviHeader, "movi");
+
+    if (!m_file.seek(0) || m_file.write(header) != header.size()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (!m_file.seek(HEADER_SIZE - 12) || m_file.write(moviHeader) != moviHeader.size()) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_diskBytes += header.size() + moviHeader.size();
+
+    logToConsole(QString("MJPEG录制完成：%1 帧，%2 字节").arg(m_frameCount).arg(m_fileSize));
+    return true;
+}
+
+QByteArray AviMjpegSink::buildHeader() const
+{
+    // 由实际PTS计算平均帧间隔，PTS不可用时使用名义帧率
+    quint32 usPerFrame = quint32(qRound(1000000.0 / m_nominalFps));
+    if (m_frameCount > 1 && m_lastPtsUs > m_firstPtsUs) {
+        usPerFrame = quint32((m_lastPtsUs - m_firstPtsUs) / (m_frameCount - 1));
+    }
+    const quint32 width = quint32(m_frameSize.width());
+    const quint32 height = quint32(m_frameSize.height());
+    const quint32 maxBytesPerSec = usPerFrame > 0 ? quint32(quint64(m_maxFrameBytes) * 1000000 / usPerFrame) : 0;
+
+    // strl: strh(56) + strf(BITMAPINFOHEADER, 40)
+    QByteArray strl;
+    putFourcc(strl, "LIST");
+    putU32(strl, 4 + 8 + 56 + 8 + 40);
+    putFourcc(strl, "strl");
+    putFourcc(strl, "strh");
+    putU32(strl, 56);
+    putFourcc(strl, "vids");
+    putFourcc(strl, "MJPG");
+    putU32(strl, 0);                  // dwFlags
+    putU16(strl, 0);                  // wPriority
+    putU16(strl, 0);                  // wLanguage
+    putU32(strl, 0);                  // dwInitialFrames
+    putU32(strl, usPerFrame);         // dwScale
+    putU32(strl, 1000000);            // dwRate
+    putU32(strl, 0);                  // dwStart
+    putU32(strl, m_frameCount);       // dwLength
+    putU32(strl, m_maxFrameBytes);    // dwSuggestedBufferSize
+    putU32(strl, 0xFFFFFFFF);         // dwQuality
+    putU32(strl, 0);                  // dwSampleSize
+    putU16(strl, 0);
+    putU16(strl, 0);
+    putU16(strl, quint16(width));
+    putU16(strl, quint16(height));
+    putFourcc(strl, "strf");
+    putU32(strl, 40);
+    putU32(strl, 40);                 // biSize
+    putU32(strl, width);
+    putU32(strl, height);
+    putU16(strl, 1);                  // biPlanes
+    putU16(strl, 24);                 // biBitCount
+    putFourcc(strl, "MJPG");          // biCompression
+    putU32(strl, width * height * 3); // biSizeImage
+    putU32(strl, 0);
+    putU32(strl, 0);
+    putU32(strl, 0);
+    putU32(strl, 0);
+
+    QByteArray hdrl;
+    putFourcc(hdrl, "LIST");
+    putU32(hdrl, 0);
+    putFourcc(hdrl, "hdrl");
+    putFourcc(hdrl, "avih");
+    putU32(hdrl, 56);
+    putU32(hdrl, usPerFrame);
+    putU32(hdrl, maxBytesPerSec);
+    putU32(hdrl, 0);                  // dwPaddingGranularity
+    putU32(hdrl, AVIF_HASINDEX);
+    putU32(hdrl, m_frameCount);       // dwTotalFrames
+    putU32(hdrl, 0);                  // dwInitialFrames
+    putU32(hdrl, m_hasAudio ? 2 : 1); // dwStreams
+    putU32(hdrl, m_maxFrameBytes);
+    putU32(hdrl, width);
+    putU32(hdrl, height);
+    for (int i = 0; i < 4; ++i) {
+        putU32(hdrl, 0);
+    }
+    hdrl.append(strl);
+    if (m_hasAudio) {
+        hdrl.append(buildAudioStreamHeader());
+    }
+    // 回填LIST hdrl的大小（加入音频流之后）
+    const quint32 hdrlSize = quint32(hdrl.size() - 8);
+    qToLittleEndian(hdrlSize, hdrl.data() + 4);
+
+    QByteArray header;
+    putFourcc(header, "RIFF");
+    putU32(header, quint32(m_fileSize - 8));
+    putFourcc(header, "AVI ");
+    header.append(hdrl);
+
+    // 用JUNK块填充到'LIST movi'之前
+    const qint64 junkSize = HEADER_SIZE - 12 - header.size() - 8;
+    putFourcc(header, "JUNK");
+    putU32(header, quint32(junkSize));
+    header.append(QByteArray(junkSize, '\0'));
+    return header;
+}
+
+QByteArray AviMjpegSink::buildAudioStreamHeader() const
+{
+    // strl: strh(56) + strf(WAVEFORMATEX, 18)
+    const quint16 blockAlign = quint16(m_audioChannels * 2);
+    const quint32 bytesPerSec = quint32(m_audioSampleRate) * blockAlign;
+
+    QByteArray strl;
+    putFourcc(strl, "LIST");
+    putU32(strl, 4 + 8 + 56 + 8 + 18);
+    putFourcc(strl, "strl");
+    putFourcc(strl, "strh");
+    putU32(strl, 56);
+    putFourcc(strl, "auds");
+    putU32(strl, 0);                                   // fccHandler
+    putU32(strl, 0);                                   // dwFlags
+    putU16(strl, 0);                                   // wPriority
+    putU16(strl, 0);                                   // wLanguage
+    putU32(strl, 0);                                   // dwInitialFrames
+    putU32(strl, blockAlign);                          // dwScale
+    putU32(strl, bytesPerSec);                         // dwRate
+    putU32(strl, 0);                                   // dwStart
+    putU32(strl, quint32(m_audioBytes / blockAlign));  // dwLength（采样数）
+    putU32(strl, m_maxAudioChunk);                     // dwSuggestedBufferSize
+    putU32(strl, 0xFFFFFFFF);                          // dwQuality
+    putU32(strl, blockAlign);                          // dwSampleSize
+    for (int i = 0; i < 4; ++i) {
+        putU16(strl, 0);                               // rcFrame
+    }
+    putFourcc(strl, "strf");
+    putU32(strl, 18);
+    putU16(strl, 1);                                   // WAVE_FORMAT_PCM
+    putU16(strl, quint16(m_audioChannels));
+    putU32(strl, quint32(m_audioSampleRate));
+    putU32(strl, bytesPerSec);
+    putU16(strl, blockAlign);
+    putU16(strl, 16);                                  // wBitsPerSample
+    putU16(strl, 0);                                   // cbSize
+    return strl;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include <QSize>
+#include <QByteArray>
+#include "FrameSink.h"
+#include "PtsIndexWriter.h"
+
+// MJPEG直通录制输出（AVI容器）
+// MJPEG帧的JPEG数据原样写入'00dc'块，不解码也不重新编码；PCM音频写入'01wb'块。
+// 数据先进入按4KB对齐的1MB写缓冲，整块写盘；idx1索引边写边追加到临时文件，
+// 关闭时拼接到文件末尾并回填文件头，因此内存占用与录制时长无关。
+class AviMjpegSink : public FrameSink {
+public:
+    AviMjpegSink(const QString &filePath, double nominalFps);
+    ~AviMjpegSink() override;
+
+    bool open() override;
+    bool writeFrame(const FramePacket &packet) override;
+    void close() override;
+
+    QString errorString() const override;
+    qint64 bytesWritten() const override;
+    QStringList outputFiles() const override;
+
+    quint32 frameCount() const;
+
+    // 文件头区域大小，movi数据从该偏移开始，保证帧数据起始于对齐位置
+    static constexpr qint64 HEADER_SIZE = 4096;
+    // 写缓冲大小
+    static constexpr qint64 WRITE_BLOCK_SIZE = 1 << 20;
+    // AVI 1.0使用32位偏移，留出索引空间后的文件大小上限
+    static constexpr qint64 MAX_FILE_SIZE = 0x7F000000;
+    // 录制时自动分段的大小：写满后在下一帧切换到新文件，为写缓冲、最后一帧和idx1索引留出余量
+    static constexpr qint64 AUTO_SEGMENT_SIZE = 0x70000000;
+
+private:
+    bool append(const char *data, qint64 size);
+    bool flushBuffer();
+    bool flushIndex();
+    bool finalize();
+    bool writeChunk(const char *fourcc, const FramePacket &packet, const QByteArray &payload);
+    QByteArray buildHeader() const;
+    QByteArray buildAudioStreamHeader() const;
+
+    QString m_filePath;
+    double m_nominalFps;
+    QFile m_file;
+    QFile m_indexFile;
+    PtsIndexWriter m_ptsIndex;
+    QString m_error;
+
+    char *m_buffer;
+    qint64 m_bufferUsed;
+    qint64 m_fileSize;        // 已追加的逻辑字节数（含缓冲中未落盘的部分）
+    qint64 m_diskBytes;       // 实际写入磁盘的字节数
+
+    QByteArray m_indexBuffer;
+    quint32 m_frameCount;
+    quint32 m_maxFrameBytes;
+    QSize m_frameSize;
+    qint64 m_firstPtsUs;
+    qint64 m_lastPtsUs;
+    bool m_warnedTranscode;
+
+    // 音频流（第一个音频包到达时确定格式）
+    bool m_hasAudio;
+    int m_audioSampleRate;
+    int m_audioChannels;
+    qint64 m_audioBytes;
+    quint32 m_maxAudioChunk;
+};
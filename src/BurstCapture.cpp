@@ -0,0 +1,320 @@
+#include "BurstCapture.h"
+#include "FrameConvert.h"
+#include "dbgout.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMutexLocker>
+#include <cstring>
+
+namespace {
+    // 原始帧按紧凑行写入（去掉行尾填充），便于用 ffplay -f rawvideo 等工具直接打开
+    bool writeRawFrame(const QString &path, const FramePacket &packet)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        if (packet.format == FramePixelFormat::MJPEG || packet.bytesPerLine <= 0) {
+            return file.write(packet.data) == packet.data.size();
+        }
+        const int bytesPerPixel = packet.format == FramePixelFormat::YUYV ? 2 : 4;
+        const qint64 rowBytes = qint64(packet.size.width()) * bytesPerPixel;
+        if (rowBytes == packet.bytesPerLine) {
+            return file.write(packet.data) == packet.data.size();
+        }
+        for (int y = 0; y < packet.size.height(); ++y) {
+            if (file.write(packet.data.constData() + qsizetype(y) * packet.bytesPerLine, rowBytes) != rowBytes) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+BurstCapture::BurstCapture(QObject *parent)
+    : QObject(parent),
+      m_pool(TaskPool::shared()),
+      m_group(new TaskGroup(m_pool)),
+      m_slotBytes(0),
+      m_capturing(false),
+      m_total(0),
+      m_captured(0),
+      m_saved(0),
+      m_failed(0),
+      m_dropped(0),
+      m_pendingEncodes(0),
+      m_progressPending(false),
+      m_encoding(Png),
+      m_jpegQuality(95),
+      m_beginUs(0)
+{
+}
+
+BurstCapture::~BurstCapture()
+{
+    cancel();
+    m_group->wait();
+}
+
+void BurstCapture::setTaskPool(TaskPool *pool)
+{
+    cancel();
+    m_group->wait();
+    m_pool = pool ? pool : TaskPool::shared();
+    m_group.reset(new TaskGroup(m_pool));
+}
+
+void BurstCapture::reserve(int slotCount, qint64 slotBytes)
+{
+    if (slotCount == m_slots.size() && slotBytes == m_slotBytes) {
+        return;
+    }
+    cancel();
+    m_group->wait();
+
+    if (slotCount <= 0 || slotBytes <= 0) {
+        m_arena = QByteArray();
+        m_slots = QVector<Slot>();
+        m_slotBytes = 0;
+        return;
+    }
+    // 分配时写一遍，让内存页在连拍之前就提交，连拍时拷贝不再触发缺页
+    m_arena = QByteArray(qsizetype(slotCount) * slotBytes, '\0');
+    m_slots = QVector<Slot>(slotCount);
+    m_slotBytes = slotBytes;
+}
+
+void BurstCapture::release()
+{
+    reserve(0, 0);
+}
+
+int BurstCapture::slotCount() const
+{
+    return m_slots.size();
+}
+
+qint64 BurstCapture::slotBytes() const
+{
+    return m_slotBytes;
+}
+
+qint64 BurstCapture::capacityBytes() const
+{
+    return m_arena.size();
+}
+
+bool BurstCapture::start(int frameCount, const QString &directory, Encoding encoding, int jpegQuality)
+{
+    if (m_slots.isEmpty()) {
+        m_errorString = "连拍缓存未分配";
+        return false;
+    }
+    if (frameCount <= 0) {
+        m_errorString = "连拍帧数无效";
+        return false;
+    }
+    if (isActive()) {
+        m_errorString = "上一次连拍尚未保存完成";
+        return false;
+    }
+    if (!QDir().mkpath(directory)) {
+        m_errorString = "无法创建目录: " + directory;
+        return false;
+    }
+
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_directory = directory;
+    m_filePrefix = "burst_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    m_encoding = encoding;
+    m_jpegQuality = jpegQuality;
+    m_total = frameCount;
+    m_captured = 0;
+    m_saved = 0;
+    m_failed = 0;
+    m_dropped = 0;
+    m_pendingEncodes = 0;
+    m_files.clear();
+    m_errorString.clear();
+    m_beginUs = monotonicUs();
+    m_capturing = true;
+    return true;
+}
+
+void BurstCapture::cancel()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (!m_capturing) {
+        return;
+    }
+    m_capturing = false;
+    m_total = m_captured;
+    finishIfDoneLocked();
+}
+
+bool BurstCapture::isActive() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_capturing || m_pendingEncodes > 0;
+}
+
+QString BurstCapture::errorString() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_errorString;
+}
+
+void BurstCapture::capture(const FramePacket &packet)
+{
+    if (packet.isAudio() || !packet.isValid()) {
+        return;
+    }
+
+    int slotIndex = 0;
+    int frameIndex = 0;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (!m_capturing) {
+            return;
+        }
+        frameIndex = m_captured++;
+        if (m_captured >= m_total) {
+            m_capturing = false;
+        }
+        // 按帧序号轮流使用各槽，槽还在编码（编码跟不上采集）或单帧超过槽大小时丢弃该帧
+        slotIndex = frameIndex % m_slots.size();
+        Slot &slot = m_slots[slotIndex];
+        if (slot.busy || packet.data.size() > m_slotBytes) {
+            m_dropped++;
+            postProgressLocked();
+            finishIfDoneLocked();
+            return;
+        }
+        slot.busy = true;
+        m_pendingEncodes++;
+    }
+
+    // 槽已标记为占用，拷贝时不需要持锁
+    Slot &slot = m_slots[slotIndex];
+    memcpy(m_arena.data() + qsizetype(slotIndex) * m_slotBytes, packet.data.constData(), size_t(packet.data.size()));
+    slot.meta = packet;
+    slot.meta.data = QByteArray();
+    slot.meta.owner.reset();
+    slot.size = packet.data.size();
+
+    m_pool->submit("burst_encode", [this, slotIndex, frameIndex]() { encodeSlot(slotIndex, frameIndex); },
+                   m_group.get());
+}
+
+void BurstCapture::encodeSlot(int slotIndex, int frameIndex)
+{
+    const Slot &slot = m_slots[slotIndex];
+    FramePacket packet = slot.meta;
+    // 直接引用环形缓存中的数据，槽在编码完成前不会被覆盖
+    packet.data = QByteArray::fromRawData(m_arena.constData() + qsizetype(slotIndex) * m_slotBytes, slot.size);
+
+    QString fileName = QString("%1_%2").arg(m_filePrefix).arg(frameIndex, 3, 10, QChar('0'));
+    if (m_encoding == Raw && packet.format != FramePixelFormat::MJPEG) {
+        fileName += QString("_%1x%2").arg(packet.size.width()).arg(packet.size.height());
+    }
+    const QString path = QDir(m_directory).filePath(fileName + "." + fileSuffix(packet.format, m_encoding));
+
+    bool ok = false;
+    if (packet.format == FramePixelFormat::MJPEG || m_encoding == Raw) {
+        ok = writeRawFrame(path, packet);
+    } else {
+        const QImage image = packetToImage(packet);
+        if (!image.isNull()) {
+            ok = m_encoding == Png ? image.save(path, "PNG") : image.save(path, "JPG", m_jpegQuality);
+        }
+    }
+    if (!ok) {
+        logToConsole("连拍保存失败: " + path);
+    }
+
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_slots[slotIndex].busy = false;
+    m_pendingEncodes--;
+    if (ok) {
+        m_saved++;
+        m_files << path;
+    } else {
+        m_failed++;
+    }
+    postProgressLocked();
+    finishIfDoneLocked();
+}
+
+void BurstCapture::postProgressLocked()
+{
+    // 上一次通知还没被处理时不重复投递
+    if (m_progressPending) {
+        return;
+    }
+    m_progressPending = true;
+    QMetaObject::invokeMethod(this, [this]() {
+        int captured = 0;
+        int saved = 0;
+        int total = 0;
+        {
+            QMutexLocker<QMutex> locker(&m_mutex);
+            m_progressPending = false;
+            captured = m_captured;
+            saved = m_saved;
+            total = m_total;
+        }
+        emit progress(captured, saved, total);
+    }, Qt::QueuedConnection);
+}
+
+void BurstCapture::finishIfDoneLocked()
+{
+    if (m_capturing || m_pendingEncodes > 0 || m_saved + m_failed + m_dropped < m_total) {
+        return;
+    }
+    QStringList files = m_files;
+    files.sort();
+    const int dropped = m_dropped;
+    const int failed = m_failed;
+    const qint64 elapsedMs = (monotonicUs() - m_beginUs) / 1000;
+    logToConsole(QString("连拍完成: 保存 %1 帧，丢弃 %2，失败 %3，用时 %4 ms")
+                     .arg(files.size()).arg(dropped).arg(failed).arg(elapsedMs));
+    QMetaObject::invokeMethod(this, [this, files, dropped, failed, elapsedMs]() {
+        emit finished(files, dropped, failed, elapsedMs);
+    }, Qt::QueuedConnection);
+}
+
+QString BurstCapture::encodingName(Encoding encoding)
+{
+    switch (encoding) {
+        case Jpeg: return "jpeg";
+        case Raw:  return "raw";
+        default:   return "png";
+    }
+}
+
+BurstCapture::Encoding BurstCapture::encodingFromName(const QString &name)
+{
+    const QString lower = name.toLower();
+    if (lower == "jpeg" || lower == "jpg") {
+        return Jpeg;
+    }
+    if (lower == "raw" || lower == "yuv") {
+        return Raw;
+    }
+    return Png;
+}
+
+QString BurstCapture::fileSuffix(FramePixelFormat format, Encoding encoding)
+{
+    if (format == FramePixelFormat::MJPEG) {
+        return "jpg";
+    }
+    switch (encoding) {
+        case Jpeg: return "jpg";
+        case Raw:  return format == FramePixelFormat::YUYV ? "yuyv" : "bgra";
+        default:   return "png";
+    }
+}
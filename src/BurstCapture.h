@@ -0,0 +1,93 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QMutex>
+#include <QVector>
+#include <QStringList>
+#include <memory>
+#include "FramePacket.h"
+#include "TaskPool.h"
+
+// 高速连拍
+// 按摄像头原始分辨率和帧率抓取连续N帧，帧数据拷贝到预先分配好的环形缓存中（采集线程只做memcpy），
+// 每帧拷贝完成后立即交给线程池编码保存，编码完成的槽可以被后面的帧复用。
+// MJPEG帧直接保存原始JPEG数据，不重新编码；YUYV帧可保存为PNG、JPEG或原始YUYV。
+class BurstCapture : public QObject {
+    Q_OBJECT
+public:
+    enum Encoding {
+        Png,
+        Jpeg,
+        Raw
+    };
+
+    explicit BurstCapture(QObject *parent = nullptr);
+    ~BurstCapture();
+
+    // pool为空时使用TaskPool::shared()
+    void setTaskPool(TaskPool *pool);
+
+    // 预分配slotCount个槽，每槽slotBytes字节；连拍进行中时等待编码完成后再重新分配
+    void reserve(int slotCount, qint64 slotBytes);
+    void release();
+    int slotCount() const;
+    qint64 slotBytes() const;
+    qint64 capacityBytes() const;
+
+    // 开始连拍frameCount帧，文件保存到directory；缓存未分配或上一次连拍未完成时返回false
+    bool start(int frameCount, const QString &directory, Encoding encoding, int jpegQuality = 95);
+    // 中止采集，已采集的帧继续编码保存
+    void cancel();
+    // 正在采集或编码
+    bool isActive() const;
+    QString errorString() const;
+
+    // 由帧发布线程调用，未在连拍时立即返回；只拷贝数据，不做编码和内存分配
+    void capture(const FramePacket &packet);
+
+    static QString encodingName(Encoding encoding);
+    static Encoding encodingFromName(const QString &name);
+    // 该格式的帧实际保存的文件扩展名（MJPEG总是jpg）
+    static QString fileSuffix(FramePixelFormat format, Encoding encoding);
+
+signals:
+    // 在对象所在线程发出
+    void progress(int captured, int saved, int total);
+    void finished(const QStringList &files, int dropped, int failed, qint64 elapsedMs);
+
+private:
+    struct Slot {
+        FramePacket meta;     // data为空，数据在m_arena中
+        qint64 size = 0;
+        bool busy = false;    // 已拷贝、等待或正在编码
+    };
+
+    void encodeSlot(int slotIndex, int frameIndex);
+    // 以下两个函数须持有m_mutex调用
+    void postProgressLocked();
+    void finishIfDoneLocked();
+
+    TaskPool *m_pool;
+    std::unique_ptr<TaskGroup> m_group;
+
+    QByteArray m_arena;
+    QVector<Slot> m_slots;
+    qint64 m_slotBytes;
+
+    mutable QMutex m_mutex;
+    bool m_capturing;
+    int m_total;
+    int m_captured;
+    int m_saved;
+    int m_failed;
+    int m_dropped;
+    int m_pendingEncodes;
+    bool m_progressPending;
+    QStringList m_files;
+    QString m_directory;
+    QString m_filePrefix;
+    Encoding m_encoding;
+    int m_jpegQuality;
+    qint64 m_beginUs;
+    QString m_errorString;
+};
@@ -1,19 +1,24 @@
 #include "CameraControlDialog.h"
+#include "FrameAnalyzer.h"
+#include "HistogramWidget.h"
+#include "FocusSweep.h"
+#include "ImageAdjust.h"
 #include <QMessageBox>
 #include <QDebug>
-#include <QRegularExpression>
 
-// 定义电力线频率常量
-#define VideoProcAmp_PowerlineFrequency 11
+// 电力线频率取值
 #define VideoProcAmp_PowerlineFreq_Disabled 0
 #define VideoProcAmp_PowerlineFreq_50Hz 1
 #define VideoProcAmp_PowerlineFreq_60Hz 2
 #define VideoProcAmp_PowerlineFreq_Auto 3
 
 // 构造函数
-CameraControlDialog::CameraControlDialog(const QString& devicePath, QWidget* parent)
-    : QDialog(parent), devicePath(devicePath), videoInputFilter(nullptr), 
-      videoProcAmp(nullptr), cameraControl(nullptr)
+CameraControlDialog::CameraControlDialog(std::shared_ptr<CameraDeviceControl> control, FrameAnalyzer* analyzer,
+                                         ImageAdjust* imageAdjust, QWidget* parent)
+    : QDialog(parent), control(std::move(control)), powerLineCombo(nullptr),
+      analyzer(analyzer), histogramWidget(nullptr),
+      focusSweep(nullptr), focusLabel(nullptr), focusSweepButton(nullptr), focusPeak(0),
+      imageAdjust(imageAdjust)
 {
     // 设置窗口标题和大小
     setWindowTitle(tr("图像控制"));
@@ -38,151 +43,56 @@ CameraControlDialog::CameraControlDialog(const QString& devicePath, QWidget* par
                   "QComboBox:down-arrow { image: url(down_arrow.png); width: 12px; height: 12px; }"
                   "QComboBox QAbstractItemView { background-color: white; selection-background-color: #E0E0E0; selection-color: #000000; }");
     
-    // 初始化DirectShow
-    if (!initializeDirectShow()) {
-        return;
-    }
-    
     // 创建控件
     createControls();
     
     // 获取当前设置
     getCurrentSettings();
-}
-
-// 析构函数
-CameraControlDialog::~CameraControlDialog()
-{
-    // 释放DirectShow接口
-    if (videoProcAmp) {
-        videoProcAmp->Release();
-        videoProcAmp = nullptr;
-    }
     
-    if (cameraControl) {
-        cameraControl->Release();
-        cameraControl = nullptr;
+    // 对话框打开期间计算直方图
+    if (analyzer && histogramWidget) {
+        analyzer->addHistogramUser();
+        connect(analyzer, &FrameAnalyzer::histogramUpdated, this, [this]() {
+            histogramWidget->setHistogram(this->analyzer->histogram());
+        });
     }
     
-    if (videoInputFilter) {
-        videoInputFilter->Release();
-        videoInputFilter = nullptr;
+    // 对话框打开期间逐帧计算清晰度，显示当前值和本次打开以来的峰值
+    if (analyzer && focusLabel) {
+        analyzer->addFocusUser();
+        connect(analyzer, &FrameAnalyzer::focusUpdated, this, [this]() {
+            const FocusMeasure measure = this->analyzer->focus();
+            focusPeak = qMax(focusPeak, measure.sharpness);
+            if (!focusSweep->isRunning()) {
+                focusLabel->setText(tr("清晰度: %1（峰值 %2）").arg(measure.sharpness, 0, 'f', 1).arg(focusPeak, 0, 'f', 1));
+            }
+        });
+        
+        focusSweep = new FocusSweep(analyzer, this);
+        connect(focusSweep, &FocusSweep::progress, this, [this](int step, int totalSteps, long position, double sharpness) {
+            focusLabel->setText(tr("扫描 %1/%2：位置 %3，清晰度 %4").arg(step).arg(totalSteps).arg(position).arg(sharpness, 0, 'f', 1));
+        });
+        connect(focusSweep, &FocusSweep::finished, this, [this](bool, long, double, const QString &message) {
+            focusLabel->setText(message);
+            focusSweepButton->setText(tr("扫描对焦"));
+            // 扫描结束后对焦为手动，同步滑块和自动复选框
+            updateValue(controlIndex(CameraProperty::Focus));
+        });
     }
-    
-    // 关闭COM
-    CoUninitialize();
 }
 
-// 初始化DirectShow
-bool CameraControlDialog::initializeDirectShow()
+// 析构函数
+CameraControlDialog::~CameraControlDialog()
 {
-    HRESULT hr;
-    
-    // 初始化COM
-    hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-    if (FAILED(hr)) {
-        QString errorMessage;
-        switch (hr) {
-            case RPC_E_CHANGED_MODE:
-                errorMessage = tr("COM库已经初始化为单线程模式");
-                break;
-            case E_OUTOFMEMORY:
-                errorMessage = tr("内存不足，无法初始化COM");
-                break;
-            default:
-                errorMessage = tr("COM初始化失败，错误码: ") + QString::number(hr, 16);
-                break;
-        }
-        QMessageBox::warning(this, tr("错误"), errorMessage);
-        return false;
-    }
-    
-    // 创建系统设备枚举器
-    ICreateDevEnum* pDevEnum = nullptr;
-    hr = CoCreateInstance(CLSID_SystemDeviceEnum, NULL, CLSCTX_INPROC_SERVER,
-                         IID_ICreateDevEnum, (void**)&pDevEnum);
-    if (FAILED(hr)) {
-        QMessageBox::warning(this, tr("错误"), tr("无法创建设备枚举器"));
-        return false;
+    if (analyzer && histogramWidget) {
+        analyzer->removeHistogramUser();
     }
-    
-    // 创建视频输入设备枚举器
-    IEnumMoniker* pEnum = nullptr;
-    hr = pDevEnum->CreateClassEnumerator(CLSID_VideoInputDeviceCategory, &pEnum, 0);
-    pDevEnum->Release();
-    
-    if (hr != S_OK) {
-        QMessageBox::warning(this, tr("错误"), tr("没有找到视频输入设备"));
-        return false;
+    if (analyzer && focusLabel) {
+        // 扫描中关闭对话框时恢复原来的对焦
+        delete focusSweep;
+        focusSweep = nullptr;
+        analyzer->removeFocusUser();
     }
-    
-    // 枚举视频输入设备
-    IMoniker* pMoniker = nullptr;
-    ULONG fetched;
-    
-    while (pEnum->Next(1, &pMoniker, &fetched) == S_OK) {
-        IPropertyBag* pPropBag = nullptr;
-        hr = pMoniker->BindToStorage(0, 0, IID_IPropertyBag, (void**)&pPropBag);
-        
-        if (SUCCEEDED(hr)) {
-            VARIANT varName;
-            VariantInit(&varName);
-            
-            // 获取设备路径
-            hr = pPropBag->Read(L"DevicePath", &varName, 0);
-            if (SUCCEEDED(hr)) {
-                QString currentPath = QString::fromWCharArray(varName.bstrVal);
-                
-                // 使用正则表达式提取PID和VID
-                QRegularExpression re("vid_(\\w+)&pid_(\\w+)");
-                QRegularExpressionMatch match = re.match(currentPath.toLower());
-                QRegularExpressionMatch targetMatch = re.match(devicePath.toLower());
-                
-                if (match.hasMatch() && targetMatch.hasMatch()) {
-                    QString currentVid = match.captured(1);
-                    QString currentPid = match.captured(2);
-                    QString targetVid = targetMatch.captured(1);
-                    QString targetPid = targetMatch.captured(2);
-                    
-                    // 比较VID和PID
-                    if (currentVid == targetVid && currentPid == targetPid) {
-                        // 找到目标设备
-                        hr = pMoniker->BindToObject(NULL, NULL, IID_IBaseFilter, (void**)&videoInputFilter);
-                        
-                        if (SUCCEEDED(hr)) {
-                            // 获取VideoProcAmp接口
-                            hr = videoInputFilter->QueryInterface(IID_IAMVideoProcAmp, (void**)&videoProcAmp);
-                            if (FAILED(hr)) {
-                                videoProcAmp = nullptr;
-                            }
-                            
-                            // 获取CameraControl接口
-                            hr = videoInputFilter->QueryInterface(IID_IAMCameraControl, (void**)&cameraControl);
-                            if (FAILED(hr)) {
-                                cameraControl = nullptr;
-                            }
-                            
-                            VariantClear(&varName);
-                            pPropBag->Release();
-                            pMoniker->Release();
-                            pEnum->Release();
-                            
-                            return true;
-                        }
-                    }
-                }
-            }
-            
-            VariantClear(&varName);
-            pPropBag->Release();
-        }
-        
-        pMoniker->Release();
-    }
-    
-    pEnum->Release();
-    QMessageBox::warning(this, tr("错误"), tr("未找到指定的摄像头设备"));
-    return false;
 }
 
 // 创建控件
@@ -250,95 +160,22 @@ void CameraControlDialog::createVideoProcAmpPage(QWidget* page)
     powerLineLayout->addWidget(powerLineLabel);
     powerLineLayout->addWidget(powerLineCombo);
     powerLineLayout->addStretch();
-    
-    // 定义视频处理控制项
-    struct ControlDef {
-        QString name;
-        long propertyId;
-    };
-    
-    // 创建控制项列表
-    QList<ControlDef> controlDefs;
-    controlDefs.append({tr("亮度"), VideoProcAmp_Brightness});
-    controlDefs.append({tr("对比度"), VideoProcAmp_Contrast});
-    controlDefs.append({tr("色调"), VideoProcAmp_Hue});
-    controlDefs.append({tr("饱和度"), VideoProcAmp_Saturation});
-    controlDefs.append({tr("清晰度"), VideoProcAmp_Sharpness});
-    controlDefs.append({tr("伽马"), VideoProcAmp_Gamma});
-    controlDefs.append({tr("白平衡"), VideoProcAmp_WhiteBalance});
-    
-    int row = 0;
-    for (const auto& def : controlDefs) {
-        if (!videoProcAmp) continue;
-        
-        // 获取属性范围
-        VideoProcAmpPropertyInfo prop;
-        getPropertyRange(prop, def.propertyId);
-        long min = prop.Min;
-        long max = prop.Max;
-        long step = prop.Step;
-        long defaultVal = prop.Default;
-        long flags = prop.Flags;
-        
-        // 创建标签
-        QLabel* label = new QLabel(def.name + ":", page);
-        
-        // 创建滑块
-        QSlider* slider = new QSlider(Qt::Horizontal, page);
-        slider->setRange(min, max);
-        slider->setSingleStep(step);
-        slider->setPageStep(step * 10);
-        slider->setValue(defaultVal);
-        
-        // 创建数值显示
-        QSpinBox* spinBox = new QSpinBox(page);
-        spinBox->setRange(min, max);
-        spinBox->setSingleStep(step);
-        spinBox->setValue(defaultVal);
-        
-        // 创建自动复选框
-        QCheckBox* autoBox = nullptr;
-        if (flags & VideoProcAmp_Flags_Auto) {
-            autoBox = new QCheckBox(tr("自动"), page);
-            autoBox->setChecked(false);
-        }
-        
-        // 连接信号和槽
-        int index = controls.count();
-        QObject::connect(slider, &QSlider::valueChanged, this, [this, index](int value) {
-            onValueChanged(index, value);
-        });
-        QObject::connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), slider, &QSlider::setValue);
-        if (autoBox) {
-            QObject::connect(autoBox, &QCheckBox::toggled, this, [this, index](bool checked) {
-                onAutoChanged(index, checked);
-            });
-        }
-        
-        // 保存控件信息
-        ControlInfo info;
-        info.name = def.name;
-        info.slider = slider;
-        info.spinBox = spinBox;
-        info.autoBox = autoBox;
-        info.propertyId = def.propertyId;
-        info.isCameraControl = false;
-        info.currentPage = "VideoProcAmp";
-        controls.append(info);
-        
-        // 添加到布局
-        gridLayout->addWidget(label, row, 0);
-        gridLayout->addWidget(slider, row, 1);
-        gridLayout->addWidget(spinBox, row, 2);
-        if (autoBox) {
-            gridLayout->addWidget(autoBox, row, 3);
-        }
-        
-        row++;
-    }
+    powerLineCombo->setEnabled(control != nullptr);
+    
+    // 视频处理控制项
+    createPropertyRows(page, gridLayout, {
+        CameraProperty::Brightness,
+        CameraProperty::Contrast,
+        CameraProperty::Hue,
+        CameraProperty::Saturation,
+        CameraProperty::Sharpness,
+        CameraProperty::Gamma,
+        CameraProperty::WhiteBalance
+    });
     
     // 添加到主布局
     procAmpLayout->addLayout(gridLayout);
+    createSoftwareAdjustRows(page, procAmpLayout);
     procAmpLayout->addLayout(powerLineLayout);
     procAmpLayout->addWidget(defaultButton);
     procAmpLayout->addStretch();
@@ -359,54 +196,56 @@ void CameraControlDialog::createCameraControlPage(QWidget* page)
         resetToDefaults(true);
     });
     
-    // 定义摄像机控制项
-    struct ControlDef {
-        QString name;
-        long propertyId;
-    };
+    // 摄像机控制项
+    createPropertyRows(page, gridLayout, {
+        CameraProperty::Pan,
+        CameraProperty::Tilt,
+        CameraProperty::Roll,
+        CameraProperty::Zoom,
+        CameraProperty::Exposure,
+        CameraProperty::Iris,
+        CameraProperty::Focus
+    });
     
-    // 创建控制项列表
-    QList<ControlDef> controlDefs;
-    controlDefs.append({tr("平移"), CameraControl_Pan});
-    controlDefs.append({tr("倾斜"), CameraControl_Tilt});
-    controlDefs.append({tr("滚动"), CameraControl_Roll});
-    controlDefs.append({tr("变焦"), CameraControl_Zoom});
-    controlDefs.append({tr("曝光"), CameraControl_Exposure});
-    controlDefs.append({tr("光圈"), CameraControl_Iris});
-    controlDefs.append({tr("对焦"), CameraControl_Focus});
+    // 添加到主布局
+    cameraLayout->addLayout(gridLayout);
+    cameraLayout->addWidget(defaultButton);
+    cameraLayout->addStretch();
     
+    page->setLayout(cameraLayout);
+}
+
+// 为每个参数创建一行滑块、数值框和自动复选框，设备不支持的参数不显示
+void CameraControlDialog::createPropertyRows(QWidget* page, QGridLayout* gridLayout, const QList<CameraProperty>& properties)
+{
     int row = 0;
-    for (const auto& def : controlDefs) {
-        if (!cameraControl) continue;
+    for (CameraProperty property : properties) {
+        if (!control || !control->isSupported(property)) continue;
         
-        // 获取属性范围
-        CameraControlPropertyInfo prop;
-        getCameraControlRange(prop, def.propertyId);
-        long min = prop.Min;
-        long max = prop.Max;
-        long step = prop.Step;
-        long defaultVal = prop.Default;
-        long flags = prop.Flags;
+        // 获取属性范围，读取失败时使用默认范围
+        CameraPropertyRange range;
+        control->range(property, &range);
+        const QString name = CameraDeviceControl::propertyName(property);
         
         // 创建标签
-        QLabel* label = new QLabel(def.name + ":", page);
+        QLabel* label = new QLabel(name + ":", page);
         
         // 创建滑块
         QSlider* slider = new QSlider(Qt::Horizontal, page);
-        slider->setRange(min, max);
-        slider->setSingleStep(step);
-        slider->setPageStep(step * 10);
-        slider->setValue(defaultVal);
+        slider->setRange(range.minimum, range.maximum);
+        slider->setSingleStep(range.step);
+        slider->setPageStep(range.step * 10);
+        slider->setValue(range.defaultValue);
         
         // 创建数值显示
         QSpinBox* spinBox = new QSpinBox(page);
-        spinBox->setRange(min, max);
-        spinBox->setSingleStep(step);
-        spinBox->setValue(defaultVal);
+        spinBox->setRange(range.minimum, range.maximum);
+        spinBox->setSingleStep(range.step);
+        spinBox->setValue(range.defaultValue);
         
         // 创建自动复选框
         QCheckBox* autoBox = nullptr;
-        if (flags & CameraControl_Flags_Auto) {
+        if (range.canAuto) {
             autoBox = new QCheckBox(tr("自动"), page);
             autoBox->setChecked(false);
         }
@@ -425,13 +264,13 @@ void CameraControlDialog::createCameraControlPage(QWidget* page)
         
         // 保存控件信息
         ControlInfo info;
-        info.name = def.name;
+        info.name = name;
         info.slider = slider;
         info.spinBox = spinBox;
         info.autoBox = autoBox;
-        info.propertyId = def.propertyId;
-        info.isCameraControl = true;
-        info.currentPage = "CameraControl";
+        info.property = property;
+        info.isCameraControl = CameraDeviceControl::isCameraControl(property);
+        info.currentPage = info.isCameraControl ? "CameraControl" : "VideoProcAmp";
         controls.append(info);
         
         // 添加到布局
@@ -443,14 +282,131 @@ void CameraControlDialog::createCameraControlPage(QWidget* page)
         }
         
         row++;
+        
+        // 曝光滑块下方显示直方图，调节时可以直接看到过曝/欠曝比例
+        if (property == CameraProperty::Exposure && analyzer) {
+            histogramWidget = new HistogramWidget(page);
+            gridLayout->addWidget(histogramWidget, row, 0, 1, 4);
+            row++;
+        }
+        
+        // 对焦滑块下方显示清晰度，扫描对焦自动找清晰度最高的位置
+        if (property == CameraProperty::Focus && analyzer) {
+            focusLabel = new QLabel(tr("清晰度: --"), page);
+            focusSweepButton = new QPushButton(tr("扫描对焦"), page);
+            focusSweepButton->setToolTip(tr("关闭自动对焦，在整个范围内移动对焦并停在画面中央最清晰的位置"));
+            connect(focusSweepButton, &QPushButton::clicked, this, &CameraControlDialog::onFocusSweepClicked);
+            gridLayout->addWidget(focusLabel, row, 0, 1, 3);
+            gridLayout->addWidget(focusSweepButton, row, 3);
+            row++;
+        }
+    }
+}
+
+// 设备不支持的亮度/对比度/饱和度/伽马改为软件调节（预览和录制的YUYV/RGB32帧）
+void CameraControlDialog::createSoftwareAdjustRows(QWidget* page, QVBoxLayout* layout)
+{
+    if (!imageAdjust) {
+        return;
     }
     
-    // 添加到主布局
-    cameraLayout->addLayout(gridLayout);
-    cameraLayout->addWidget(defaultButton);
-    cameraLayout->addStretch();
-    
-    page->setLayout(cameraLayout);
+    ImageAdjustSettings settings = imageAdjust->settings();
+    QGroupBox* groupBox = nullptr;
+    QGridLayout* gridLayout = nullptr;
+    int row = 0;
+    const QList<CameraProperty> properties = {
+        CameraProperty::Brightness,
+        CameraProperty::Contrast,
+        CameraProperty::Saturation,
+        CameraProperty::Gamma
+    };
+    for (CameraProperty property : properties) {
+        int* field = nullptr;
+        int minimum = 0;
+        int maximum = 200;
+        int defaultValue = 100;
+        switch (property) {
+            case CameraProperty::Brightness:
+                field = &settings.brightness;
+                minimum = -100;
+                maximum = 100;
+                defaultValue = 0;
+                break;
+            case CameraProperty::Contrast:
+                field = &settings.contrast;
+                break;
+            case CameraProperty::Saturation:
+                field = &settings.saturation;
+                break;
+            default:
+                field = &settings.gamma;
+                minimum = 20;
+                maximum = 300;
+                break;
+        }
+        // 硬件支持的参数不做软件调节，避免换设备后两者叠加
+        if (control && control->isSupported(property)) {
+            *field = defaultValue;
+            continue;
+        }
+        
+        if (!groupBox) {
+            groupBox = new QGroupBox(tr("软件调节（设备不支持）"), page);
+            groupBox->setToolTip(tr("在预览和录制的YUYV/RGB32帧上按查找表调节，MJPEG直通录制不受影响"));
+            gridLayout = new QGridLayout(groupBox);
+        }
+        QLabel* label = new QLabel(CameraDeviceControl::propertyName(property) + ":", groupBox);
+        QSlider* slider = new QSlider(Qt::Horizontal, groupBox);
+        slider->setRange(minimum, maximum);
+        slider->setPageStep(10);
+        slider->setValue(*field);
+        QSpinBox* spinBox = new QSpinBox(groupBox);
+        spinBox->setRange(minimum, maximum);
+        spinBox->setValue(*field);
+        connect(slider, &QSlider::valueChanged, spinBox, &QSpinBox::setValue);
+        connect(spinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), slider, &QSlider::setValue);
+        connect(slider, &QSlider::valueChanged, this, &CameraControlDialog::onSoftwareAdjustChanged);
+        
+        SoftwareAdjustInfo info;
+        info.property = property;
+        info.slider = slider;
+        info.spinBox = spinBox;
+        info.defaultValue = defaultValue;
+        softwareControls.append(info);
+        
+        gridLayout->addWidget(label, row, 0);
+        gridLayout->addWidget(slider, row, 1);
+        gridLayout->addWidget(spinBox, row, 2);
+        row++;
+    }
+    imageAdjust->setSettings(settings);
+    if (groupBox) {
+        layout->addWidget(groupBox);
+    }
+}
+
+// 软件调节滑块改变：参数不变时ImageAdjust不会重建查找表
+void CameraControlDialog::onSoftwareAdjustChanged()
+{
+    ImageAdjustSettings settings = imageAdjust->settings();
+    for (const SoftwareAdjustInfo& info : softwareControls) {
+        const int value = info.slider->value();
+        switch (info.property) {
+            case CameraProperty::Brightness:
+                settings.brightness = value;
+                break;
+            case CameraProperty::Contrast:
+                settings.contrast = value;
+                break;
+            case CameraProperty::Saturation:
+                settings.saturation = value;
+                break;
+            default:
+                settings.gamma = value;
+                break;
+        }
+    }
+    imageAdjust->setSettings(settings);
 }
 
 // 获取当前设置
@@ -459,6 +415,17 @@ void CameraControlDialog::getCurrentSettings()
     for (int i = 0; i < controls.count(); i++) {
         updateValue(i);
     }
+    
+    // 电力线频率
+    long powerLine = 0;
+    if (control && control->value(CameraProperty::PowerLineFrequency, &powerLine)) {
+        for (int i = 0; i < powerLineCombo->count(); i++) {
+            if (powerLineCombo->itemData(i).toLongLong() == powerLine) {
+                powerLineCombo->setCurrentIndex(i);
+                break;
+            }
+        }
+    }
 }
 
 // 更新控件值
@@ -466,33 +433,16 @@ void CameraControlDialog::updateValue(int index)
 {
     if (index >= 0 && index < controls.count()) {
         const ControlInfo& info = controls[index];
-        long value = 0, flags = 0;
+        long value = 0;
+        bool autoMode = false;
         
-        if (info.isCameraControl && cameraControl) {
-            cameraControl->Get(info.propertyId, &value, &flags);
-            if (info.autoBox) {
-                info.autoBox->setChecked((flags & CameraControl_Flags_Auto) != 0);
-            }
-        }
-        else if (!info.isCameraControl && videoProcAmp) {
-            videoProcAmp->Get(info.propertyId, &value, &flags);
-            if (info.autoBox) {
-                info.autoBox->setChecked((flags & VideoProcAmp_Flags_Auto) != 0);
-            }
+        control->value(info.property, &value, &autoMode);
+        if (info.autoBox) {
+            info.autoBox->setChecked(autoMode);
         }
         
         info.slider->setValue(value);
         info.spinBox->setValue(value);
-        
-        // 更新电力线频率控制
-        if (!info.isCameraControl && info.propertyId == VideoProcAmp_PowerlineFrequency && videoProcAmp) {
-            for (int i = 0; i < powerLineCombo->count(); i++) {
-                if (powerLineCombo->itemData(i).toLongLong() == value) {
-                    powerLineCombo->setCurrentIndex(i);
-                    break;
-                }
-            }
-        }
     }
 }
 
@@ -503,28 +453,18 @@ void CameraControlDialog::resetToDefaults(bool isCameraControl)
         const ControlInfo& info = controls[i];
         
         if (info.isCameraControl == isCameraControl) {
-            long value = 0, flags = 0;
-            
-            if (info.isCameraControl && cameraControl) {
-                CameraControlPropertyInfo prop;
-                getCameraControlRange(prop, info.propertyId);
-                value = prop.Default;
-                flags = prop.Flags;
-                if (info.autoBox) {
-                    info.autoBox->setChecked((flags & CameraControl_Flags_Auto) != 0);
-                }
-            }
-            else if (!info.isCameraControl && videoProcAmp) {
-                VideoProcAmpPropertyInfo prop;
-                getPropertyRange(prop, info.propertyId);
-                value = prop.Default;
-                flags = prop.Flags;
-                if (info.autoBox) {
-                    info.autoBox->setChecked((flags & VideoProcAmp_Flags_Auto) != 0);
-                }
+            CameraPropertyRange range;
+            control->range(info.property, &range);
+            if (info.autoBox) {
+                info.autoBox->setChecked(range.canAuto);
             }
-            
-            info.slider->setValue(value);
+            info.slider->setValue(range.defaultValue);
+        }
+    }
+    
+    if (!isCameraControl) {
+        for (const SoftwareAdjustInfo& info : softwareControls) {
+            info.slider->setValue(info.defaultValue);
         }
     }
 }
@@ -536,37 +476,13 @@ void CameraControlDialog::onValueChanged(int index, int value)
         const ControlInfo& info = controls[index];
         info.spinBox->setValue(value);
         
-        // 检查是否是电力线频率控制
-        if (!info.isCameraControl && info.propertyId == VideoProcAmp_PowerlineFrequency && videoProcAmp) {
-            long flags = VideoProcAmp_Flags_Manual;
-            videoProcAmp->Set(VideoProcAmp_PowerlineFrequency, value, flags);
-            return;
-        }
-        
-        if (info.isCameraControl && cameraControl) {
-            // 获取当前的flags
-            long currentValue, flags;
-            HRESULT hr = cameraControl->Get(info.propertyId, &currentValue, &flags);
-            if (SUCCEEDED(hr)) {
-                // 保持原来的自动/手动设置
-                cameraControl->Set(info.propertyId, value, flags);
-            } else {
-                // 默认使用手动模式
-                cameraControl->Set(info.propertyId, value, CameraControl_Flags_Manual);
-            }
-        }
-        else if (!info.isCameraControl && videoProcAmp) {
-            // 获取当前的flags
-            long currentValue, flags;
-            HRESULT hr = videoProcAmp->Get(info.propertyId, &currentValue, &flags);
-            if (SUCCEEDED(hr)) {
-                // 保持原来的自动/手动设置
-                videoProcAmp->Set(info.propertyId, value, flags);
-            } else {
-                // 默认使用手动模式
-                videoProcAmp->Set(info.propertyId, value, VideoProcAmp_Flags_Manual);
-            }
+        // 保持原来的自动/手动设置，读取失败时使用手动模式
+        long currentValue = 0;
+        bool autoMode = false;
+        if (!control->value(info.property, &currentValue, &autoMode)) {
+            autoMode = false;
         }
+        control->setValue(info.property, value, autoMode);
         
         // 记录日志
         qDebug() << "设置参数:" << info.name << "值:" << value;
@@ -578,43 +494,17 @@ void CameraControlDialog::onAutoChanged(int index, bool checked)
 {
     if (index >= 0 && index < controls.count()) {
         const ControlInfo& info = controls[index];
-        long flags;
-        if (info.isCameraControl) {
-            flags = checked ? CameraControl_Flags_Auto : CameraControl_Flags_Manual;
-        } else {
-            flags = checked ? VideoProcAmp_Flags_Auto : VideoProcAmp_Flags_Manual;
-        }
         
-        // 获取当前值
+        // 先获取设备当前值，确保设置正确
         long currentValue = info.slider->value();
-        
-        if (info.isCameraControl && cameraControl) {
-            // 先获取当前值，确保设置正确
-            long oldValue, oldFlags;
-            HRESULT hr = cameraControl->Get(info.propertyId, &oldValue, &oldFlags);
-            if (SUCCEEDED(hr)) {
-                currentValue = oldValue; // 使用设备当前值
-            }
-            
-            // 设置新的标志
-            hr = cameraControl->Set(info.propertyId, currentValue, flags);
-            if (FAILED(hr)) {
-                qDebug() << "设置摄像机控制自动模式失败:" << info.name << "错误码:" << hr;
-            }
+        long deviceValue = 0;
+        if (control->value(info.property, &deviceValue)) {
+            currentValue = deviceValue;
         }
-        else if (!info.isCameraControl && videoProcAmp) {
-            // 先获取当前值，确保设置正确
-            long oldValue, oldFlags;
-            HRESULT hr = videoProcAmp->Get(info.propertyId, &oldValue, &oldFlags);
-            if (SUCCEEDED(hr)) {
-                currentValue = oldValue; // 使用设备当前值
-            }
-            
-            // 设置新的标志
-            hr = videoProcAmp->Set(info.propertyId, currentValue, flags);
-            if (FAILED(hr)) {
-                qDebug() << "设置视频处理自动模式失败:" << info.name << "错误码:" << hr;
-            }
+        
+        // 设置新的模式
+        if (!control->setValue(info.property, currentValue, checked)) {
+            qDebug() << "设置自动模式失败:" << info.name;
         }
         
         // 更新UI状态
@@ -636,15 +526,46 @@ void CameraControlDialog::onDefaultClicked()
     }
 }
 
+// 对焦扫描按钮：开始扫描，扫描中再次点击取消
+void CameraControlDialog::onFocusSweepClicked()
+{
+    if (focusSweep->isRunning()) {
+        focusSweep->cancel();
+        return;
+    }
+    
+    QString error;
+    if (!focusSweep->start(control, &error)) {
+        QMessageBox::warning(this, tr("警告"), tr("无法开始对焦扫描：%1").arg(error));
+        return;
+    }
+    focusSweepButton->setText(tr("取消扫描"));
+    int index = controlIndex(CameraProperty::Focus);
+    if (index >= 0 && controls[index].autoBox) {
+        controls[index].autoBox->setChecked(false);
+    }
+}
+
+// 参数对应的控件序号，没有时返回-1
+int CameraControlDialog::controlIndex(CameraProperty property) const
+{
+    for (int i = 0; i < controls.count(); i++) {
+        if (controls[i].property == property) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // 应用按钮点击处理
 void CameraControlDialog::onApplyClicked()
 {
     // 应用电力线频率设置
-    if (videoProcAmp) {
+    if (control && control->isSupported(CameraProperty::PowerLineFrequency)) {
         int index = powerLineCombo->currentIndex();
         if (index >= 0) {
             long value = powerLineCombo->itemData(index).toLongLong();
-            videoProcAmp->Set(VideoProcAmp_PowerlineFrequency, value, VideoProcAmp_Flags_Manual);
+            control->setValue(CameraProperty::PowerLineFrequency, value);
             qDebug() << "设置电力线频率:" << value;
         }
     }
@@ -660,35 +581,3 @@ void CameraControlDialog::onApplyClicked()
     
     QMessageBox::information(this, tr("信息"), tr("设置已应用"));
 }
-
-// 获取属性范围
-void CameraControlDialog::getPropertyRange(VideoProcAmpPropertyInfo& prop, long propertyId)
-{
-    if (videoProcAmp) {
-        HRESULT hr = videoProcAmp->GetRange(propertyId, &prop.Min, &prop.Max, 
-                                           &prop.Step, &prop.Default, &prop.Flags);
-        if (FAILED(hr)) {
-            prop.Min = 0;
-            prop.Max = 100;
-            prop.Step = 1;
-            prop.Default = 50;
-            prop.Flags = VideoProcAmp_Flags_Manual;
-        }
-    }
-}
-
-// 获取摄像机控制范围
-void CameraControlDialog::getCameraControlRange(CameraControlPropertyInfo& prop, long propertyId)
-{
-    if (cameraControl) {
-        HRESULT hr = cameraControl->GetRange(propertyId, &prop.Min, &prop.Max, 
-                                            &prop.Step, &prop.Default, &prop.Flags);
-        if (FAILED(hr)) {
-            prop.Min = 0;
-            prop.Max = 100;
-            prop.Step = 1;
-            prop.Default = 50;
-            prop.Flags = CameraControl_Flags_Manual;
-        }
-    }
-} 
\ No newline at end of file
@@ -13,34 +13,24 @@
 #include <QList>
 #include <QString>
 
-// Windows DirectShow头文件
-#include <dshow.h>
-#include <strmif.h>
-#include <control.h>
+#include <memory>
+#include "CameraDeviceControl.h"
 
-// VideoProcAmp属性ID和范围结构体
-struct VideoProcAmpPropertyInfo {
-    long Min;
-    long Max;
-    long Step;
-    long Default;
-    long Flags;
-};
-
-// CameraControl属性ID和范围结构体
-struct CameraControlPropertyInfo {
-    long Min;
-    long Max;
-    long Step;
-    long Default;
-    long Flags;
-};
+class FrameAnalyzer;
+class HistogramWidget;
+class FocusSweep;
+class ImageAdjust;
 
 // 摄像头控制对话框类
 class CameraControlDialog : public QDialog {
     Q_OBJECT
 public:
-    explicit CameraControlDialog(const QString& devicePath, QWidget* parent = nullptr);
+    // control由调用方创建（见CaptureController::deviceControl），对话框与其共享，为空时只显示软件调节；
+    // analyzer不为空时在曝光滑块下方显示实时直方图、在对焦滑块下方显示清晰度和对焦扫描按钮；
+    // imageAdjust不为空时，设备不支持的亮度/对比度/饱和度/伽马改为软件调节。
+    // analyzer和imageAdjust必须比对话框存活得久
+    explicit CameraControlDialog(std::shared_ptr<CameraDeviceControl> control, FrameAnalyzer* analyzer = nullptr,
+                                 ImageAdjust* imageAdjust = nullptr, QWidget* parent = nullptr);
     ~CameraControlDialog();
 
 private slots:
@@ -48,21 +38,20 @@ private slots:
     void onAutoChanged(int index, bool checked);
     void onApplyClicked();
     void onDefaultClicked();
+    void onFocusSweepClicked();
 private:
     void createControls();
     void createVideoProcAmpPage(QWidget* page);
     void createCameraControlPage(QWidget* page);
-    bool initializeDirectShow();
-    void getPropertyRange(VideoProcAmpPropertyInfo& prop, long propertyId);
-    void getCameraControlRange(CameraControlPropertyInfo& prop, long propertyId);
+    void createPropertyRows(QWidget* page, QGridLayout* gridLayout, const QList<CameraProperty>& properties);
+    void createSoftwareAdjustRows(QWidget* page, QVBoxLayout* layout);
+    void onSoftwareAdjustChanged();
     void updateValue(int index);
     void getCurrentSettings();
     void resetToDefaults(bool isCameraControl);
     
-    // DirectShow接口
-    IBaseFilter* videoInputFilter;
-    IAMVideoProcAmp* videoProcAmp;
-    IAMCameraControl* cameraControl;
+    // 摄像头参数控制接口（Windows下为DirectShow实现）
+    std::shared_ptr<CameraDeviceControl> control;
     
     // 控件列表
     struct ControlInfo {
@@ -70,7 +59,7 @@ private:
         QSlider* slider;
         QSpinBox* spinBox;
         QCheckBox* autoBox;
-        long propertyId;
+        CameraProperty property;
         bool isCameraControl;  // true为CameraControl，false为VideoProcAmp
         QString currentPage;   // 当前页面名称
         
@@ -79,16 +68,34 @@ private:
                    slider == other.slider &&
                    spinBox == other.spinBox &&
                    autoBox == other.autoBox &&
-                   propertyId == other.propertyId &&
+                   property == other.property &&
                    isCameraControl == other.isCameraControl &&
                    currentPage == other.currentPage;
         }
     };
     QList<ControlInfo> controls;
     
-    // 设备路径
-    QString devicePath;
-    
     // 电力线频率控制
     QComboBox* powerLineCombo;
+    
+    // 曝光调节参考：实时直方图
+    FrameAnalyzer* analyzer;
+    HistogramWidget* histogramWidget;
+    
+    // 对焦辅助：实时清晰度和软件对焦扫描
+    FocusSweep* focusSweep;
+    QLabel* focusLabel;
+    QPushButton* focusSweepButton;
+    double focusPeak;
+    int controlIndex(CameraProperty property) const;
+    
+    // 软件图像调节：设备不支持的VideoProcAmp参数
+    struct SoftwareAdjustInfo {
+        CameraProperty property;
+        QSlider* slider;
+        QSpinBox* spinBox;
+        int defaultValue;
+    };
+    ImageAdjust* imageAdjust;
+    QList<SoftwareAdjustInfo> softwareControls;
 }; 
\ No newline at end of file
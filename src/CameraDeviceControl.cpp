@@ -0,0 +1,53 @@
+#include "CameraDeviceControl.h"
+
+#ifdef Q_OS_WIN
+#include "DirectShowDeviceControl.h"
+#endif
+
+std::shared_ptr<CameraDeviceControl> CameraDeviceControl::create(const QByteArray &deviceId, QString *error)
+{
+#ifdef Q_OS_WIN
+    auto control = std::make_shared<DirectShowDeviceControl>();
+    if (!control->open(QString::fromUtf8(deviceId))) {
+        if (error) {
+            *error = control->errorString();
+        }
+        return nullptr;
+    }
+    return control;
+#else
+    Q_UNUSED(deviceId);
+    if (error) {
+        *error = "当前平台不支持摄像头参数控制";
+    }
+    return nullptr;
+#endif
+}
+
+bool CameraDeviceControl::isCameraControl(CameraProperty property)
+{
+    return property >= CameraProperty::Pan;
+}
+
+QString CameraDeviceControl::propertyName(CameraProperty property)
+{
+    switch (property) {
+        case CameraProperty::Brightness: return "亮度";
+        case CameraProperty::Contrast: return "对比度";
+        case CameraProperty::Hue: return "色调";
+        case CameraProperty::Saturation: return "饱和度";
+        case CameraProperty::Sharpness: return "清晰度";
+        case CameraProperty::Gamma: return "伽马";
+        case CameraProperty::WhiteBalance: return "白平衡";
+        case CameraProperty::Gain: return "增益";
+        case CameraProperty::PowerLineFrequency: return "电力线频率";
+        case CameraProperty::Pan: return "平移";
+        case CameraProperty::Tilt: return "倾斜";
+        case CameraProperty::Roll: return "滚动";
+        case CameraProperty::Zoom: return "变焦";
+        case CameraProperty::Exposure: return "曝光";
+        case CameraProperty::Iris: return "光圈";
+        case CameraProperty::Focus: return "对焦";
+    }
+    return QString();
+}
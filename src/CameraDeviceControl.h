@@ -0,0 +1,57 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+// 摄像头参数（对应UVC的图像处理单元和摄像机终端控制）
+enum class CameraProperty {
+    // 图像处理（VideoProcAmp）
+    Brightness,
+    Contrast,
+    Hue,
+    Saturation,
+    Sharpness,
+    Gamma,
+    WhiteBalance,
+    Gain,
+    PowerLineFrequency,
+    // 摄像机控制（CameraControl）
+    Pan,
+    Tilt,
+    Roll,
+    Zoom,
+    Exposure,
+    Iris,
+    Focus
+};
+
+// 参数范围，读取失败时为0~100、步长1、默认50、只支持手动
+struct CameraPropertyRange {
+    long minimum = 0;
+    long maximum = 100;
+    long step = 1;
+    long defaultValue = 50;
+    bool canAuto = false;
+    bool canManual = true;
+};
+
+// 摄像头参数控制接口
+// 把平台相关的参数读写（Windows下为DirectShow的IAMVideoProcAmp/IAMCameraControl）与界面分开，
+// 参数对话框、自动曝光等功能只依赖这个接口，也可以用模拟实现在没有摄像头的环境下运行。
+class CameraDeviceControl {
+public:
+    virtual ~CameraDeviceControl() = default;
+
+    // 按设备ID创建当前平台的实现；平台不支持或找不到设备时返回nullptr，原因写入error
+    static std::shared_ptr<CameraDeviceControl> create(const QByteArray &deviceId, QString *error = nullptr);
+
+    // 属于摄像机控制（曝光、对焦等）而不是图像处理
+    static bool isCameraControl(CameraProperty property);
+    static QString propertyName(CameraProperty property);
+
+    virtual bool isSupported(CameraProperty property) const = 0;
+    virtual bool range(CameraProperty property, CameraPropertyRange *range) const = 0;
+    // autoMode可以为nullptr
+    virtual bool value(CameraProperty property, long *value, bool *autoMode = nullptr) const = 0;
+    virtual bool setValue(CameraProperty property, long value, bool autoMode = false) = 0;
+};
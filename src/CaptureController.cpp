@@ -0,0 +1,741 @@
+#include "CaptureController.h"
+#include "AudioManager.h"
+#include "AviMjpegSink.h"
+#include "DigitalZoom.h"
+#include "RawFileSink.h"
+#include "SegmentedSink.h"
+#include "dbgout.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMediaDevices>
+
+namespace {
+    // 移动侦测的耗时和检测结果每分钟输出一次，用于调节灵敏度
+    const qint64 MOTION_LOG_INTERVAL_US = 60000000;
+    // 录制队列中已有这么多帧等待写入时（写入线程没跟上），新帧拷贝后再入队
+    const int RECORDING_COPY_QUEUE_DEPTH = 1;
+}
+
+CaptureController::CaptureController(QObject *parent)
+    : QObject(parent),
+      m_camera(nullptr),
+      m_analyzer(&m_frameBus),
+      m_preview(&m_frameBus, &m_lensCorrection, &m_imageAdjust),
+      m_audio(nullptr),
+      m_recording(false),
+      m_motionArmed(false),
+      m_motionStatsStartUs(0),
+      m_suspended(false),
+      m_sequence(0),
+      m_audioSequence(0),
+      m_candidateIndex(0),
+      m_verifyStartSequence(0),
+      m_verifyStartUs(0)
+{
+    m_session.setVideoSink(&m_videoSink);
+    connect(&m_videoSink, &QVideoSink::videoFrameChanged, this, &CaptureController::handleVideoFrame);
+    connect(&m_pipeline, &RecordingPipeline::sinkError, this, &CaptureController::recordingError);
+    connect(&m_analyzer, &FrameAnalyzer::motionUpdated, this, &CaptureController::handleMotionUpdated);
+    // 帧间隔变化，预览按新的预算从最高质量重新开始
+    connect(this, &CaptureController::formatChanged, this, [this](const QCameraFormat &format) {
+        m_preview.governor()->reset(format.maxFrameRate());
+    });
+    connect(&m_watchdog, &StreamWatchdog::restartRequested, this, &CaptureController::restartCamera);
+    connect(&m_watchdog, &StreamWatchdog::recovered, this, [](qint64 recoveryMs, int attempts) {
+        logToConsole(QString("采集: 视频流已恢复，中断 %1 ms，重启 %2 次").arg(recoveryMs).arg(attempts));
+    });
+
+    // 录制：队列为空时直接把引用映射内存的帧入队，写入线程马上取走，写完（或降噪、校正、调节换成自己的缓冲区）后释放。
+    // 磁盘慢时队列会积压，持有的帧句柄会占住摄像头缓冲区，采集和预览都会停下来，
+    // 所以队列中已有帧等待时在发布线程中拷贝一份再入队，最多只占用写入线程正在处理和排队的两个缓冲区
+    m_frameBus.subscribe("录制", [this](const SharedFrame &frame) {
+        if (m_recording) {
+            FramePacket packet = frame.packet();
+            if (packet.owner && m_pipeline.queueDepth() >= RECORDING_COPY_QUEUE_DEPTH) {
+                packet.data = QByteArray(packet.data.constData(), packet.data.size());
+                packet.owner.reset();
+            }
+            m_pipeline.submit(packet);
+        }
+    }, 0);
+
+    // 降噪、畸变校正、裁剪和软件图像调节在写入线程中进行，不占用发布线程（裁剪区域是在校正后的预览上选的，所以先校正）；
+    // MJPEG直通不做降噪、畸变校正和图像调节（需要重新编码），裁剪时才重新编码
+    m_pipeline.setFrameTransform([this](FramePacket *packet) {
+        bool changed = m_denoise.apply(packet, &m_denoiseBuffer);
+        changed = m_lensCorrection.apply(packet, &m_lensBuffer) || changed;
+        if (!m_activeCrop.isEmpty() && !packet->isAudio()) {
+            changed = cropPacket(packet, cropRegion(m_activeCrop, packet->size, packet->format), &m_cropBuffer) || changed;
+        }
+        return m_imageAdjust.apply(packet, &m_adjustBuffer) || changed;
+    });
+
+    // 预录：拷贝到预录缓存，不持有帧句柄
+    m_frameBus.subscribe("预录", [this](const SharedFrame &frame) {
+        if (!m_recording && m_preRoll.isEnabled()) {
+            m_preRoll.push(frame.packet());
+        }
+    }, 0);
+
+    connect(&m_statsTimer, &QTimer::timeout, this, &CaptureController::updateStats);
+    m_verifyTimer.setSingleShot(true);
+    connect(&m_verifyTimer, &QTimer::timeout, this, &CaptureController::verifyFormat);
+}
+
+CaptureController::~CaptureController()
+{
+    close();
+    m_session.setVideoSink(nullptr);
+}
+
+QCameraDevice CaptureController::findCamera(const QString &spec)
+{
+    const QList<QCameraDevice> cameras = QMediaDevices::videoInputs();
+    if (spec.isEmpty()) {
+        return QMediaDevices::defaultVideoInput();
+    }
+    bool isIndex = false;
+    const int index = spec.toInt(&isIndex);
+    if (isIndex) {
+        return index >= 0 && index < cameras.size() ? cameras[index] : QCameraDevice();
+    }
+    for (const QCameraDevice &device : cameras) {
+        if (device.id() == spec.toUtf8()) {
+            return device;
+        }
+    }
+    for (const QCameraDevice &device : cameras) {
+        if (device.description().contains(spec, Qt::CaseInsensitive)) {
+            return device;
+        }
+    }
+    return QCameraDevice();
+}
+
+QCameraFormat CaptureController::chooseFormat(const QCameraDevice &device, const FormatIndex &index, const QString &formatName,
+                                              const QSize &resolution, int fps, QList<FormatScore> *candidates)
+{
+    if (candidates) {
+        candidates->clear();
+    }
+    if (formatName.compare("auto", Qt::CaseInsensitive) == 0 || formatName == "自动") {
+        const QList<FormatScore> ranked = FormatSelector::rankFormats(device, resolution, fps);
+        if (candidates) {
+            *candidates = ranked;
+        }
+        return ranked.isEmpty() ? QCameraFormat() : ranked.first().format;
+    }
+    return index.find(FormatIndex::pixelFormatFromName(formatName), resolution, fps);
+}
+
+FrameSink *CaptureController::createSink(const QString &path, double fps, qint64 segmentUs, qint64 segmentBytes)
+{
+    const bool raw = path.endsWith(".raw", Qt::CaseInsensitive);
+    if (!raw && !path.endsWith(".avi", Qt::CaseInsensitive)) {
+        return nullptr;
+    }
+    if (!raw && (segmentBytes <= 0 || segmentBytes > AviMjpegSink::AUTO_SEGMENT_SIZE)) {
+        // AVI单文件不能超过2GB，总是按大小分段，长时间录制在接近上限时自动切换到新文件
+        segmentBytes = AviMjpegSink::AUTO_SEGMENT_SIZE;
+    }
+    if (segmentUs > 0 || segmentBytes > 0) {
+        // 分段录制：按时长或大小滚动到新文件，旧文件在后台收尾
+        SegmentedSink::SinkFactory factory = [raw, fps](const QString &segmentPath) -> FrameSink* {
+            if (raw) {
+                return new RawFileSink(segmentPath);
+            }
+            // 摄像头输出的JPEG数据原样写入AVI，不解码也不重新编码
+            return new AviMjpegSink(segmentPath, fps);
+        };
+        return new SegmentedSink(path, factory, segmentUs, segmentBytes);
+    }
+    return new RawFileSink(path);
+}
+
+bool CaptureController::open(const QCameraDevice &device, const QString &formatName, const QSize &resolution, int fps)
+{
+    close();
+    if (device.isNull()) {
+        m_errorString = "找不到摄像头";
+        return false;
+    }
+
+    QCameraFormat format;
+    m_candidates.clear();
+    m_candidateIndex = 0;
+    if (!formatName.isEmpty()) {
+        format = chooseFormat(device, FormatIndex(device.videoFormats()), formatName, resolution, fps, &m_candidates);
+    }
+    if (!formatName.isEmpty() && format.isNull()) {
+        m_errorString = QString("摄像头 %1 不支持 %2 %3x%4")
+                            .arg(device.description()).arg(formatName)
+                            .arg(resolution.width()).arg(resolution.height());
+        return false;
+    }
+    for (int i = 0; i < qMin(3, int(m_candidates.size())); ++i) {
+        logToConsole(QString("自动格式候选 %1: %2").arg(i + 1).arg(FormatSelector::describe(m_candidates[i])));
+    }
+
+    m_watchdog.resetStats();
+    m_camera = new QCamera(device, this);
+    connect(m_camera, &QCamera::errorOccurred, this, [this](QCamera::Error, const QString &message) {
+        emit errorOccurred("摄像头错误: " + message);
+    });
+    m_session.setCamera(m_camera);
+    if (!format.isNull()) {
+        m_camera->setCameraFormat(format);
+    }
+    m_camera->start();
+    format = m_camera->cameraFormat();
+    logToConsole(QString("采集: 打开 %1，%2 %3x%4@%5")
+                     .arg(device.description())
+                     .arg(FormatSelector::pixelFormatLabel(format.pixelFormat()))
+                     .arg(format.resolution().width()).arg(format.resolution().height())
+                     .arg(format.maxFrameRate()));
+
+    m_fps.reset();
+    m_statsTimer.start(1000);
+    m_verifyStartUs = 0;
+    m_watchdog.setFrameRate(format.maxFrameRate());
+    m_watchdog.start();
+    logToConsole(QString("视频流看门狗: %1 ms 未收到帧判定为卡顿").arg(m_watchdog.stallThresholdMs()));
+
+    if (m_audio && !m_audioDevice.isNull()) {
+        m_audio->startCapture();
+    }
+    emit formatChanged(format);
+    return true;
+}
+
+void CaptureController::close()
+{
+    stopMotionRecording();
+    stopRecording();
+    m_watchdog.stop();
+    m_statsTimer.stop();
+    m_verifyTimer.stop();
+    m_candidates.clear();
+    m_suspended = false;
+    m_preRoll.configure(0, 0, 0);
+    if (m_audio) {
+        m_audio->stopCapture();
+    }
+    if (m_camera) {
+        m_camera->stop();
+        m_session.setCamera(nullptr);
+        delete m_camera;
+        m_camera = nullptr;
+        logToConsole("采集: 摄像头已关闭");
+
+        // 输出本次的卡顿统计；统计保留到下次打开，关闭后仍可读取
+        const StreamWatchdogStats watchdogStats = m_watchdog.stats();
+        if (watchdogStats.stalls > 0) {
+            logToConsole(QString("视频流卡顿统计: 卡顿 %1 次，恢复 %2 次，重启 %3 次，恢复耗时平均 %4 ms，最长 %5 ms")
+                             .arg(watchdogStats.stalls).arg(watchdogStats.recoveries).arg(watchdogStats.restarts)
+                             .arg(watchdogStats.recoveries > 0 ? watchdogStats.totalRecoveryMs / watchdogStats.recoveries : 0)
+                             .arg(watchdogStats.maxRecoveryMs));
+        }
+    }
+    m_deviceControl.reset();
+    m_analyzer.clear();
+    m_preview.clear();
+}
+
+bool CaptureController::isOpen() const
+{
+    return m_camera != nullptr;
+}
+
+bool CaptureController::isActive() const
+{
+    return m_camera && m_camera->isActive();
+}
+
+QCameraDevice CaptureController::device() const
+{
+    return m_camera ? m_camera->cameraDevice() : QCameraDevice();
+}
+
+QCameraFormat CaptureController::cameraFormat() const
+{
+    return m_camera ? m_camera->cameraFormat() : QCameraFormat();
+}
+
+bool CaptureController::setFormat(const QString &formatName, const QSize &resolution, int fps)
+{
+    if (!m_camera) {
+        m_errorString = "摄像头未打开";
+        return false;
+    }
+    const QCameraDevice device = m_camera->cameraDevice();
+    const QCameraFormat format = chooseFormat(device, FormatIndex(device.videoFormats()), formatName,
+                                              resolution, fps, &m_candidates);
+    m_candidateIndex = 0;
+    if (format.isNull()) {
+        m_errorString = QString("摄像头不支持 %1 %2x%3").arg(formatName).arg(resolution.width()).arg(resolution.height());
+        return false;
+    }
+    applyFormat(format);
+    return true;
+}
+
+void CaptureController::suspend()
+{
+    if (!m_camera || m_suspended) {
+        return;
+    }
+    m_suspended = true;
+    m_suspendedFormat = m_camera->cameraFormat();
+    m_watchdog.stop();
+    m_verifyTimer.stop();
+    m_camera->stop();
+    if (m_audio) {
+        m_audio->stopCapture();
+    }
+    m_deviceControl.reset();
+}
+
+bool CaptureController::resume(const QCameraDevice &device)
+{
+    if (!m_camera || !m_suspended) {
+        return false;
+    }
+    m_suspended = false;
+
+    // 按断开前的格式重新打开，找不到相同格式时使用设备默认格式
+    QCameraFormat restored;
+    for (const QCameraFormat &format : FormatIndex(device.videoFormats()).formats()) {
+        if (format.pixelFormat() == m_suspendedFormat.pixelFormat()
+            && format.resolution() == m_suspendedFormat.resolution()
+            && qFuzzyCompare(format.maxFrameRate(), m_suspendedFormat.maxFrameRate())) {
+            restored = format;
+            break;
+        }
+    }
+    m_camera->setCameraDevice(device);
+    if (!restored.isNull()) {
+        m_camera->setCameraFormat(restored);
+    }
+    m_camera->start();
+    m_watchdog.setFrameRate(m_camera->cameraFormat().maxFrameRate());
+    m_watchdog.start();
+    if (m_audio && !m_audioDevice.isNull()) {
+        m_audio->startCapture();
+    }
+    if (restored.isNull()) {
+        emit formatChanged(m_camera->cameraFormat());
+    }
+    return !restored.isNull();
+}
+
+bool CaptureController::isSuspended() const
+{
+    return m_suspended;
+}
+
+QMediaCaptureSession *CaptureController::captureSession()
+{
+    return &m_session;
+}
+
+std::shared_ptr<CameraDeviceControl> CaptureController::deviceControl()
+{
+    if (!m_deviceControl && m_camera && !m_suspended) {
+        m_deviceControl = CameraDeviceControl::create(m_camera->cameraDevice().id(), &m_errorString);
+    } else if (!m_camera) {
+        m_errorString = "摄像头未打开";
+    }
+    return m_deviceControl;
+}
+
+void CaptureController::setAudioDevice(const QAudioDevice &device)
+{
+    m_audioDevice = device;
+    if (!m_audio) {
+        if (device.isNull()) {
+            return;
+        }
+        m_audio = new AudioSpectrumAnalyzer(this);
+        connect(m_audio, &AudioSpectrumAnalyzer::audioCaptured, this, &CaptureController::handleAudioCaptured);
+    }
+    m_audio->setAudioDevice(device);
+    if (isActive() && !device.isNull()) {
+        m_audio->startCapture();
+    }
+}
+
+AudioSpectrumAnalyzer *CaptureController::audioAnalyzer() const
+{
+    return m_audio;
+}
+
+void CaptureController::submitAudio(const QByteArray &pcm, int sampleRate, int channelCount)
+{
+    const FramePacket packet = packetFromAudio(pcm, sampleRate, channelCount, ++m_audioSequence);
+    if (m_recording) {
+        m_pipeline.submit(packet);
+    } else if (m_preRoll.isEnabled()) {
+        m_preRoll.push(packet);
+    }
+}
+
+void CaptureController::configurePreRoll(int seconds)
+{
+    if (seconds <= 0 || !m_camera) {
+        m_preRoll.configure(0, 0, 0);
+        return;
+    }
+
+    // 按格式估算每帧大小：YUYV为每像素2字节，MJPEG按每像素0.25字节估算
+    const QCameraFormat format = m_camera->cameraFormat();
+    const QSize resolution = format.resolution().isValid() ? format.resolution() : QSize(1920, 1080);
+    const double fps = format.maxFrameRate() > 0 ? format.maxFrameRate() : 30.0;
+    const qint64 pixels = qint64(resolution.width()) * resolution.height();
+    const qint64 frameBytes = format.pixelFormat() == QVideoFrameFormat::Format_Jpeg ? pixels / 4 : pixels * 2;
+    const qint64 audioBytes = qint64(seconds) * 48000 * 2 * 2;
+
+    // 缓存上限512MB，超出时实际可保留的时长会短于设置值
+    const qint64 maxArena = qint64(512) * 1024 * 1024;
+    qint64 arenaBytes = qint64(seconds * fps * frameBytes * 1.1) + audioBytes;
+    if (arenaBytes > maxArena) {
+        logToConsole(QString("预录缓存需要 %1 MB，超过上限，限制为 %2 MB")
+                         .arg(arenaBytes / (1024 * 1024)).arg(maxArena / (1024 * 1024)));
+        arenaBytes = maxArena;
+    }
+    // 音频约每50ms一包
+    const int maxPackets = int(seconds * (fps + 25)) + 16;
+
+    m_preRoll.configure(qint64(seconds) * 1000000, arenaBytes, maxPackets);
+    logToConsole(QString("预录缓存已分配: %1 秒，%2 MB").arg(seconds).arg(arenaBytes / (1024.0 * 1024.0), 0, 'f', 1));
+}
+
+const PreRollBuffer &CaptureController::preRollBuffer() const
+{
+    return m_preRoll;
+}
+
+bool CaptureController::startRecording(const QString &path, qint64 segmentUs, qint64 segmentBytes)
+{
+    // 摄像头启动是异步的，打开后可以立即开始录制，收到的第一帧起写入
+    if (!m_camera) {
+        m_errorString = "摄像头未打开";
+        return false;
+    }
+    if (m_recording) {
+        m_errorString = "录制已经在进行中";
+        return false;
+    }
+    FrameSink *sink = createSink(path, cameraFormat().maxFrameRate(), segmentUs, segmentBytes);
+    if (!sink) {
+        m_errorString = "不支持的录制文件类型（仅支持.raw和.avi）: " + path;
+        return false;
+    }
+    m_activeCrop = m_recordingCrop;
+    if (!m_activeCrop.isEmpty()) {
+        const QRect region = cropRegion(m_activeCrop, cameraFormat().resolution(), FramePixelFormat::Unknown);
+        logToConsole(QString("采集: 录制裁剪区域约 %1x%2+%3+%4（按像素格式对齐）").arg(region.width()).arg(region.height())
+                         .arg(region.x()).arg(region.y()));
+    }
+    if (m_lensCorrection.isActive() && cameraFormat().pixelFormat() == QVideoFrameFormat::Format_Jpeg) {
+        logToConsole("采集: MJPEG直通录制不做镜头畸变校正（需要重新编码），只有预览是校正后的画面");
+    }
+    if (m_denoise.isActive() && cameraFormat().pixelFormat() == QVideoFrameFormat::Format_Jpeg) {
+        logToConsole("采集: MJPEG直通录制不做时域降噪（需要重新编码），只有预览是降噪后的画面");
+    }
+    // 预录帧与上一次录制的最后一帧不连续，降噪从第一帧重新累积
+    m_denoise.reset();
+    // 先写入预录缓存中的帧，随后的实时帧紧接其后
+    const QList<FramePacket> preRoll = m_preRoll.takeAll();
+    if (!preRoll.isEmpty()) {
+        logToConsole(QString("写入预录帧: %1").arg(preRoll.size()));
+    }
+    if (!m_pipeline.start(sink, preRoll)) {
+        m_errorString = m_pipeline.errorString();
+        return false;
+    }
+    m_recording = true;
+    logToConsole("采集: 开始录制到 " + path);
+    return true;
+}
+
+void CaptureController::stopRecording()
+{
+    if (!m_recording) {
+        return;
+    }
+    m_recording = false;
+    m_pipeline.stop();
+    const RecordingStats stats = m_pipeline.stats();
+    logToConsole(QString("采集: 停止录制，已写 %1 帧，丢弃 %2 帧").arg(stats.encoded).arg(stats.dropped));
+}
+
+bool CaptureController::startMotionRecording(const QString &basePath, int sensitivity, int postRollSeconds)
+{
+    if (!m_camera) {
+        m_errorString = "摄像头未打开";
+        return false;
+    }
+    if (m_recording) {
+        m_errorString = "录制已经在进行中";
+        return false;
+    }
+    const QString suffix = QFileInfo(basePath).suffix().toLower();
+    if (suffix != "raw" && suffix != "avi") {
+        m_errorString = "不支持的录制文件类型（仅支持.raw和.avi）: " + basePath;
+        return false;
+    }
+    if (m_motionArmed) {
+        stopMotionRecording();
+    }
+    m_motionBasePath = basePath;
+    m_motionTrigger.reset();
+    m_motionTrigger.setPostRollUs(qint64(qMax(0, postRollSeconds)) * 1000000);
+    m_motionStats = MotionStats();
+    m_motionStatsStartUs = monotonicUs();
+    m_analyzer.setMotionSensitivity(sensitivity);
+    m_analyzer.addMotionUser();
+    m_motionArmed = true;
+    logToConsole(QString("移动侦测: 开始侦测，灵敏度 %1，预录 %2 秒，延录 %3 秒，文件 %4")
+                     .arg(m_analyzer.motionSensitivity())
+                     .arg(m_preRoll.isEnabled() ? m_preRoll.windowUs() / 1000000 : 0)
+                     .arg(postRollSeconds).arg(basePath));
+    if (!m_preRoll.isEnabled()) {
+        logToConsole("移动侦测: 预录缓存未开启，录制将从检测到移动时开始");
+    }
+    return true;
+}
+
+void CaptureController::stopMotionRecording()
+{
+    if (!m_motionArmed) {
+        return;
+    }
+    m_motionArmed = false;
+    m_analyzer.removeMotionUser();
+    if (m_motionTrigger.isActive()) {
+        m_motionTrigger.reset();
+        stopRecording();
+        emit motionRecordingChanged(false, m_motionPath);
+    }
+    if (m_motionStats.checks > 0) {
+        logToConsole("移动侦测: " + m_motionStats.summary());
+    }
+    logToConsole("移动侦测: 停止侦测");
+}
+
+bool CaptureController::isMotionRecordingArmed() const
+{
+    return m_motionArmed;
+}
+
+void CaptureController::handleMotionUpdated()
+{
+    if (!m_motionArmed) {
+        return;
+    }
+    // 信号排队期间可能有多次检测，只处理最新的结果
+    const MotionResult result = m_analyzer.motion();
+    if (!result.isValid()) {
+        return;
+    }
+    m_motionStats.add(result);
+    const qint64 now = monotonicUs();
+    if (now - m_motionStatsStartUs >= MOTION_LOG_INTERVAL_US) {
+        logToConsole("移动侦测: " + m_motionStats.summary());
+        m_motionStats = MotionStats();
+        m_motionStatsStartUs = now;
+    }
+
+    switch (m_motionTrigger.update(result)) {
+        case MotionTrigger::StartRecording: {
+            const QFileInfo info(m_motionBasePath);
+            m_motionPath = info.dir().filePath(QString("%1_%2.%3").arg(info.completeBaseName())
+                                                   .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"))
+                                                   .arg(info.suffix()));
+            logToConsole(QString("移动侦测: 检测到移动，变化块 %1/%2，最大块差 %3（阈值 %4，整体亮度变化 %5），耗时 %6 ms")
+                             .arg(result.changedBlocks).arg(result.blocks)
+                             .arg(result.maxBlockDiff, 0, 'f', 1).arg(result.threshold, 0, 'f', 1)
+                             .arg(result.globalOffset, 0, 'f', 1).arg(result.computeUs / 1000.0, 0, 'f', 2));
+            if (!startRecording(m_motionPath)) {
+                // 下一次检测到移动时重试
+                m_motionTrigger.reset();
+                logToConsole("移动侦测: 无法开始录制: " + m_errorString);
+                emit errorOccurred("移动侦测无法开始录制: " + m_errorString);
+                break;
+            }
+            emit motionRecordingChanged(true, m_motionPath);
+            break;
+        }
+        case MotionTrigger::StopRecording:
+            logToConsole(QString("移动侦测: %1 秒内没有移动，事件时长 %2 秒，停止录制")
+                             .arg(m_motionTrigger.postRollUs() / 1000000)
+                             .arg((result.captureUs - m_motionTrigger.eventStartUs()) / 1000000.0, 0, 'f', 1));
+            stopRecording();
+            emit motionRecordingChanged(false, m_motionPath);
+            break;
+        default:
+            break;
+    }
+}
+
+void CaptureController::setRecordingCrop(const QRectF &roi)
+{
+    m_recordingCrop = roi;
+}
+
+QRectF CaptureController::recordingCrop() const
+{
+    return m_recordingCrop;
+}
+
+bool CaptureController::isRecording() const
+{
+    return m_recording;
+}
+
+FrameBus *CaptureController::frameBus()
+{
+    return &m_frameBus;
+}
+
+RecordingPipeline *CaptureController::pipeline()
+{
+    return &m_pipeline;
+}
+
+StreamWatchdog *CaptureController::watchdog()
+{
+    return &m_watchdog;
+}
+
+FrameAnalyzer *CaptureController::analyzer()
+{
+    return &m_analyzer;
+}
+
+ImageAdjust *CaptureController::imageAdjust()
+{
+    return &m_imageAdjust;
+}
+
+LensCorrection *CaptureController::lensCorrection()
+{
+    return &m_lensCorrection;
+}
+
+TemporalDenoise *CaptureController::temporalDenoise()
+{
+    return &m_denoise;
+}
+
+PreviewPipeline *CaptureController::previewPipeline()
+{
+    return &m_preview;
+}
+
+quint64 CaptureController::framesReceived() const
+{
+    return m_sequence;
+}
+
+double CaptureController::fps() const
+{
+    return m_fps.fps();
+}
+
+double CaptureController::smoothedFps() const
+{
+    return m_fps.smoothedFps();
+}
+
+QString CaptureController::errorString() const
+{
+    return m_errorString;
+}
+
+void CaptureController::handleVideoFrame(const QVideoFrame &frame)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+    m_sequence++;
+    m_fps.frameArrived();
+    m_watchdog.frameArrived();
+
+    // 自动格式：从第一帧开始统计1秒内实际收到的帧数
+    if (!m_candidates.isEmpty() && m_verifyStartUs == 0) {
+        m_verifyStartUs = monotonicUs();
+        m_verifyStartSequence = m_sequence;
+        m_verifyTimer.start(1000);
+    }
+
+    m_frameBus.publish(SharedFrame::fromVideoFrame(frame, m_sequence));
+}
+
+void CaptureController::handleAudioCaptured(const QByteArray &pcm, int sampleRate, int channelCount)
+{
+    submitAudio(pcm, sampleRate, channelCount);
+}
+
+void CaptureController::updateStats()
+{
+    m_fps.update();
+    emit statsUpdated();
+}
+
+void CaptureController::restartCamera(int attempt)
+{
+    if (!m_camera || m_suspended) {
+        return;
+    }
+    logToConsole(QString("采集: 视频流卡顿，重启摄像头（第 %1 次）").arg(attempt));
+    m_camera->stop();
+    m_camera->start();
+}
+
+void CaptureController::applyFormat(const QCameraFormat &format)
+{
+    m_camera->stop();
+    m_camera->setCameraFormat(format);
+    m_camera->start();
+    m_verifyTimer.stop();
+    m_verifyStartUs = 0;
+    // 帧率可能变化，重新开始监视
+    m_watchdog.setFrameRate(format.maxFrameRate());
+    m_watchdog.start();
+    emit formatChanged(format);
+}
+
+void CaptureController::verifyFormat()
+{
+    if (!isActive() || m_suspended || m_candidateIndex >= m_candidates.size()) {
+        return;
+    }
+    const double elapsedSec = (monotonicUs() - m_verifyStartUs) / 1000000.0;
+    const double deliveredFps = elapsedSec > 0 ? (m_sequence - m_verifyStartSequence) / elapsedSec : 0;
+    const FormatScore &current = m_candidates[m_candidateIndex];
+    logToConsole(QString("自动格式校验: %1，实际 %2 FPS")
+                     .arg(FormatSelector::describe(current)).arg(deliveredFps, 0, 'f', 1));
+    if (deliveredFps >= current.expectedFps * 0.8) {
+        m_candidates.clear();
+        return;
+    }
+
+    // 只在分辨率不低于当前格式的候选中查找，避免为了帧率悄悄降低分辨率
+    const QSize currentSize = current.format.resolution();
+    for (int i = m_candidateIndex + 1; i < m_candidates.size(); ++i) {
+        const FormatScore &next = m_candidates[i];
+        const QSize size = next.format.resolution();
+        if (qint64(size.width()) * size.height() < qint64(currentSize.width()) * currentSize.height()
+            || next.expectedFps <= deliveredFps) {
+            continue;
+        }
+        logToConsole("自动格式: 实际帧率不足，改用 " + FormatSelector::describe(next));
+        m_candidateIndex = i;
+        applyFormat(next.format);
+        return;
+    }
+    logToConsole("自动格式: 没有更好的候选格式，保持当前格式");
+    m_candidates.clear();
+}
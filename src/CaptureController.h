@@ -0,0 +1,188 @@
+#pragma once
+#include <QObject>
+#include <QCamera>
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QMediaCaptureSession>
+#include <QVideoSink>
+#include <QVideoFrame>
+#include <QAudioDevice>
+#include <QRectF>
+#include <QTimer>
+#include <memory>
+#include "CameraDeviceControl.h"
+#include "FormatIndex.h"
+#include "FrameAnalyzer.h"
+#include "FormatSelector.h"
+#include "FpsCounter.h"
+#include "FrameBus.h"
+#include "ImageAdjust.h"
+#include "LensCorrection.h"
+#include "PreRollBuffer.h"
+#include "PreviewPipeline.h"
+#include "RecordingPipeline.h"
+#include "StreamWatchdog.h"
+#include "TemporalDenoise.h"
+
+class AudioSpectrumAnalyzer;
+class FrameSink;
+
+// 采集控制器（不依赖任何界面控件）
+// 负责打开摄像头、选择格式（含自动格式和1秒帧率校验）、把帧发布到帧总线、预录缓存、
+// 卡顿自动重启、断开后重新连接、原始帧/MJPEG直通录制、移动触发录制以及预览处理，主窗口和无界面模式共用。
+class CaptureController : public QObject {
+    Q_OBJECT
+public:
+    explicit CaptureController(QObject *parent = nullptr);
+    ~CaptureController();
+
+    // 按序号、设备ID或名称（不区分大小写的子串）查找摄像头，spec为空时返回默认摄像头
+    static QCameraDevice findCamera(const QString &spec);
+    // formatName为"auto"/"自动"、"yuyv"/"YUY2"或"mjpeg"/"MJPEG"；自动格式时candidates返回按吞吐量排序的候选
+    static QCameraFormat chooseFormat(const QCameraDevice &device, const FormatIndex &index, const QString &formatName,
+                                      const QSize &resolution, int fps, QList<FormatScore> *candidates = nullptr);
+    // 按扩展名创建录制输出：.raw为原始帧，.avi为MJPEG直通；分段参数不为0时包装为分段输出；不支持的扩展名返回nullptr
+    static FrameSink *createSink(const QString &path, double fps, qint64 segmentUs = 0, qint64 segmentBytes = 0);
+
+    // formatName为空时使用设备的默认格式
+    bool open(const QCameraDevice &device, const QString &formatName, const QSize &resolution, int fps);
+    void close();
+    // 摄像头对象存在（包括启动中和断开后等待重新连接）
+    bool isOpen() const;
+    // 摄像头正在出帧
+    bool isActive() const;
+    QCameraDevice device() const;
+    QCameraFormat cameraFormat() const;
+    // 打开状态下切换格式，摄像头会重启
+    bool setFormat(const QString &formatName, const QSize &resolution, int fps);
+
+    // 摄像头被拔出：停止摄像头和看门狗，录制、预录和帧总线保持不变
+    void suspend();
+    // 设备重新插入：按断开前的格式重新开始采集，返回是否恢复了原格式
+    bool resume(const QCameraDevice &device);
+    bool isSuspended() const;
+
+    // 主窗口的MP4录制（QMediaRecorder）挂在同一个捕获会话上
+    QMediaCaptureSession *captureSession();
+    // 当前摄像头的参数控制，第一次调用时创建；平台不支持时返回nullptr，原因见errorString()
+    std::shared_ptr<CameraDeviceControl> deviceControl();
+
+    // 空设备表示不采集音频；录制时音频以PCM写入同一文件
+    void setAudioDevice(const QAudioDevice &device);
+    AudioSpectrumAnalyzer *audioAnalyzer() const;
+    // 外部采集的音频（如主窗口的音频面板），录制时写入文件，否则进入预录缓存
+    void submitAudio(const QByteArray &pcm, int sampleRate, int channelCount);
+
+    // 按当前格式分配最近seconds秒的预录缓存，0表示关闭；开始录制时先写入缓存中的内容
+    void configurePreRoll(int seconds);
+    const PreRollBuffer &preRollBuffer() const;
+
+    // 录制裁剪区域（归一化，空为整帧），开始录制时生效并在整个录制期间保持不变（输出文件的帧尺寸不能变化）
+    void setRecordingCrop(const QRectF &roi);
+    QRectF recordingCrop() const;
+
+    bool startRecording(const QString &path, qint64 segmentUs = 0, qint64 segmentBytes = 0);
+    void stopRecording();
+    bool isRecording() const;
+
+    // 移动触发录制：分析线程检测到移动时开始录制到basePath加时间的新文件（先写入预录缓存，预录时长由configurePreRoll()设置），
+    // 最后一次检测到移动postRollSeconds秒后停止，等待期间不写文件；扩展名决定录制格式（.raw或.avi）
+    bool startMotionRecording(const QString &basePath, int sensitivity, int postRollSeconds);
+    // 停止侦测，正在进行的事件录制也会停止
+    void stopMotionRecording();
+    bool isMotionRecordingArmed() const;
+
+    FrameBus *frameBus();
+    RecordingPipeline *pipeline();
+    // 卡顿统计在open()时清零，close()之后仍保留本次会话的结果
+    StreamWatchdog *watchdog();
+    // 直方图等画面统计，有使用者时才计算
+    FrameAnalyzer *analyzer();
+    // 软件图像调节：录制的YUYV/RGB32帧在写入线程中调节，预览管线按同一设置调节缩放后的图像
+    ImageAdjust *imageAdjust();
+    // 镜头畸变校正：录制的YUYV/RGB32帧在写入线程中校正（先于裁剪和图像调节），预览管线在转换前校正
+    LensCorrection *lensCorrection();
+    // 时域降噪：录制的YUYV/RGB32帧在写入线程中降噪（最先进行，此时噪声还没有被插值和调节放大），
+    // 历史只属于录制这一路画面；预览管线用自己的对象降噪，强度另外设置
+    TemporalDenoise *temporalDenoise();
+    // 预览处理管线，默认不启用；格式变化时质量调节器按新帧率重置，关闭摄像头时丢弃最后一帧
+    PreviewPipeline *previewPipeline();
+
+    quint64 framesReceived() const;
+    // 最近一秒的实际帧率
+    double fps() const;
+    // 平滑后的帧率，用于界面显示
+    double smoothedFps() const;
+    QString errorString() const;
+
+signals:
+    // 每秒一次
+    void statsUpdated();
+    // 打开、切换格式或重新连接后格式变化，帧大小相关的缓存需要重新分配
+    void formatChanged(const QCameraFormat &format);
+    void errorOccurred(const QString &message);
+    // 录制输出写入失败，录制需要停止
+    void recordingError(const QString &message);
+    // 移动触发的录制开始（path为新文件）或停止
+    void motionRecordingChanged(bool recording, const QString &path);
+
+private slots:
+    void handleVideoFrame(const QVideoFrame &frame);
+    void handleAudioCaptured(const QByteArray &pcm, int sampleRate, int channelCount);
+    void updateStats();
+    void restartCamera(int attempt);
+    void verifyFormat();
+    void handleMotionUpdated();
+
+private:
+    void applyFormat(const QCameraFormat &format);
+
+    QCamera *m_camera;
+    QMediaCaptureSession m_session;
+    QVideoSink m_videoSink;
+    FrameBus m_frameBus;
+    RecordingPipeline m_pipeline;
+    PreRollBuffer m_preRoll;
+    StreamWatchdog m_watchdog;
+    // 订阅m_frameBus，必须在其后声明（先于帧总线析构）
+    FrameAnalyzer m_analyzer;
+    std::shared_ptr<CameraDeviceControl> m_deviceControl;
+    ImageAdjust m_imageAdjust;
+    QByteArray m_adjustBuffer;      // 只在录制写入线程中使用，跨帧复用
+    LensCorrection m_lensCorrection;
+    QByteArray m_lensBuffer;        // 只在录制写入线程中使用，跨帧复用
+    TemporalDenoise m_denoise;      // apply()只在录制写入线程中调用
+    QByteArray m_denoiseBuffer;     // 只在录制写入线程中使用，跨帧复用
+    // 订阅m_frameBus并使用上面的畸变校正和图像调节，必须在它们之后声明
+    PreviewPipeline m_preview;
+    QRectF m_recordingCrop;
+    QRectF m_activeCrop;            // 本次录制使用的裁剪区域，录制期间只由写入线程读取
+    QByteArray m_cropBuffer;        // 只在录制写入线程中使用，跨帧复用
+    AudioSpectrumAnalyzer *m_audio;
+    QAudioDevice m_audioDevice;
+
+    bool m_recording;
+
+    // 移动触发录制
+    bool m_motionArmed;
+    QString m_motionBasePath;
+    QString m_motionPath;           // 当前事件的录制文件
+    MotionTrigger m_motionTrigger;
+    MotionStats m_motionStats;      // 定期输出到日志后清零
+    qint64 m_motionStatsStartUs;
+    bool m_suspended;
+    QCameraFormat m_suspendedFormat;
+    quint64 m_sequence;
+    quint64 m_audioSequence;
+    FpsCounter m_fps;
+    QTimer m_statsTimer;
+
+    // 自动格式校验
+    QList<FormatScore> m_candidates;
+    int m_candidateIndex;
+    QTimer m_verifyTimer;
+    quint64 m_verifyStartSequence;
+    qint64 m_verifyStartUs;
+
+    QString m_errorString;
+};
@@ -0,0 +1,107 @@
+#include "DeviceMonitor.h"
+#include "dbgout.h"
+
+namespace {
+    // 按设备ID比较两次枚举结果，返回在from中而不在to中的设备
+    template <typename Device>
+    QList<Device> missingFrom(const QList<Device> &from, const QList<Device> &to)
+    {
+        QList<Device> result;
+        for (const Device &device : from) {
+            bool found = false;
+            for (const Device &other : to) {
+                if (other.id() == device.id()) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                result << device;
+            }
+        }
+        return result;
+    }
+}
+
+DeviceMonitor::DeviceMonitor(QObject *parent)
+    : QObject(parent),
+      m_cameras(QMediaDevices::videoInputs()),
+      m_audioInputs(QMediaDevices::audioInputs())
+{
+    connect(&m_mediaDevices, &QMediaDevices::videoInputsChanged, this, &DeviceMonitor::updateCameras);
+    connect(&m_mediaDevices, &QMediaDevices::audioInputsChanged, this, &DeviceMonitor::updateAudioInputs);
+}
+
+QList<QCameraDevice> DeviceMonitor::cameras() const
+{
+    return m_cameras;
+}
+
+QList<QAudioDevice> DeviceMonitor::audioInputs() const
+{
+    return m_audioInputs;
+}
+
+QCameraDevice DeviceMonitor::camera(const QByteArray &id) const
+{
+    for (const QCameraDevice &device : m_cameras) {
+        if (device.id() == id) {
+            return device;
+        }
+    }
+    return QCameraDevice();
+}
+
+FormatIndex DeviceMonitor::formatIndex(const QCameraDevice &device)
+{
+    auto it = m_formatCache.find(device.id());
+    if (it == m_formatCache.end()) {
+        it = m_formatCache.insert(device.id(), FormatIndex(device.videoFormats()));
+    }
+    return it.value();
+}
+
+void DeviceMonitor::refresh()
+{
+    m_formatCache.clear();
+    updateCameras();
+    updateAudioInputs();
+}
+
+void DeviceMonitor::updateCameras()
+{
+    const QList<QCameraDevice> current = QMediaDevices::videoInputs();
+    const QList<QCameraDevice> added = missingFrom(current, m_cameras);
+    const QList<QCameraDevice> removed = missingFrom(m_cameras, current);
+    m_cameras = current;
+
+    // 重新插入的设备格式可能变化（如换到USB 3.0接口），丢弃旧缓存
+    for (const QCameraDevice &device : added) {
+        m_formatCache.remove(device.id());
+        logToConsole("摄像头已连接: " + device.description());
+    }
+    for (const QCameraDevice &device : removed) {
+        logToConsole("摄像头已断开: " + device.description());
+    }
+    if (!removed.isEmpty()) {
+        emit camerasRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        emit camerasAdded(added);
+    }
+}
+
+void DeviceMonitor::updateAudioInputs()
+{
+    const QList<QAudioDevice> current = QMediaDevices::audioInputs();
+    const QList<QAudioDevice> added = missingFrom(current, m_audioInputs);
+    const QList<QAudioDevice> removed = missingFrom(m_audioInputs, current);
+    m_audioInputs = current;
+
+    if (!removed.isEmpty()) {
+        emit audioInputsRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        emit audioInputsAdded(added);
+    }
+}
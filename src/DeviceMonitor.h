@@ -0,0 +1,44 @@
+#pragma once
+#include <QObject>
+#include <QMediaDevices>
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QAudioDevice>
+#include <QHash>
+#include <QList>
+#include "FormatIndex.h"
+
+// 设备热插拔监视
+// 监听QMediaDevices的设备变化信号，与上一次的设备集合比较后只报告新增和移除的设备，
+// 并缓存每个摄像头的格式索引，界面更新时不需要重新枚举所有设备和格式。
+class DeviceMonitor : public QObject {
+    Q_OBJECT
+public:
+    explicit DeviceMonitor(QObject *parent = nullptr);
+
+    QList<QCameraDevice> cameras() const;
+    QList<QAudioDevice> audioInputs() const;
+    // 按设备ID查找，找不到时返回空设备
+    QCameraDevice camera(const QByteArray &id) const;
+    // 格式索引在第一次查询时从设备读取并缓存，设备重新插入或refresh()时丢弃
+    FormatIndex formatIndex(const QCameraDevice &device);
+
+    // 重新枚举全部设备（"查找摄像头"按钮），会发出相应的新增/移除信号
+    void refresh();
+
+signals:
+    void camerasAdded(const QList<QCameraDevice> &devices);
+    void camerasRemoved(const QList<QCameraDevice> &devices);
+    void audioInputsAdded(const QList<QAudioDevice> &devices);
+    void audioInputsRemoved(const QList<QAudioDevice> &devices);
+
+private slots:
+    void updateCameras();
+    void updateAudioInputs();
+
+private:
+    QMediaDevices m_mediaDevices;
+    QList<QCameraDevice> m_cameras;
+    QList<QAudioDevice> m_audioInputs;
+    QHash<QByteArray, FormatIndex> m_formatCache;
+};
@@ -0,0 +1,167 @@
+#include "DigitalZoom.h"
+#include "FrameConvert.h"
+#include <QBuffer>
+#include <QImage>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const double MAX_DIGITAL_ZOOM = 8.0;
+    // MJPEG最大的MCU为16x16（4:2:0）
+    const int MJPEG_MCU_SIZE = 16;
+
+    // 向外对齐到align的倍数，不超出[0, limit]
+    void alignSpan(int *begin, int *end, int align, int limit)
+    {
+        *begin = *begin / align * align;
+        *end = qMin(limit, (*end + align - 1) / align * align);
+    }
+}
+
+DigitalZoom::DigitalZoom()
+    : m_factor(1.0),
+      m_center(0.5, 0.5)
+{
+}
+
+double DigitalZoom::factor() const
+{
+    return m_factor;
+}
+
+bool DigitalZoom::isZoomed() const
+{
+    return m_factor > 1.0;
+}
+
+void DigitalZoom::setFactor(double factor)
+{
+    m_factor = qBound(1.0, factor, MAX_DIGITAL_ZOOM);
+    clampCenter();
+}
+
+void DigitalZoom::zoomAt(double factor, const QPointF &viewPoint)
+{
+    // 缩放前viewPoint对应的画面位置
+    const QPointF anchor(m_center.x() + (viewPoint.x() - 0.5) / m_factor,
+                         m_center.y() + (viewPoint.y() - 0.5) / m_factor);
+    m_factor = qBound(1.0, factor, MAX_DIGITAL_ZOOM);
+    m_center = QPointF(anchor.x() - (viewPoint.x() - 0.5) / m_factor,
+                       anchor.y() - (viewPoint.y() - 0.5) / m_factor);
+    clampCenter();
+}
+
+void DigitalZoom::pan(const QPointF &viewDelta)
+{
+    m_center -= viewDelta / m_factor;
+    clampCenter();
+}
+
+void DigitalZoom::reset()
+{
+    m_factor = 1.0;
+    m_center = QPointF(0.5, 0.5);
+}
+
+QRectF DigitalZoom::roi() const
+{
+    if (!isZoomed()) {
+        return QRectF();
+    }
+    const double size = 1.0 / m_factor;
+    return QRectF(m_center.x() - size / 2, m_center.y() - size / 2, size, size);
+}
+
+QRectF DigitalZoom::mapToView(const QRectF &frameRect) const
+{
+    if (!isZoomed()) {
+        return frameRect;
+    }
+    const QRectF view = roi();
+    return QRectF((frameRect.x() - view.x()) * m_factor, (frameRect.y() - view.y()) * m_factor,
+                  frameRect.width() * m_factor, frameRect.height() * m_factor);
+}
+
+// 显示区域不超出画面
+void DigitalZoom::clampCenter()
+{
+    const double half = 0.5 / m_factor;
+    m_center.setX(qBound(half, m_center.x(), 1.0 - half));
+    m_center.setY(qBound(half, m_center.y(), 1.0 - half));
+}
+
+QRect cropRegion(const QRectF &roi, const QSize &frameSize, FramePixelFormat format)
+{
+    const QRect frameRect(QPoint(0, 0), frameSize);
+    if (roi.isEmpty() || frameSize.isEmpty()) {
+        return frameRect;
+    }
+    int left = qBound(0, int(roi.left() * frameSize.width()), frameSize.width() - 1);
+    int top = qBound(0, int(roi.top() * frameSize.height()), frameSize.height() - 1);
+    int right = qBound(left + 1, int(std::ceil(roi.right() * frameSize.width())), frameSize.width());
+    int bottom = qBound(top + 1, int(std::ceil(roi.bottom() * frameSize.height())), frameSize.height());
+    if (format == FramePixelFormat::YUYV) {
+        alignSpan(&left, &right, 2, frameSize.width());
+    } else if (format == FramePixelFormat::MJPEG) {
+        alignSpan(&left, &right, MJPEG_MCU_SIZE, frameSize.width());
+        alignSpan(&top, &bottom, MJPEG_MCU_SIZE, frameSize.height());
+    }
+    return QRect(left, top, right - left, bottom - top);
+}
+
+bool cropPacket(FramePacket *packet, const QRect &region, QByteArray *buffer, int jpegQuality)
+{
+    const QRect frameRect(QPoint(0, 0), packet->size);
+    const QRect clip = region.intersected(frameRect);
+    if (clip.isEmpty() || clip == frameRect) {
+        return false;
+    }
+
+    switch (packet->format) {
+        case FramePixelFormat::YUYV:
+        case FramePixelFormat::RGB32: {
+            if (packet->data.size() < qsizetype(packet->bytesPerLine) * (clip.bottom() + 1)) {
+                return false;
+            }
+            // 与cropRegion相同，YUYV左边界和宽度按2像素对齐
+            const bool yuyv = packet->format == FramePixelFormat::YUYV;
+            const int bytesPerPixel = yuyv ? 2 : 4;
+            const int left = yuyv ? clip.left() & ~1 : clip.left();
+            int width = clip.right() + 1 - left;
+            if (yuyv) {
+                width = (width + 1) & ~1;
+            }
+            const int rowBytes = qMin(width, packet->size.width() - left) * bytesPerPixel;
+            buffer->resize(qsizetype(rowBytes) * clip.height());
+            const char *src = packet->data.constData() + qsizetype(clip.top()) * packet->bytesPerLine + left * bytesPerPixel;
+            char *dst = buffer->data();
+            for (int y = 0; y < clip.height(); ++y) {
+                std::memcpy(dst + qsizetype(y) * rowBytes, src + qsizetype(y) * packet->bytesPerLine, rowBytes);
+            }
+            packet->data = *buffer;
+            packet->size = QSize(rowBytes / bytesPerPixel, clip.height());
+            packet->bytesPerLine = rowBytes;
+            packet->owner.reset();
+            return true;
+        }
+        case FramePixelFormat::MJPEG: {
+            // 压缩数据不能直接裁剪，只能解码区域后重新编码
+            const QImage image = packetToImage(*packet, clip);
+            if (image.isNull()) {
+                return false;
+            }
+            QByteArray jpeg;
+            QBuffer output(&jpeg);
+            output.open(QIODevice::WriteOnly);
+            if (!image.save(&output, "JPG", jpegQuality)) {
+                return false;
+            }
+            packet->data = jpeg;
+            packet->size = image.size();
+            packet->owner.reset();
+            return true;
+        }
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QByteArray>
+#include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include "FramePacket.h"
+
+// 数字变焦/平移（摄像头不支持CameraControl_Zoom时使用）
+// 以归一化坐标保存显示区域：factor为放大倍数，center为显示区域中心在整帧中的位置。
+// 只保存视图状态，不处理帧；在界面线程中使用，需要跨线程时传递roi()的值
+class DigitalZoom {
+public:
+    DigitalZoom();
+
+    double factor() const;
+    bool isZoomed() const;
+    // 以当前中心缩放，倍数限制在1~8
+    void setFactor(double factor);
+    // 以显示区域内的归一化位置viewPoint为中心缩放，缩放前后该点对应的画面位置不变（鼠标滚轮）
+    void zoomAt(double factor, const QPointF &viewPoint);
+    // 按显示区域的比例平移（拖动），画面随鼠标移动
+    void pan(const QPointF &viewDelta);
+    void reset();
+
+    // 整帧中的显示区域（归一化），未放大时为空
+    QRectF roi() const;
+    // 整帧中的归一化区域映射到显示区域（归一化），用于在放大的预览上绘制叠加框
+    QRectF mapToView(const QRectF &frameRect) const;
+
+private:
+    void clampCenter();
+
+    double m_factor;
+    QPointF m_center;
+};
+
+// 归一化区域换算为像素区域并按格式对齐：YUYV左边界和宽度为2的倍数，
+// MJPEG向外扩展到16像素（MCU）边界，便于解码器跳过区域外的MCU行。roi为空时返回整帧
+QRect cropRegion(const QRectF &roi, const QSize &frameSize, FramePixelFormat format);
+
+// 把帧裁剪为region（录制用）：YUYV/RGB32把区域内的行紧凑地拷贝到buffer（可以跨帧复用），
+// MJPEG按区域解码后重新编码为JPEG（质量jpegQuality）。region为整帧、格式不支持或数据不完整时返回false，packet不变
+bool cropPacket(FramePacket *packet, const QRect &region, QByteArray *buffer, int jpegQuality = 90);
@@ -0,0 +1,207 @@
+#include "DirectShowDeviceControl.h"
+#include <QRegularExpression>
+
+namespace {
+    // 电力线频率不在IAMVideoProcAmp的枚举中，UVC驱动按属性ID 11提供
+    const long VIDEO_PROC_AMP_POWERLINE_FREQUENCY = 11;
+}
+
+DirectShowDeviceControl::DirectShowDeviceControl()
+    : m_comInitialized(false),
+      m_filter(nullptr),
+      m_videoProcAmp(nullptr),
+      m_cameraControl(nullptr)
+{
+}
+
+DirectShowDeviceControl::~DirectShowDeviceControl()
+{
+    // 释放DirectShow接口
+    if (m_videoProcAmp) {
+        m_videoProcAmp->Release();
+    }
+    if (m_cameraControl) {
+        m_cameraControl->Release();
+    }
+    if (m_filter) {
+        m_filter->Release();
+    }
+    if (m_comInitialized) {
+        CoUninitialize();
+    }
+}
+
+bool DirectShowDeviceControl::open(const QString &devicePath)
+{
+    // 初始化COM
+    HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    if (FAILED(hr)) {
+        switch (hr) {
+            case RPC_E_CHANGED_MODE:
+                m_errorString = "COM库已经初始化为单线程模式";
+                break;
+            case E_OUTOFMEMORY:
+                m_errorString = "内存不足，无法初始化COM";
+                break;
+            default:
+                m_errorString = "COM初始化失败，错误码: " + QString::number(hr, 16);
+                break;
+        }
+        return false;
+    }
+    m_comInitialized = true;
+
+    // 创建系统设备枚举器
+    ICreateDevEnum *devEnum = nullptr;
+    hr = CoCreateInstance(CLSID_SystemDeviceEnum, NULL, CLSCTX_INPROC_SERVER,
+                          IID_ICreateDevEnum, (void**)&devEnum);
+    if (FAILED(hr)) {
+        m_errorString = "无法创建设备枚举器";
+        return false;
+    }
+
+    // 创建视频输入设备枚举器
+    IEnumMoniker *enumMoniker = nullptr;
+    hr = devEnum->CreateClassEnumerator(CLSID_VideoInputDeviceCategory, &enumMoniker, 0);
+    devEnum->Release();
+    if (hr != S_OK) {
+        m_errorString = "没有找到视频输入设备";
+        return false;
+    }
+
+    // 按VID/PID匹配设备路径
+    const QRegularExpression re("vid_(\\w+)&pid_(\\w+)");
+    const QRegularExpressionMatch targetMatch = re.match(devicePath.toLower());
+    IMoniker *moniker = nullptr;
+    ULONG fetched = 0;
+    while (!m_filter && enumMoniker->Next(1, &moniker, &fetched) == S_OK) {
+        IPropertyBag *propertyBag = nullptr;
+        hr = moniker->BindToStorage(0, 0, IID_IPropertyBag, (void**)&propertyBag);
+        if (SUCCEEDED(hr)) {
+            VARIANT varPath;
+            VariantInit(&varPath);
+            hr = propertyBag->Read(L"DevicePath", &varPath, 0);
+            if (SUCCEEDED(hr)) {
+                const QString currentPath = QString::fromWCharArray(varPath.bstrVal);
+                const QRegularExpressionMatch match = re.match(currentPath.toLower());
+                if (match.hasMatch() && targetMatch.hasMatch()
+                    && match.captured(1) == targetMatch.captured(1)
+                    && match.captured(2) == targetMatch.captured(2)) {
+                    hr = moniker->BindToObject(NULL, NULL, IID_IBaseFilter, (void**)&m_filter);
+                    if (FAILED(hr)) {
+                        m_filter = nullptr;
+                    }
+                }
+            }
+            VariantClear(&varPath);
+            propertyBag->Release();
+        }
+        moniker->Release();
+    }
+    enumMoniker->Release();
+
+    if (!m_filter) {
+        m_errorString = "未找到指定的摄像头设备";
+        return false;
+    }
+
+    // 两个接口都是可选的，不支持的摄像头只是少一组参数
+    if (FAILED(m_filter->QueryInterface(IID_IAMVideoProcAmp, (void**)&m_videoProcAmp))) {
+        m_videoProcAmp = nullptr;
+    }
+    if (FAILED(m_filter->QueryInterface(IID_IAMCameraControl, (void**)&m_cameraControl))) {
+        m_cameraControl = nullptr;
+    }
+    return true;
+}
+
+QString DirectShowDeviceControl::errorString() const
+{
+    return m_errorString;
+}
+
+bool DirectShowDeviceControl::isSupported(CameraProperty property) const
+{
+    return isCameraControl(property) ? m_cameraControl != nullptr : m_videoProcAmp != nullptr;
+}
+
+bool DirectShowDeviceControl::range(CameraProperty property, CameraPropertyRange *range) const
+{
+    *range = CameraPropertyRange();
+    long flags = 0;
+    HRESULT hr = E_NOINTERFACE;
+    if (isCameraControl(property) && m_cameraControl) {
+        hr = m_cameraControl->GetRange(propertyId(property), &range->minimum, &range->maximum,
+                                       &range->step, &range->defaultValue, &flags);
+        if (SUCCEEDED(hr)) {
+            range->canAuto = (flags & CameraControl_Flags_Auto) != 0;
+            range->canManual = (flags & CameraControl_Flags_Manual) != 0;
+        }
+    } else if (!isCameraControl(property) && m_videoProcAmp) {
+        hr = m_videoProcAmp->GetRange(propertyId(property), &range->minimum, &range->maximum,
+                                      &range->step, &range->defaultValue, &flags);
+        if (SUCCEEDED(hr)) {
+            range->canAuto = (flags & VideoProcAmp_Flags_Auto) != 0;
+            range->canManual = (flags & VideoProcAmp_Flags_Manual) != 0;
+        }
+    }
+    if (FAILED(hr)) {
+        *range = CameraPropertyRange();
+        return false;
+    }
+    return true;
+}
+
+bool DirectShowDeviceControl::value(CameraProperty property, long *value, bool *autoMode) const
+{
+    long flags = 0;
+    HRESULT hr = E_NOINTERFACE;
+    if (isCameraControl(property) && m_cameraControl) {
+        hr = m_cameraControl->Get(propertyId(property), value, &flags);
+        if (autoMode) {
+            *autoMode = (flags & CameraControl_Flags_Auto) != 0;
+        }
+    } else if (!isCameraControl(property) && m_videoProcAmp) {
+        hr = m_videoProcAmp->Get(propertyId(property), value, &flags);
+        if (autoMode) {
+            *autoMode = (flags & VideoProcAmp_Flags_Auto) != 0;
+        }
+    }
+    return SUCCEEDED(hr);
+}
+
+bool DirectShowDeviceControl::setValue(CameraProperty property, long value, bool autoMode)
+{
+    HRESULT hr = E_NOINTERFACE;
+    if (isCameraControl(property) && m_cameraControl) {
+        hr = m_cameraControl->Set(propertyId(property), value,
+                                  autoMode ? CameraControl_Flags_Auto : CameraControl_Flags_Manual);
+    } else if (!isCameraControl(property) && m_videoProcAmp) {
+        hr = m_videoProcAmp->Set(propertyId(property), value,
+                                 autoMode ? VideoProcAmp_Flags_Auto : VideoProcAmp_Flags_Manual);
+    }
+    return SUCCEEDED(hr);
+}
+
+long DirectShowDeviceControl::propertyId(CameraProperty property)
+{
+    switch (property) {
+        case CameraProperty::Brightness: return VideoProcAmp_Brightness;
+        case CameraProperty::Contrast: return VideoProcAmp_Contrast;
+        case CameraProperty::Hue: return VideoProcAmp_Hue;
+        case CameraProperty::Saturation: return VideoProcAmp_Saturation;
+        case CameraProperty::Sharpness: return VideoProcAmp_Sharpness;
+        case CameraProperty::Gamma: return VideoProcAmp_Gamma;
+        case CameraProperty::WhiteBalance: return VideoProcAmp_WhiteBalance;
+        case CameraProperty::Gain: return VideoProcAmp_Gain;
+        case CameraProperty::PowerLineFrequency: return VIDEO_PROC_AMP_POWERLINE_FREQUENCY;
+        case CameraProperty::Pan: return CameraControl_Pan;
+        case CameraProperty::Tilt: return CameraControl_Tilt;
+        case CameraProperty::Roll: return CameraControl_Roll;
+        case CameraProperty::Zoom: return CameraControl_Zoom;
+        case CameraProperty::Exposure: return CameraControl_Exposure;
+        case CameraProperty::Iris: return CameraControl_Iris;
+        case CameraProperty::Focus: return CameraControl_Focus;
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "CameraDeviceControl.h"
+
+// Windows DirectShow头文件
+#include <dshow.h>
+#include <strmif.h>
+#include <control.h>
+
+// DirectShow实现：按设备路径中的VID/PID找到视频输入设备，通过IAMVideoProcAmp和IAMCameraControl读写参数
+class DirectShowDeviceControl : public CameraDeviceControl {
+public:
+    DirectShowDeviceControl();
+    ~DirectShowDeviceControl() override;
+
+    bool open(const QString &devicePath);
+    QString errorString() const;
+
+    bool isSupported(CameraProperty property) const override;
+    bool range(CameraProperty property, CameraPropertyRange *range) const override;
+    bool value(CameraProperty property, long *value, bool *autoMode = nullptr) const override;
+    bool setValue(CameraProperty property, long value, bool autoMode = false) override;
+
+private:
+    static long propertyId(CameraProperty property);
+
+    bool m_comInitialized;
+    IBaseFilter *m_filter;
+    IAMVideoProcAmp *m_videoProcAmp;
+    IAMCameraControl *m_cameraControl;
+    QString m_errorString;
+};
@@ -0,0 +1,138 @@
+#include "ExposureStats.h"
+#include "FrameConvert.h"
+#include <QImage>
+#include <cmath>
+
+namespace {
+    // 只用于统计均值，解码得越小越省时
+    const QSize MJPEG_STATS_SIZE(320, 180);
+
+    // 参与白平衡统计的范围：太暗的像素噪声大，接近饱和的像素颜色已经失真
+    const int NEUTRAL_MIN_LUMA = 32;
+    const int NEUTRAL_MAX_CHANNEL = 235;
+    const int CLIPPED_LEVEL = 250;
+
+    struct StatsAccumulator {
+        double lumaSum = 0;
+        double weightSum = 0;
+        double redSum = 0;
+        double greenSum = 0;
+        double blueSum = 0;
+        quint32 neutral = 0;
+        quint32 clipped = 0;
+        quint32 samples = 0;
+
+        void add(int r, int g, int b, bool centre)
+        {
+            const int luma = (77 * r + 150 * g + 29 * b + 128) >> 8;
+            const double weight = centre ? 2.0 : 1.0;
+            lumaSum += luma * weight;
+            weightSum += weight;
+            const int maxChannel = qMax(r, qMax(g, b));
+            if (maxChannel >= CLIPPED_LEVEL) {
+                clipped++;
+            }
+            if (luma >= NEUTRAL_MIN_LUMA && maxChannel <= NEUTRAL_MAX_CHANNEL) {
+                redSum += r;
+                greenSum += g;
+                blueSum += b;
+                neutral++;
+            }
+            samples++;
+        }
+    };
+
+    inline int clampChannel(int value)
+    {
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    // 稀疏网格的间距，使采样数不超过maxSamples
+    int gridStep(const QSize &size, int maxSamples)
+    {
+        const double pixels = double(size.width()) * size.height();
+        return qMax(1, int(std::ceil(std::sqrt(pixels / qMax(1, maxSamples)))));
+    }
+
+    inline bool inCentre(int x, int y, const QSize &size)
+    {
+        return x >= size.width() / 4 && x < size.width() * 3 / 4 &&
+               y >= size.height() / 4 && y < size.height() * 3 / 4;
+    }
+
+    void accumulateRgb32(const QImage &image, int maxSamples, StatsAccumulator *acc)
+    {
+        const int step = gridStep(image.size(), maxSamples);
+        for (int y = step / 2; y < image.height(); y += step) {
+            const quint32 *row = reinterpret_cast<const quint32*>(image.constScanLine(y));
+            for (int x = step / 2; x < image.width(); x += step) {
+                const quint32 p = row[x];
+                acc->add((p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF, inCentre(x, y, image.size()));
+            }
+        }
+    }
+}
+
+bool computeExposureStats(const FramePacket &packet, ExposureStats *stats, int maxSamples)
+{
+    const qint64 begin = monotonicUs();
+    *stats = ExposureStats();
+    stats->captureUs = packet.captureUs;
+    StatsAccumulator acc;
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return false;
+            }
+            const uchar *data = reinterpret_cast<const uchar*>(packet.data.constData());
+            const int step = gridStep(packet.size, maxSamples);
+            for (int y = step / 2; y < packet.size.height(); y += step) {
+                const uchar *row = data + qsizetype(y) * packet.bytesPerLine;
+                for (int x = step / 2; x < packet.size.width(); x += step) {
+                    // 每对像素共用UV：Y0 U Y1 V
+                    const uchar *pair = row + (x & ~1) * 2;
+                    const int c = (row[x * 2] - 16) * 298;
+                    const int d = pair[1] - 128;
+                    const int e = pair[3] - 128;
+                    acc.add(clampChannel((c + 409 * e + 128) >> 8),
+                            clampChannel((c - 100 * d - 208 * e + 128) >> 8),
+                            clampChannel((c + 516 * d + 128) >> 8),
+                            inCentre(x, y, packet.size));
+                }
+            }
+            break;
+        }
+        case FramePixelFormat::MJPEG: {
+            const QImage image = packetToPreview(packet, MJPEG_STATS_SIZE);
+            if (image.isNull()) {
+                return false;
+            }
+            accumulateRgb32(image.convertToFormat(QImage::Format_RGB32), maxSamples, &acc);
+            break;
+        }
+        case FramePixelFormat::RGB32: {
+            const QImage image(reinterpret_cast<const uchar*>(packet.data.constData()),
+                               packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                               QImage::Format_RGB32);
+            accumulateRgb32(image, maxSamples, &acc);
+            break;
+        }
+        default:
+            return false;
+    }
+
+    stats->samples = acc.samples;
+    if (acc.samples > 0) {
+        stats->meanLuma = acc.lumaSum / acc.weightSum;
+        stats->clippedHighPercent = acc.clipped * 100.0 / acc.samples;
+    }
+    stats->neutralSamples = acc.neutral;
+    if (acc.neutral > 0) {
+        stats->meanRed = acc.redSum / acc.neutral;
+        stats->meanGreen = acc.greenSum / acc.neutral;
+        stats->meanBlue = acc.blueSum / acc.neutral;
+    }
+    stats->computeUs = monotonicUs() - begin;
+    return stats->isValid();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <QtGlobal>
+#include "FramePacket.h"
+
+// 软件自动曝光/白平衡用的画面统计
+struct ExposureStats {
+    double meanLuma = 0;            // 中央加权的平均亮度（0~255，中央1/2区域权重为2）
+    double meanRed = 0;             // 以下三项只统计亮度适中、没有饱和的像素（灰世界白平衡）
+    double meanGreen = 0;
+    double meanBlue = 0;
+    quint32 neutralSamples = 0;     // 参与白平衡统计的采样数
+    double clippedHighPercent = 0;  // 任一通道达到250的采样比例
+    quint32 samples = 0;
+    qint64 captureUs = 0;           // 对应帧进入管线的时间，调节器用来跳过参数生效前的帧
+    qint64 computeUs = 0;
+
+    bool isValid() const { return samples > 0; }
+};
+
+// 按稀疏网格采样统计（默认约1.6万个采样，每帧约0.2 ms，与分辨率基本无关）
+// YUYV直接读取原始数据，MJPEG先缩小解码到320x180以内，RGB32直接采样；不支持的格式返回false
+bool computeExposureStats(const FramePacket &packet, ExposureStats *stats, int maxSamples = 16384);
@@ -0,0 +1,24 @@
+#include "FileSync.h"
+#include <QFile>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+bool syncFileToDisk(const QString &filePath)
+{
+    // 以写方式打开已有文件（不截断），对文件句柄执行同步
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    const bool ok = _commit(file.handle()) == 0;
+#else
+    const bool ok = ::fsync(file.handle()) == 0;
+#endif
+    file.close();
+    return ok;
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include <QString>
+
+// 把文件在操作系统缓存中的数据同步写入磁盘（POSIX fsync / Windows _commit）
+bool syncFileToDisk(const QString &filePath);
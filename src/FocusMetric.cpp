@@ -0,0 +1,223 @@
+#include "FocusMetric.h"
+#include "FrameConvert.h"
+#include <cstdlib>
+#include <vector>
+
+#include "SimdSupport.h"
+
+namespace {
+    // MJPEG缩小解码的尺寸上限，与直方图相同（640x360）
+    const QSize MJPEG_FOCUS_SIZE(640, 360);
+
+    // 默认统计画面中央1/3区域
+    const QRectF DEFAULT_ROI(1.0 / 3, 1.0 / 3, 1.0 / 3, 1.0 / 3);
+
+    // 归一化区域换算为像素区域，并留出一像素边框供中心差分使用
+    QRect focusRegion(const QRectF &roi, const QSize &size)
+    {
+        const QRectF normalized = effectiveFocusRoi(roi);
+        const QRect region(qRound(normalized.x() * size.width()), qRound(normalized.y() * size.height()),
+                           qRound(normalized.width() * size.width()), qRound(normalized.height() * size.height()));
+        return region.intersected(QRect(1, 1, size.width() - 2, size.height() - 2));
+    }
+
+    // 一行的梯度平方和。三行数据都是每像素2字节、亮度在低字节（YUYV原始数据和亮度缓冲区通用），
+    // 只统计[first, last)列，调用方保证first >= 1且last <= 宽度-1
+    quint64 tenengradRow(const uchar *up, const uchar *mid, const uchar *down, int first, int last)
+    {
+        quint64 sum = 0;
+        int x = first;
+#ifdef CAMERA_HAVE_SSE2
+        const __m128i lowByte = _mm_set1_epi16(0xFF);
+        // 每次8个像素，每个32位通道累加两个像素的gx²+gy²，一行最多约26万次，不会溢出
+        __m128i acc = _mm_setzero_si128();
+        for (; x + 8 <= last; x += 8) {
+            const __m128i left = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + (x - 1) * 2)), lowByte);
+            const __m128i right = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + (x + 1) * 2)), lowByte);
+            const __m128i above = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x * 2)), lowByte);
+            const __m128i below = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x * 2)), lowByte);
+            const __m128i gx = _mm_sub_epi16(right, left);
+            const __m128i gy = _mm_sub_epi16(below, above);
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(gx, gx), _mm_madd_epi16(gy, gy)));
+        }
+        alignas(16) quint32 lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        sum += quint64(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+        for (; x < last; ++x) {
+            const int gx = mid[(x + 1) * 2] - mid[(x - 1) * 2];
+            const int gy = down[x * 2] - up[x * 2];
+            sum += gx * gx + gy * gy;
+        }
+        return sum;
+    }
+
+    // RGB32一行换算为亮度（BT.601，8位定点），每像素一个quint16
+    void rgb32ToLuma(const uchar *src, quint16 *dst, int width)
+    {
+        const quint32 *pixels = reinterpret_cast<const quint32*>(src);
+        int x = 0;
+#ifdef CAMERA_HAVE_SSE2
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        for (; x + 8 <= width; x += 8) {
+            const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+            const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x + 4));
+            const __m128i b = _mm_packs_epi32(_mm_and_si128(p0, byteMask), _mm_and_si128(p1, byteMask));
+            const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), byteMask),
+                                              _mm_and_si128(_mm_srli_epi32(p1, 8), byteMask));
+            const __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), byteMask),
+                                              _mm_and_si128(_mm_srli_epi32(p1, 16), byteMask));
+            // 加权和最大65408，按无符号16位计算不会溢出
+            __m128i luma = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(77)), _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+            luma = _mm_add_epi16(luma, _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+            luma = _mm_srli_epi16(_mm_add_epi16(luma, _mm_set1_epi16(128)), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), luma);
+        }
+#endif
+        for (; x < width; ++x) {
+            const quint32 p = pixels[x];
+            dst[x] = quint16((77 * ((p >> 16) & 0xFF) + 150 * ((p >> 8) & 0xFF) + 29 * (p & 0xFF) + 128) >> 8);
+        }
+    }
+
+    // 统计每像素2字节数据上的区域，rowAt返回第y行的起始地址
+    template <typename RowAt>
+    void accumulateRegion(const QRect &region, int maxSamples, RowAt rowAt, quint64 *sum, quint32 *samples)
+    {
+        const qint64 total = qint64(region.width()) * region.height();
+        const int rowStep = qMax(1, int((total + maxSamples - 1) / qMax(1, maxSamples)));
+        for (int y = region.top(); y <= region.bottom(); y += rowStep) {
+            *sum += tenengradRow(rowAt(y - 1), rowAt(y), rowAt(y + 1), region.left(), region.right() + 1);
+            *samples += region.width();
+        }
+    }
+
+    // RGB32图像：只换算区域上下各多一行的亮度
+    void accumulateRgb32(const QImage &image, const QRectF &roi, int maxSamples, FocusMeasure *measure, quint64 *sum)
+    {
+        measure->roi = focusRegion(roi, image.size());
+        if (measure->roi.isEmpty()) {
+            return;
+        }
+        const int firstRow = measure->roi.top() - 1;
+        const int rows = measure->roi.height() + 2;
+        std::vector<quint16> luma(size_t(image.width()) * rows);
+        for (int i = 0; i < rows; ++i) {
+            rgb32ToLuma(image.constScanLine(firstRow + i), luma.data() + size_t(i) * image.width(), image.width());
+        }
+        const uchar *base = reinterpret_cast<const uchar*>(luma.data());
+        const int stride = image.width() * 2;
+        accumulateRegion(measure->roi, maxSamples, [&](int y) {
+            return base + qsizetype(y - firstRow) * stride;
+        }, sum, &measure->samples);
+    }
+}
+
+QRectF effectiveFocusRoi(const QRectF &roi)
+{
+    return roi.isEmpty() ? DEFAULT_ROI : roi;
+}
+
+bool computeFocus(const FramePacket &packet, const QRectF &roi, FocusMeasure *measure, int maxSamples)
+{
+    const qint64 begin = monotonicUs();
+    *measure = FocusMeasure();
+    measure->sequence = packet.sequence;
+    measure->captureUs = packet.captureUs;
+    quint64 sum = 0;
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return false;
+            }
+            // 亮度就是每两个字节中的第一个，直接在原始数据上计算
+            measure->roi = focusRegion(roi, packet.size);
+            if (measure->roi.isEmpty()) {
+                return false;
+            }
+            const uchar *data = reinterpret_cast<const uchar*>(packet.data.constData());
+            accumulateRegion(measure->roi, maxSamples, [&](int y) {
+                return data + qsizetype(y) * packet.bytesPerLine;
+            }, &sum, &measure->samples);
+            break;
+        }
+        case FramePixelFormat::MJPEG: {
+            const QImage image = packetToPreview(packet, MJPEG_FOCUS_SIZE);
+            if (image.isNull()) {
+                return false;
+            }
+            accumulateRgb32(image.convertToFormat(QImage::Format_RGB32), roi, maxSamples, measure, &sum);
+            break;
+        }
+        case FramePixelFormat::RGB32: {
+            const QImage image(reinterpret_cast<const uchar*>(packet.data.constData()),
+                               packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                               QImage::Format_RGB32);
+            accumulateRgb32(image, roi, maxSamples, measure, &sum);
+            break;
+        }
+        default:
+            return false;
+    }
+
+    if (measure->samples > 0) {
+        measure->sharpness = double(sum) / measure->samples;
+    }
+    measure->computeUs = monotonicUs() - begin;
+    return measure->isValid();
+}
+
+void applyFocusPeaking(QImage *image, int threshold, QRgb color)
+{
+    if (image->isNull() || image->width() < 3 || image->height() < 3) {
+        return;
+    }
+    if (image->format() != QImage::Format_RGB32 && image->format() != QImage::Format_ARGB32) {
+        *image = image->convertToFormat(QImage::Format_RGB32);
+    }
+    const int width = image->width();
+    const int height = image->height();
+
+    // 先换算整幅图的亮度，涂色时不影响相邻像素的梯度
+    std::vector<quint16> luma(size_t(width) * height);
+    for (int y = 0; y < height; ++y) {
+        rgb32ToLuma(image->constScanLine(y), luma.data() + size_t(y) * width, width);
+    }
+
+    for (int y = 1; y < height - 1; ++y) {
+        const quint16 *up = luma.data() + size_t(y - 1) * width;
+        const quint16 *mid = luma.data() + size_t(y) * width;
+        const quint16 *down = luma.data() + size_t(y + 1) * width;
+        quint32 *row = reinterpret_cast<quint32*>(image->scanLine(y));
+        int x = 1;
+#ifdef CAMERA_HAVE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi16(qint16(threshold));
+        for (; x + 8 <= width - 1; x += 8) {
+            const __m128i gx = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x + 1)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x - 1)));
+            const __m128i gy = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x)));
+            // SSE2没有16位绝对值指令，用max(g, -g)
+            const __m128i magnitude = _mm_add_epi16(_mm_max_epi16(gx, _mm_sub_epi16(zero, gx)),
+                                                    _mm_max_epi16(gy, _mm_sub_epi16(zero, gy)));
+            const int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(magnitude, limit));
+            if (mask == 0) {
+                continue;
+            }
+            for (int i = 0; i < 8; ++i) {
+                if (mask & (1 << (i * 2))) {
+                    row[x + i] = color;
+                }
+            }
+        }
+#endif
+        for (; x < width - 1; ++x) {
+            const int magnitude = std::abs(mid[x + 1] - mid[x - 1]) + std::abs(down[x] - up[x]);
+            if (magnitude > threshold) {
+                row[x] = color;
+            }
+        }
+    }
+}
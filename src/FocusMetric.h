@@ -0,0 +1,30 @@
+#pragma once
+#include <QtGlobal>
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+#include "FramePacket.h"
+
+// 对焦清晰度（Tenengrad：感兴趣区域内亮度中心差分梯度平方和的均值）
+// 数值只在同一摄像头、同一格式和分辨率下可比，用于对焦时找峰值
+struct FocusMeasure {
+    double sharpness = 0;
+    quint32 samples = 0;
+    QRect roi;              // 实际统计的区域（统计图像的像素坐标）
+    qint64 computeUs = 0;
+    qint64 captureUs = 0;   // 对应帧进入管线的时间，对焦扫描用来判断镜头是否已经到位
+    quint64 sequence = 0;
+
+    bool isValid() const { return samples > 0; }
+};
+
+// 计算roi（相对画面的归一化坐标，空矩形表示中央1/3区域）内的清晰度，采样数不超过maxSamples（隔行）
+// YUYV直接读取原始数据的亮度字节（支持SSE2时每次处理8个像素），
+// MJPEG先缩小解码到640x360以内，RGB32先换算亮度；不支持的格式返回false
+bool computeFocus(const FramePacket &packet, const QRectF &roi, FocusMeasure *measure, int maxSamples = 262144);
+
+// 实际使用的统计区域（归一化坐标）：roi为空时返回中央1/3区域
+QRectF effectiveFocusRoi(const QRectF &roi);
+
+// 峰值对焦：在RGB32图像上把亮度梯度（|gx|+|gy|）超过threshold的像素涂成color，用于预览叠加
+void applyFocusPeaking(QImage *image, int threshold, QRgb color);
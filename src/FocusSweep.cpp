@@ -0,0 +1,179 @@
+#include "FocusSweep.h"
+#include "FrameAnalyzer.h"
+#include "FramePacket.h"
+
+namespace {
+    const int COARSE_POSITIONS = 12;
+    const int FINE_POSITIONS = 8;
+    // 对焦电机移动和曝光延迟，之前进入管线的帧不计入
+    const qint64 SETTLE_US = 150000;
+    const int SAMPLES_PER_POSITION = 2;
+    // 超过这个时间没有新的清晰度结果（没有画面）就放弃
+    const int TIMEOUT_MS = 2000;
+}
+
+FocusSweep::FocusSweep(FrameAnalyzer *analyzer, QObject *parent)
+    : QObject(parent),
+      m_analyzer(analyzer),
+      m_originalValue(0),
+      m_originalAuto(false),
+      m_running(false),
+      m_fine(false),
+      m_index(0),
+      m_settleUntilUs(0),
+      m_sampleSum(0),
+      m_sampleCount(0),
+      m_step(0),
+      m_coarseInterval(0),
+      m_bestPosition(0),
+      m_bestSharpness(0)
+{
+    m_timeout.setSingleShot(true);
+    m_timeout.setInterval(TIMEOUT_MS);
+    connect(&m_timeout, &QTimer::timeout, this, &FocusSweep::handleTimeout);
+    // 分析线程发出的信号排队到本对象所在线程
+    connect(m_analyzer, &FrameAnalyzer::focusUpdated, this, &FocusSweep::handleFocusUpdated);
+}
+
+FocusSweep::~FocusSweep()
+{
+    if (m_running) {
+        restore();
+        m_analyzer->removeFocusUser();
+    }
+}
+
+bool FocusSweep::start(std::shared_ptr<CameraDeviceControl> control, QString *error)
+{
+    if (m_running) {
+        if (error) *error = "对焦扫描正在进行";
+        return false;
+    }
+    if (!control || !control->isSupported(CameraProperty::Focus)) {
+        if (error) *error = "设备不支持对焦控制";
+        return false;
+    }
+    if (!control->range(CameraProperty::Focus, &m_range) || m_range.maximum <= m_range.minimum) {
+        if (error) *error = "无法读取对焦范围";
+        return false;
+    }
+    if (!control->value(CameraProperty::Focus, &m_originalValue, &m_originalAuto)) {
+        if (error) *error = "无法读取当前对焦值";
+        return false;
+    }
+
+    m_control = std::move(control);
+    m_running = true;
+    m_fine = false;
+    m_step = 0;
+    m_bestPosition = m_originalValue;
+    m_bestSharpness = -1;
+    m_positions = positionsBetween(m_range.minimum, m_range.maximum, COARSE_POSITIONS);
+    m_coarseInterval = (m_range.maximum - m_range.minimum) / (COARSE_POSITIONS - 1);
+    m_analyzer->addFocusUser();
+    moveTo(0);
+    return true;
+}
+
+void FocusSweep::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+    restore();
+    finish(false, "对焦扫描已取消");
+}
+
+bool FocusSweep::isRunning() const
+{
+    return m_running;
+}
+
+// [from, to]内等间隔取count个位置，按设备步长取整，去掉重复
+QList<long> FocusSweep::positionsBetween(long from, long to, int count) const
+{
+    QList<long> positions;
+    const long step = qMax(1L, m_range.step);
+    for (int i = 0; i < count; ++i) {
+        const double value = from + double(to - from) * i / qMax(1, count - 1);
+        long position = m_range.minimum + qRound64((value - m_range.minimum) / step) * step;
+        position = qBound(m_range.minimum, position, m_range.maximum);
+        if (positions.isEmpty() || positions.last() != position) {
+            positions.append(position);
+        }
+    }
+    return positions;
+}
+
+void FocusSweep::moveTo(int index)
+{
+    m_index = index;
+    m_sampleSum = 0;
+    m_sampleCount = 0;
+    m_control->setValue(CameraProperty::Focus, m_positions[index], false);
+    m_settleUntilUs = monotonicUs() + SETTLE_US;
+    m_timeout.start();
+}
+
+void FocusSweep::handleFocusUpdated()
+{
+    if (!m_running) {
+        return;
+    }
+    const FocusMeasure measure = m_analyzer->focus();
+    if (!measure.isValid() || measure.captureUs < m_settleUntilUs) {
+        return;
+    }
+    m_timeout.start();
+    m_sampleSum += measure.sharpness;
+    if (++m_sampleCount < SAMPLES_PER_POSITION) {
+        return;
+    }
+
+    const long position = m_positions[m_index];
+    const double sharpness = m_sampleSum / m_sampleCount;
+    if (sharpness > m_bestSharpness) {
+        m_bestSharpness = sharpness;
+        m_bestPosition = position;
+    }
+    emit progress(++m_step, COARSE_POSITIONS + FINE_POSITIONS, position, sharpness);
+
+    if (m_index + 1 < m_positions.size()) {
+        moveTo(m_index + 1);
+        return;
+    }
+    if (!m_fine && m_coarseInterval > m_range.step) {
+        // 粗扫结束，在峰值两侧细扫
+        m_fine = true;
+        m_positions = positionsBetween(qMax(m_range.minimum, m_bestPosition - m_coarseInterval),
+                                       qMin(m_range.maximum, m_bestPosition + m_coarseInterval),
+                                       FINE_POSITIONS);
+        moveTo(0);
+        return;
+    }
+    m_control->setValue(CameraProperty::Focus, m_bestPosition, false);
+    finish(true, QString("对焦完成：位置 %1，清晰度 %2").arg(m_bestPosition).arg(m_bestSharpness, 0, 'f', 1));
+}
+
+void FocusSweep::handleTimeout()
+{
+    if (!m_running) {
+        return;
+    }
+    restore();
+    finish(false, "等待画面超时，对焦扫描已停止");
+}
+
+void FocusSweep::restore()
+{
+    m_control->setValue(CameraProperty::Focus, m_originalValue, m_originalAuto);
+}
+
+void FocusSweep::finish(bool success, const QString &message)
+{
+    m_running = false;
+    m_timeout.stop();
+    m_analyzer->removeFocusUser();
+    m_control.reset();
+    emit finished(success, success ? m_bestPosition : m_originalValue, m_bestSharpness, message);
+}
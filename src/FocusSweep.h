@@ -0,0 +1,59 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QList>
+#include <QString>
+#include <memory>
+#include "CameraDeviceControl.h"
+
+class FrameAnalyzer;
+
+// 软件对焦扫描
+// 关闭自动对焦后分两轮移动对焦：粗扫在全范围内等间隔取12个位置，细扫在粗扫峰值两侧各一个间隔内取8个位置。
+// 每个位置等待镜头稳定（150毫秒）后取2帧清晰度的平均，最后停在清晰度最高的位置。
+// 清晰度来自FrameAnalyzer，扫描期间自己登记为对焦使用者；失败或取消时恢复开始前的对焦值和自动模式。
+class FocusSweep : public QObject {
+    Q_OBJECT
+public:
+    // analyzer必须比本对象存活得久
+    explicit FocusSweep(FrameAnalyzer *analyzer, QObject *parent = nullptr);
+    ~FocusSweep();
+
+    // 设备不支持对焦、读取失败或已在扫描时返回false，原因写入error
+    bool start(std::shared_ptr<CameraDeviceControl> control, QString *error = nullptr);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    // step从1开始，每测完一个位置发出一次
+    void progress(int step, int totalSteps, long position, double sharpness);
+    void finished(bool success, long position, double sharpness, const QString &message);
+
+private slots:
+    void handleFocusUpdated();
+    void handleTimeout();
+
+private:
+    QList<long> positionsBetween(long from, long to, int count) const;
+    void moveTo(int index);
+    void restore();
+    void finish(bool success, const QString &message);
+
+    FrameAnalyzer *m_analyzer;
+    std::shared_ptr<CameraDeviceControl> m_control;
+    QTimer m_timeout;
+    CameraPropertyRange m_range;
+    long m_originalValue;
+    bool m_originalAuto;
+    bool m_running;
+    bool m_fine;
+    QList<long> m_positions;
+    int m_index;
+    qint64 m_settleUntilUs;
+    double m_sampleSum;
+    int m_sampleCount;
+    int m_step;
+    long m_coarseInterval;
+    long m_bestPosition;
+    double m_bestSharpness;
+};
@@ -0,0 +1,96 @@
+#include "FormatIndex.h"
+#include "FormatSelector.h"
+#include <algorithm>
+#include <climits>
+
+FormatIndex::FormatIndex(const QList<QCameraFormat> &formats)
+{
+    for (const QCameraFormat &format : formats) {
+        if (format.pixelFormat() == QVideoFrameFormat::Format_YUYV
+            || format.pixelFormat() == QVideoFrameFormat::Format_Jpeg) {
+            m_formats << format;
+        }
+    }
+}
+
+bool FormatIndex::isEmpty() const
+{
+    return m_formats.isEmpty();
+}
+
+QList<QCameraFormat> FormatIndex::formats() const
+{
+    return m_formats;
+}
+
+QStringList FormatIndex::pixelFormatLabels() const
+{
+    QStringList labels;
+    for (const QCameraFormat &format : m_formats) {
+        const QString label = FormatSelector::pixelFormatLabel(format.pixelFormat());
+        if (!labels.contains(label)) {
+            labels << label;
+        }
+    }
+    labels.sort();
+    return labels;
+}
+
+QList<QSize> FormatIndex::resolutions(const QString &label) const
+{
+    QList<QSize> result;
+    for (const QCameraFormat &format : m_formats) {
+        if (matches(format, label) && !result.contains(format.resolution())) {
+            result << format.resolution();
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const QSize &a, const QSize &b) {
+        return qint64(a.width()) * a.height() > qint64(b.width()) * b.height();
+    });
+    return result;
+}
+
+int FormatIndex::maxFrameRate(const QString &label, const QSize &resolution) const
+{
+    int maxFps = 0;
+    for (const QCameraFormat &format : m_formats) {
+        if (matches(format, label) && (!resolution.isValid() || format.resolution() == resolution)) {
+            maxFps = qMax(maxFps, qRound(format.maxFrameRate()));
+        }
+    }
+    return maxFps;
+}
+
+QCameraFormat FormatIndex::find(QVideoFrameFormat::PixelFormat pixelFormat, const QSize &resolution, int fps) const
+{
+    QCameraFormat best;
+    int bestFpsDiff = INT_MAX;
+    for (const QCameraFormat &format : m_formats) {
+        if (format.pixelFormat() != pixelFormat || format.resolution() != resolution) {
+            continue;
+        }
+        const int fpsDiff = qAbs(qRound(format.maxFrameRate()) - fps);
+        if (fpsDiff < bestFpsDiff) {
+            bestFpsDiff = fpsDiff;
+            best = format;
+        }
+    }
+    return best;
+}
+
+QVideoFrameFormat::PixelFormat FormatIndex::pixelFormatFromName(const QString &name)
+{
+    const QString lower = name.toLower();
+    if (lower == "yuyv" || lower == "yuy2") {
+        return QVideoFrameFormat::Format_YUYV;
+    }
+    if (lower == "mjpeg" || lower == "jpeg") {
+        return QVideoFrameFormat::Format_Jpeg;
+    }
+    return QVideoFrameFormat::Format_Invalid;
+}
+
+bool FormatIndex::matches(const QCameraFormat &format, const QString &label) const
+{
+    return label.isEmpty() || label == "自动" || FormatSelector::pixelFormatLabel(format.pixelFormat()) == label;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <QCameraFormat>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVideoFrameFormat>
+
+// 摄像头格式索引
+// 只收录YUYV和MJPEG格式，按像素格式、分辨率、帧率查询，供格式/分辨率/帧率下拉框和格式查找共用，
+// 不再在每个界面事件里遍历设备的全部格式。
+class FormatIndex {
+public:
+    FormatIndex() = default;
+    explicit FormatIndex(const QList<QCameraFormat> &formats);
+
+    bool isEmpty() const;
+    QList<QCameraFormat> formats() const;
+
+    // "YUY2"、"MJPEG"等标签，按字母顺序
+    QStringList pixelFormatLabels() const;
+    // label为空或"自动"时包含所有格式，按面积从大到小排序并去重
+    QList<QSize> resolutions(const QString &label) const;
+    // resolution无效时不限分辨率；没有匹配格式时返回0
+    int maxFrameRate(const QString &label, const QSize &resolution = QSize()) const;
+    // 分辨率必须一致，帧率取最接近的；找不到时返回空格式
+    QCameraFormat find(QVideoFrameFormat::PixelFormat pixelFormat, const QSize &resolution, int fps) const;
+
+    // "yuyv"/"yuy2"/"YUY2"和"mjpeg"/"jpeg"/"MJPEG"，其他返回Format_Invalid
+    static QVideoFrameFormat::PixelFormat pixelFormatFromName(const QString &name);
+
+private:
+    bool matches(const QCameraFormat &format, const QString &label) const;
+
+    QList<QCameraFormat> m_formats;
+};
@@ -0,0 +1,140 @@
+#include "FormatSelector.h"
+#include "FrameConvert.h"
+#include "TestPatternSource.h"
+#include "dbgout.h"
+#include <QImage>
+#include <algorithm>
+#include <climits>
+
+namespace {
+    // USB 2.0高速等时端点每微帧最多3×1024字节，约24.5MB/s，实际摄像头通常只能用到其中一部分
+    double g_busBandwidth = 24.0 * 1000 * 1000;
+
+    // MJPEG帧大小按每像素0.25字节估算，与预录缓存的估算一致
+    const double MJPEG_BYTES_PER_PIXEL = 0.25;
+
+    // 测量时用的帧尺寸和重复次数，取最小值排除调度抖动
+    const QSize BENCH_SIZE(1280, 720);
+    const int BENCH_REPEAT = 3;
+}
+
+DecodeCost FormatSelector::decodeCost()
+{
+    static const DecodeCost cost = []() {
+        DecodeCost result;
+        const double mpix = BENCH_SIZE.width() * BENCH_SIZE.height() / 1000000.0;
+
+        TestPatternSource source;
+        source.setNoiseAmplitude(8);
+        source.setFormat(FramePixelFormat::YUYV, BENCH_SIZE, 30.0);
+        const FramePacket yuyv = source.generateFrame(0);
+        QImage rgb(BENCH_SIZE, QImage::Format_RGB32);
+        qint64 best = LLONG_MAX;
+        for (int i = 0; i < BENCH_REPEAT; ++i) {
+            const qint64 begin = monotonicUs();
+            convertYuyvToRgb32(reinterpret_cast<const uchar*>(yuyv.data.constData()), yuyv.bytesPerLine,
+                               rgb.bits(), int(rgb.bytesPerLine()), BENCH_SIZE.width(), 0, BENCH_SIZE.height());
+            best = qMin(best, monotonicUs() - begin);
+        }
+        result.yuyvUsPerMpix = qMax<qint64>(1, best) / mpix;
+
+        source.setFormat(FramePixelFormat::MJPEG, BENCH_SIZE, 30.0);
+        const FramePacket jpeg = source.generateFrame(0);
+        best = LLONG_MAX;
+        for (int i = 0; i < BENCH_REPEAT; ++i) {
+            const qint64 begin = monotonicUs();
+            const QImage decoded = QImage::fromData(jpeg.data, "JPG");
+            best = qMin(best, monotonicUs() - begin);
+            if (decoded.isNull()) {
+                break;
+            }
+        }
+        result.mjpegUsPerMpix = qMax<qint64>(1, best) / mpix;
+
+        logToConsole(QString("格式选择: 本机YUYV转换 %1 ms/百万像素，MJPEG解码 %2 ms/百万像素")
+                         .arg(result.yuyvUsPerMpix / 1000.0, 0, 'f', 2)
+                         .arg(result.mjpegUsPerMpix / 1000.0, 0, 'f', 2));
+        return result;
+    }();
+    return cost;
+}
+
+void FormatSelector::setBusBandwidth(double bytesPerSecond)
+{
+    g_busBandwidth = bytesPerSecond;
+}
+
+double FormatSelector::busBandwidth()
+{
+    return g_busBandwidth;
+}
+
+QList<FormatScore> FormatSelector::rankFormats(const QCameraDevice &device, const QSize &resolution, int fps)
+{
+    const DecodeCost cost = decodeCost();
+    const double targetArea = double(resolution.width()) * resolution.height();
+    const double requestedFps = fps > 0 ? fps : 30.0;
+
+    QList<FormatScore> scores;
+    for (const QCameraFormat &format : device.videoFormats()) {
+        const QVideoFrameFormat::PixelFormat pixelFormat = format.pixelFormat();
+        if (pixelFormat != QVideoFrameFormat::Format_YUYV && pixelFormat != QVideoFrameFormat::Format_Jpeg) {
+            continue;
+        }
+        const double area = double(format.resolution().width()) * format.resolution().height();
+        if (area <= 0) {
+            continue;
+        }
+        const bool yuyv = pixelFormat == QVideoFrameFormat::Format_YUYV;
+
+        FormatScore s;
+        s.format = format;
+        s.frameBytes = area * (yuyv ? 2.0 : MJPEG_BYTES_PER_PIXEL);
+        s.busFps = g_busBandwidth / s.frameBytes;
+        const double decodeUs = area / 1000000.0 * (yuyv ? cost.yuyvUsPerMpix : cost.mjpegUsPerMpix);
+        s.decodeFps = decodeUs > 0 ? 1000000.0 / decodeUs : requestedFps;
+        s.expectedFps = std::min({double(format.maxFrameRate()), requestedFps, s.busFps, s.decodeFps});
+        s.cpuLoad = decodeUs * s.expectedFps / 1000000.0;
+
+        // 帧率达成率占主要权重；分辨率低于目标时按缺少的面积重罚，高于目标时轻罚（多传多算了像素）
+        s.score = 100.0 * s.expectedFps / requestedFps;
+        if (area < targetArea) {
+            s.score -= 200.0 * (1.0 - area / targetArea);
+        } else if (area > targetArea && targetArea > 0) {
+            s.score -= std::min(20.0, 5.0 * (area / targetArea - 1.0));
+        }
+        // 最大帧率高于请求时略微扣分，避免选到需要驱动降频的格式
+        s.score -= 0.01 * qAbs(format.maxFrameRate() - requestedFps);
+        s.score -= 10.0 * s.cpuLoad;
+        scores << s;
+    }
+
+    std::stable_sort(scores.begin(), scores.end(), [](const FormatScore &a, const FormatScore &b) {
+        return a.score > b.score;
+    });
+    return scores;
+}
+
+QString FormatSelector::describe(const FormatScore &score)
+{
+    return QString("%1 %2x%3@%4 预计 %5 FPS，带宽 %6 MB/s，CPU %7 核")
+        .arg(pixelFormatLabel(score.format.pixelFormat()))
+        .arg(score.format.resolution().width())
+        .arg(score.format.resolution().height())
+        .arg(qRound(score.format.maxFrameRate()))
+        .arg(score.expectedFps, 0, 'f', 1)
+        .arg(score.frameBytes * score.expectedFps / (1000.0 * 1000.0), 0, 'f', 1)
+        .arg(score.cpuLoad, 0, 'f', 2);
+}
+
+QString FormatSelector::pixelFormatLabel(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+        case QVideoFrameFormat::Format_YUYV:
+            return "YUY2";
+        case QVideoFrameFormat::Format_Jpeg:
+            return "MJPEG";
+        default:
+            return QString("格式%1").arg(int(format));
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+// 本机转换/解码开销（每百万像素微秒，单线程）
+struct DecodeCost {
+    double yuyvUsPerMpix = 0;   // YUYV转RGB32
+    double mjpegUsPerMpix = 0;  // MJPEG解码
+};
+
+// 一个摄像头格式的评估结果
+struct FormatScore {
+    QCameraFormat format;
+    double frameBytes = 0;      // 预计每帧大小
+    double busFps = 0;          // 总线带宽允许的帧率
+    double decodeFps = 0;       // 单线程转换/解码允许的帧率
+    double expectedFps = 0;     // 预计实际帧率（不超过请求帧率）
+    double cpuLoad = 0;         // 预计转换/解码占用的CPU核数
+    double score = 0;           // 越大越好
+};
+
+// 自动选择吞吐量最高的摄像头格式
+// 按每个格式的预计带宽（受USB总线限制）、本机测得的转换/解码开销和请求帧率打分，
+// 在满足目标分辨率的前提下优先选择实际帧率最高、CPU占用最低的格式。
+class FormatSelector {
+public:
+    // 首次调用时用生成的测试帧测一次YUYV转换和MJPEG解码耗时（约几十毫秒），之后返回缓存结果
+    static DecodeCost decodeCost();
+
+    // 摄像头可用的总线带宽（字节/秒），默认按USB 2.0等时传输的实际上限估算
+    static void setBusBandwidth(double bytesPerSecond);
+    static double busBandwidth();
+
+    // 只评估YUYV和MJPEG格式，按score从高到低排序
+    static QList<FormatScore> rankFormats(const QCameraDevice &device, const QSize &resolution, int fps);
+
+    // 形如 "MJPEG 1920x1080@30 预计 30.0 FPS，带宽 15.6 MB/s，CPU 0.35 核" 的说明
+    static QString describe(const FormatScore &score);
+    static QString pixelFormatLabel(QVideoFrameFormat::PixelFormat format);
+};
@@ -0,0 +1,48 @@
+#include "FpsCounter.h"
+#include "FramePacket.h"
+
+FpsCounter::FpsCounter()
+{
+    reset();
+}
+
+void FpsCounter::reset()
+{
+    m_frames = 0;
+    m_lastFrames = 0;
+    m_lastUs = monotonicUs();
+    m_fps = 0;
+    m_smoothedFps = 0;
+}
+
+void FpsCounter::frameArrived()
+{
+    m_frames++;
+}
+
+void FpsCounter::update()
+{
+    const qint64 now = monotonicUs();
+    if (now <= m_lastUs) {
+        return;
+    }
+    m_fps = (m_frames - m_lastFrames) * 1000000.0 / (now - m_lastUs);
+    m_smoothedFps = m_smoothedFps == 0 ? m_fps : m_smoothedFps * 0.7 + m_fps * 0.3;
+    m_lastFrames = m_frames;
+    m_lastUs = now;
+}
+
+quint64 FpsCounter::frames() const
+{
+    return m_frames;
+}
+
+double FpsCounter::fps() const
+{
+    return m_fps;
+}
+
+double FpsCounter::smoothedFps() const
+{
+    return m_smoothedFps;
+}
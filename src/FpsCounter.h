@@ -0,0 +1,26 @@
+#pragma once
+#include <QtGlobal>
+
+// 帧率统计
+// frameArrived()只计数，update()按两次调用之间的实际时间计算帧率，并做指数平滑（新值权重0.3）
+class FpsCounter {
+public:
+    FpsCounter();
+
+    void reset();
+    void frameArrived();
+    // 一般每秒调用一次
+    void update();
+
+    quint64 frames() const;
+    // 最近一个统计周期的帧率
+    double fps() const;
+    double smoothedFps() const;
+
+private:
+    quint64 m_frames;
+    quint64 m_lastFrames;
+    qint64 m_lastUs;
+    double m_fps;
+    double m_smoothedFps;
+};
@@ -0,0 +1,232 @@
+#include "FrameAnalyzer.h"
+#include <QMutexLocker>
+
+namespace {
+    // 直方图最多每秒更新20次，更快肉眼也看不出区别
+    const qint64 HISTOGRAM_INTERVAL_US = 50000;
+    const qint64 EXPOSURE_INTERVAL_US = 100000;
+    const qint64 MOTION_INTERVAL_US = 100000;
+}
+
+FrameAnalyzer::FrameAnalyzer(FrameBus *bus, QObject *parent)
+    : QObject(parent),
+      m_bus(bus),
+      m_subscription(0),
+      m_histogramUsers(0),
+      m_lastHistogramUs(0),
+      m_focusUsers(0),
+      m_exposureUsers(0),
+      m_lastExposureUs(0),
+      m_motionUsers(0),
+      m_motionSensitivity(50),
+      m_lastMotionUs(0),
+      m_motionResetPending(false)
+{
+    // 只保留最新一帧，分析来不及时丢弃旧帧，不影响其他订阅者
+    m_subscription = m_bus->subscribe("分析", [this](const SharedFrame &frame) {
+        analyze(frame);
+    }, 1, RecordingPipeline::DropOldest);
+}
+
+FrameAnalyzer::~FrameAnalyzer()
+{
+    // 等待分发线程退出后才能释放本对象
+    m_bus->unsubscribe(m_subscription);
+}
+
+void FrameAnalyzer::addHistogramUser()
+{
+    m_histogramUsers.ref();
+}
+
+void FrameAnalyzer::removeHistogramUser()
+{
+    if (m_histogramUsers.loadRelaxed() > 0) {
+        m_histogramUsers.deref();
+    }
+}
+
+bool FrameAnalyzer::isHistogramEnabled() const
+{
+    return m_histogramUsers.loadRelaxed() > 0;
+}
+
+FrameHistogram FrameAnalyzer::histogram() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_histogram;
+}
+
+void FrameAnalyzer::addFocusUser()
+{
+    m_focusUsers.ref();
+}
+
+void FrameAnalyzer::removeFocusUser()
+{
+    if (m_focusUsers.loadRelaxed() > 0) {
+        m_focusUsers.deref();
+    }
+}
+
+bool FrameAnalyzer::isFocusEnabled() const
+{
+    return m_focusUsers.loadRelaxed() > 0;
+}
+
+FocusMeasure FrameAnalyzer::focus() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_focus;
+}
+
+void FrameAnalyzer::addExposureUser()
+{
+    m_exposureUsers.ref();
+}
+
+void FrameAnalyzer::removeExposureUser()
+{
+    if (m_exposureUsers.loadRelaxed() > 0) {
+        m_exposureUsers.deref();
+    }
+}
+
+bool FrameAnalyzer::isExposureEnabled() const
+{
+    return m_exposureUsers.loadRelaxed() > 0;
+}
+
+ExposureStats FrameAnalyzer::exposureStats() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_exposureStats;
+}
+
+void FrameAnalyzer::addMotionUser()
+{
+    m_motionUsers.ref();
+}
+
+void FrameAnalyzer::removeMotionUser()
+{
+    if (m_motionUsers.loadRelaxed() > 0) {
+        m_motionUsers.deref();
+    }
+}
+
+bool FrameAnalyzer::isMotionEnabled() const
+{
+    return m_motionUsers.loadRelaxed() > 0;
+}
+
+MotionResult FrameAnalyzer::motion() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_motion;
+}
+
+void FrameAnalyzer::setMotionSensitivity(int sensitivity)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_motionSensitivity = qBound(1, sensitivity, 100);
+}
+
+int FrameAnalyzer::motionSensitivity() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_motionSensitivity;
+}
+
+void FrameAnalyzer::setFocusRoi(const QRectF &roi)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_focusRoi = roi;
+}
+
+QRectF FrameAnalyzer::focusRoi() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_focusRoi;
+}
+
+void FrameAnalyzer::clear()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_histogram = FrameHistogram();
+    m_lastHistogramUs = 0;
+    m_focus = FocusMeasure();
+    m_exposureStats = ExposureStats();
+    m_lastExposureUs = 0;
+    m_motion = MotionResult();
+    m_lastMotionUs = 0;
+    m_motionResetPending = true;
+}
+
+void FrameAnalyzer::analyze(const SharedFrame &frame)
+{
+    qint64 lastHistogramUs = 0;
+    qint64 lastExposureUs = 0;
+    qint64 lastMotionUs = 0;
+    int motionSensitivity = 0;
+    bool motionReset = false;
+    QRectF focusRoi;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        lastHistogramUs = m_lastHistogramUs;
+        lastExposureUs = m_lastExposureUs;
+        lastMotionUs = m_lastMotionUs;
+        motionSensitivity = m_motionSensitivity;
+        motionReset = m_motionResetPending;
+        m_motionResetPending = false;
+        focusRoi = m_focusRoi;
+    }
+    // 背景只对连续的画面有意义：切换摄像头或停止侦测后重新建立
+    if (motionReset || (!isMotionEnabled() && m_motionDetector.hasBackground())) {
+        m_motionDetector.reset();
+    }
+    if (isMotionEnabled() && frame.captureUs() - lastMotionUs >= MOTION_INTERVAL_US) {
+        MotionResult motion;
+        m_motionDetector.setSensitivity(motionSensitivity);
+        if (m_motionDetector.update(frame.packet(), &motion)) {
+            {
+                QMutexLocker<QMutex> locker(&m_mutex);
+                m_motion = motion;
+                m_lastMotionUs = frame.captureUs();
+            }
+            emit motionUpdated();
+        }
+    }
+    if (isExposureEnabled() && frame.captureUs() - lastExposureUs >= EXPOSURE_INTERVAL_US) {
+        ExposureStats stats;
+        if (computeExposureStats(frame.packet(), &stats)) {
+            {
+                QMutexLocker<QMutex> locker(&m_mutex);
+                m_exposureStats = stats;
+                m_lastExposureUs = frame.captureUs();
+            }
+            emit exposureStatsUpdated();
+        }
+    }
+    if (isFocusEnabled()) {
+        FocusMeasure focus;
+        if (computeFocus(frame.packet(), focusRoi, &focus)) {
+            {
+                QMutexLocker<QMutex> locker(&m_mutex);
+                m_focus = focus;
+            }
+            emit focusUpdated();
+        }
+    }
+    if (isHistogramEnabled() && frame.captureUs() - lastHistogramUs >= HISTOGRAM_INTERVAL_US) {
+        FrameHistogram histogram;
+        if (computeHistogram(frame.packet(), &histogram)) {
+            {
+                QMutexLocker<QMutex> locker(&m_mutex);
+                m_histogram = histogram;
+                m_lastHistogramUs = frame.captureUs();
+            }
+            emit histogramUpdated();
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+#include "FrameBus.h"
+#include "FrameHistogram.h"
+#include "FocusMetric.h"
+#include "ExposureStats.h"
+#include "MotionDetector.h"
+
+// 画面分析（不依赖界面控件）
+// 订阅帧总线，在自己的分发线程中按需计算直方图、对焦清晰度、曝光统计等，只保留最新结果；
+// 没有使用者时不做任何计算。使用者通过addXxxUser()/removeXxxUser()登记，可以同时有多个。
+class FrameAnalyzer : public QObject {
+    Q_OBJECT
+public:
+    explicit FrameAnalyzer(FrameBus *bus, QObject *parent = nullptr);
+    ~FrameAnalyzer();
+
+    void addHistogramUser();
+    void removeHistogramUser();
+    bool isHistogramEnabled() const;
+    // 最新的直方图，还没有计算过时isValid()为false
+    FrameHistogram histogram() const;
+
+    // 对焦清晰度每帧都计算（SSE2下1080p中央区域约0.1 ms），对焦扫描需要逐帧的结果
+    void addFocusUser();
+    void removeFocusUser();
+    bool isFocusEnabled() const;
+    FocusMeasure focus() const;
+    // 统计区域（归一化坐标），空矩形表示中央1/3
+    void setFocusRoi(const QRectF &roi);
+    QRectF focusRoi() const;
+
+    // 软件自动曝光/白平衡用的统计，最多每秒10次（调节器本身的调整间隔更长）
+    void addExposureUser();
+    void removeExposureUser();
+    bool isExposureEnabled() const;
+    ExposureStats exposureStats() const;
+
+    // 移动侦测，最多每秒10次；没有使用者时丢弃背景，重新登记后先用约1秒建立背景
+    void addMotionUser();
+    void removeMotionUser();
+    bool isMotionEnabled() const;
+    MotionResult motion() const;
+    // 灵敏度1~100，下一次检测时生效
+    void setMotionSensitivity(int sensitivity);
+    int motionSensitivity() const;
+
+    // 丢弃旧结果（切换摄像头或格式后调用）
+    void clear();
+
+signals:
+    // 在分析线程中发出，连接到界面对象时自动排队到界面线程
+    void histogramUpdated();
+    void focusUpdated();
+    void exposureStatsUpdated();
+    void motionUpdated();
+
+private:
+    void analyze(const SharedFrame &frame);
+
+    FrameBus *m_bus;
+    int m_subscription;
+    QAtomicInt m_histogramUsers;
+    mutable QMutex m_mutex;
+    FrameHistogram m_histogram;
+    qint64 m_lastHistogramUs;
+    QAtomicInt m_focusUsers;
+    FocusMeasure m_focus;
+    QRectF m_focusRoi;
+    QAtomicInt m_exposureUsers;
+    ExposureStats m_exposureStats;
+    qint64 m_lastExposureUs;
+    QAtomicInt m_motionUsers;
+    MotionDetector m_motionDetector;    // 只在分析线程中使用
+    MotionResult m_motion;
+    int m_motionSensitivity;
+    qint64 m_lastMotionUs;
+    bool m_motionResetPending;          // clear()后由分析线程丢弃背景
+};
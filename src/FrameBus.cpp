@@ -0,0 +1,334 @@
+#include "FrameBus.h"
+#include "dbgout.h"
+#include <QMutexLocker>
+#include <QStringList>
+
+// ---------------- SharedFrame ----------------
+
+struct SharedFrame::Data {
+    QVideoFrame frame;
+    bool mapped = false;
+    FramePacket packet;   // owner为空，由packet()在返回时填入
+
+    ~Data()
+    {
+        if (mapped) {
+            frame.unmap();
+        }
+    }
+};
+
+SharedFrame::SharedFrame()
+{
+}
+
+SharedFrame SharedFrame::fromVideoFrame(const QVideoFrame &frame, quint64 sequence)
+{
+    SharedFrame shared;
+    if (!frame.isValid()) {
+        return shared;
+    }
+
+    auto data = std::make_shared<Data>();
+    data->frame = frame;
+
+    const QVideoFrameFormat::PixelFormat pixelFormat = frame.pixelFormat();
+    if (pixelFormat == QVideoFrameFormat::Format_YUYV || pixelFormat == QVideoFrameFormat::Format_Jpeg) {
+        if (!data->frame.map(QVideoFrame::ReadOnly)) {
+            return shared;
+        }
+        data->mapped = true;
+
+        FramePacket &packet = data->packet;
+        packet.captureUs = monotonicUs();
+        packet.sequence = sequence;
+        packet.size = frame.size();
+        packet.ptsUs = frame.startTime() >= 0 ? frame.startTime() : packet.captureUs;
+        const char *bits = reinterpret_cast<const char*>(data->frame.bits(0));
+        if (pixelFormat == QVideoFrameFormat::Format_YUYV) {
+            packet.format = FramePixelFormat::YUYV;
+            packet.bytesPerLine = data->frame.bytesPerLine(0);
+            packet.data = QByteArray::fromRawData(bits, qsizetype(packet.bytesPerLine) * packet.size.height());
+        } else {
+            packet.format = FramePixelFormat::MJPEG;
+            packet.data = QByteArray::fromRawData(bits, data->frame.mappedBytes(0));
+        }
+    } else {
+        data->packet = packetFromVideoFrame(frame, sequence);
+    }
+
+    if (!data->packet.isValid()) {
+        return shared;
+    }
+    shared.d = data;
+    return shared;
+}
+
+SharedFrame SharedFrame::fromPacket(const FramePacket &packet)
+{
+    SharedFrame shared;
+    if (!packet.isValid()) {
+        return shared;
+    }
+    auto data = std::make_shared<Data>();
+    data->packet = packet;
+    shared.d = data;
+    return shared;
+}
+
+bool SharedFrame::isValid() const
+{
+    return d != nullptr;
+}
+
+FramePacket SharedFrame::packet() const
+{
+    if (!d) {
+        return FramePacket();
+    }
+    FramePacket packet = d->packet;
+    packet.owner = d;
+    return packet;
+}
+
+QVideoFrame SharedFrame::videoFrame() const
+{
+    return d ? d->frame : QVideoFrame();
+}
+
+FramePixelFormat SharedFrame::format() const
+{
+    return d ? d->packet.format : FramePixelFormat::Unknown;
+}
+
+QSize SharedFrame::size() const
+{
+    return d ? d->packet.size : QSize();
+}
+
+quint64 SharedFrame::sequence() const
+{
+    return d ? d->packet.sequence : 0;
+}
+
+qint64 SharedFrame::captureUs() const
+{
+    return d ? d->packet.captureUs : 0;
+}
+
+long SharedFrame::useCount() const
+{
+    return d.use_count();
+}
+
+// ---------------- FrameBus ----------------
+
+FrameBus::FrameBus(QObject *parent)
+    : QObject(parent),
+      m_nextId(1)
+{
+}
+
+FrameBus::~FrameBus()
+{
+    QList<int> ids;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        for (const auto &subscriber : m_subscribers) {
+            ids << subscriber->stats.id;
+        }
+    }
+    for (int id : ids) {
+        unsubscribe(id);
+    }
+}
+
+int FrameBus::subscribe(const QString &name, Handler handler, int queueDepth, DropPolicy policy)
+{
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->handler = handler;
+    subscriber->policy = policy;
+    subscriber->stats.name = name;
+    subscriber->stats.queueCapacity = qMax(0, queueDepth);
+    subscriber->direct = queueDepth <= 0;
+
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        subscriber->stats.id = m_nextId++;
+    }
+
+    if (!subscriber->direct) {
+        Subscriber *raw = subscriber.get();
+        subscriber->thread = QThread::create([raw]() { dispatchLoop(raw); });
+        subscriber->thread->setObjectName("FrameBus:" + name);
+        subscriber->thread->start();
+    }
+
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_subscribers.append(subscriber);
+    logToConsole(QString("帧总线: 订阅 %1，队列深度 %2，丢帧策略 %3")
+                     .arg(name)
+                     .arg(queueDepth)
+                     .arg(queueDepth > 0 ? RecordingPipeline::dropPolicyName(policy) : QString("直接调用")));
+    return subscriber->stats.id;
+}
+
+void FrameBus::unsubscribe(int id)
+{
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        for (int i = 0; i < m_subscribers.size(); ++i) {
+            if (m_subscribers[i]->stats.id == id) {
+                subscriber = m_subscribers.takeAt(i);
+                break;
+            }
+        }
+    }
+    if (!subscriber) {
+        return;
+    }
+
+    {
+        QMutexLocker<QMutex> locker(&subscriber->mutex);
+        subscriber->stopping = true;
+        subscriber->queue.clear();
+        subscriber->notEmpty.wakeAll();
+        subscriber->notFull.wakeAll();
+        // 发布前已取得订阅者列表的publish()可能正在直接调用handler，等它返回
+        while (subscriber->inFlight > 0) {
+            subscriber->idle.wait(&subscriber->mutex);
+        }
+    }
+    if (!subscriber->thread) {
+        return;
+    }
+    subscriber->thread->wait();
+    delete subscriber->thread;
+    subscriber->thread = nullptr;
+}
+
+void FrameBus::publish(const SharedFrame &frame)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+    QList<std::shared_ptr<Subscriber>> subscribers;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        subscribers = m_subscribers;
+    }
+    for (const auto &subscriber : subscribers) {
+        deliver(subscriber.get(), frame);
+    }
+}
+
+void FrameBus::deliver(Subscriber *subscriber, const SharedFrame &frame)
+{
+    if (subscriber->direct) {
+        {
+            QMutexLocker<QMutex> locker(&subscriber->mutex);
+            if (subscriber->stopping) {
+                return;
+            }
+            subscriber->stats.delivered++;
+            subscriber->inFlight++;
+        }
+        handle(subscriber, frame);
+        QMutexLocker<QMutex> locker(&subscriber->mutex);
+        if (--subscriber->inFlight == 0 && subscriber->stopping) {
+            subscriber->idle.wakeAll();
+        }
+        return;
+    }
+
+    QMutexLocker<QMutex> locker(&subscriber->mutex);
+    if (subscriber->stopping) {
+        return;
+    }
+    const int capacity = subscriber->stats.queueCapacity;
+    if (subscriber->queue.size() >= capacity) {
+        switch (subscriber->policy) {
+            case RecordingPipeline::DropOldest:
+                subscriber->queue.dequeue();
+                subscriber->stats.dropped++;
+                break;
+            case RecordingPipeline::DropNewest:
+                subscriber->stats.dropped++;
+                return;
+            case RecordingPipeline::Block:
+                while (subscriber->queue.size() >= capacity && !subscriber->stopping) {
+                    subscriber->notFull.wait(&subscriber->mutex);
+                }
+                if (subscriber->stopping) {
+                    return;
+                }
+                break;
+        }
+    }
+    // 入队的只是句柄，不拷贝帧数据
+    subscriber->queue.enqueue(frame);
+    subscriber->stats.delivered++;
+    subscriber->stats.queueDepth = int(subscriber->queue.size());
+    subscriber->stats.maxQueueDepth = qMax(subscriber->stats.maxQueueDepth, subscriber->stats.queueDepth);
+    subscriber->notEmpty.wakeOne();
+}
+
+void FrameBus::handle(Subscriber *subscriber, const SharedFrame &frame)
+{
+    const qint64 begin = monotonicUs();
+    subscriber->handler(frame);
+    const qint64 elapsed = monotonicUs() - begin;
+
+    QMutexLocker<QMutex> locker(&subscriber->mutex);
+    FrameSubscriberStats &stats = subscriber->stats;
+    stats.processed++;
+    subscriber->totalHandleUs += elapsed;
+    stats.avgHandleUs = double(subscriber->totalHandleUs) / double(stats.processed);
+    stats.maxHandleUs = qMax(stats.maxHandleUs, elapsed);
+    stats.maxLatencyUs = qMax(stats.maxLatencyUs, begin - frame.captureUs());
+}
+
+void FrameBus::dispatchLoop(Subscriber *subscriber)
+{
+    for (;;) {
+        SharedFrame frame;
+        {
+            QMutexLocker<QMutex> locker(&subscriber->mutex);
+            while (subscriber->queue.isEmpty() && !subscriber->stopping) {
+                subscriber->notEmpty.wait(&subscriber->mutex);
+            }
+            if (subscriber->stopping) {
+                return;
+            }
+            frame = subscriber->queue.dequeue();
+            subscriber->stats.queueDepth = int(subscriber->queue.size());
+            subscriber->notFull.wakeOne();
+        }
+        handle(subscriber, frame);
+    }
+}
+
+QList<FrameSubscriberStats> FrameBus::stats() const
+{
+    QList<std::shared_ptr<Subscriber>> subscribers;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        subscribers = m_subscribers;
+    }
+    QList<FrameSubscriberStats> list;
+    for (const auto &subscriber : subscribers) {
+        QMutexLocker<QMutex> locker(&subscriber->mutex);
+        list << subscriber->stats;
+    }
+    return list;
+}
+
+QString FrameBus::statsSummary() const
+{
+    QStringList parts;
+    for (const FrameSubscriberStats &s : stats()) {
+        parts << QString("%1 丢弃 %2 / 处理 %3 ms").arg(s.name).arg(s.dropped).arg(s.avgHandleUs / 1000.0, 0, 'f', 2);
+    }
+    return parts.join("  ");
+}
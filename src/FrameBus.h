@@ -0,0 +1,106 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QThread>
+#include <QVideoFrame>
+#include <QList>
+#include <functional>
+#include <memory>
+#include "FramePacket.h"
+#include "RecordingPipeline.h"
+
+// 只读、引用计数的帧句柄
+// 摄像头帧在发布时映射一次，所有订阅者共享同一块映射内存，最后一个句柄释放时才解除映射
+class SharedFrame {
+public:
+    SharedFrame();
+
+    // YUYV/MJPEG直接引用映射内存，不拷贝；其他格式转换为RGB32（只转换一次）
+    static SharedFrame fromVideoFrame(const QVideoFrame &frame, quint64 sequence);
+    static SharedFrame fromPacket(const FramePacket &packet);
+
+    bool isValid() const;
+    // 返回的packet通过owner持有本帧，packet存活期间数据有效
+    FramePacket packet() const;
+    QVideoFrame videoFrame() const;
+    FramePixelFormat format() const;
+    QSize size() const;
+    quint64 sequence() const;
+    qint64 captureUs() const;
+    long useCount() const;
+
+private:
+    struct Data;
+    std::shared_ptr<const Data> d;
+};
+
+Q_DECLARE_METATYPE(SharedFrame)
+
+// 订阅者统计
+struct FrameSubscriberStats {
+    int id = 0;
+    QString name;
+    quint64 delivered = 0;   // 进入该订阅者队列的帧数
+    quint64 processed = 0;   // 处理完成的帧数
+    quint64 dropped = 0;     // 队列满被丢弃的帧数
+    int queueDepth = 0;
+    int maxQueueDepth = 0;
+    int queueCapacity = 0;   // 0表示在发布线程直接调用
+    double avgHandleUs = 0;
+    qint64 maxHandleUs = 0;
+    qint64 maxLatencyUs = 0; // 从采集到开始处理的最大延迟
+};
+
+// 帧分发总线
+// 每帧只包装一次，按订阅顺序分发给所有订阅者；每个订阅者有自己的队列深度、丢帧策略和分发线程，
+// 慢的订阅者只会让自己丢帧，不影响发布者和其他订阅者。
+class FrameBus : public QObject {
+    Q_OBJECT
+public:
+    using Handler = std::function<void(const SharedFrame &frame)>;
+    using DropPolicy = RecordingPipeline::DropPolicy;
+
+    explicit FrameBus(QObject *parent = nullptr);
+    ~FrameBus();
+
+    // queueDepth为0时handler在发布线程中直接调用（只适合入队、计数等很快的操作），
+    // 否则为该订阅者启动独立的分发线程；返回订阅ID
+    int subscribe(const QString &name, Handler handler, int queueDepth = 2,
+                  DropPolicy policy = RecordingPipeline::DropOldest);
+    // 取消订阅，队列中未处理的帧直接丢弃；返回时handler已不会再被调用（包括发布线程中正在进行的直接调用），
+    // 调用方可以安全销毁handler捕获的对象。不能在handler内部调用
+    void unsubscribe(int id);
+
+    void publish(const SharedFrame &frame);
+
+    QList<FrameSubscriberStats> stats() const;
+    // 形如 "预览 丢弃 0 / 处理 1.2 ms" 的单行摘要
+    QString statsSummary() const;
+
+private:
+    struct Subscriber {
+        FrameSubscriberStats stats;
+        Handler handler;
+        DropPolicy policy = RecordingPipeline::DropOldest;
+        QMutex mutex;
+        QWaitCondition notEmpty;
+        QWaitCondition notFull;
+        QQueue<SharedFrame> queue;
+        QWaitCondition idle;
+        bool direct = false;     // 订阅时确定，之后不变：在发布线程中直接调用
+        bool stopping = false;
+        int inFlight = 0;        // 发布线程中正在执行的直接调用数
+        QThread *thread = nullptr;
+        qint64 totalHandleUs = 0;
+    };
+
+    static void deliver(Subscriber *subscriber, const SharedFrame &frame);
+    static void handle(Subscriber *subscriber, const SharedFrame &frame);
+    static void dispatchLoop(Subscriber *subscriber);
+
+    mutable QMutex m_mutex;
+    QList<std::shared_ptr<Subscriber>> m_subscribers;
+    int m_nextId;
+};
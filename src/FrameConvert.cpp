@@ -0,0 +1,386 @@
+#include "FrameConvert.h"
+#include "TaskPool.h"
+#include <QBuffer>
+#include <QVideoFrame>
+#include <QVector>
+#include <QImageReader>
+#include "SimdSupport.h"
+
+namespace {
+    inline uchar clampToByte(int value)
+    {
+        return uchar(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+}
+
+void convertYuyvToRgb32(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                        int width, int firstRow, int rowCount)
+{
+    // 定点系数（放大256倍）：
+    // R = 1.164(Y-16) + 1.596(V-128)
+    // G = 1.164(Y-16) - 0.391(U-128) - 0.813(V-128)
+    // B = 1.164(Y-16) + 2.018(U-128)
+    for (int row = firstRow; row < firstRow + rowCount; ++row) {
+        const uchar *in = src + qsizetype(row) * srcStride;
+        quint32 *out = reinterpret_cast<quint32*>(dst + qsizetype(row) * dstStride);
+        for (int x = 0; x + 1 < width; x += 2) {
+            const int y0 = (in[0] - 16) * 298;
+            const int u = in[1] - 128;
+            const int y1 = (in[2] - 16) * 298;
+            const int v = in[3] - 128;
+            in += 4;
+
+            const int rd = 409 * v + 128;
+            const int gd = -100 * u - 208 * v + 128;
+            const int bd = 516 * u + 128;
+
+            out[x] = 0xFF000000u
+                     | (quint32(clampToByte((y0 + rd) >> 8)) << 16)
+                     | (quint32(clampToByte((y0 + gd) >> 8)) << 8)
+                     | quint32(clampToByte((y0 + bd) >> 8));
+            out[x + 1] = 0xFF000000u
+                         | (quint32(clampToByte((y1 + rd) >> 8)) << 16)
+                         | (quint32(clampToByte((y1 + gd) >> 8)) << 8)
+                         | quint32(clampToByte((y1 + bd) >> 8));
+        }
+    }
+}
+
+void scaleRgb32Area(const uchar *src, int srcStride, const QSize &srcSize,
+                    uchar *dst, int dstStride, const QSize &dstSize, int firstRow, int rowCount)
+{
+    const int srcWidth = srcSize.width();
+    const int srcHeight = srcSize.height();
+    const int dstWidth = dstSize.width();
+    const int dstHeight = dstSize.height();
+
+    // 每个目标列对应的源列区间[x0, x1)
+    QVector<int> columnStart(dstWidth + 1);
+    for (int x = 0; x <= dstWidth; ++x) {
+        columnStart[x] = int(qint64(x) * srcWidth / dstWidth);
+    }
+
+    for (int y = firstRow; y < firstRow + rowCount; ++y) {
+        const int y0 = int(qint64(y) * srcHeight / dstHeight);
+        const int y1 = qMax(y0 + 1, int(qint64(y + 1) * srcHeight / dstHeight));
+        quint32 *out = reinterpret_cast<quint32*>(dst + qsizetype(y) * dstStride);
+        for (int x = 0; x < dstWidth; ++x) {
+            const int x0 = columnStart[x];
+            const int x1 = qMax(x0 + 1, columnStart[x + 1]);
+            quint64 r = 0;
+            quint64 g = 0;
+            quint64 b = 0;
+            for (int sy = y0; sy < y1; ++sy) {
+                const quint32 *in = reinterpret_cast<const quint32*>(src + qsizetype(sy) * srcStride);
+                for (int sx = x0; sx < x1; ++sx) {
+                    const quint32 p = in[sx];
+                    r += (p >> 16) & 0xFF;
+                    g += (p >> 8) & 0xFF;
+                    b += p & 0xFF;
+                }
+            }
+            const quint64 n = quint64(y1 - y0) * quint64(x1 - x0);
+            out[x] = 0xFF000000u
+                     | (quint32((r + n / 2) / n) << 16)
+                     | (quint32((g + n / 2) / n) << 8)
+                     | quint32((b + n / 2) / n);
+        }
+    }
+}
+
+void scaleRgb32Bilinear(const uchar *src, int srcStride, const QSize &srcSize,
+                        uchar *dst, int dstStride, const QSize &dstSize, int firstRow, int rowCount)
+{
+    const int srcWidth = srcSize.width();
+    const int srcHeight = srcSize.height();
+    const int dstWidth = dstSize.width();
+    const int dstHeight = dstSize.height();
+    if (srcWidth < 2 || srcHeight < 2) {
+        scaleRgb32Area(src, srcStride, srcSize, dst, dstStride, dstSize, firstRow, rowCount);
+        return;
+    }
+
+    // 源坐标用16.16定点数表示，按像素中心对齐；每列的左侧源像素和8位水平权重只算一次
+    QVector<int> columnX(dstWidth);
+    QVector<int> columnWeight(dstWidth);
+    const qint64 stepX = (qint64(srcWidth) << 16) / dstWidth;
+    for (int x = 0; x < dstWidth; ++x) {
+        const qint64 fx = qMax<qint64>(0, (x * stepX + stepX / 2) - 0x8000);
+        columnX[x] = qMin(int(fx >> 16), srcWidth - 2);
+        columnWeight[x] = fx >> 16 > srcWidth - 2 ? 256 : int((fx >> 8) & 0xFF);
+    }
+    const qint64 stepY = (qint64(srcHeight) << 16) / dstHeight;
+
+    for (int y = firstRow; y < firstRow + rowCount; ++y) {
+        const qint64 fy = qMax<qint64>(0, (y * stepY + stepY / 2) - 0x8000);
+        const int sy = qMin(int(fy >> 16), srcHeight - 2);
+        const int wy = fy >> 16 > srcHeight - 2 ? 256 : int((fy >> 8) & 0xFF);
+        const quint32 *row0 = reinterpret_cast<const quint32*>(src + qsizetype(sy) * srcStride);
+        const quint32 *row1 = reinterpret_cast<const quint32*>(src + qsizetype(sy + 1) * srcStride);
+        quint32 *out = reinterpret_cast<quint32*>(dst + qsizetype(y) * dstStride);
+#ifdef CAMERA_HAVE_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weightY = _mm_set1_epi16(short(wy));
+        const __m128i inverseY = _mm_set1_epi16(short(256 - wy));
+        for (int x = 0; x < dstWidth; ++x) {
+            const int sx = columnX[x];
+            const int wx = columnWeight[x];
+            // 低4个16位通道乘左侧像素权重，高4个乘右侧像素权重
+            const __m128i weightX = _mm_set_epi16(short(wx), short(wx), short(wx), short(wx),
+                                                  short(256 - wx), short(256 - wx), short(256 - wx), short(256 - wx));
+            __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0 + sx)), zero);
+            __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row1 + sx)), zero);
+            // 255 * 256 不超过16位无符号范围
+            top = _mm_mullo_epi16(top, weightX);
+            bottom = _mm_mullo_epi16(bottom, weightX);
+            top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), 8);
+            bottom = _mm_srli_epi16(_mm_add_epi16(bottom, _mm_srli_si128(bottom, 8)), 8);
+            __m128i pixel = _mm_add_epi16(_mm_mullo_epi16(top, inverseY), _mm_mullo_epi16(bottom, weightY));
+            pixel = _mm_srli_epi16(pixel, 8);
+            out[x] = quint32(_mm_cvtsi128_si32(_mm_packus_epi16(pixel, zero))) | 0xFF000000u;
+        }
+#else
+        for (int x = 0; x < dstWidth; ++x) {
+            const int sx = columnX[x];
+            const int wx = columnWeight[x];
+            quint32 pixel = 0xFF000000u;
+            for (int shift = 0; shift < 24; shift += 8) {
+                const int top = (((row0[sx] >> shift) & 0xFF) * (256 - wx) + ((row0[sx + 1] >> shift) & 0xFF) * wx) >> 8;
+                const int bottom = (((row1[sx] >> shift) & 0xFF) * (256 - wx) + ((row1[sx + 1] >> shift) & 0xFF) * wx) >> 8;
+                pixel |= quint32((top * (256 - wy) + bottom * wy) >> 8) << shift;
+            }
+            out[x] = pixel;
+        }
+#endif
+    }
+}
+
+QImage convertYuyvParallel(const uchar *src, int srcStride, const QSize &size)
+{
+    QImage image(size, QImage::Format_RGB32);
+    if (image.isNull()) {
+        return QImage();
+    }
+    uchar *dst = image.bits();
+    const int dstStride = int(image.bytesPerLine());
+    const int width = size.width();
+    TaskPool::shared()->parallelStripes("yuyv_to_rgb", size.height(), [=](int firstRow, int rowCount) {
+        convertYuyvToRgb32(src, srcStride, dst, dstStride, width, firstRow, rowCount);
+    });
+    return image;
+}
+
+QImage scaleImageParallel(const QImage &image, const QSize &target)
+{
+    if (image.isNull() || target.isEmpty()) {
+        return QImage();
+    }
+    const QImage source = image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32
+                              ? image : image.convertToFormat(QImage::Format_RGB32);
+    if (source.size() == target) {
+        return source;
+    }
+
+    QImage scaled(target, QImage::Format_RGB32);
+    const uchar *src = source.constBits();
+    const int srcStride = int(source.bytesPerLine());
+    const QSize srcSize = source.size();
+    uchar *dst = scaled.bits();
+    const int dstStride = int(scaled.bytesPerLine());
+    // 缩小倍数大时每行计算量大，条带可以更窄
+    const int minRows = qMax(4, 64 * target.height() / qMax(1, srcSize.height()));
+    TaskPool::shared()->parallelStripes("scale_rgb", target.height(), [=](int firstRow, int rowCount) {
+        scaleRgb32Area(src, srcStride, srcSize, dst, dstStride, target, firstRow, rowCount);
+    }, minRows);
+    return scaled;
+}
+
+QImage videoFrameToImage(const QVideoFrame &frame)
+{
+    if (frame.pixelFormat() == QVideoFrameFormat::Format_YUYV) {
+        QVideoFrame mapped(frame);
+        if (mapped.map(QVideoFrame::ReadOnly)) {
+            const QImage image = convertYuyvParallel(mapped.bits(0), mapped.bytesPerLine(0), mapped.size());
+            mapped.unmap();
+            return image;
+        }
+    }
+    QImage image = frame.toImage();
+    if (!image.isNull() && image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+    return image;
+}
+
+QImage scaleImageBilinearParallel(const QImage &image, const QSize &target)
+{
+    if (image.isNull() || target.isEmpty()) {
+        return QImage();
+    }
+    const QImage source = image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32
+                              ? image : image.convertToFormat(QImage::Format_RGB32);
+    if (source.size() == target) {
+        return source;
+    }
+
+    QImage scaled(target, QImage::Format_RGB32);
+    const uchar *src = source.constBits();
+    const int srcStride = int(source.bytesPerLine());
+    const QSize srcSize = source.size();
+    uchar *dst = scaled.bits();
+    const int dstStride = int(scaled.bytesPerLine());
+    TaskPool::shared()->parallelStripes("scale_bilinear", target.height(), [=](int firstRow, int rowCount) {
+        scaleRgb32Bilinear(src, srcStride, srcSize, dst, dstStride, target, firstRow, rowCount);
+    }, 32);
+    return scaled;
+}
+
+QImage packetToImage(const FramePacket &packet)
+{
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return QImage();
+            }
+            return convertYuyvParallel(reinterpret_cast<const uchar*>(packet.data.constData()),
+                                       packet.bytesPerLine, packet.size);
+        }
+        case FramePixelFormat::MJPEG:
+            return QImage::fromData(packet.data, "JPG");
+        case FramePixelFormat::RGB32:
+            // 深拷贝，避免QImage引用packet内存后packet先释放
+            return QImage(reinterpret_cast<const uchar*>(packet.data.constData()),
+                          packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                          QImage::Format_RGB32).copy();
+        default:
+            return QImage();
+    }
+}
+
+QImage packetToImage(const FramePacket &packet, const QRect &region)
+{
+    const QRect frameRect(QPoint(0, 0), packet.size);
+    QRect clip = region.isEmpty() ? frameRect : region.intersected(frameRect);
+    if (clip == frameRect) {
+        return packetToImage(packet);
+    }
+    if (clip.isEmpty()) {
+        return QImage();
+    }
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            // 每两个像素共用一组UV，左边界和宽度按2像素对齐
+            clip.setLeft(clip.left() & ~1);
+            clip.setWidth(qMin((clip.width() + 1) & ~1, packet.size.width() - clip.left()));
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * (clip.bottom() + 1)) {
+                return QImage();
+            }
+            const uchar *src = reinterpret_cast<const uchar*>(packet.data.constData()) +
+                               qsizetype(clip.top()) * packet.bytesPerLine + clip.left() * 2;
+            return convertYuyvParallel(src, packet.bytesPerLine, clip.size());
+        }
+        case FramePixelFormat::MJPEG: {
+            // 解码器在裁剪区域的最后一行之后停止解码
+            QBuffer buffer;
+            buffer.setData(packet.data);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer, "JPG");
+            reader.setClipRect(clip);
+            return reader.read();
+        }
+        case FramePixelFormat::RGB32:
+            return QImage(reinterpret_cast<const uchar*>(packet.data.constData()),
+                          packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                          QImage::Format_RGB32).copy(clip);
+        default:
+            return QImage();
+    }
+}
+
+QImage packetToPreview(const FramePacket &packet, const QSize &boundingSize)
+{
+    return packetToPreview(packet, boundingSize, QRect());
+}
+
+QImage packetToPreview(const FramePacket &packet, const QSize &boundingSize, const QRect &region)
+{
+    if (!packet.size.isValid() || boundingSize.isEmpty()) {
+        return QImage();
+    }
+    const QRect frameRect(QPoint(0, 0), packet.size);
+    const QRect clip = region.isEmpty() ? frameRect : region.intersected(frameRect);
+    // 整帧不放大；数字变焦时放大到预览尺寸
+    const QSize fitted = clip.size().scaled(boundingSize, Qt::KeepAspectRatio);
+    const QSize target = clip == frameRect ? fitted.boundedTo(clip.size()) : fitted;
+    if (target.isEmpty()) {
+        return QImage();
+    }
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return QImage();
+            }
+            QImage image(target, QImage::Format_RGB32);
+            const uchar *src = reinterpret_cast<const uchar*>(packet.data.constData());
+            const int clipWidth = clip.width();
+            const int clipHeight = clip.height();
+            for (int y = 0; y < target.height(); ++y) {
+                const uchar *in = src + qsizetype(clip.top() + y * clipHeight / target.height()) * packet.bytesPerLine;
+                quint32 *out = reinterpret_cast<quint32*>(image.scanLine(y));
+                for (int x = 0; x < target.width(); ++x) {
+                    // 每两个像素共用一组UV
+                    const int sx = clip.left() + x * clipWidth / target.width();
+                    const uchar *pair = in + (sx & ~1) * 2;
+                    const int luma = (pair[(sx & 1) * 2] - 16) * 298;
+                    const int u = pair[1] - 128;
+                    const int v = pair[3] - 128;
+                    out[x] = 0xFF000000u
+                             | (quint32(clampToByte((luma + 409 * v + 128) >> 8)) << 16)
+                             | (quint32(clampToByte((luma - 100 * u - 208 * v + 128) >> 8)) << 8)
+                             | quint32(clampToByte((luma + 516 * u + 128) >> 8));
+                }
+            }
+            return image;
+        }
+        case FramePixelFormat::MJPEG: {
+            // JPEG解码器支持按1/2、1/4、1/8直接缩小解码；有裁剪区域时区域以下的MCU行不解码
+            QBuffer buffer;
+            buffer.setData(packet.data);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer, "JPG");
+            if (clip != frameRect) {
+                reader.setClipRect(clip);
+            }
+            reader.setScaledSize(target);
+            return reader.read();
+        }
+        case FramePixelFormat::RGB32: {
+            const uchar *src = reinterpret_cast<const uchar*>(packet.data.constData()) +
+                               qsizetype(clip.top()) * packet.bytesPerLine + clip.left() * 4;
+            const QImage source(src, clip.width(), clip.height(), packet.bytesPerLine, QImage::Format_RGB32);
+            return source.scaled(target, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        }
+        default:
+            return QImage();
+    }
+}
+
+QByteArray packetToJpeg(const FramePacket &packet, int quality)
+{
+    if (packet.format == FramePixelFormat::MJPEG) {
+        return packet.data;
+    }
+
+    const QImage image = packetToImage(packet);
+    if (image.isNull()) {
+        return QByteArray();
+    }
+
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG", quality);
+    return jpeg;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <QImage>
+#include <QtGlobal>
+#include "FramePacket.h"
+
+class QVideoFrame;
+
+// YUYV(BT.601有限范围) 转 RGB32，只处理[firstRow, firstRow + rowCount)行
+void convertYuyvToRgb32(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                        int width, int firstRow, int rowCount);
+
+// RGB32按面积平均缩放（缩小时每个目标像素取覆盖区域的均值，放大时退化为最近邻），只处理目标的[firstRow, firstRow + rowCount)行
+void scaleRgb32Area(const uchar *src, int srcStride, const QSize &srcSize,
+                    uchar *dst, int dstStride, const QSize &dstSize, int firstRow, int rowCount);
+
+// RGB32双线性缩放（8位定点权重，支持SSE2时每次处理一个像素的4个通道），只处理目标的[firstRow, firstRow + rowCount)行
+// 比面积平均快，但缩小倍数大于2时会有锯齿，用于预览降级
+void scaleRgb32Bilinear(const uchar *src, int srcStride, const QSize &srcSize,
+                        uchar *dst, int dstStride, const QSize &dstSize, int firstRow, int rowCount);
+
+// 以下并行版本按水平条带交给TaskPool::shared()执行，返回时已全部完成
+QImage convertYuyvParallel(const uchar *src, int srcStride, const QSize &size);
+QImage scaleImageParallel(const QImage &image, const QSize &target);
+QImage scaleImageBilinearParallel(const QImage &image, const QSize &target);
+
+// 摄像头帧转RGB32：YUYV直接从映射内存并行转换，不经过中间拷贝；其他格式由Qt转换
+QImage videoFrameToImage(const QVideoFrame &frame);
+
+// 把管线帧转换为QImage（RGB32），MJPEG会被解码；失败时返回空图像
+QImage packetToImage(const FramePacket &packet);
+// 只转换region内的画面（数字变焦/裁剪），region为空时转换整帧。
+// YUYV只转换区域内的行和列（左边界按2像素对齐），MJPEG由解码器按裁剪区域解码
+QImage packetToImage(const FramePacket &packet, const QRect &region);
+
+// 生成不超过boundingSize、保持宽高比的预览图
+// YUYV直接按最近邻隔点转换，MJPEG在解码时缩小，耗时与预览尺寸而不是原始分辨率成正比
+QImage packetToPreview(const FramePacket &packet, const QSize &boundingSize);
+// 只取region内的画面生成预览（数字变焦，会放大到boundingSize），region为空时与上面相同；耗时只与预览尺寸有关
+QImage packetToPreview(const FramePacket &packet, const QSize &boundingSize, const QRect &region);
+
+// 把管线帧编码为JPEG，MJPEG帧直接返回原始数据
+QByteArray packetToJpeg(const FramePacket &packet, int quality = 85);
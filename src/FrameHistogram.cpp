@@ -0,0 +1,177 @@
+#include "FrameHistogram.h"
+#include "FrameConvert.h"
+#include <QImage>
+#include <cmath>
+
+#include "SimdSupport.h"
+
+namespace {
+    // MJPEG缩小解码的尺寸上限，只用于统计，不需要细节
+    const QSize MJPEG_ANALYSIS_SIZE(640, 360);
+
+    // BT.601有限范围转全范围RGB，系数放大64倍，保证16位运算不溢出（SIMD和标量结果一致）
+    const int COEFF_Y = 74;     // 1.164
+    const int COEFF_RV = 102;   // 1.596
+    const int COEFF_GU = 25;    // 0.391
+    const int COEFF_GV = 52;    // 0.813
+    const int COEFF_BU = 129;   // 2.018
+
+    inline int clampHistogramByte(int value)
+    {
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    // 累加一个采样
+    inline void accumulate(FrameHistogram *histogram, quint64 *lumaSum, quint32 *high, quint32 *low,
+                           int luma, int r, int g, int b)
+    {
+        histogram->luma[luma]++;
+        histogram->red[r]++;
+        histogram->green[g]++;
+        histogram->blue[b]++;
+        *lumaSum += luma;
+        *high += (r == 255) | (g == 255) | (b == 255);
+        *low += (r | g | b) == 0;
+    }
+
+    inline void accumulateYuv(FrameHistogram *histogram, quint64 *lumaSum, quint32 *high, quint32 *low,
+                              int y, int u, int v)
+    {
+        // 有限范围的亮度换算为全范围后作为亮度直方图的值
+        const int luma = (y - 16) * COEFF_Y;
+        const int cu = u - 128;
+        const int cv = v - 128;
+        const int r = clampHistogramByte(qBound(-32768, luma + cv * COEFF_RV, 32767) >> 6);
+        const int g = clampHistogramByte((luma - cu * COEFF_GU - cv * COEFF_GV) >> 6);
+        const int b = clampHistogramByte(qBound(-32768, luma + cu * COEFF_BU, 32767) >> 6);
+        accumulate(histogram, lumaSum, high, low, clampHistogramByte(luma >> 6), r, g, b);
+    }
+
+    // 统计一行YUYV中的所有像素对，每对取第一个亮度
+    void accumulateYuyvRow(const uchar *row, int pairs, SimdLevel level, FrameHistogram *histogram,
+                           quint64 *lumaSum, quint32 *high, quint32 *low)
+    {
+        int pair = 0;
+#ifdef CAMERA_HAVE_SSE2
+        // Scalar级别全部按标量路径统计
+        const int simdPairs = level >= SimdLevel::Sse2 ? pairs : 0;
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        const __m128i offsetY = _mm_set1_epi16(16);
+        const __m128i offsetUv = _mm_set1_epi16(128);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i maxByte = _mm_set1_epi16(255);
+        alignas(16) qint16 lumaOut[8];
+        alignas(16) qint16 redOut[8];
+        alignas(16) qint16 greenOut[8];
+        alignas(16) qint16 blueOut[8];
+        for (; pair + 8 <= simdPairs; pair += 8) {
+            // 每个32位通道是一对像素 Y0 U Y1 V
+            const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + pair * 4));
+            const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + pair * 4 + 16));
+            const __m128i y = _mm_packs_epi32(_mm_and_si128(p0, byteMask), _mm_and_si128(p1, byteMask));
+            const __m128i u = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), byteMask),
+                                              _mm_and_si128(_mm_srli_epi32(p1, 8), byteMask));
+            const __m128i v = _mm_packs_epi32(_mm_srli_epi32(p0, 24), _mm_srli_epi32(p1, 24));
+
+            const __m128i luma = _mm_mullo_epi16(_mm_sub_epi16(y, offsetY), _mm_set1_epi16(COEFF_Y));
+            const __m128i cu = _mm_sub_epi16(u, offsetUv);
+            const __m128i cv = _mm_sub_epi16(v, offsetUv);
+            // R和B可能超出16位有符号范围，用饱和加法（结果都会被截到255）
+            __m128i r = _mm_adds_epi16(luma, _mm_mullo_epi16(cv, _mm_set1_epi16(COEFF_RV)));
+            __m128i g = _mm_sub_epi16(_mm_sub_epi16(luma, _mm_mullo_epi16(cu, _mm_set1_epi16(COEFF_GU))),
+                                      _mm_mullo_epi16(cv, _mm_set1_epi16(COEFF_GV)));
+            __m128i b = _mm_adds_epi16(luma, _mm_mullo_epi16(cu, _mm_set1_epi16(COEFF_BU)));
+            r = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(r, 6), zero), maxByte);
+            g = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(g, 6), zero), maxByte);
+            b = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(b, 6), zero), maxByte);
+            const __m128i lumaByte = _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(luma, 6), zero), maxByte);
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(lumaOut), lumaByte);
+            _mm_store_si128(reinterpret_cast<__m128i*>(redOut), r);
+            _mm_store_si128(reinterpret_cast<__m128i*>(greenOut), g);
+            _mm_store_si128(reinterpret_cast<__m128i*>(blueOut), b);
+            for (int i = 0; i < 8; ++i) {
+                accumulate(histogram, lumaSum, high, low, lumaOut[i], redOut[i], greenOut[i], blueOut[i]);
+            }
+        }
+#endif
+        for (; pair < pairs; ++pair) {
+            const uchar *p = row + pair * 4;
+            accumulateYuv(histogram, lumaSum, high, low, p[0], p[1], p[3]);
+        }
+    }
+
+    void accumulateRgb32(const QImage &image, int maxSamples, FrameHistogram *histogram,
+                         quint64 *lumaSum, quint32 *high, quint32 *low)
+    {
+        const qint64 pixels = qint64(image.width()) * image.height();
+        const int step = qMax(1, int(std::ceil(std::sqrt(double(pixels) / maxSamples))));
+        for (int y = 0; y < image.height(); y += step) {
+            const quint32 *row = reinterpret_cast<const quint32*>(image.constScanLine(y));
+            for (int x = 0; x < image.width(); x += step) {
+                const quint32 p = row[x];
+                const int r = (p >> 16) & 0xFF;
+                const int g = (p >> 8) & 0xFF;
+                const int b = p & 0xFF;
+                accumulate(histogram, lumaSum, high, low, (77 * r + 150 * g + 29 * b + 128) >> 8, r, g, b);
+            }
+        }
+    }
+}
+
+bool computeHistogram(const FramePacket &packet, FrameHistogram *histogram, int maxSamples)
+{
+    const qint64 begin = monotonicUs();
+    *histogram = FrameHistogram();
+    histogram->sequence = packet.sequence;
+    quint64 lumaSum = 0;
+    quint32 high = 0;
+    quint32 low = 0;
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return false;
+            }
+            // 每行的所有像素对都统计（连续读取便于向量化），通过隔行控制采样数
+            const int pairs = packet.size.width() / 2;
+            const qint64 total = qint64(pairs) * packet.size.height();
+            const int rowStep = qMax(1, int((total + maxSamples - 1) / qMax(1, maxSamples)));
+            const uchar *data = reinterpret_cast<const uchar*>(packet.data.constData());
+            const SimdLevel level = simdLevel();
+            for (int y = rowStep / 2; y < packet.size.height(); y += rowStep) {
+                accumulateYuyvRow(data + qsizetype(y) * packet.bytesPerLine, pairs, level, histogram,
+                                  &lumaSum, &high, &low);
+            }
+            break;
+        }
+        case FramePixelFormat::MJPEG: {
+            const QImage image = packetToPreview(packet, MJPEG_ANALYSIS_SIZE);
+            if (image.isNull()) {
+                return false;
+            }
+            accumulateRgb32(image.convertToFormat(QImage::Format_RGB32), maxSamples, histogram, &lumaSum, &high, &low);
+            break;
+        }
+        case FramePixelFormat::RGB32: {
+            const QImage image(reinterpret_cast<const uchar*>(packet.data.constData()),
+                               packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                               QImage::Format_RGB32);
+            accumulateRgb32(image, maxSamples, histogram, &lumaSum, &high, &low);
+            break;
+        }
+        default:
+            return false;
+    }
+
+    for (int i = 0; i < 256; ++i) {
+        histogram->samples += histogram->luma[i];
+    }
+    if (histogram->samples > 0) {
+        histogram->meanLuma = double(lumaSum) / histogram->samples;
+        histogram->clippedHighPercent = high * 100.0 / histogram->samples;
+        histogram->clippedLowPercent = low * 100.0 / histogram->samples;
+    }
+    histogram->computeUs = monotonicUs() - begin;
+    return histogram->isValid();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <QtGlobal>
+#include "FramePacket.h"
+
+// 亮度和RGB直方图（0~255，亮度为全范围）
+struct FrameHistogram {
+    quint32 luma[256] = {};
+    quint32 red[256] = {};
+    quint32 green[256] = {};
+    quint32 blue[256] = {};
+    quint32 samples = 0;
+    double meanLuma = 0;
+    double clippedHighPercent = 0;  // 任一通道达到255的采样比例（过曝）
+    double clippedLowPercent = 0;   // 三个通道都为0的采样比例（欠曝）
+    qint64 computeUs = 0;
+    quint64 sequence = 0;
+
+    bool isValid() const { return samples > 0; }
+};
+
+// 按隔行隔点采样统计直方图，采样数不超过maxSamples
+// YUYV直接读取原始数据（每对像素取第一个亮度和共用的UV，支持SSE2时每次转换8个采样），
+// MJPEG先缩小解码到640x360以内，RGB32直接采样；不支持的格式返回false
+bool computeHistogram(const FramePacket &packet, FrameHistogram *histogram, int maxSamples = 131072);
@@ -0,0 +1,108 @@
+#include "FramePacket.h"
+#include <QVideoFrame>
+#include <QVideoFrameFormat>
+#include <QImage>
+#include <QElapsedTimer>
+
+qint64 monotonicUs()
+{
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.nsecsElapsed() / 1000;
+}
+
+FramePacket packetFromVideoFrame(const QVideoFrame &frame, quint64 sequence)
+{
+    FramePacket packet;
+    packet.captureUs = monotonicUs();
+    packet.sequence = sequence;
+    packet.size = frame.size();
+    packet.ptsUs = frame.startTime() >= 0 ? frame.startTime() : packet.captureUs;
+
+    const QVideoFrameFormat::PixelFormat pixelFormat = frame.pixelFormat();
+    if (pixelFormat == QVideoFrameFormat::Format_YUYV || pixelFormat == QVideoFrameFormat::Format_Jpeg) {
+        // 原始数据直接拷贝，不做任何解码
+        QVideoFrame mapped(frame);
+        if (!mapped.map(QVideoFrame::ReadOnly)) {
+            return packet;
+        }
+        if (pixelFormat == QVideoFrameFormat::Format_YUYV) {
+            packet.format = FramePixelFormat::YUYV;
+            packet.bytesPerLine = mapped.bytesPerLine(0);
+            packet.data = QByteArray(reinterpret_cast<const char*>(mapped.bits(0)),
+                                     qsizetype(packet.bytesPerLine) * packet.size.height());
+        } else {
+            packet.format = FramePixelFormat::MJPEG;
+            packet.data = QByteArray(reinterpret_cast<const char*>(mapped.bits(0)), mapped.mappedBytes(0));
+        }
+        mapped.unmap();
+        return packet;
+    }
+
+    // 其他格式（NV12等）由Qt转换为RGB32
+    QImage image = frame.toImage();
+    if (image.isNull()) {
+        return packet;
+    }
+    if (image.format() != QImage::Format_RGB32) {
+        image = image.convertToFormat(QImage::Format_RGB32);
+    }
+    packet.format = FramePixelFormat::RGB32;
+    packet.size = image.size();
+    packet.bytesPerLine = int(image.bytesPerLine());
+    packet.data = QByteArray(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
+    return packet;
+}
+
+QString pixelFormatName(FramePixelFormat format)
+{
+    switch (format) {
+        case FramePixelFormat::YUYV:
+            return "YUYV";
+        case FramePixelFormat::MJPEG:
+            return "MJPEG";
+        case FramePixelFormat::RGB32:
+            return "RGB32";
+        case FramePixelFormat::PCM16:
+            return "PCM16";
+        default:
+            return "Unknown";
+    }
+}
+
+FramePixelFormat pixelFormatFromName(const QString &name)
+{
+    const QString upper = name.toUpper();
+    if (upper == "YUYV" || upper == "YUY2") {
+        return FramePixelFormat::YUYV;
+    }
+    if (upper == "MJPEG" || upper == "MJPG" || upper == "JPEG") {
+        return FramePixelFormat::MJPEG;
+    }
+    if (upper == "RGB32") {
+        return FramePixelFormat::RGB32;
+    }
+    if (upper == "PCM16") {
+        return FramePixelFormat::PCM16;
+    }
+    return FramePixelFormat::Unknown;
+}
+
+FramePacket packetFromAudio(const QByteArray &pcm, int sampleRate, int channelCount, quint64 sequence)
+{
+    FramePacket packet;
+    packet.format = FramePixelFormat::PCM16;
+    packet.data = pcm;
+    packet.sampleRate = sampleRate;
+    packet.channelCount = channelCount;
+    packet.sequence = sequence;
+    // 时间戳取这段音频第一个采样的时刻
+    const int bytesPerFrame = qMax(1, channelCount) * 2;
+    const qint64 durationUs = sampleRate > 0 ? qint64(pcm.size() / bytesPerFrame) * 1000000 / sampleRate : 0;
+    packet.captureUs = monotonicUs();
+    packet.ptsUs = packet.captureUs - durationUs;
+    return packet;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <QByteArray>
+#include <QSize>
+#include <QString>
+#include <QMetaType>
+#include <memory>
+
+class QVideoFrame;
+
+// 管线内部使用的像素格式，与QVideoFrameFormat解耦，便于在没有摄像头的环境下生成测试帧
+enum class FramePixelFormat {
+    Unknown,
+    YUYV,
+    MJPEG,
+    RGB32,
+    PCM16     // 音频：16位有符号交错PCM
+};
+
+// 录制/分析管线中流转的一帧数据
+// data为隐式共享的QByteArray，按值传递时不会复制像素数据；
+// 需要长期保存帧数据的地方（如预录缓存）应拷贝data而不是保留packet，否则会一直占用摄像头缓冲区
+struct FramePacket {
+    QByteArray data;
+    FramePixelFormat format = FramePixelFormat::Unknown;
+    QSize size;
+    int bytesPerLine = 0;
+    qint64 ptsUs = -1;        // 摄像头给出的显示时间戳（微秒），录制时原样保留
+    qint64 captureUs = 0;     // 进入管线时的单调时钟时间（微秒），用于计算端到端延迟
+    quint64 sequence = 0;     // 帧序号
+    bool keyFrame = true;     // YUYV/MJPEG每帧都可独立解码
+    int sampleRate = 0;       // 仅音频
+    int channelCount = 0;     // 仅音频
+    // data不拥有内存时（指向映射中的摄像头帧），由owner保证packet存活期间内存有效
+    std::shared_ptr<const void> owner;
+
+    bool isValid() const { return !data.isEmpty() && format != FramePixelFormat::Unknown; }
+    bool isAudio() const { return format == FramePixelFormat::PCM16; }
+};
+
+Q_DECLARE_METATYPE(FramePacket)
+
+// 进程内单调时钟（微秒）
+qint64 monotonicUs();
+
+// 从摄像头帧中取出原始数据，YUYV和MJPEG保持原样，其他格式转换为RGB32
+FramePacket packetFromVideoFrame(const QVideoFrame &frame, quint64 sequence);
+
+// 把一段采集到的PCM音频包装为管线帧
+FramePacket packetFromAudio(const QByteArray &pcm, int sampleRate, int channelCount, quint64 sequence);
+
+// 像素格式名称，用于日志和索引文件
+QString pixelFormatName(FramePixelFormat format);
+FramePixelFormat pixelFormatFromName(const QString &name);
@@ -0,0 +1,21 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include "FramePacket.h"
+
+// 录制管线的输出端接口
+// open()在调用线程执行，writeFrame()在管线的写入线程执行，close()在管线停止时执行
+class FrameSink {
+public:
+    virtual ~FrameSink() = default;
+
+    virtual bool open() = 0;
+    virtual bool writeFrame(const FramePacket &packet) = 0;
+    virtual void close() = 0;
+
+    virtual QString errorString() const = 0;
+    virtual qint64 bytesWritten() const = 0;
+
+    // 输出端写入的所有文件（含索引文件），用于关闭后落盘同步
+    virtual QStringList outputFiles() const { return QStringList(); }
+};
@@ -0,0 +1,190 @@
+#include "HeadlessCapture.h"
+#include "CaptureController.h"
+#include "FormatSelector.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QMediaDevices>
+#include <QTextStream>
+#include <QTimer>
+#include <csignal>
+
+namespace {
+    volatile std::sig_atomic_t g_interrupted = 0;
+
+    void handleInterrupt(int)
+    {
+        g_interrupted = 1;
+    }
+
+    QAudioDevice findAudioInput(const QString &spec)
+    {
+        if (spec == "default") {
+            return QMediaDevices::defaultAudioInput();
+        }
+        for (const QAudioDevice &device : QMediaDevices::audioInputs()) {
+            if (device.description().contains(spec, Qt::CaseInsensitive)) {
+                return device;
+            }
+        }
+        return QAudioDevice();
+    }
+}
+
+int runHeadless(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("摄像头无界面采集：录制原始帧或MJPEG直通AVI并输出统计");
+    parser.addHelpOption();
+    parser.addOption({"headless", "无界面模式"});
+    parser.addOption({"list-devices", "列出摄像头及其格式后退出"});
+    parser.addOption({"device", "摄像头序号、设备ID或名称的一部分，默认使用系统默认摄像头", "device"});
+    parser.addOption({"format", "像素格式：auto、yuyv 或 mjpeg", "format", "auto"});
+    parser.addOption({"size", "分辨率，如 1920x1080", "size", "1920x1080"});
+    parser.addOption({"fps", "帧率", "fps", "30"});
+    parser.addOption({"output", "输出文件（.raw 原始帧，.avi MJPEG直通），不指定时只采集和统计", "path"});
+    parser.addOption({"duration", "采集时长（秒），0表示直到按Ctrl+C", "seconds", "0"});
+    parser.addOption({"audio", "同时录制音频：default 或音频设备名称的一部分", "device"});
+    parser.addOption({"segment-seconds", "按时长分段（秒），0表示不分段", "seconds", "0"});
+    parser.addOption({"segment-mb", "按大小分段（MB），0表示不分段", "mb", "0"});
+    parser.addOption({"motion", "移动侦测录制：检测到移动时才录制，--output作为文件名前缀，每次事件一个文件"});
+    parser.addOption({"motion-sensitivity", "移动侦测灵敏度（1~100）", "value", "50"});
+    parser.addOption({"pre-roll", "移动侦测录制的预录时长（秒）", "seconds", "5"});
+    parser.addOption({"post-roll", "最后一次检测到移动后继续录制的时长（秒）", "seconds", "10"});
+    parser.addOption({"stall-intervals", "连续多少个帧间隔没有画面判定为卡顿", "intervals", "10"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    if (parser.isSet("list-devices")) {
+        const QList<QCameraDevice> cameras = QMediaDevices::videoInputs();
+        for (int i = 0; i < cameras.size(); ++i) {
+            out << i << ": " << cameras[i].description() << "  [" << QString::fromUtf8(cameras[i].id()) << "]" << Qt::endl;
+            for (const QCameraFormat &format : cameras[i].videoFormats()) {
+                out << "    " << FormatSelector::pixelFormatLabel(format.pixelFormat()) << " "
+                    << format.resolution().width() << "x" << format.resolution().height()
+                    << " @ " << format.maxFrameRate() << Qt::endl;
+            }
+        }
+        return 0;
+    }
+
+    const QStringList sizeParts = parser.value("size").split('x');
+    if (sizeParts.size() != 2) {
+        out << "无效的分辨率: " << parser.value("size") << Qt::endl;
+        return 1;
+    }
+    const QSize size(sizeParts[0].toInt(), sizeParts[1].toInt());
+    const QCameraDevice device = CaptureController::findCamera(parser.value("device"));
+    if (device.isNull()) {
+        out << "找不到摄像头: " << parser.value("device") << Qt::endl;
+        return 1;
+    }
+
+    CaptureController controller;
+    controller.watchdog()->setMissedIntervals(parser.value("stall-intervals").toInt());
+    if (parser.isSet("audio")) {
+        const QAudioDevice audio = findAudioInput(parser.value("audio"));
+        if (audio.isNull()) {
+            out << "找不到音频设备: " << parser.value("audio") << Qt::endl;
+            return 1;
+        }
+        controller.setAudioDevice(audio);
+    }
+    if (!controller.open(device, parser.value("format"), size, parser.value("fps").toInt())) {
+        out << "无法打开摄像头: " << controller.errorString() << Qt::endl;
+        return 1;
+    }
+
+    const QString output = parser.value("output");
+    if (parser.isSet("motion")) {
+        if (output.isEmpty()) {
+            out << "移动侦测录制需要用--output指定文件名前缀" << Qt::endl;
+            return 1;
+        }
+        // 预录缓存按格式分配，自动格式校验后切换格式时重新分配
+        const int preRollSeconds = parser.value("pre-roll").toInt();
+        controller.configurePreRoll(preRollSeconds);
+        QObject::connect(&controller, &CaptureController::formatChanged, &app, [&controller, preRollSeconds]() {
+            controller.configurePreRoll(preRollSeconds);
+        });
+        if (!controller.startMotionRecording(output, parser.value("motion-sensitivity").toInt(),
+                                             parser.value("post-roll").toInt())) {
+            out << "无法开启移动侦测录制: " << controller.errorString() << Qt::endl;
+            return 1;
+        }
+        QObject::connect(&controller, &CaptureController::motionRecordingChanged, &app,
+                         [&](bool recording, const QString &path) {
+            out << (recording ? "移动事件开始录制: " : "移动事件录制结束: ") << path << Qt::endl;
+        });
+    } else if (!output.isEmpty()) {
+        const qint64 segmentUs = qint64(parser.value("segment-seconds").toDouble() * 1000000);
+        const qint64 segmentBytes = parser.value("segment-mb").toLongLong() * 1024 * 1024;
+        if (!controller.startRecording(output, segmentUs, segmentBytes)) {
+            out << "无法开始录制: " << controller.errorString() << Qt::endl;
+            return 1;
+        }
+    }
+
+    int exitCode = 0;
+    auto fail = [&](const QString &message) {
+        out << "错误: " << message << Qt::endl;
+        exitCode = 2;
+        app.quit();
+    };
+    QObject::connect(&controller, &CaptureController::errorOccurred, &app, fail);
+    QObject::connect(&controller, &CaptureController::recordingError, &app, fail);
+
+    // 每秒一行统计
+    QObject::connect(&controller, &CaptureController::statsUpdated, &app, [&]() {
+        out << QString("帧率 %1  已收 %2").arg(controller.fps(), 0, 'f', 1).arg(controller.framesReceived());
+        if (controller.isRecording()) {
+            const RecordingStats stats = controller.pipeline()->stats();
+            out << QString("  已写 %1  丢弃 %2  队列 %3/%4  %5 MB")
+                       .arg(stats.encoded).arg(stats.dropped)
+                       .arg(stats.queueDepth).arg(stats.queueCapacity)
+                       .arg(stats.bytesWritten / (1024.0 * 1024.0), 0, 'f', 1);
+        }
+        if (controller.watchdog()->isStalled()) {
+            out << QString("  卡顿 %1 ms").arg(controller.watchdog()->stalledForMs());
+        }
+        out << Qt::endl;
+    });
+
+    // Ctrl+C时正常收尾（写完队列、补全AVI索引），而不是直接结束进程
+    std::signal(SIGINT, handleInterrupt);
+    std::signal(SIGTERM, handleInterrupt);
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, &app, [&]() {
+        if (g_interrupted) {
+            app.quit();
+        }
+    });
+    interruptTimer.start(100);
+
+    const double durationSec = parser.value("duration").toDouble();
+    if (durationSec > 0) {
+        QTimer::singleShot(int(durationSec * 1000), &app, &QCoreApplication::quit);
+    }
+
+    app.exec();
+
+    const bool recorded = controller.isRecording();
+    controller.close();
+    if (recorded) {
+        const RecordingStats stats = controller.pipeline()->stats();
+        out << QString("录制完成: 已写 %1 帧，丢弃 %2 帧，%3 MB")
+                   .arg(stats.encoded).arg(stats.dropped)
+                   .arg(stats.bytesWritten / (1024.0 * 1024.0), 0, 'f', 1) << Qt::endl;
+        out << "端到端延迟: " << controller.pipeline()->latencyHistogram().summary() << Qt::endl;
+        if (stats.preRollFrames > 0) {
+            out << QString("预录 %1 帧，最早一帧写入时距采集 %2 s")
+                       .arg(stats.preRollFrames).arg(stats.maxPreRollAgeUs / 1e6, 0, 'f', 1) << Qt::endl;
+        }
+    }
+    const StreamWatchdogStats watchdog = controller.watchdog()->stats();
+    if (watchdog.stalls > 0) {
+        out << QString("卡顿 %1 次，恢复 %2 次，最长恢复 %3 ms")
+                   .arg(watchdog.stalls).arg(watchdog.recoveries).arg(watchdog.maxRecoveryMs) << Qt::endl;
+    }
+    return exitCode;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+class QCoreApplication;
+
+// 无界面采集模式（--headless）：不创建任何窗口控件，按命令行参数打开摄像头、录制并每秒输出统计
+// 返回进程退出码
+int runHeadless(QCoreApplication &app);
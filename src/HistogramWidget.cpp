@@ -0,0 +1,100 @@
+#include "HistogramWidget.h"
+#include <QPainter>
+#include <QPainterPath>
+
+namespace {
+    // 底部文字行的高度
+    const int TEXT_HEIGHT = 14;
+
+    // 把一个通道的直方图画成折线或填充区域，按scale归一化
+    QPainterPath histogramPath(const quint32 *bins, const QRect &area, double scale, bool closed)
+    {
+        QPainterPath path;
+        if (closed) {
+            path.moveTo(area.left(), area.bottom());
+        }
+        for (int i = 0; i < 256; ++i) {
+            const double x = area.left() + i * (area.width() - 1) / 255.0;
+            const double y = area.bottom() - qMin(1.0, bins[i] * scale) * (area.height() - 1);
+            if (i == 0 && !closed) {
+                path.moveTo(x, y);
+            } else {
+                path.lineTo(x, y);
+            }
+        }
+        if (closed) {
+            path.lineTo(area.right(), area.bottom());
+            path.closeSubpath();
+        }
+        return path;
+    }
+}
+
+HistogramWidget::HistogramWidget(QWidget* parent)
+    : QWidget(parent)
+{
+    setMinimumSize(200, 90);
+}
+
+void HistogramWidget::setHistogram(const FrameHistogram &histogram)
+{
+    this->histogram = histogram;
+    update();
+}
+
+QSize HistogramWidget::sizeHint() const
+{
+    return QSize(280, 110);
+}
+
+void HistogramWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    paintHistogram(painter, rect(), histogram);
+}
+
+void HistogramWidget::paintHistogram(QPainter &painter, const QRect &rect, const FrameHistogram &histogram)
+{
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.fillRect(rect, QColor(0, 0, 0, 160));
+
+    const QRect area = rect.adjusted(4, 4, -4, -4 - TEXT_HEIGHT);
+    if (!histogram.isValid() || area.height() <= 0) {
+        painter.setPen(Qt::white);
+        painter.drawText(rect, Qt::AlignCenter, "等待画面");
+        painter.restore();
+        return;
+    }
+
+    // 两端的桶常因过曝/欠曝出现尖峰，归一化时不计入，避免其余部分被压扁
+    quint32 peak = 1;
+    for (int i = 1; i < 255; ++i) {
+        peak = qMax(peak, qMax(histogram.luma[i], qMax(histogram.red[i], qMax(histogram.green[i], histogram.blue[i]))));
+    }
+    const double scale = 1.0 / peak;
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(200, 200, 200, 150));
+    painter.drawPath(histogramPath(histogram.luma, area, scale, true));
+    painter.setBrush(Qt::NoBrush);
+    painter.setPen(QPen(QColor(255, 64, 64, 220), 1));
+    painter.drawPath(histogramPath(histogram.red, area, scale, false));
+    painter.setPen(QPen(QColor(64, 255, 64, 220), 1));
+    painter.drawPath(histogramPath(histogram.green, area, scale, false));
+    painter.setPen(QPen(QColor(96, 96, 255, 220), 1));
+    painter.drawPath(histogramPath(histogram.blue, area, scale, false));
+
+    // 过曝/欠曝比例超过1%时用红色提示
+    const bool warn = histogram.clippedHighPercent > 1.0 || histogram.clippedLowPercent > 1.0;
+    painter.setPen(warn ? QColor(255, 96, 96) : Qt::white);
+    painter.setFont(QFont("Arial", 8));
+    painter.drawText(QRect(rect.left() + 4, rect.bottom() - TEXT_HEIGHT, rect.width() - 8, TEXT_HEIGHT),
+                     Qt::AlignLeft | Qt::AlignVCenter,
+                     QString("平均亮度 %1  过曝 %2%  欠曝 %3%  统计 %4 ms")
+                         .arg(histogram.meanLuma, 0, 'f', 0)
+                         .arg(histogram.clippedHighPercent, 0, 'f', 1)
+                         .arg(histogram.clippedLowPercent, 0, 'f', 1)
+                         .arg(histogram.computeUs / 1000.0, 0, 'f', 2));
+    painter.restore();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <QWidget>
+#include "FrameHistogram.h"
+
+class QPainter;
+
+// 直方图显示控件：亮度为灰色填充，RGB为三条曲线，下方显示平均亮度和过曝/欠曝比例
+class HistogramWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit HistogramWidget(QWidget* parent = nullptr);
+
+    void setHistogram(const FrameHistogram &histogram);
+    QSize sizeHint() const override;
+
+    // 预览叠加层也用这个函数绘制
+    static void paintHistogram(QPainter &painter, const QRect &rect, const FrameHistogram &histogram);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    FrameHistogram histogram;
+};
@@ -0,0 +1,541 @@
+#include "ImageAdjust.h"
+#include "TaskPool.h"
+#include <QMutexLocker>
+#include <cmath>
+
+#include "SimdSupport.h"
+
+namespace {
+    // 定点系数：对比度和YUYV色度按1/128（不超过256，x * 系数在16位无符号范围内），RGB饱和度按1/64
+    // （(c - 亮度) * 系数在16位有符号范围内），SSE2都可以直接用16位乘法
+    const double ADJUST_CONTRAST_SCALE = 1.28;
+    const double ADJUST_CHROMA_SCALE = 1.28;
+    const double ADJUST_RGB_SATURATION_SCALE = 0.64;
+    const int ADJUST_RGB_SATURATION_UNITY = 64;
+    // 亮度-100~100对应的偏移：YUYV为有限范围（219级），RGB为全范围
+    const double ADJUST_LUMA_OFFSET_SCALE = 1.1;
+    const double ADJUST_RGB_OFFSET_SCALE = 1.28;
+    // 整帧处理的最小条带行数
+    const int ADJUST_MIN_STRIPE_ROWS = 32;
+
+    inline int clampAdjustByte(int value)
+    {
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
+    }
+
+    // 以128为中心的线性变换，SSE2路径按同样的定点公式计算
+    inline int adjustLinear(int value, int multiplier, int offset)
+    {
+        return clampAdjustByte(128 + (((value - 128) * multiplier) >> 7) + offset);
+    }
+}
+
+// 由ImageAdjustSettings编译出的查找表和定点系数，发布后只读
+struct ImageAdjustTables {
+    bool linear = true;             // 伽马为100，可以用定点运算代替查表
+    int contrastMul = 128;
+    int lumaOffset = 0;
+    int rgbOffset = 0;
+    int chromaMul = 128;
+    int rgbSaturationMul = ADJUST_RGB_SATURATION_UNITY;
+    uchar luma[256];
+    uchar chroma[256];
+    uchar rgb[256];
+    // 与luma/rgb相同的表按32位存放，供AVX2的gather使用
+    quint32 lumaWords[256];
+    quint32 rgbWords[256];
+};
+
+bool ImageAdjustSettings::isIdentity() const
+{
+    return brightness == 0 && contrast == 100 && saturation == 100 && gamma == 100;
+}
+
+bool ImageAdjustSettings::operator==(const ImageAdjustSettings &other) const
+{
+    return brightness == other.brightness && contrast == other.contrast &&
+           saturation == other.saturation && gamma == other.gamma;
+}
+
+ImageAdjust::ImageAdjust()
+    : m_parallel(true)
+{
+}
+
+void ImageAdjust::setParallel(bool parallel)
+{
+    m_parallel = parallel;
+}
+
+void ImageAdjust::setSettings(const ImageAdjustSettings &settings)
+{
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (settings == m_settings) {
+            return;
+        }
+    }
+    // 编译在锁外进行，处理中的帧继续使用旧表
+    std::shared_ptr<const ImageAdjustTables> tables = settings.isIdentity() ? nullptr : compile(settings);
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_settings = settings;
+    m_tables = std::move(tables);
+}
+
+ImageAdjustSettings ImageAdjust::settings() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_settings;
+}
+
+bool ImageAdjust::isActive() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_tables != nullptr;
+}
+
+std::shared_ptr<const ImageAdjustTables> ImageAdjust::tables() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_tables;
+}
+
+std::shared_ptr<const ImageAdjustTables> ImageAdjust::compile(const ImageAdjustSettings &settings)
+{
+    auto tables = std::make_shared<ImageAdjustTables>();
+    tables->linear = settings.gamma == 100;
+    tables->contrastMul = qBound(0, qRound(settings.contrast * ADJUST_CONTRAST_SCALE), 256);
+    tables->lumaOffset = qRound(settings.brightness * ADJUST_LUMA_OFFSET_SCALE);
+    tables->rgbOffset = qRound(settings.brightness * ADJUST_RGB_OFFSET_SCALE);
+    tables->chromaMul = qBound(0, qRound(settings.saturation * ADJUST_CHROMA_SCALE), 256);
+    tables->rgbSaturationMul = qBound(0, qRound(settings.saturation * ADJUST_RGB_SATURATION_SCALE), 128);
+
+    // 伽马作用在对比度和亮度之后；YUYV只处理有限范围[16, 235]内的亮度
+    const double exponent = 100.0 / qBound(20, settings.gamma, 300);
+    for (int i = 0; i < 256; ++i) {
+        int luma = adjustLinear(i, tables->contrastMul, tables->lumaOffset);
+        int rgb = adjustLinear(i, tables->contrastMul, tables->rgbOffset);
+        if (!tables->linear) {
+            if (luma >= 16 && luma <= 235) {
+                luma = 16 + qRound(219.0 * std::pow((luma - 16) / 219.0, exponent));
+            }
+            rgb = qRound(255.0 * std::pow(rgb / 255.0, exponent));
+        }
+        tables->luma[i] = uchar(luma);
+        tables->rgb[i] = uchar(clampAdjustByte(rgb));
+        tables->chroma[i] = uchar(adjustLinear(i, tables->chromaMul, 0));
+        tables->lumaWords[i] = tables->luma[i];
+        tables->rgbWords[i] = tables->rgb[i];
+    }
+    return tables;
+}
+
+namespace {
+#ifdef CAMERA_HAVE_SSE2
+    // 16个字节的adjustLinear()：((v - 128) * m) >> 7 等于 ((v * m) >> 7) - m，
+    // v放在16位的高字节（v * 256）与2m做无符号高位乘法正好得到 (v * m) >> 7，-m并入base，每半边只需一次乘法和一次加法
+    inline __m128i adjustLinearBytes(__m128i in, __m128i doubledMul, __m128i base, __m128i *hi)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        *hi = _mm_add_epi16(_mm_mulhi_epu16(_mm_unpackhi_epi8(zero, in), doubledMul), base);
+        return _mm_add_epi16(_mm_mulhi_epu16(_mm_unpacklo_epi8(zero, in), doubledMul), base);
+    }
+
+    // 伽马为100时的YUYV：每次16字节，Y和UV通道交替使用不同系数，返回处理到的位置
+    int adjustYuyvLinearSse2(const ImageAdjustTables &t, const uchar *src, uchar *dst, int bytes)
+    {
+        const short lumaMul = short(t.contrastMul * 2);
+        const short chromaMul = short(t.chromaMul * 2);
+        const short lumaBase = short(128 + t.lumaOffset - t.contrastMul);
+        const short chromaBase = short(128 - t.chromaMul);
+        const __m128i mul = _mm_set_epi16(chromaMul, lumaMul, chromaMul, lumaMul, chromaMul, lumaMul, chromaMul, lumaMul);
+        const __m128i base = _mm_set_epi16(chromaBase, lumaBase, chromaBase, lumaBase,
+                                           chromaBase, lumaBase, chromaBase, lumaBase);
+        int x = 0;
+        for (; x + 16 <= bytes; x += 16) {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+            __m128i hi;
+            const __m128i lo = adjustLinearBytes(in, mul, base, &hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+        }
+        return x;
+    }
+
+    // 4个像素（每通道16位，BGRA交替）的饱和度：亮度用madd求加权和，再扩展到同一像素的4个通道
+    inline void saturatePixels(__m128i *lo, __m128i *hi, __m128i mul)
+    {
+        const __m128i weights = _mm_set_epi16(0, 77, 150, 29, 0, 77, 150, 29);
+        const __m128i round = _mm_set1_epi32(128);
+        __m128i sumLo = _mm_madd_epi16(*lo, weights);
+        __m128i sumHi = _mm_madd_epi16(*hi, weights);
+        sumLo = _mm_add_epi32(sumLo, _mm_shuffle_epi32(sumLo, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumHi = _mm_add_epi32(sumHi, _mm_shuffle_epi32(sumHi, _MM_SHUFFLE(2, 3, 0, 1)));
+        const __m128i luma = _mm_packs_epi32(_mm_srli_epi32(_mm_add_epi32(sumLo, round), 8),
+                                             _mm_srli_epi32(_mm_add_epi32(sumHi, round), 8));
+        const __m128i lumaLo = _mm_unpacklo_epi16(luma, luma);
+        const __m128i lumaHi = _mm_unpackhi_epi16(luma, luma);
+        // (c - 亮度)在±255以内，乘以不超过128的系数不会溢出；超出0~255的部分在打包时截断
+        *lo = _mm_add_epi16(lumaLo, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(*lo, lumaLo), mul), 6));
+        *hi = _mm_add_epi16(lumaHi, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(*hi, lumaHi), mul), 6));
+    }
+
+    // 伽马为100时的RGB32：在同一趟中完成线性变换和饱和度（结果与查表后再调饱和度一致），返回处理到的像素
+    int adjustRgb32LinearSse2(const ImageAdjustTables &t, const uchar *src, uchar *dst, int width)
+    {
+        const bool saturate = t.rgbSaturationMul != ADJUST_RGB_SATURATION_UNITY;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i maxByte = _mm_set1_epi16(255);
+        const __m128i mul = _mm_set1_epi16(short(t.contrastMul * 2));
+        const __m128i base = _mm_set1_epi16(short(128 + t.rgbOffset - t.contrastMul));
+        const __m128i saturation = _mm_set1_epi16(short(t.rgbSaturationMul));
+        const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000));
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+            __m128i hi;
+            __m128i lo = adjustLinearBytes(in, mul, base, &hi);
+            if (saturate) {
+                // 饱和度按截断后的通道值计算
+                lo = _mm_min_epi16(_mm_max_epi16(lo, zero), maxByte);
+                hi = _mm_min_epi16(_mm_max_epi16(hi, zero), maxByte);
+                saturatePixels(&lo, &hi, saturation);
+            }
+            const __m128i out = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                             _mm_or_si128(_mm_andnot_si128(alphaMask, out), _mm_and_si128(alphaMask, in)));
+        }
+        return x;
+    }
+
+    // 已经查过表的RGB32像素原地调饱和度，返回处理到的像素
+    int saturateRgb32Sse2(uchar *data, int width, int multiplier)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mul = _mm_set1_epi16(short(multiplier));
+        const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000));
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + x * 4));
+            __m128i lo = _mm_unpacklo_epi8(in, zero);
+            __m128i hi = _mm_unpackhi_epi8(in, zero);
+            saturatePixels(&lo, &hi, mul);
+            const __m128i out = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + x * 4),
+                             _mm_or_si128(_mm_andnot_si128(alphaMask, out), _mm_and_si128(alphaMask, in)));
+        }
+        return x;
+    }
+#endif
+
+#ifdef CAMERA_HAVE_AVX2
+    // 8个像素的饱和度，与saturatePixels()相同，每128位通道各4个像素
+    CAMERA_TARGET_AVX2 inline void saturatePixelsAvx2(__m256i *lo, __m256i *hi, __m256i mul)
+    {
+        const __m256i weights = _mm256_set_epi16(0, 77, 150, 29, 0, 77, 150, 29, 0, 77, 150, 29, 0, 77, 150, 29);
+        const __m256i round = _mm256_set1_epi32(128);
+        __m256i sumLo = _mm256_madd_epi16(*lo, weights);
+        __m256i sumHi = _mm256_madd_epi16(*hi, weights);
+        sumLo = _mm256_add_epi32(sumLo, _mm256_shuffle_epi32(sumLo, _MM_SHUFFLE(2, 3, 0, 1)));
+        sumHi = _mm256_add_epi32(sumHi, _mm256_shuffle_epi32(sumHi, _MM_SHUFFLE(2, 3, 0, 1)));
+        const __m256i luma = _mm256_packs_epi32(_mm256_srli_epi32(_mm256_add_epi32(sumLo, round), 8),
+                                                _mm256_srli_epi32(_mm256_add_epi32(sumHi, round), 8));
+        const __m256i lumaLo = _mm256_unpacklo_epi16(luma, luma);
+        const __m256i lumaHi = _mm256_unpackhi_epi16(luma, luma);
+        *lo = _mm256_add_epi16(lumaLo, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(*lo, lumaLo), mul), 6));
+        *hi = _mm256_add_epi16(lumaHi, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(*hi, lumaHi), mul), 6));
+    }
+
+    // 已经调过亮度/对比度/伽马的8个像素调饱和度，alpha取自原始像素
+    CAMERA_TARGET_AVX2 inline __m256i saturateRgb32Avx2(__m256i adjusted, __m256i in, __m256i mul)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000));
+        __m256i lo = _mm256_unpacklo_epi8(adjusted, zero);
+        __m256i hi = _mm256_unpackhi_epi8(adjusted, zero);
+        saturatePixelsAvx2(&lo, &hi, mul);
+        return _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), in, alphaMask);
+    }
+
+    // 伽马不为100时的YUYV：Y用gather从32位表中查（每次8个），UV的变换总是线性的，按定点公式计算；
+    // 每次32字节，返回处理到的位置
+    CAMERA_TARGET_AVX2 int lookupYuyvAvx2(const ImageAdjustTables &t, const uchar *src, uchar *dst, int bytes)
+    {
+        const int *lumaTable = reinterpret_cast<const int*>(t.lumaWords);
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const __m256i chromaMask = _mm256_set1_epi16(short(0xFF00));
+        const __m256i chromaMul = _mm256_set1_epi16(short(t.chromaMul * 2));
+        const __m256i chromaBase = _mm256_set1_epi16(short(128 - t.chromaMul));
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i maxByte = _mm256_set1_epi16(255);
+        int x = 0;
+        for (; x + 32 <= bytes; x += 32) {
+            const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+            // 每个32位字为Y0 U Y1 V
+            const __m256i y0 = _mm256_i32gather_epi32(lumaTable, _mm256_and_si256(in, byteMask), 4);
+            const __m256i y1 = _mm256_i32gather_epi32(lumaTable, _mm256_and_si256(_mm256_srli_epi32(in, 16), byteMask), 4);
+            __m256i chroma = _mm256_add_epi16(_mm256_mulhi_epu16(_mm256_and_si256(in, chromaMask), chromaMul), chromaBase);
+            chroma = _mm256_slli_epi16(_mm256_min_epi16(_mm256_max_epi16(chroma, zero), maxByte), 8);
+            const __m256i luma = _mm256_or_si256(y0, _mm256_slli_epi32(y1, 16));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_or_si256(luma, chroma));
+        }
+        return x;
+    }
+
+    // RGB32每次8个像素：伽马为100时按定点公式计算，否则B/G/R各用一次gather查表，再调饱和度，返回处理到的像素
+    CAMERA_TARGET_AVX2 int adjustRgb32Avx2(const ImageAdjustTables &t, const uchar *src, uchar *dst, int width)
+    {
+        const bool saturate = t.rgbSaturationMul != ADJUST_RGB_SATURATION_UNITY;
+        const int *rgbTable = reinterpret_cast<const int*>(t.rgbWords);
+        const __m256i byteMask = _mm256_set1_epi32(0xFF);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i mul = _mm256_set1_epi16(short(t.contrastMul * 2));
+        const __m256i base = _mm256_set1_epi16(short(128 + t.rgbOffset - t.contrastMul));
+        const __m256i saturation = _mm256_set1_epi16(short(t.rgbSaturationMul));
+        const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000));
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            const __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+            __m256i adjusted;
+            if (t.linear) {
+                const __m256i lo = _mm256_add_epi16(_mm256_mulhi_epu16(_mm256_unpacklo_epi8(zero, in), mul), base);
+                const __m256i hi = _mm256_add_epi16(_mm256_mulhi_epu16(_mm256_unpackhi_epi8(zero, in), mul), base);
+                adjusted = _mm256_packus_epi16(lo, hi);
+            } else {
+                const __m256i b = _mm256_i32gather_epi32(rgbTable, _mm256_and_si256(in, byteMask), 4);
+                const __m256i g = _mm256_i32gather_epi32(rgbTable, _mm256_and_si256(_mm256_srli_epi32(in, 8), byteMask), 4);
+                const __m256i r = _mm256_i32gather_epi32(rgbTable, _mm256_and_si256(_mm256_srli_epi32(in, 16), byteMask), 4);
+                adjusted = _mm256_or_si256(b, _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(r, 16)));
+            }
+            const __m256i out = saturate ? saturateRgb32Avx2(adjusted, in, saturation)
+                                         : _mm256_blendv_epi8(adjusted, in, alphaMask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), out);
+        }
+        return x;
+    }
+
+    // 256项字节表：vpermi2b按索引的低7位从两个寄存器（128项）中取字节，最高位选择前后两半
+    struct ByteTable512 {
+        __m512i low0, low1, high0, high1;
+    };
+
+    CAMERA_TARGET_AVX512VBMI inline ByteTable512 loadByteTable512(const uchar *table)
+    {
+        ByteTable512 t;
+        t.low0 = _mm512_loadu_si512(table);
+        t.low1 = _mm512_loadu_si512(table + 64);
+        t.high0 = _mm512_loadu_si512(table + 128);
+        t.high1 = _mm512_loadu_si512(table + 192);
+        return t;
+    }
+
+    CAMERA_TARGET_AVX512VBMI inline __m512i lookupBytes512(const ByteTable512 &t, __m512i index)
+    {
+        const __m512i low = _mm512_permutex2var_epi8(t.low0, index, t.low1);
+        const __m512i high = _mm512_permutex2var_epi8(t.high0, index, t.high1);
+        return _mm512_mask_blend_epi8(_mm512_movepi8_mask(index), low, high);
+    }
+
+    // 伽马不为100时的YUYV：每次64字节，Y和UV分别整体查表后按奇偶字节合并，返回处理到的位置
+    CAMERA_TARGET_AVX512VBMI int lookupYuyvVbmi(const ImageAdjustTables &t, const uchar *src, uchar *dst, int bytes)
+    {
+        const ByteTable512 luma = loadByteTable512(t.luma);
+        const ByteTable512 chroma = loadByteTable512(t.chroma);
+        const __mmask64 chromaBytes = 0xAAAAAAAAAAAAAAAAULL;
+        int x = 0;
+        for (; x + 64 <= bytes; x += 64) {
+            const __m512i in = _mm512_loadu_si512(src + x);
+            const __m512i out = _mm512_mask_blend_epi8(chromaBytes, lookupBytes512(luma, in), lookupBytes512(chroma, in));
+            _mm512_storeu_si512(dst + x, out);
+        }
+        return x;
+    }
+
+    // 16个像素的saturatePixelsAvx2()，每128位通道各4个像素。
+    // GCC的_mm512_shuffle_epi32/_mm512_srli_epi32以未定义的值作为合并源，-Wall下会误报未初始化，改用全选掩码的maskz形式
+    CAMERA_TARGET_AVX512VBMI inline void saturatePixels512(__m512i *lo, __m512i *hi, __m512i mul)
+    {
+        const __mmask16 all = 0xFFFF;
+        const __m512i weights = _mm512_set4_epi32(77, (150 << 16) | 29, 77, (150 << 16) | 29);
+        const __m512i round = _mm512_set1_epi32(128);
+        __m512i sumLo = _mm512_madd_epi16(*lo, weights);
+        __m512i sumHi = _mm512_madd_epi16(*hi, weights);
+        sumLo = _mm512_add_epi32(sumLo, _mm512_maskz_shuffle_epi32(all, sumLo, _MM_PERM_CDAB));
+        sumHi = _mm512_add_epi32(sumHi, _mm512_maskz_shuffle_epi32(all, sumHi, _MM_PERM_CDAB));
+        const __m512i luma = _mm512_packs_epi32(_mm512_maskz_srli_epi32(all, _mm512_add_epi32(sumLo, round), 8),
+                                                _mm512_maskz_srli_epi32(all, _mm512_add_epi32(sumHi, round), 8));
+        const __m512i lumaLo = _mm512_unpacklo_epi16(luma, luma);
+        const __m512i lumaHi = _mm512_unpackhi_epi16(luma, luma);
+        *lo = _mm512_add_epi16(lumaLo, _mm512_srai_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(*lo, lumaLo), mul), 6));
+        *hi = _mm512_add_epi16(lumaHi, _mm512_srai_epi16(_mm512_mullo_epi16(_mm512_sub_epi16(*hi, lumaHi), mul), 6));
+    }
+
+    // 伽马不为100时的RGB32：每次16个像素查表并调饱和度，返回处理到的像素
+    CAMERA_TARGET_AVX512VBMI int lookupRgb32Vbmi(const ImageAdjustTables &t, const uchar *src, uchar *dst, int width)
+    {
+        const bool saturate = t.rgbSaturationMul != ADJUST_RGB_SATURATION_UNITY;
+        const ByteTable512 rgb = loadByteTable512(t.rgb);
+        const __mmask64 alphaBytes = 0x8888888888888888ULL;
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i saturation = _mm512_set1_epi16(short(t.rgbSaturationMul));
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const __m512i in = _mm512_loadu_si512(src + x * 4);
+            __m512i out = lookupBytes512(rgb, in);
+            if (saturate) {
+                __m512i lo = _mm512_unpacklo_epi8(out, zero);
+                __m512i hi = _mm512_unpackhi_epi8(out, zero);
+                saturatePixels512(&lo, &hi, saturation);
+                out = _mm512_packus_epi16(lo, hi);
+            }
+            _mm512_storeu_si512(dst + x * 4, _mm512_mask_blend_epi8(alphaBytes, out, in));
+        }
+        return x;
+    }
+#endif
+
+    // YUYV一行（bytes为偶数），按level选择实现；SIMD处理不了的尾部和Scalar级别逐字节查表
+    void adjustYuyvRow(const ImageAdjustTables &t, SimdLevel level, const uchar *src, uchar *dst, int bytes)
+    {
+        int x = 0;
+#ifdef CAMERA_HAVE_AVX2
+        if (!t.linear && level >= SimdLevel::Avx512Vbmi) {
+            x = lookupYuyvVbmi(t, src, dst, bytes);
+        } else if (!t.linear && level >= SimdLevel::Avx2) {
+            x = lookupYuyvAvx2(t, src, dst, bytes);
+        }
+#endif
+#ifdef CAMERA_HAVE_SSE2
+        if (t.linear && level >= SimdLevel::Sse2) {
+            x = adjustYuyvLinearSse2(t, src, dst, bytes);
+        }
+#endif
+        for (; x < bytes; x += 2) {
+            dst[x] = t.luma[src[x]];
+            dst[x + 1] = t.chroma[src[x + 1]];
+        }
+    }
+
+    // RGB32的饱和度：每个通道向BT.601亮度靠拢或远离，alpha不变
+    inline quint32 saturatePixel(quint32 p, int multiplier)
+    {
+        const int r = (p >> 16) & 0xFF;
+        const int g = (p >> 8) & 0xFF;
+        const int b = p & 0xFF;
+        const int luma = (77 * r + 150 * g + 29 * b + 128) >> 8;
+        return (p & 0xFF000000) |
+               (quint32(clampAdjustByte(luma + (((r - luma) * multiplier) >> 6))) << 16) |
+               (quint32(clampAdjustByte(luma + (((g - luma) * multiplier) >> 6))) << 8) |
+               quint32(clampAdjustByte(luma + (((b - luma) * multiplier) >> 6)));
+    }
+
+    // RGB32一行：先按通道表调亮度/对比度/伽马，再调饱和度。
+    // AVX2/AVX-512在同一趟中完成两步；SSE2只有线性时同一趟完成，伽马不为100时查表后再批量调饱和度
+    void adjustRgb32Row(const ImageAdjustTables &t, SimdLevel level, const uchar *src, uchar *dst, int width)
+    {
+        const bool saturate = t.rgbSaturationMul != ADJUST_RGB_SATURATION_UNITY;
+        int x = 0;
+#ifdef CAMERA_HAVE_AVX2
+        if (!t.linear && level >= SimdLevel::Avx512Vbmi) {
+            x = lookupRgb32Vbmi(t, src, dst, width);
+        } else if (level >= SimdLevel::Avx2) {
+            x = adjustRgb32Avx2(t, src, dst, width);
+        }
+#endif
+#ifdef CAMERA_HAVE_SSE2
+        if (t.linear && level == SimdLevel::Sse2) {
+            x = adjustRgb32LinearSse2(t, src, dst, width);
+        }
+#endif
+        const int first = x;
+        for (; x < width; ++x) {
+            const uchar *s = src + x * 4;
+            uchar *d = dst + x * 4;
+            d[0] = t.rgb[s[0]];
+            d[1] = t.rgb[s[1]];
+            d[2] = t.rgb[s[2]];
+            d[3] = s[3];
+        }
+        if (!saturate || first >= width) {
+            return;
+        }
+        uchar *rest = dst + first * 4;
+        x = 0;
+#ifdef CAMERA_HAVE_SSE2
+        if (level >= SimdLevel::Sse2) {
+            x = saturateRgb32Sse2(rest, width - first, t.rgbSaturationMul);
+        }
+#endif
+        quint32 *pixels = reinterpret_cast<quint32*>(rest);
+        for (; x < width - first; ++x) {
+            pixels[x] = saturatePixel(pixels[x], t.rgbSaturationMul);
+        }
+    }
+}
+
+void ImageAdjust::apply(QImage *image) const
+{
+    const std::shared_ptr<const ImageAdjustTables> t = tables();
+    if (!t || !image || image->isNull()) {
+        return;
+    }
+    if (image->format() != QImage::Format_RGB32 && image->format() != QImage::Format_ARGB32) {
+        *image = image->convertToFormat(QImage::Format_RGB32);
+    }
+    // bits()在图像共享或引用只读数据时先复制
+    uchar *data = image->bits();
+    const qsizetype stride = image->bytesPerLine();
+    const int width = image->width();
+    const SimdLevel level = simdLevel();
+    auto rows = [=](int firstRow, int rowCount) {
+        for (int y = firstRow; y < firstRow + rowCount; ++y) {
+            uchar *row = data + y * stride;
+            adjustRgb32Row(*t, level, row, row, width);
+        }
+    };
+    if (m_parallel) {
+        TaskPool::shared()->parallelStripes("image_adjust", image->height(), rows, ADJUST_MIN_STRIPE_ROWS);
+    } else {
+        rows(0, image->height());
+    }
+}
+
+bool ImageAdjust::apply(FramePacket *packet, QByteArray *buffer) const
+{
+    const std::shared_ptr<const ImageAdjustTables> t = tables();
+    if (!t || !packet || !buffer) {
+        return false;
+    }
+    const bool yuyv = packet->format == FramePixelFormat::YUYV;
+    if ((!yuyv && packet->format != FramePixelFormat::RGB32) || packet->size.isEmpty()) {
+        return false;
+    }
+    const qsizetype stride = packet->bytesPerLine;
+    const qsizetype frameBytes = stride * packet->size.height();
+    if (packet->data.size() < frameBytes || stride < packet->size.width() * (yuyv ? 2 : 4)) {
+        return false;
+    }
+
+    // 整行（含行尾填充）一起处理，输出不留未初始化的字节
+    buffer->resize(frameBytes);
+    const uchar *src = reinterpret_cast<const uchar*>(packet->data.constData());
+    uchar *dst = reinterpret_cast<uchar*>(buffer->data());
+    const SimdLevel level = simdLevel();
+    auto rows = [=](int firstRow, int rowCount) {
+        for (int y = firstRow; y < firstRow + rowCount; ++y) {
+            if (yuyv) {
+                adjustYuyvRow(*t, level, src + y * stride, dst + y * stride, int(stride & ~qsizetype(1)));
+            } else {
+                adjustRgb32Row(*t, level, src + y * stride, dst + y * stride, int(stride / 4));
+            }
+        }
+    };
+    if (m_parallel) {
+        TaskPool::shared()->parallelStripes("image_adjust", packet->size.height(), rows, ADJUST_MIN_STRIPE_ROWS);
+    } else {
+        rows(0, packet->size.height());
+    }
+
+    packet->data = *buffer;
+    packet->owner.reset();
+    return true;
+}
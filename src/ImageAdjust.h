@@ -0,0 +1,57 @@
+#pragma once
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <memory>
+#include "FramePacket.h"
+
+struct ImageAdjustTables;
+
+// 软件图像调节参数，默认值为不调节
+struct ImageAdjustSettings {
+    int brightness = 0;     // -100~100
+    int contrast = 100;     // 0~200（%）
+    int saturation = 100;   // 0~200（%）
+    int gamma = 100;        // 20~300，大于100时提亮暗部
+
+    bool isIdentity() const;
+    bool operator==(const ImageAdjustSettings &other) const;
+    bool operator!=(const ImageAdjustSettings &other) const { return !(*this == other); }
+};
+
+// 软件图像调节（设备没有VideoProcAmp的亮度/对比度/饱和度/伽马时代替硬件调节）
+// 参数改变时才把设置编译为256项的查找表：YUYV的Y表和UV表，以及RGB32的通道表。
+// 伽马为100时变换是线性的，用定点运算（YUYV用SSE2，RGB32有AVX2时连同饱和度用AVX2）；其他伽马按simdLevel()选择：
+// AVX-512 VBMI用vpermi2b整表查找，AVX2用gather查32位表，再往下逐字节查表。各级结果与逐字节查表完全一致（SimdLevel::Scalar为参考实现）。
+// 整帧处理按条带在TaskPool::shared()中并行。1080p YUYV单核实测（见tools/adjust_bench.cpp）：线性约0.45 ms，
+// 与整帧内存拷贝相当；伽马不为100时VBMI约0.45 ms、AVX2约0.6~0.8 ms，只有SSE2时约1.5~3 ms。
+// 每帧0.5 ms的预算只针对1080p YUYV；1080p RGB32的数据量是它的两倍，内存拷贝就要0.9 ms，调饱和度时单核1.5~4 ms，
+// 预览只在缩放后的图像上调节。
+// 查找表以共享指针发布，预览线程和录制写入线程可以同时调用apply()，改参数不会等待正在处理的帧。
+class ImageAdjust {
+public:
+    ImageAdjust();
+
+    // 与当前设置相同时不重建查找表
+    void setSettings(const ImageAdjustSettings &settings);
+    ImageAdjustSettings settings() const;
+    // 设置不是默认值
+    bool isActive() const;
+    // 整帧是否按条带并行，默认开启（性能测试中测量单核耗时时关闭），在调用apply()之前设置
+    void setParallel(bool parallel);
+
+    // 原地调节图像（alpha不变），不是RGB32/ARGB32时先转换为RGB32
+    void apply(QImage *image) const;
+    // 调节YUYV/RGB32帧，结果写入buffer并替换packet的数据（buffer可以跨帧复用，避免每帧分配）。
+    // 没有调节、格式不支持（MJPEG等压缩格式需要重新编码）或数据不完整时返回false，packet不变
+    bool apply(FramePacket *packet, QByteArray *buffer) const;
+
+private:
+    static std::shared_ptr<const ImageAdjustTables> compile(const ImageAdjustSettings &settings);
+    std::shared_ptr<const ImageAdjustTables> tables() const;
+
+    mutable QMutex m_mutex;
+    ImageAdjustSettings m_settings;
+    std::shared_ptr<const ImageAdjustTables> m_tables;     // 不调节时为空
+    bool m_parallel;
+};
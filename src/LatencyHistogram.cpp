@@ -0,0 +1,122 @@
+#include "LatencyHistogram.h"
+#include <QtGlobal>
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(LEVELS * SUB_BUCKETS, 0),
+      m_count(0),
+      m_min(0),
+      m_max(0),
+      m_sum(0)
+{
+}
+
+void LatencyHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0;
+}
+
+int LatencyHistogram::bucketIndex(qint64 us)
+{
+    // 0~7微秒各占一个桶，之后每个2的幂区间分为8个子桶
+    if (us < SUB_BUCKETS) {
+        return int(qMax<qint64>(0, us));
+    }
+    int level = 0;
+    quint64 v = quint64(us);
+    while (v >= quint64(SUB_BUCKETS) * 2) {
+        v >>= 1;
+        level++;
+    }
+    // 此时 v 在 [8, 16) 内
+    const int index = (level + 1) * SUB_BUCKETS + int(v - SUB_BUCKETS);
+    return qMin(index, LEVELS * SUB_BUCKETS - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const int level = index / SUB_BUCKETS - 1;
+    const qint64 sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << level) - 1;
+}
+
+void LatencyHistogram::add(qint64 us)
+{
+    m_buckets[bucketIndex(us)]++;
+    if (m_count == 0 || us < m_min) {
+        m_min = us;
+    }
+    if (m_count == 0 || us > m_max) {
+        m_max = us;
+    }
+    m_count++;
+    m_sum += double(us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    for (int i = 0; i < m_buckets.size(); ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_min = m_count == 0 ? other.m_min : qMin(m_min, other.m_min);
+    m_max = m_count == 0 ? other.m_max : qMax(m_max, other.m_max);
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 LatencyHistogram::minUs() const
+{
+    return m_min;
+}
+
+qint64 LatencyHistogram::maxUs() const
+{
+    return m_max;
+}
+
+double LatencyHistogram::meanUs() const
+{
+    return m_count > 0 ? m_sum / double(m_count) : 0.0;
+}
+
+qint64 LatencyHistogram::percentileUs(double p) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    const quint64 target = quint64(qBound(0.0, p, 100.0) / 100.0 * double(m_count - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < m_buckets.size(); ++i) {
+        seen += m_buckets[i];
+        if (seen >= target) {
+            // 桶上界可能超出实际最大值
+            return qMin(bucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+QString LatencyHistogram::summary() const
+{
+    auto ms = [](qint64 us) { return QString::number(us / 1000.0, 'f', 2); };
+    return QString("p50 %1 ms  p90 %2 ms  p99 %3 ms  p99.9 %4 ms  max %5 ms")
+        .arg(ms(percentileUs(50)))
+        .arg(ms(percentileUs(90)))
+        .arg(ms(percentileUs(99)))
+        .arg(ms(percentileUs(99.9)))
+        .arg(ms(maxUs()));
+}
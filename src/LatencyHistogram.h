@@ -0,0 +1,37 @@
+#pragma once
+#include <QVector>
+#include <QString>
+
+// 延迟分布直方图（微秒）
+// 桶宽按2的幂分级，每级再等分为8个子桶，相对误差不超过12.5%，内存固定
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void clear();
+    void add(qint64 us);
+    void merge(const LatencyHistogram &other);
+
+    quint64 count() const;
+    qint64 minUs() const;
+    qint64 maxUs() const;
+    double meanUs() const;
+    // p取0~100，返回所在桶的上界
+    qint64 percentileUs(double p) const;
+
+    // 形如 "p50 1.2 ms  p90 ...  max ..." 的摘要
+    QString summary() const;
+
+private:
+    static int bucketIndex(qint64 us);
+    static qint64 bucketUpperBound(int index);
+
+    static const int SUB_BUCKETS = 8;
+    static const int LEVELS = 40;
+
+    QVector<quint64> m_buckets;
+    quint64 m_count;
+    qint64 m_min;
+    qint64 m_max;
+    double m_sum;
+};
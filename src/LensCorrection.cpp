@@ -0,0 +1,551 @@
+#include "LensCorrection.h"
+#include "TaskPool.h"
+#include "dbgout.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+
+#include "SimdSupport.h"
+
+namespace {
+    const int LENS_TILE_WIDTH = 64;
+    const int LENS_TILE_HEIGHT = 16;
+    // 插值精度1/16像素：水平和垂直两次插值的中间结果都不超过16位，SSE2可以用madd直接计算
+    const int LENS_FRACTION_BITS = 4;
+    const int LENS_FRACTION_ONE = 1 << LENS_FRACTION_BITS;
+    // 缓存的映射表数（预览和录制各用一种布局，切换分辨率时保留上一种）
+    const int LENS_MAX_TABLES = 4;
+    // 自动放大倍数的搜索范围和边界采样间隔
+    const double LENS_MIN_ZOOM = 0.25;
+    const double LENS_MAX_ZOOM = 4.0;
+    const int LENS_FIT_STEP = 8;
+    const int LENS_FIT_ITERATIONS = 24;
+
+    // 输出像素（已去畸变的归一化坐标）对应的源像素位置
+    struct LensModel {
+        double fx, fy, cx, cy;
+        double k1, k2, p1, p2, k3;
+        double zoom;
+
+        // 返回false表示该点超出了畸变多项式单调的范围（半径增大时畸变后的半径反而减小），映射不可信
+        bool sourceOf(double u, double v, double *sx, double *sy) const
+        {
+            const double x = (u - cx) / (fx * zoom);
+            const double y = (v - cy) / (fy * zoom);
+            const double r2 = x * x + y * y;
+            const double radial = 1.0 + r2 * (k1 + r2 * (k2 + r2 * k3));
+            const double xd = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+            const double yd = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+            *sx = fx * xd + cx;
+            *sy = fy * yd + cy;
+            return 1.0 + r2 * (3.0 * k1 + r2 * (5.0 * k2 + r2 * 7.0 * k3)) > 0;
+        }
+
+        bool inside(double u, double v, int width, int height) const
+        {
+            double sx = 0;
+            double sy = 0;
+            return sourceOf(u, v, &sx, &sy) && sx >= 0 && sy >= 0 && sx <= width - 1 && sy <= height - 1;
+        }
+
+        // 输出边界上的采样点全部落在源图像内，即按zoom缩放后没有黑边
+        bool fits(int width, int height) const
+        {
+            for (int x = 0; x <= width; x += LENS_FIT_STEP) {
+                const double u = qMin(x, width - 1);
+                if (!inside(u, 0, width, height) || !inside(u, height - 1, width, height)) {
+                    return false;
+                }
+            }
+            for (int y = 0; y <= height; y += LENS_FIT_STEP) {
+                const double v = qMin(y, height - 1);
+                if (!inside(0, v, width, height) || !inside(width - 1, v, width, height)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    inline int lensInterpolate(int p00, int p01, int p10, int p11, int fx, int fy)
+    {
+        const int top = p00 * (LENS_FRACTION_ONE - fx) + p01 * fx;
+        const int bottom = p10 * (LENS_FRACTION_ONE - fx) + p11 * fx;
+        return (top * (LENS_FRACTION_ONE - fy) + bottom * fy + 128) >> 8;
+    }
+
+#ifdef CAMERA_HAVE_SSE2
+    inline int loadLens32(const uchar *p)
+    {
+        int value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // 每个32位通道为(16 - f) | (f << 16)，与交错排列的两个16位样本做madd即得到插值
+    inline __m128i lensWeights(__m128i fraction)
+    {
+        return _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(fraction, 16), fraction), _mm_set1_epi32(LENS_FRACTION_ONE));
+    }
+
+    // 4个输出像素的亮度：fractions为4个32位通道的小数字节
+    inline __m128i remapLuma4(const uchar *src, int stride, const quint32 *offsets, __m128i fractions)
+    {
+        const __m128i lumaMask = _mm_set1_epi32(0x00FF00FF);
+        const __m128i top = _mm_and_si128(_mm_set_epi32(loadLens32(src + offsets[3]), loadLens32(src + offsets[2]),
+                                                        loadLens32(src + offsets[1]), loadLens32(src + offsets[0])),
+                                          lumaMask);
+        const __m128i bottom = _mm_and_si128(_mm_set_epi32(loadLens32(src + offsets[3] + stride),
+                                                           loadLens32(src + offsets[2] + stride),
+                                                           loadLens32(src + offsets[1] + stride),
+                                                           loadLens32(src + offsets[0] + stride)),
+                                             lumaMask);
+        const __m128i wx = lensWeights(_mm_and_si128(fractions, _mm_set1_epi32(LENS_FRACTION_ONE - 1)));
+        const __m128i wy = lensWeights(_mm_srli_epi32(fractions, LENS_FRACTION_BITS));
+        const __m128i rows = _mm_or_si128(_mm_madd_epi16(top, wx), _mm_slli_epi32(_mm_madd_epi16(bottom, wx), 16));
+        return _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(rows, wy), _mm_set1_epi32(128)), 8);
+    }
+
+    // 两个像素对的色度：两行各取一个8字节（两个像素对）并排列为U0 U1 V0 V1
+    inline __m128i loadChromaPairs(const uchar *a, const uchar *b)
+    {
+        __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a)),
+                                       _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b)));
+        v = _mm_srli_epi16(v, 8);
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+        return _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    // 两个输出像素对的U、V：pairBase为两对的起始偏移，cx/fy为对应偶数像素的小数部分（32位通道0、1）
+    inline __m128i remapChroma2(const uchar *src, int stride, const quint32 *pairBase, __m128i cx, __m128i fy)
+    {
+        const __m128i top = loadChromaPairs(src + pairBase[0], src + pairBase[1]);
+        const __m128i bottom = loadChromaPairs(src + pairBase[0] + stride, src + pairBase[1] + stride);
+        const __m128i wx = lensWeights(cx);
+        const __m128i wy = lensWeights(fy);
+        const __m128i wx2 = _mm_unpacklo_epi32(wx, wx);
+        const __m128i wy2 = _mm_unpacklo_epi32(wy, wy);
+        const __m128i rows = _mm_or_si128(_mm_madd_epi16(top, wx2), _mm_slli_epi32(_mm_madd_epi16(bottom, wx2), 16));
+        return _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(rows, wy2), _mm_set1_epi32(128)), 8);
+    }
+#endif
+
+    // YUYV一段输出行（width为偶数）。亮度按每个像素的映射插值；
+    // 色度按像素对中偶数像素的映射，在水平半分辨率的色度平面上插值
+    void remapYuyvRow(const uchar *src, int stride, const quint32 *offsets, const quint8 *fractions,
+                      uchar *dst, int width, SimdLevel level)
+    {
+        int x = 0;
+#ifdef CAMERA_HAVE_SSE2
+        const int simdWidth = level >= SimdLevel::Sse2 ? width : 0;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i fractionMask = _mm_set1_epi32(LENS_FRACTION_ONE - 1);
+        for (; x + 8 <= simdWidth; x += 8) {
+            const __m128i fraction8 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(fractions + x)), zero);
+            const __m128i fractionLo = _mm_unpacklo_epi16(fraction8, zero);
+            const __m128i fractionHi = _mm_unpackhi_epi16(fraction8, zero);
+            const __m128i luma = _mm_packs_epi32(remapLuma4(src, stride, offsets + x, fractionLo),
+                                                 remapLuma4(src, stride, offsets + x + 4, fractionHi));
+
+            // 偶数像素（0、2、4、6）的偏移和小数部分
+            const __m128i offsetLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + x));
+            const __m128i offsetHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + x + 4));
+            const __m128i evenOffsets = _mm_unpacklo_epi64(_mm_shuffle_epi32(offsetLo, _MM_SHUFFLE(2, 0, 2, 0)),
+                                                           _mm_shuffle_epi32(offsetHi, _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128i evenFractions = _mm_unpacklo_epi64(_mm_shuffle_epi32(fractionLo, _MM_SHUFFLE(2, 0, 2, 0)),
+                                                             _mm_shuffle_epi32(fractionHi, _MM_SHUFFLE(2, 0, 2, 0)));
+            // 色度平面上的小数部分：奇数源像素加半个像素对
+            const __m128i cx = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(evenOffsets, 1), _mm_set1_epi32(1)), 3),
+                                             _mm_srli_epi32(_mm_and_si128(evenFractions, fractionMask), 1));
+            const __m128i fy = _mm_srli_epi32(evenFractions, LENS_FRACTION_BITS);
+            alignas(16) quint32 pairBase[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(pairBase), _mm_andnot_si128(_mm_set1_epi32(3), evenOffsets));
+            const __m128i chroma = _mm_packs_epi32(
+                remapChroma2(src, stride, pairBase, cx, fy),
+                remapChroma2(src, stride, pairBase + 2, _mm_srli_si128(cx, 8), _mm_srli_si128(fy, 8)));
+
+            const __m128i out = _mm_packus_epi16(_mm_unpacklo_epi16(luma, chroma), _mm_unpackhi_epi16(luma, chroma));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2), out);
+        }
+#endif
+        for (; x < width; x += 2) {
+            for (int i = 0; i < 2; ++i) {
+                const uchar *p = src + offsets[x + i];
+                const int fraction = fractions[x + i];
+                dst[x * 2 + i * 2] = uchar(lensInterpolate(p[0], p[2], p[stride], p[stride + 2],
+                                                           fraction & (LENS_FRACTION_ONE - 1),
+                                                           fraction >> LENS_FRACTION_BITS));
+            }
+            const quint32 offset = offsets[x];
+            const uchar *pair = src + (offset & ~3u);
+            const int fraction = fractions[x];
+            const int cx = int((offset >> 1) & 1) * (LENS_FRACTION_ONE / 2) + ((fraction & (LENS_FRACTION_ONE - 1)) >> 1);
+            const int fy = fraction >> LENS_FRACTION_BITS;
+            dst[x * 2 + 1] = uchar(lensInterpolate(pair[1], pair[5], pair[stride + 1], pair[stride + 5], cx, fy));
+            dst[x * 2 + 3] = uchar(lensInterpolate(pair[3], pair[7], pair[stride + 3], pair[stride + 7], cx, fy));
+        }
+    }
+
+    // RGB32一段输出行，四个通道（含alpha）分别插值
+    void remapRgb32Row(const uchar *src, int stride, const quint32 *offsets, const quint8 *fractions,
+                       uchar *dst, int width, SimdLevel level)
+    {
+        int x = 0;
+#ifdef CAMERA_HAVE_SSE2
+        const int simdWidth = level >= SimdLevel::Sse2 ? width : 0;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi32(128);
+        for (; x + 4 <= simdWidth; x += 4) {
+            __m128i pixels[4];
+            for (int i = 0; i < 4; ++i) {
+                const uchar *p = src + offsets[x + i];
+                const int fx = fractions[x + i] & (LENS_FRACTION_ONE - 1);
+                const int fy = fractions[x + i] >> LENS_FRACTION_BITS;
+                // 左右两个像素的同一通道交错排列：B0 B1 G0 G1 R0 R1 A0 A1
+                const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+                const __m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + stride)), zero);
+                const __m128i wx = _mm_set1_epi32((LENS_FRACTION_ONE - fx) | (fx << 16));
+                const __m128i wy = _mm_set1_epi32((LENS_FRACTION_ONE - fy) | (fy << 16));
+                const __m128i rows = _mm_or_si128(
+                    _mm_madd_epi16(_mm_unpacklo_epi16(top, _mm_srli_si128(top, 8)), wx),
+                    _mm_slli_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(bottom, _mm_srli_si128(bottom, 8)), wx), 16));
+                pixels[i] = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(rows, wy), round), 8);
+            }
+            const __m128i out = _mm_packus_epi16(_mm_packs_epi32(pixels[0], pixels[1]), _mm_packs_epi32(pixels[2], pixels[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), out);
+        }
+#endif
+        for (; x < width; ++x) {
+            const uchar *p = src + offsets[x];
+            const int fx = fractions[x] & (LENS_FRACTION_ONE - 1);
+            const int fy = fractions[x] >> LENS_FRACTION_BITS;
+            for (int c = 0; c < 4; ++c) {
+                dst[x * 4 + c] = uchar(lensInterpolate(p[c], p[c + 4], p[stride + c], p[stride + c + 4], fx, fy));
+            }
+        }
+    }
+
+    // 条带band在映射表中的起始位置（之前的条带都是满16行）
+    inline qsizetype bandBegin(const LensRemapTable &table, int band)
+    {
+        return qsizetype(band) * LENS_TILE_HEIGHT * table.size.width();
+    }
+}
+
+bool LensCalibration::isValid() const
+{
+    return !size.isEmpty() && fx > 0 && fy > 0;
+}
+
+bool LensCalibration::operator==(const LensCalibration &other) const
+{
+    return size == other.size && fx == other.fx && fy == other.fy && cx == other.cx && cy == other.cy &&
+           k1 == other.k1 && k2 == other.k2 && p1 == other.p1 && p2 == other.p2 && k3 == other.k3;
+}
+
+QString LensCalibration::deviceKey(const QString &vid, const QString &pid)
+{
+    return QString("%1:%2").arg(vid.toUpper(), pid.toUpper());
+}
+
+bool LensCalibration::load(const QString &path, const QString &key, LensCalibration *calibration, QString *error)
+{
+    error->clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开标定文件%1：%2").arg(path, file.errorString());
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        *error = QString("标定文件%1格式错误：%2").arg(path, parseError.errorString());
+        return false;
+    }
+    // 键不区分大小写
+    const QJsonObject root = document.object();
+    QJsonObject entry;
+    bool found = false;
+    for (auto it = root.begin(); it != root.end(); ++it) {
+        if (it.key().compare(key, Qt::CaseInsensitive) == 0) {
+            entry = it.value().toObject();
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    LensCalibration result;
+    result.size = QSize(entry.value("width").toInt(), entry.value("height").toInt());
+    result.fx = entry.value("fx").toDouble();
+    result.fy = entry.value("fy").toDouble();
+    // 没有给出主点时取画面中心
+    result.cx = entry.value("cx").toDouble((result.size.width() - 1) / 2.0);
+    result.cy = entry.value("cy").toDouble((result.size.height() - 1) / 2.0);
+    result.k1 = entry.value("k1").toDouble();
+    result.k2 = entry.value("k2").toDouble();
+    result.p1 = entry.value("p1").toDouble();
+    result.p2 = entry.value("p2").toDouble();
+    result.k3 = entry.value("k3").toDouble();
+    if (!result.isValid()) {
+        *error = QString("标定文件%1中%2的参数不完整（需要width、height、fx、fy）").arg(path, key);
+        return false;
+    }
+    *calibration = result;
+    return true;
+}
+
+int LensRemapTable::bands() const
+{
+    return (size.height() + LENS_TILE_HEIGHT - 1) / LENS_TILE_HEIGHT;
+}
+
+void LensRemapTable::remap(const uchar *src, uchar *dst, int firstBand, int bandCount) const
+{
+    const int width = size.width();
+    const int bytesPerPixel = format == FramePixelFormat::YUYV ? 2 : 4;
+    const SimdLevel level = simdLevel();
+    for (int band = firstBand; band < firstBand + bandCount; ++band) {
+        const int top = band * LENS_TILE_HEIGHT;
+        const int rows = qMin(LENS_TILE_HEIGHT, size.height() - top);
+        qsizetype index = bandBegin(*this, band);
+        for (int left = 0; left < width; left += LENS_TILE_WIDTH) {
+            const int tileWidth = qMin(LENS_TILE_WIDTH, width - left);
+            for (int y = top; y < top + rows; ++y) {
+                uchar *out = dst + qsizetype(y) * bytesPerLine + left * bytesPerPixel;
+                if (format == FramePixelFormat::YUYV) {
+                    remapYuyvRow(src, bytesPerLine, offsets.data() + index, fractions.data() + index, out, tileWidth,
+                                 level);
+                } else {
+                    remapRgb32Row(src, bytesPerLine, offsets.data() + index, fractions.data() + index, out, tileWidth,
+                                  level);
+                }
+                index += tileWidth;
+            }
+        }
+    }
+}
+
+LensCorrection::LensCorrection()
+    : m_enabled(false),
+      m_generation(0)
+{
+}
+
+void LensCorrection::setCalibration(const LensCalibration &calibration)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (calibration == m_calibration) {
+        return;
+    }
+    m_calibration = calibration;
+    m_generation++;
+    m_tables.clear();
+}
+
+LensCalibration LensCorrection::calibration() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_calibration;
+}
+
+void LensCorrection::setEnabled(bool enabled)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+bool LensCorrection::isEnabled() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_enabled;
+}
+
+bool LensCorrection::isActive() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_enabled && m_calibration.isValid();
+}
+
+std::shared_ptr<const LensRemapTable> LensCorrection::buildTable(const LensCalibration &calibration, const QSize &size,
+                                                                 int bytesPerLine, FramePixelFormat format)
+{
+    const bool yuyv = format == FramePixelFormat::YUYV;
+    if (!calibration.isValid() || (!yuyv && format != FramePixelFormat::RGB32) ||
+        size.width() < 4 || size.height() < 2 || bytesPerLine < size.width() * (yuyv ? 2 : 4)) {
+        return nullptr;
+    }
+    // YUYV的色度按4字节的像素对定位，要求每行从4字节边界开始
+    if (yuyv && (size.width() % 2 != 0 || bytesPerLine % 4 != 0)) {
+        return nullptr;
+    }
+    const double aspect = double(size.width()) / size.height();
+    const double calibrationAspect = double(calibration.size.width()) / calibration.size.height();
+    if (std::abs(aspect / calibrationAspect - 1.0) > 0.01) {
+        return nullptr;
+    }
+
+    const double scaleX = double(size.width()) / calibration.size.width();
+    const double scaleY = double(size.height()) / calibration.size.height();
+    LensModel model = {calibration.fx * scaleX, calibration.fy * scaleY,
+                       (calibration.cx + 0.5) * scaleX - 0.5, (calibration.cy + 0.5) * scaleY - 0.5,
+                       calibration.k1, calibration.k2, calibration.p1, calibration.p2, calibration.k3, 1.0};
+    // 二分查找输出没有黑边的最小缩放倍数：桶形畸变小于1（校正后保留更多视野），枕形畸变大于1；
+    // 范围内找不到时不缩放，超出画面的部分取边缘像素
+    model.zoom = LENS_MAX_ZOOM;
+    if (model.fits(size.width(), size.height())) {
+        double low = LENS_MIN_ZOOM;
+        double high = LENS_MAX_ZOOM;
+        for (int i = 0; i < LENS_FIT_ITERATIONS; ++i) {
+            model.zoom = (low + high) / 2;
+            if (model.fits(size.width(), size.height())) {
+                high = model.zoom;
+            } else {
+                low = model.zoom;
+            }
+        }
+        model.zoom = high;
+    } else {
+        model.zoom = 1.0;
+    }
+
+    auto table = std::make_shared<LensRemapTable>();
+    table->size = size;
+    table->bytesPerLine = bytesPerLine;
+    table->format = format;
+    table->zoom = model.zoom;
+    const qsizetype pixels = qsizetype(size.width()) * size.height();
+    table->offsets.resize(pixels);
+    table->fractions.resize(pixels);
+
+    // 源坐标限制在2x2邻域不越界的范围内（最后一行/列按15/16的权重取到）：
+    // YUYV的色度还要读右边一个像素对，x不超过宽度-2
+    const int bytesPerPixel = yuyv ? 2 : 4;
+    const int maxX = (size.width() - (yuyv ? 2 : 1)) * LENS_FRACTION_ONE - 1;
+    const int maxY = (size.height() - 1) * LENS_FRACTION_ONE - 1;
+    LensRemapTable *t = table.get();
+    TaskPool::shared()->parallelStripes("lens_table", t->bands(), [t, model, maxX, maxY, bytesPerPixel](int firstBand, int bandCount) {
+        const int width = t->size.width();
+        for (int band = firstBand; band < firstBand + bandCount; ++band) {
+            const int top = band * LENS_TILE_HEIGHT;
+            const int rows = qMin(LENS_TILE_HEIGHT, t->size.height() - top);
+            qsizetype index = bandBegin(*t, band);
+            for (int left = 0; left < width; left += LENS_TILE_WIDTH) {
+                const int tileWidth = qMin(LENS_TILE_WIDTH, width - left);
+                for (int y = top; y < top + rows; ++y) {
+                    for (int x = left; x < left + tileWidth; ++x, ++index) {
+                        double sx = 0;
+                        double sy = 0;
+                        model.sourceOf(x, y, &sx, &sy);
+                        const int fixedX = qBound(0, int(std::lround(sx * LENS_FRACTION_ONE)), maxX);
+                        const int fixedY = qBound(0, int(std::lround(sy * LENS_FRACTION_ONE)), maxY);
+                        t->offsets[index] = quint32(fixedY >> LENS_FRACTION_BITS) * quint32(t->bytesPerLine) +
+                                            quint32(fixedX >> LENS_FRACTION_BITS) * quint32(bytesPerPixel);
+                        t->fractions[index] = quint8((fixedX & (LENS_FRACTION_ONE - 1)) |
+                                                     ((fixedY & (LENS_FRACTION_ONE - 1)) << LENS_FRACTION_BITS));
+                    }
+                }
+            }
+        }
+    }, 1);
+    return table;
+}
+
+// 按帧布局取缓存的映射表，没有时生成（在锁外，不阻塞另一个线程处理帧）
+std::shared_ptr<const LensRemapTable> LensCorrection::table(const QSize &size, int bytesPerLine, FramePixelFormat format) const
+{
+    LensCalibration calibration;
+    quint64 generation = 0;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (!m_enabled || !m_calibration.isValid()) {
+            return nullptr;
+        }
+        for (const std::shared_ptr<const LensRemapTable> &table : m_tables) {
+            if (table->size == size && table->bytesPerLine == bytesPerLine && table->format == format) {
+                return table;
+            }
+        }
+        calibration = m_calibration;
+        generation = m_generation;
+    }
+
+    const qint64 begin = monotonicUs();
+    std::shared_ptr<const LensRemapTable> table = buildTable(calibration, size, bytesPerLine, format);
+    if (!table) {
+        return nullptr;
+    }
+    logToConsole(QString("镜头校正: 生成%1x%2 %3映射表，放大%4倍，耗时 %5 ms")
+                     .arg(size.width()).arg(size.height()).arg(pixelFormatName(format))
+                     .arg(table->zoom, 0, 'f', 3)
+                     .arg((monotonicUs() - begin) / 1000.0, 0, 'f', 1));
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (generation == m_generation) {
+        if (m_tables.size() >= LENS_MAX_TABLES) {
+            m_tables.removeFirst();
+        }
+        m_tables.append(table);
+    }
+    return table;
+}
+
+bool LensCorrection::apply(FramePacket *packet, QByteArray *buffer) const
+{
+    if (!packet || !buffer ||
+        (packet->format != FramePixelFormat::YUYV && packet->format != FramePixelFormat::RGB32)) {
+        return false;
+    }
+    const qsizetype frameBytes = qsizetype(packet->bytesPerLine) * packet->size.height();
+    if (packet->data.size() < frameBytes) {
+        return false;
+    }
+    const std::shared_ptr<const LensRemapTable> t = table(packet->size, packet->bytesPerLine, packet->format);
+    if (!t) {
+        return false;
+    }
+
+    // 行尾填充清零，输出不留未初始化的字节
+    buffer->resize(frameBytes);
+    const uchar *src = reinterpret_cast<const uchar*>(packet->data.constData());
+    uchar *dst = reinterpret_cast<uchar*>(buffer->data());
+    const int rowBytes = packet->size.width() * (packet->format == FramePixelFormat::YUYV ? 2 : 4);
+    if (rowBytes < packet->bytesPerLine) {
+        for (int y = 0; y < packet->size.height(); ++y) {
+            std::memset(dst + qsizetype(y) * packet->bytesPerLine + rowBytes, 0, packet->bytesPerLine - rowBytes);
+        }
+    }
+    TaskPool::shared()->parallelStripes("lens_correction", t->bands(), [&t, src, dst](int firstBand, int bandCount) {
+        t->remap(src, dst, firstBand, bandCount);
+    }, 1);
+
+    packet->data = *buffer;
+    packet->owner.reset();
+    return true;
+}
+
+bool LensCorrection::apply(QImage *image) const
+{
+    if (!image || image->isNull()) {
+        return false;
+    }
+    if (image->format() != QImage::Format_RGB32 && image->format() != QImage::Format_ARGB32) {
+        *image = image->convertToFormat(QImage::Format_RGB32);
+    }
+    const std::shared_ptr<const LensRemapTable> t = table(image->size(), int(image->bytesPerLine()), FramePixelFormat::RGB32);
+    if (!t) {
+        return false;
+    }
+    QImage corrected(image->size(), image->format());
+    const uchar *src = image->constBits();
+    uchar *dst = corrected.bits();
+    TaskPool::shared()->parallelStripes("lens_correction", t->bands(), [&t, src, dst](int firstBand, int bandCount) {
+        t->remap(src, dst, firstBand, bandCount);
+    }, 1);
+    *image = corrected;
+    return true;
+}
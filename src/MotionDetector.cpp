@@ -0,0 +1,329 @@
+#include "MotionDetector.h"
+#include "FrameConvert.h"
+#include <QImage>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    // 缩小后的亮度平面宽度上限，移动侦测不需要细节，越小越抗噪声
+    const int MOTION_PLANE_WIDTH = 160;
+    // 每格在每个方向上最多取的采样数
+    const int MOTION_BOX_SAMPLES = 4;
+    const int MOTION_BLOCK_SIZE = 8;
+    // 只用于缩小，解码得越小越省时
+    const QSize MJPEG_MOTION_SIZE(320, 180);
+    // 背景更新速度（右移位数）：没有变化的块1/16，变化的块1/128
+    const int MOTION_FAST_SHIFT = 4;
+    const int MOTION_SLOW_SHIFT = 7;
+    // 开始或分辨率变化后用于建立背景的帧数（约1秒，同时等待自动曝光稳定）
+    const int MOTION_LEARNING_FRAMES = 10;
+    const double MOTION_MIN_THRESHOLD = 3.0;
+    const double MOTION_THRESHOLD_STEP = 0.3;
+    // 开始录制需要连续检测到移动的次数，过滤单帧的噪声和闪烁
+    const int MOTION_CONFIRM_COUNT = 2;
+
+    // 把w x h的亮度缩小到planeSize（每个方向最多缩小到1/factor，采样点不会越界），
+    // row(y)返回源图像第y行，luma(row, x)返回该行第x个像素的亮度；sums是跨帧复用的逐列累加缓存
+    template<typename RowAt, typename LumaAt>
+    void downsampleLuma(int width, const QSize &planeSize, quint8 *plane, std::vector<quint32> *sums,
+                        RowAt rowAt, LumaAt luma)
+    {
+        const int factor = qMax(1, width / planeSize.width());
+        const int samples = qMin(factor, MOTION_BOX_SAMPLES);
+        const int spacing = factor / samples;
+        const int first = spacing / 2;
+        const int count = samples * samples;
+        sums->resize(size_t(planeSize.width()));
+        quint32 *columnSums = sums->data();
+        for (int py = 0; py < planeSize.height(); ++py) {
+            std::fill(sums->begin(), sums->end(), 0u);
+            // 逐行累加，每行只读取一次
+            for (int sy = 0; sy < samples; ++sy) {
+                const auto row = rowAt(py * factor + first + sy * spacing);
+                for (int px = 0; px < planeSize.width(); ++px) {
+                    const int x = px * factor + first;
+                    quint32 sum = 0;
+                    for (int sx = 0; sx < samples; ++sx) {
+                        sum += luma(row, x + sx * spacing);
+                    }
+                    columnSums[px] += sum;
+                }
+            }
+            quint8 *out = plane + py * planeSize.width();
+            for (int px = 0; px < planeSize.width(); ++px) {
+                out[px] = quint8((columnSums[px] + count / 2) / count);
+            }
+        }
+    }
+
+    QSize planeSizeFor(const QSize &size)
+    {
+        const int factor = qMax(1, (size.width() + MOTION_PLANE_WIDTH - 1) / MOTION_PLANE_WIDTH);
+        return QSize(qMax(1, size.width() / factor), qMax(1, size.height() / factor));
+    }
+
+    void downsampleRgb32(const QImage &image, const QSize &planeSize, quint8 *plane, std::vector<quint32> *sums)
+    {
+        downsampleLuma(image.width(), planeSize, plane, sums, [&image](int y) {
+            return reinterpret_cast<const quint32*>(image.constScanLine(y));
+        }, [](const quint32 *row, int x) {
+            const quint32 p = row[x];
+            return (77 * ((p >> 16) & 0xFF) + 150 * ((p >> 8) & 0xFF) + 29 * (p & 0xFF) + 128) >> 8;
+        });
+    }
+}
+
+MotionDetector::MotionDetector()
+    : m_sensitivity(50),
+      m_format(FramePixelFormat::Unknown),
+      m_learningFrames(0)
+{
+}
+
+void MotionDetector::setSensitivity(int sensitivity)
+{
+    m_sensitivity = qBound(1, sensitivity, 100);
+}
+
+int MotionDetector::sensitivity() const
+{
+    return m_sensitivity;
+}
+
+double MotionDetector::blockThreshold() const
+{
+    return MOTION_MIN_THRESHOLD + (100 - m_sensitivity) * MOTION_THRESHOLD_STEP;
+}
+
+void MotionDetector::reset()
+{
+    m_frameSize = QSize();
+    m_format = FramePixelFormat::Unknown;
+    m_planeSize = QSize();
+    m_background.clear();
+    m_learningFrames = 0;
+}
+
+bool MotionDetector::hasBackground() const
+{
+    return !m_background.empty();
+}
+
+bool MotionDetector::update(const FramePacket &packet, MotionResult *result)
+{
+    const qint64 begin = monotonicUs();
+    *result = MotionResult();
+    result->captureUs = packet.captureUs;
+    result->threshold = blockThreshold();
+    if (packet.size.isEmpty()) {
+        return false;
+    }
+
+    // 格式或分辨率变化后背景作废
+    if (packet.size != m_frameSize || packet.format != m_format) {
+        reset();
+        m_frameSize = packet.size;
+        m_format = packet.format;
+    }
+
+    switch (packet.format) {
+        case FramePixelFormat::YUYV: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return false;
+            }
+            const uchar *data = reinterpret_cast<const uchar*>(packet.data.constData());
+            const int bytesPerLine = packet.bytesPerLine;
+            m_planeSize = planeSizeFor(packet.size);
+            m_plane.resize(size_t(m_planeSize.width()) * m_planeSize.height());
+            downsampleLuma(packet.size.width(), m_planeSize, m_plane.data(), &m_columnSums, [data, bytesPerLine](int y) {
+                return data + qsizetype(y) * bytesPerLine;
+            }, [](const uchar *row, int x) {
+                return quint32(row[x * 2]);
+            });
+            break;
+        }
+        case FramePixelFormat::MJPEG: {
+            const QImage image = packetToPreview(packet, MJPEG_MOTION_SIZE).convertToFormat(QImage::Format_RGB32);
+            if (image.isNull()) {
+                return false;
+            }
+            // 缩小解码的尺寸只由帧尺寸决定，每帧相同
+            m_planeSize = planeSizeFor(image.size());
+            m_plane.resize(size_t(m_planeSize.width()) * m_planeSize.height());
+            downsampleRgb32(image, m_planeSize, m_plane.data(), &m_columnSums);
+            break;
+        }
+        case FramePixelFormat::RGB32: {
+            if (packet.data.size() < qsizetype(packet.bytesPerLine) * packet.size.height()) {
+                return false;
+            }
+            const QImage image(reinterpret_cast<const uchar*>(packet.data.constData()),
+                               packet.size.width(), packet.size.height(), packet.bytesPerLine,
+                               QImage::Format_RGB32);
+            m_planeSize = planeSizeFor(packet.size);
+            m_plane.resize(size_t(m_planeSize.width()) * m_planeSize.height());
+            downsampleRgb32(image, m_planeSize, m_plane.data(), &m_columnSums);
+            break;
+        }
+        default:
+            return false;
+    }
+
+    const int width = m_planeSize.width();
+    const int height = m_planeSize.height();
+    const size_t pixels = m_plane.size();
+    const int blocksX = (width + MOTION_BLOCK_SIZE - 1) / MOTION_BLOCK_SIZE;
+    const int blocksY = (height + MOTION_BLOCK_SIZE - 1) / MOTION_BLOCK_SIZE;
+    result->blocks = blocksX * blocksY;
+
+    if (m_background.size() != pixels) {
+        m_background.resize(pixels);
+        for (size_t i = 0; i < pixels; ++i) {
+            m_background[i] = quint16(m_plane[i] << 8);
+        }
+        m_changed.assign(size_t(result->blocks), 0);
+        m_learningFrames = MOTION_LEARNING_FRAMES;
+    }
+
+    // 整体亮度变化：当前平面与背景的平均差，比较时先扣除
+    qint64 planeSum = 0;
+    qint64 backgroundSum = 0;
+    for (size_t i = 0; i < pixels; ++i) {
+        planeSum += m_plane[i];
+        backgroundSum += m_background[i];
+    }
+    const double offset = (planeSum - backgroundSum / 256.0) / pixels;
+    const int offset8 = int(offset * 256.0 + (offset < 0 ? -0.5 : 0.5));
+    result->globalOffset = offset;
+
+    // 逐块的绝对差之和（8.8定点），与阈值乘以块内像素数比较
+    const qint64 threshold8 = qint64(result->threshold * 256.0);
+    qint64 maxBlockDiff8 = 0;
+    for (int by = 0; by < blocksY; ++by) {
+        const int y0 = by * MOTION_BLOCK_SIZE;
+        const int y1 = qMin(height, y0 + MOTION_BLOCK_SIZE);
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const int x0 = bx * MOTION_BLOCK_SIZE;
+            const int x1 = qMin(width, x0 + MOTION_BLOCK_SIZE);
+            qint64 sad = 0;
+            for (int y = y0; y < y1; ++y) {
+                const quint8 *row = m_plane.data() + y * width;
+                const quint16 *bg = m_background.data() + y * width;
+                for (int x = x0; x < x1; ++x) {
+                    sad += std::abs((int(row[x]) << 8) - int(bg[x]) - offset8);
+                }
+            }
+            const int count = (y1 - y0) * (x1 - x0);
+            const qint64 blockDiff8 = sad / count;
+            maxBlockDiff8 = qMax(maxBlockDiff8, blockDiff8);
+            const bool changed = blockDiff8 > threshold8;
+            m_changed[size_t(by * blocksX + bx)] = changed ? 1 : 0;
+            if (changed) {
+                result->changedBlocks++;
+            }
+        }
+    }
+    result->maxBlockDiff = maxBlockDiff8 / 256.0;
+
+    // 更新背景：建立背景期间全部快速跟随
+    for (int y = 0; y < height; ++y) {
+        const quint8 *row = m_plane.data() + y * width;
+        quint16 *bg = m_background.data() + y * width;
+        const quint8 *changedRow = m_changed.data() + (y / MOTION_BLOCK_SIZE) * blocksX;
+        for (int x = 0; x < width; ++x) {
+            const int shift = (m_learningFrames == 0 && changedRow[x / MOTION_BLOCK_SIZE])
+                                  ? MOTION_SLOW_SHIFT : MOTION_FAST_SHIFT;
+            const int value = int(bg[x]);
+            bg[x] = quint16(value + (((int(row[x]) << 8) - value) >> shift));
+        }
+    }
+
+    if (m_learningFrames > 0) {
+        m_learningFrames--;
+        result->learning = true;
+    } else {
+        result->motion = result->changedBlocks > 0;
+    }
+    result->computeUs = monotonicUs() - begin;
+    return true;
+}
+
+MotionTrigger::MotionTrigger()
+    : m_postRollUs(10000000),
+      m_consecutive(0),
+      m_active(false),
+      m_eventStartUs(0),
+      m_lastMotionUs(0)
+{
+}
+
+void MotionTrigger::setPostRollUs(qint64 postRollUs)
+{
+    m_postRollUs = qMax<qint64>(0, postRollUs);
+}
+
+qint64 MotionTrigger::postRollUs() const
+{
+    return m_postRollUs;
+}
+
+MotionTrigger::Action MotionTrigger::update(const MotionResult &result)
+{
+    if (result.motion) {
+        m_consecutive++;
+        m_lastMotionUs = result.captureUs;
+        if (!m_active && m_consecutive >= MOTION_CONFIRM_COUNT) {
+            m_active = true;
+            m_eventStartUs = result.captureUs;
+            return StartRecording;
+        }
+        return NoAction;
+    }
+    m_consecutive = 0;
+    if (m_active && result.captureUs - m_lastMotionUs >= m_postRollUs) {
+        m_active = false;
+        return StopRecording;
+    }
+    return NoAction;
+}
+
+bool MotionTrigger::isActive() const
+{
+    return m_active;
+}
+
+qint64 MotionTrigger::eventStartUs() const
+{
+    return m_eventStartUs;
+}
+
+void MotionTrigger::reset()
+{
+    m_consecutive = 0;
+    m_active = false;
+    m_eventStartUs = 0;
+    m_lastMotionUs = 0;
+}
+
+void MotionStats::add(const MotionResult &result)
+{
+    checks++;
+    if (result.motion) {
+        motionChecks++;
+    }
+    totalUs += result.computeUs;
+    maxUs = qMax(maxUs, result.computeUs);
+    maxChangedBlocks = qMax(maxChangedBlocks, result.changedBlocks);
+    blocks = result.blocks;
+    maxBlockDiff = qMax(maxBlockDiff, result.maxBlockDiff);
+    threshold = result.threshold;
+}
+
+QString MotionStats::summary() const
+{
+    return QString("检测 %1 次（有移动 %2 次），耗时平均 %3 ms，最大 %4 ms，变化块最多 %5/%6，最大块差 %7（阈值 %8）")
+        .arg(checks).arg(motionChecks)
+        .arg(checks > 0 ? totalUs / 1000.0 / checks : 0, 0, 'f', 2).arg(maxUs / 1000.0, 0, 'f', 2)
+        .arg(maxChangedBlocks).arg(blocks)
+        .arg(maxBlockDiff, 0, 'f', 1).arg(threshold, 0, 'f', 1);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <QSize>
+#include <QString>
+#include <QtGlobal>
+#include <vector>
+#include "FramePacket.h"
+
+// 一次移动侦测的结果
+struct MotionResult {
+    int changedBlocks = 0;      // 与背景差别超过阈值的块数
+    int blocks = 0;
+    double maxBlockDiff = 0;    // 差别最大的块的平均亮度差（0~255，已扣除整体亮度变化）
+    double globalOffset = 0;    // 整体亮度相对背景的变化（自动曝光、开关灯）
+    double threshold = 0;       // 本次使用的块差阈值
+    bool learning = false;      // 刚开始或分辨率变化后正在建立背景，不报告移动
+    bool motion = false;
+    qint64 captureUs = 0;
+    qint64 computeUs = 0;
+
+    bool isValid() const { return blocks > 0; }
+    double changedPercent() const { return blocks > 0 ? changedBlocks * 100.0 / blocks : 0; }
+};
+
+// 轻量移动侦测：把亮度缩小到宽160左右的平面（每格取不超过4x4个采样的平均），按8x8的块与背景比较平均绝对差。
+// 背景是8.8定点的滑动平均，没有变化的块快速跟随（1/16），有变化的块缓慢吸收（1/128），
+// 停下来的物体和光线的缓慢变化会逐渐融入背景；整体亮度变化先扣除，不会触发。
+// 1080p YUYV每次约0.5 ms（只读取三分之一的行）。不是线程安全的，只在分析线程中使用
+class MotionDetector {
+public:
+    MotionDetector();
+
+    // 灵敏度1~100，越大越灵敏（块差阈值从约33降到3）
+    void setSensitivity(int sensitivity);
+    int sensitivity() const;
+    double blockThreshold() const;
+
+    // 分析一帧并更新背景；YUYV直接读取原始亮度，MJPEG先缩小解码，RGB32按像素计算亮度。
+    // 不支持的格式或数据不完整时返回false
+    bool update(const FramePacket &packet, MotionResult *result);
+    // 丢弃背景，下一帧重新建立
+    void reset();
+    bool hasBackground() const;
+
+private:
+    int m_sensitivity;
+    QSize m_frameSize;
+    FramePixelFormat m_format;
+    QSize m_planeSize;
+    std::vector<quint8> m_plane;
+    std::vector<quint32> m_columnSums;     // 缩小时的逐列累加，跨帧复用
+    std::vector<quint16> m_background;     // 8.8定点
+    std::vector<quint8> m_changed;         // 每块是否变化，决定背景更新速度
+    int m_learningFrames;                  // 剩余的背景建立帧数
+};
+
+// 移动触发录制的状态机：连续两次检测到移动时开始，最后一次移动后postRoll时间内没有再检测到移动时停止
+class MotionTrigger {
+public:
+    enum Action {
+        NoAction,
+        StartRecording,
+        StopRecording
+    };
+
+    MotionTrigger();
+
+    void setPostRollUs(qint64 postRollUs);
+    qint64 postRollUs() const;
+    Action update(const MotionResult &result);
+    // 移动事件进行中（已经开始录制）
+    bool isActive() const;
+    qint64 eventStartUs() const;
+    void reset();
+
+private:
+    qint64 m_postRollUs;
+    int m_consecutive;
+    bool m_active;
+    qint64 m_eventStartUs;
+    qint64 m_lastMotionUs;
+};
+
+// 移动侦测耗时和结果的周期统计，用于日志中调节灵敏度
+struct MotionStats {
+    quint64 checks = 0;
+    quint64 motionChecks = 0;
+    qint64 totalUs = 0;
+    qint64 maxUs = 0;
+    int maxChangedBlocks = 0;
+    int blocks = 0;
+    double maxBlockDiff = 0;
+    double threshold = 0;
+
+    void add(const MotionResult &result);
+    QString summary() const;
+};
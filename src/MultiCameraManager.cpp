@@ -0,0 +1,463 @@
+#include "MultiCameraManager.h"
+#include "CaptureController.h"
+#include "TestPatternSource.h"
+#include "FrameConvert.h"
+#include "dbgout.h"
+#include <QDir>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <climits>
+
+// ---------------- CameraStream ----------------
+
+CameraStream::CameraStream(int index, const QString &name, TaskPool *converterPool, QObject *parent)
+    : QObject(parent),
+      m_index(index),
+      m_name(name),
+      m_converterPool(converterPool),
+      m_worker(new QObject),
+      m_camera(nullptr),
+      m_session(nullptr),
+      m_sink(nullptr),
+      m_pattern(nullptr),
+      m_previewBusy(false),
+      m_closing(false),
+      m_previewSize(640, 360),
+      m_lastFormat(FramePixelFormat::Unknown),
+      m_nominalFps(30.0),
+      m_sequence(0),
+      m_totalConvertUs(0),
+      m_fpsWindowStartUs(0),
+      m_fpsWindowFrames(0)
+{
+    m_thread.setObjectName(QString("CameraStream%1").arg(index));
+    m_worker->moveToThread(&m_thread);
+    connect(&m_recorder, &RecordingPipeline::sinkError, this, [this](const QString &message) {
+        emit streamError(m_index, "录制写入失败: " + message);
+    });
+}
+
+CameraStream::~CameraStream()
+{
+    close();
+    delete m_worker;
+}
+
+int CameraStream::index() const
+{
+    return m_index;
+}
+
+QString CameraStream::name() const
+{
+    return m_name;
+}
+
+bool CameraStream::openCamera(const QCameraDevice &device, const QCameraFormat &format)
+{
+    close();
+
+    m_camera = new QCamera(device);
+    if (!format.isNull()) {
+        m_camera->setCameraFormat(format);
+        m_nominalFps = format.maxFrameRate() > 0 ? format.maxFrameRate() : 30.0;
+    }
+    m_session = new QMediaCaptureSession;
+    m_sink = new QVideoSink;
+    m_session->setCamera(m_camera);
+    m_session->setVideoSink(m_sink);
+
+    // 上下文对象在工作线程，回调以队列方式在工作线程执行，不占用GUI线程
+    connect(m_sink, &QVideoSink::videoFrameChanged, m_worker, [this](const QVideoFrame &frame) {
+        processVideoFrame(frame);
+    });
+    connect(m_camera, &QCamera::errorOccurred, this, [this](QCamera::Error, const QString &message) {
+        m_error = message;
+        emit streamError(m_index, message);
+    });
+
+    m_thread.start();
+    m_camera->start();
+    logToConsole(QString("多路采集: 打开 %1，格式 %2x%3 @ %4 FPS")
+                     .arg(m_name)
+                     .arg(format.resolution().width())
+                     .arg(format.resolution().height())
+                     .arg(format.maxFrameRate(), 0, 'f', 1));
+    return true;
+}
+
+void CameraStream::openTestPattern(FramePixelFormat format, const QSize &size, double fps)
+{
+    close();
+
+    m_nominalFps = fps;
+    m_pattern = new TestPatternSource;
+    m_pattern->setFormat(format, size, fps);
+    m_pattern->moveToThread(&m_thread);
+    // 同一线程内直接调用
+    connect(m_pattern, &TestPatternSource::frameReady, m_worker, [this](const FramePacket &packet) {
+        processPacket(packet);
+    });
+
+    m_thread.start();
+    TestPatternSource *pattern = m_pattern;
+    QMetaObject::invokeMethod(pattern, [pattern]() { pattern->start(); });
+}
+
+void CameraStream::close()
+{
+    if (m_camera) {
+        m_camera->stop();
+        m_session->setCamera(nullptr);
+        m_session->setVideoSink(nullptr);
+        delete m_session;
+        delete m_camera;
+        delete m_sink;
+        m_session = nullptr;
+        m_camera = nullptr;
+        m_sink = nullptr;
+    }
+    if (m_pattern && m_thread.isRunning()) {
+        // 定时器必须在所属线程停止
+        TestPatternSource *pattern = m_pattern;
+        QMetaObject::invokeMethod(pattern, [pattern]() { pattern->stop(); }, Qt::BlockingQueuedConnection);
+    }
+
+    // 先停工作线程，不再产生新的转换任务，再等待正在执行的转换完成
+    m_thread.quit();
+    m_thread.wait();
+    waitPreviewIdle();
+    stopRecording();
+
+    delete m_pattern;
+    m_pattern = nullptr;
+
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_closing = false;
+    m_preview = QImage();
+    m_stats = CameraStreamStats();
+    m_totalConvertUs = 0;
+    m_fpsWindowStartUs = 0;
+    m_fpsWindowFrames = 0;
+}
+
+bool CameraStream::isOpen() const
+{
+    return m_thread.isRunning();
+}
+
+QString CameraStream::errorString() const
+{
+    return m_error;
+}
+
+bool CameraStream::startRecording(FrameSink *sink)
+{
+    if (!m_recorder.start(sink)) {
+        m_error = m_recorder.errorString();
+        return false;
+    }
+    return true;
+}
+
+void CameraStream::stopRecording()
+{
+    if (m_recorder.isRunning()) {
+        m_recorder.stop();
+    }
+}
+
+FramePixelFormat CameraStream::lastFormat() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_lastFormat;
+}
+
+double CameraStream::nominalFps() const
+{
+    return m_nominalFps;
+}
+
+void CameraStream::setPreviewSize(const QSize &size)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_previewSize = size;
+}
+
+QImage CameraStream::latestPreview() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_preview;
+}
+
+CameraStreamStats CameraStream::stats() const
+{
+    CameraStreamStats stats;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        stats = m_stats;
+    }
+    stats.recording = m_recorder.isRunning();
+    stats.recorder = m_recorder.stats();
+    return stats;
+}
+
+void CameraStream::processVideoFrame(const QVideoFrame &frame)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+    const FramePacket packet = packetFromVideoFrame(frame, ++m_sequence);
+    if (packet.isValid()) {
+        processPacket(packet);
+    }
+}
+
+void CameraStream::processPacket(const FramePacket &packet)
+{
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_stats.received++;
+        m_lastFormat = packet.format;
+
+        m_fpsWindowFrames++;
+        const qint64 now = monotonicUs();
+        if (m_fpsWindowStartUs == 0) {
+            m_fpsWindowStartUs = now;
+        } else if (now - m_fpsWindowStartUs >= 1000000) {
+            m_stats.fps = m_fpsWindowFrames * 1000000.0 / double(now - m_fpsWindowStartUs);
+            m_fpsWindowStartUs = now;
+            m_fpsWindowFrames = 0;
+        }
+    }
+
+    // 录制管线内部加锁，入队后立即返回
+    m_recorder.submit(packet);
+    schedulePreview(packet);
+}
+
+void CameraStream::schedulePreview(const FramePacket &packet)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (m_closing || m_previewSize.isEmpty()) {
+        return;
+    }
+    if (m_previewBusy) {
+        // 上一帧还在转换，只保留最新一帧，被替换的帧计为预览丢帧
+        if (m_previewPending.isValid()) {
+            m_stats.previewDropped++;
+        }
+        m_previewPending = packet;
+        return;
+    }
+    m_previewBusy = true;
+    locker.unlock();
+    m_converterPool->submit("preview", [this, packet]() { runPreview(packet); });
+}
+
+void CameraStream::runPreview(FramePacket packet)
+{
+    QSize size;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        size = m_previewSize;
+    }
+
+    const qint64 begin = monotonicUs();
+    const QImage image = packetToPreview(packet, size);
+    const qint64 elapsed = monotonicUs() - begin;
+
+    FramePacket next;
+    bool resubmit = false;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (!image.isNull()) {
+            m_preview = image;
+            m_stats.previewed++;
+            m_totalConvertUs += elapsed;
+            m_stats.avgConvertUs = double(m_totalConvertUs) / double(m_stats.previewed);
+        }
+        next = m_previewPending;
+        m_previewPending = FramePacket();
+        resubmit = next.isValid() && !m_closing;
+        if (!resubmit) {
+            m_previewBusy = false;
+            m_previewIdle.wakeAll();
+        }
+    }
+
+    if (!image.isNull()) {
+        emit previewUpdated(m_index);
+    }
+    // 重新排到线程池队尾而不是在本线程继续转换，各路轮流使用转换线程
+    if (resubmit) {
+        m_converterPool->submit("preview", [this, next]() { runPreview(next); });
+    }
+}
+
+void CameraStream::waitPreviewIdle()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_closing = true;
+    m_previewPending = FramePacket();
+    while (m_previewBusy) {
+        m_previewIdle.wait(&m_mutex);
+    }
+}
+
+// ---------------- MultiCameraManager ----------------
+
+MultiCameraManager::MultiCameraManager(QObject *parent)
+    : QObject(parent),
+      m_converterPool(TaskPool::shared()),
+      m_previewSize(640, 360),
+      m_recording(false)
+{
+}
+
+MultiCameraManager::~MultiCameraManager()
+{
+    // 各路关闭时会等待自己的转换任务完成
+    closeAll();
+}
+
+QCameraFormat MultiCameraManager::chooseFormat(const QCameraDevice &device, QVideoFrameFormat::PixelFormat pixelFormat,
+                                               const QSize &resolution, int fps)
+{
+    // 像素格式不符代价最大，其次是分辨率面积差，最后是帧率差
+    QCameraFormat best;
+    qint64 bestScore = LLONG_MAX;
+    const qint64 targetArea = qint64(resolution.width()) * resolution.height();
+    for (const QCameraFormat &format : device.videoFormats()) {
+        qint64 score = 0;
+        if (format.pixelFormat() != pixelFormat) {
+            score += qint64(1) << 50;
+        }
+        const qint64 area = qint64(format.resolution().width()) * format.resolution().height();
+        score += qAbs(area - targetArea) * 1000;
+        score += qAbs(qRound(format.maxFrameRate()) - fps);
+        if (score < bestScore) {
+            bestScore = score;
+            best = format;
+        }
+    }
+    return best;
+}
+
+int MultiCameraManager::openDevices(const QList<QCameraDevice> &devices, QVideoFrameFormat::PixelFormat pixelFormat,
+                                    const QSize &resolution, int fps)
+{
+    closeAll();
+    if (pixelFormat == QVideoFrameFormat::Format_YUYV && devices.size() > 1) {
+        logToConsole("多路采集: 多个USB摄像头同时使用YUY2容易超出总线带宽，建议使用MJPEG");
+    }
+
+    int opened = 0;
+    for (const QCameraDevice &device : devices) {
+        CameraStream *stream = new CameraStream(int(m_streams.size()), device.description(), m_converterPool, this);
+        stream->setPreviewSize(m_previewSize);
+        connect(stream, &CameraStream::previewUpdated, this, &MultiCameraManager::previewUpdated);
+        connect(stream, &CameraStream::streamError, this, &MultiCameraManager::streamError);
+        m_streams.append(stream);
+        if (stream->openCamera(device, chooseFormat(device, pixelFormat, resolution, fps))) {
+            opened++;
+        }
+    }
+    return opened;
+}
+
+void MultiCameraManager::addTestPattern(FramePixelFormat format, const QSize &size, double fps)
+{
+    const int index = int(m_streams.size());
+    CameraStream *stream = new CameraStream(index, QString("测试图案 %1").arg(index + 1), m_converterPool, this);
+    stream->setPreviewSize(m_previewSize);
+    connect(stream, &CameraStream::previewUpdated, this, &MultiCameraManager::previewUpdated);
+    connect(stream, &CameraStream::streamError, this, &MultiCameraManager::streamError);
+    m_streams.append(stream);
+    stream->openTestPattern(format, size, fps);
+}
+
+void MultiCameraManager::closeAll()
+{
+    stopRecording();
+    for (CameraStream *stream : m_streams) {
+        stream->close();
+        delete stream;
+    }
+    m_streams.clear();
+}
+
+int MultiCameraManager::streamCount() const
+{
+    return int(m_streams.size());
+}
+
+CameraStream *MultiCameraManager::stream(int index) const
+{
+    return m_streams.value(index, nullptr);
+}
+
+bool MultiCameraManager::startRecording(const QString &dir)
+{
+    stopRecording();
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
+    for (CameraStream *stream : m_streams) {
+        const bool mjpeg = stream->lastFormat() == FramePixelFormat::MJPEG;
+        const QString path = QDir(dir).filePath(QString("cam%1_%2.%3")
+                                                    .arg(stream->index() + 1)
+                                                    .arg(timestamp)
+                                                    .arg(mjpeg ? "avi" : "raw"));
+        // 与单路录制相同，AVI接近2GB时自动切换到新文件
+        FrameSink *sink = CaptureController::createSink(path, stream->nominalFps());
+        if (!stream->startRecording(sink)) {
+            m_error = QString("%1: %2").arg(stream->name()).arg(stream->errorString());
+            stopRecording();
+            return false;
+        }
+        logToConsole(QString("多路采集: %1 录制到 %2").arg(stream->name()).arg(path));
+    }
+    m_recording = !m_streams.isEmpty();
+    return m_recording;
+}
+
+void MultiCameraManager::stopRecording()
+{
+    for (CameraStream *stream : m_streams) {
+        stream->stopRecording();
+    }
+    m_recording = false;
+}
+
+bool MultiCameraManager::isRecording() const
+{
+    return m_recording;
+}
+
+QString MultiCameraManager::errorString() const
+{
+    return m_error;
+}
+
+void MultiCameraManager::setPreviewSize(const QSize &size)
+{
+    m_previewSize = size;
+    for (CameraStream *stream : m_streams) {
+        stream->setPreviewSize(size);
+    }
+}
+
+void MultiCameraManager::setConverterThreads(int count)
+{
+    if (!m_streams.isEmpty()) {
+        logToConsole("多路采集: 已打开设备，不能再更换转换线程池");
+        return;
+    }
+    m_ownPool.reset(new TaskPool(qMax(1, count)));
+    m_converterPool = m_ownPool.get();
+}
+
+int MultiCameraManager::converterThreads() const
+{
+    return m_converterPool->threadCount();
+}
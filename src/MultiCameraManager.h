@@ -0,0 +1,146 @@
+#pragma once
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QList>
+#include <QCamera>
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QMediaCaptureSession>
+#include <QVideoSink>
+#include <QVideoFrame>
+#include "FramePacket.h"
+#include "RecordingPipeline.h"
+#include "TaskPool.h"
+#include <memory>
+
+class TestPatternSource;
+
+// 单路统计
+struct CameraStreamStats {
+    quint64 received = 0;        // 收到的帧数
+    quint64 previewed = 0;       // 完成预览转换的帧数
+    quint64 previewDropped = 0;  // 转换来不及、被新帧替换的帧数
+    double fps = 0;              // 最近一秒的输入帧率
+    double avgConvertUs = 0;     // 预览转换平均耗时
+    bool recording = false;
+    RecordingStats recorder;
+};
+
+// 多路采集中的一路
+// 摄像头对象在GUI线程创建，帧在本路独立的工作线程中打包并送入录制管线，
+// 预览转换交给共享的工作窃取线程池，每路最多一个转换任务在执行，新帧只保留最新一帧
+class CameraStream : public QObject {
+    Q_OBJECT
+public:
+    CameraStream(int index, const QString &name, TaskPool *converterPool, QObject *parent = nullptr);
+    ~CameraStream();
+
+    int index() const;
+    QString name() const;
+
+    bool openCamera(const QCameraDevice &device, const QCameraFormat &format);
+    // 用测试图案代替摄像头（性能测试用）
+    void openTestPattern(FramePixelFormat format, const QSize &size, double fps);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    // 接管sink的所有权
+    bool startRecording(FrameSink *sink);
+    void stopRecording();
+    FramePixelFormat lastFormat() const;
+    double nominalFps() const;
+
+    void setPreviewSize(const QSize &size);
+    QImage latestPreview() const;
+    CameraStreamStats stats() const;
+
+signals:
+    void previewUpdated(int index);
+    void streamError(int index, const QString &message);
+
+private:
+    // 以下在工作线程执行
+    void processVideoFrame(const QVideoFrame &frame);
+    void processPacket(const FramePacket &packet);
+    void schedulePreview(const FramePacket &packet);
+    // 在转换线程池执行
+    void runPreview(FramePacket packet);
+    void waitPreviewIdle();
+
+    int m_index;
+    QString m_name;
+    TaskPool *m_converterPool;
+
+    QThread m_thread;
+    QObject *m_worker;   // 工作线程中的上下文对象，帧回调在其线程执行
+    QCamera *m_camera;
+    QMediaCaptureSession *m_session;
+    QVideoSink *m_sink;
+    TestPatternSource *m_pattern;
+    RecordingPipeline m_recorder;
+    QString m_error;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_previewIdle;
+    bool m_previewBusy;
+    bool m_closing;
+    FramePacket m_previewPending;
+    QSize m_previewSize;
+    QImage m_preview;
+    FramePixelFormat m_lastFormat;
+    double m_nominalFps;
+    quint64 m_sequence;
+    CameraStreamStats m_stats;
+    qint64 m_totalConvertUs;
+    qint64 m_fpsWindowStartUs;
+    quint64 m_fpsWindowFrames;
+};
+
+// 多摄像头管理
+// 每个设备一个捕获会话和工作线程，预览转换由共享线程池按路轮转调度
+class MultiCameraManager : public QObject {
+    Q_OBJECT
+public:
+    explicit MultiCameraManager(QObject *parent = nullptr);
+    ~MultiCameraManager();
+
+    // 打开设备，格式优先选择指定像素格式和分辨率下帧率最接近的一项；返回成功打开的路数
+    int openDevices(const QList<QCameraDevice> &devices, QVideoFrameFormat::PixelFormat pixelFormat,
+                    const QSize &resolution, int fps);
+    // 添加一路测试图案输入
+    void addTestPattern(FramePixelFormat format, const QSize &size, double fps);
+    void closeAll();
+
+    int streamCount() const;
+    CameraStream *stream(int index) const;
+
+    // 每路录制到dir下独立的文件：MJPEG为.avi直通，其他为.raw
+    bool startRecording(const QString &dir);
+    void stopRecording();
+    bool isRecording() const;
+    QString errorString() const;
+
+    void setPreviewSize(const QSize &size);
+    // 默认使用TaskPool::shared()；指定线程数时改用独立的线程池（须在打开设备前调用，用于测试）
+    void setConverterThreads(int count);
+    int converterThreads() const;
+
+    static QCameraFormat chooseFormat(const QCameraDevice &device, QVideoFrameFormat::PixelFormat pixelFormat,
+                                      const QSize &resolution, int fps);
+
+signals:
+    void previewUpdated(int index);
+    void streamError(int index, const QString &message);
+
+private:
+    TaskPool *m_converterPool;
+    std::unique_ptr<TaskPool> m_ownPool;
+    QList<CameraStream*> m_streams;
+    QSize m_previewSize;
+    bool m_recording;
+    QString m_error;
+};
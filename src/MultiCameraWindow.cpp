@@ -0,0 +1,81 @@
+#include "MultiCameraWindow.h"
+#include "dbgout.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QFileDialog>
+#include <QCoreApplication>
+#include <QCloseEvent>
+
+MultiCameraWindow::MultiCameraWindow(QWidget *parent)
+    : QWidget(parent, Qt::Window),
+      m_manager(new MultiCameraManager(this)),
+      m_preview(new TiledPreviewWidget(this)),
+      m_btnRecord(new QPushButton("全部录制", this)),
+      m_labelStatus(new QLabel(this))
+{
+    setWindowTitle("多路预览");
+    setAttribute(Qt::WA_DeleteOnClose);
+    resize(1280, 760);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    buttons->addWidget(m_labelStatus, 1);
+    buttons->addWidget(m_btnRecord);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_preview, 1);
+    layout->addLayout(buttons);
+
+    connect(m_btnRecord, &QPushButton::clicked, this, &MultiCameraWindow::toggleRecording);
+    connect(m_manager, &MultiCameraManager::streamError, this, &MultiCameraWindow::handleStreamError);
+}
+
+MultiCameraWindow::~MultiCameraWindow()
+{
+    m_preview->setManager(nullptr);
+    m_manager->closeAll();
+}
+
+int MultiCameraWindow::openDevices(const QList<QCameraDevice> &devices, QVideoFrameFormat::PixelFormat pixelFormat,
+                                   const QSize &resolution, int fps)
+{
+    const int opened = m_manager->openDevices(devices, pixelFormat, resolution, fps);
+    m_preview->setManager(m_manager);
+    m_labelStatus->setText(QString("已打开 %1 路，转换线程: %2").arg(opened).arg(m_manager->converterThreads()));
+    return opened;
+}
+
+void MultiCameraWindow::closeEvent(QCloseEvent *event)
+{
+    m_manager->stopRecording();
+    QWidget::closeEvent(event);
+}
+
+void MultiCameraWindow::toggleRecording()
+{
+    if (m_manager->isRecording()) {
+        m_manager->stopRecording();
+        m_btnRecord->setText("全部录制");
+        logToConsole("多路采集: 停止录制");
+        return;
+    }
+
+    const QString dir = QFileDialog::getExistingDirectory(this, tr("选择录制目录"),
+                                                          QCoreApplication::applicationDirPath());
+    if (dir.isEmpty()) {
+        return;
+    }
+    if (!m_manager->startRecording(dir)) {
+        QMessageBox::critical(this, tr("录制错误"), tr("无法开始录制：%1").arg(m_manager->errorString()));
+        return;
+    }
+    m_btnRecord->setText("停止录制");
+}
+
+void MultiCameraWindow::handleStreamError(int index, const QString &message)
+{
+    const CameraStream *stream = m_manager->stream(index);
+    const QString name = stream ? stream->name() : QString::number(index + 1);
+    logToConsole(QString("多路采集: %1 出错: %2").arg(name).arg(message));
+    m_labelStatus->setText(QString("%1 出错: %2").arg(name).arg(message));
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <QWidget>
+#include <QPushButton>
+#include <QLabel>
+#include <QCameraDevice>
+#include <QVideoFrameFormat>
+#include "MultiCameraManager.h"
+#include "TiledPreviewWidget.h"
+
+// 多路预览窗口：同时打开多个摄像头，拼接预览并可一键全部录制
+class MultiCameraWindow : public QWidget {
+    Q_OBJECT
+public:
+    explicit MultiCameraWindow(QWidget *parent = nullptr);
+    ~MultiCameraWindow();
+
+    // 返回成功打开的路数
+    int openDevices(const QList<QCameraDevice> &devices, QVideoFrameFormat::PixelFormat pixelFormat,
+                    const QSize &resolution, int fps);
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
+private slots:
+    void toggleRecording();
+    void handleStreamError(int index, const QString &message);
+
+private:
+    MultiCameraManager *m_manager;
+    TiledPreviewWidget *m_preview;
+    QPushButton *m_btnRecord;
+    QLabel *m_labelStatus;
+};
@@ -0,0 +1,197 @@
+#include "PreRollBuffer.h"
+#include <QVideoFrame>
+#include <cstring>
+
+PreRollBuffer::PreRollBuffer()
+    : m_oldest(0),
+      m_count(0),
+      m_writePos(0),
+      m_usedBytes(0),
+      m_windowUs(0)
+{
+}
+
+void PreRollBuffer::configure(qint64 windowUs, qint64 arenaBytes, int maxPackets)
+{
+    m_windowUs = windowUs;
+    if (arenaBytes <= 0 || maxPackets <= 0 || windowUs <= 0) {
+        m_arena = QByteArray();
+        m_slots = QVector<Slot>();
+    } else {
+        if (m_arena.size() != arenaBytes) {
+            m_arena = QByteArray(arenaBytes, Qt::Uninitialized);
+        }
+        if (m_slots.size() != maxPackets) {
+            m_slots = QVector<Slot>(maxPackets);
+        }
+    }
+    clear();
+}
+
+void PreRollBuffer::clear()
+{
+    for (int i = 0; i < m_count; ++i) {
+        m_slots[(m_oldest + i) % m_slots.size()].meta = FramePacket();
+    }
+    m_oldest = 0;
+    m_count = 0;
+    m_writePos = 0;
+    m_usedBytes = 0;
+}
+
+bool PreRollBuffer::isEnabled() const
+{
+    return m_windowUs > 0 && !m_arena.isEmpty();
+}
+
+bool PreRollBuffer::overlapsOldest(qint64 begin, qint64 end) const
+{
+    const Slot &slot = m_slots[m_oldest];
+    return slot.offset < end && slot.offset + slot.size > begin;
+}
+
+void PreRollBuffer::evictOldest()
+{
+    Slot &slot = m_slots[m_oldest];
+    m_usedBytes -= slot.size;
+    slot.meta = FramePacket();
+    m_oldest = (m_oldest + 1) % m_slots.size();
+    m_count--;
+    if (m_count == 0) {
+        m_writePos = 0;
+        m_usedBytes = 0;
+    }
+}
+
+bool PreRollBuffer::push(const FramePacket &meta, const char *payload, qint64 size)
+{
+    const qint64 capacity = m_arena.size();
+    if (!isEnabled() || size <= 0 || size > capacity) {
+        return false;
+    }
+
+    // 尾部放不下时回绕到开头，先淘汰位于尾部区域的旧数据
+    qint64 pos = m_writePos;
+    if (pos + size > capacity) {
+        while (m_count > 0 && m_slots[m_oldest].offset >= pos) {
+            evictOldest();
+        }
+        pos = 0;
+    }
+    while (m_count > 0 && overlapsOldest(pos, pos + size)) {
+        evictOldest();
+    }
+    if (m_count == m_slots.size()) {
+        evictOldest();
+    }
+
+    memcpy(m_arena.data() + pos, payload, size_t(size));
+
+    Slot &slot = m_slots[(m_oldest + m_count) % m_slots.size()];
+    slot.meta = meta;
+    slot.meta.data = QByteArray();
+    slot.meta.owner.reset();
+    slot.offset = pos;
+    slot.size = size;
+    m_count++;
+    m_writePos = pos + size;
+    m_usedBytes += size;
+
+    // 按时间窗口淘汰
+    while (m_count > 1 && meta.captureUs - m_slots[m_oldest].meta.captureUs > m_windowUs) {
+        evictOldest();
+    }
+    return true;
+}
+
+bool PreRollBuffer::push(const FramePacket &packet)
+{
+    return push(packet, packet.data.constData(), packet.data.size());
+}
+
+bool PreRollBuffer::pushVideoFrame(const QVideoFrame &frame, quint64 sequence)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    const QVideoFrameFormat::PixelFormat pixelFormat = frame.pixelFormat();
+    if (pixelFormat != QVideoFrameFormat::Format_YUYV && pixelFormat != QVideoFrameFormat::Format_Jpeg) {
+        return false;
+    }
+
+    QVideoFrame mapped(frame);
+    if (!mapped.map(QVideoFrame::ReadOnly)) {
+        return false;
+    }
+
+    FramePacket meta;
+    meta.captureUs = monotonicUs();
+    meta.sequence = sequence;
+    meta.size = frame.size();
+    meta.ptsUs = frame.startTime() >= 0 ? frame.startTime() : meta.captureUs;
+    qint64 size = 0;
+    if (pixelFormat == QVideoFrameFormat::Format_YUYV) {
+        meta.format = FramePixelFormat::YUYV;
+        meta.bytesPerLine = mapped.bytesPerLine(0);
+        size = qint64(meta.bytesPerLine) * meta.size.height();
+    } else {
+        meta.format = FramePixelFormat::MJPEG;
+        size = mapped.mappedBytes(0);
+    }
+
+    const bool ok = push(meta, reinterpret_cast<const char*>(mapped.bits(0)), size);
+    mapped.unmap();
+    return ok;
+}
+
+QList<FramePacket> PreRollBuffer::takeAll()
+{
+    QList<FramePacket> packets;
+    packets.reserve(m_count);
+    for (int i = 0; i < m_count; ++i) {
+        const Slot &slot = m_slots[(m_oldest + i) % m_slots.size()];
+        FramePacket packet = slot.meta;
+        packet.data = QByteArray(m_arena.constData() + slot.offset, slot.size);
+        packets.append(packet);
+    }
+    clear();
+    return packets;
+}
+
+qint64 PreRollBuffer::windowUs() const
+{
+    return m_windowUs;
+}
+
+qint64 PreRollBuffer::usedBytes() const
+{
+    return m_usedBytes;
+}
+
+qint64 PreRollBuffer::capacityBytes() const
+{
+    return m_arena.size();
+}
+
+int PreRollBuffer::packetCount() const
+{
+    return m_count;
+}
+
+qint64 PreRollBuffer::spanUs() const
+{
+    qint64 first = -1;
+    qint64 last = -1;
+    for (int i = 0; i < m_count; ++i) {
+        const Slot &slot = m_slots[(m_oldest + i) % m_slots.size()];
+        if (slot.meta.isAudio()) {
+            continue;
+        }
+        if (first < 0) {
+            first = slot.meta.captureUs;
+        }
+        last = slot.meta.captureUs;
+    }
+    return first >= 0 ? last - first : 0;
+}
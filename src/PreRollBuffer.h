@@ -0,0 +1,54 @@
+#pragma once
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include "FramePacket.h"
+
+class QVideoFrame;
+
+// 预录环形缓存
+// 未录制时持续保存最近N秒的视频帧（MJPEG/YUYV原始数据）和音频，开始录制时一次性取出写入文件。
+// 数据保存在启动时分配好的固定大小内存块中，帧元数据保存在固定长度的槽数组中，
+// 推入新帧只做memcpy，不做任何内存分配；空间或槽不够时淘汰最旧的数据。
+class PreRollBuffer {
+public:
+    PreRollBuffer();
+
+    // 分配缓存，windowUs为保留时长；arenaBytes为0时释放缓存并关闭预录
+    void configure(qint64 windowUs, qint64 arenaBytes, int maxPackets);
+    void clear();
+    bool isEnabled() const;
+
+    // 推入一帧，只拷贝payload到缓存，packet.data被忽略
+    bool push(const FramePacket &meta, const char *payload, qint64 size);
+    bool push(const FramePacket &packet);
+    // 直接从摄像头帧映射的内存拷贝，YUYV/MJPEG以外的格式不缓存
+    bool pushVideoFrame(const QVideoFrame &frame, quint64 sequence);
+
+    // 按时间顺序取出所有缓存的帧（深拷贝）并清空缓存
+    QList<FramePacket> takeAll();
+
+    qint64 windowUs() const;
+    qint64 usedBytes() const;
+    qint64 capacityBytes() const;
+    int packetCount() const;
+    qint64 spanUs() const;       // 缓存中最旧与最新视频帧的时间跨度
+
+private:
+    struct Slot {
+        FramePacket meta;         // data始终为空
+        qint64 offset = 0;
+        qint64 size = 0;
+    };
+
+    void evictOldest();
+    bool overlapsOldest(qint64 begin, qint64 end) const;
+
+    QByteArray m_arena;
+    QVector<Slot> m_slots;
+    int m_oldest;
+    int m_count;
+    qint64 m_writePos;
+    qint64 m_usedBytes;
+    qint64 m_windowUs;
+};
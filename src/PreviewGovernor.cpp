@@ -0,0 +1,166 @@
+#include "PreviewGovernor.h"
+#include "FramePacket.h"
+#include <QMutexLocker>
+
+namespace {
+    // 每帧预览最多占用帧间隔的一半，其余留给采集、录制和界面
+    const double BUDGET_FRACTION = 0.5;
+    // 平均耗时低于预算的这个比例才算有余量
+    const double HEADROOM_FRACTION = 0.5;
+    // 帧率未知时按30 FPS计算预算
+    const double DEFAULT_FRAME_RATE = 30.0;
+    // 持续超出预算这么久才降级
+    const qint64 OVER_BUDGET_US = 500000;
+    // 持续有余量这么久才升级，升级后很快又降级时加倍，最长60秒
+    const qint64 STEP_UP_HOLD_US = 3000000;
+    const qint64 MAX_STEP_UP_HOLD_US = 60000000;
+    // 升级后在这段时间内降级视为来回切换
+    const qint64 OSCILLATION_WINDOW_US = 5000000;
+    // 调整后等新级别的耗时稳定下来再判断
+    const qint64 COOLDOWN_US = 1000000;
+    const int MIN_SAMPLES = 5;
+    const int MAX_HISTORY = 8;
+}
+
+PreviewGovernor::PreviewGovernor()
+{
+    reset(0);
+}
+
+void PreviewGovernor::reset(double frameRate)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    const double fps = frameRate > 0 ? frameRate : DEFAULT_FRAME_RATE;
+    m_level = Smooth;
+    m_budgetUs = 1000000.0 / fps * BUDGET_FRACTION;
+    m_averageCostUs = 0;
+    m_samples = 0;
+    m_skipCounter = 0;
+    m_lastChangeUs = monotonicUs();
+    m_lastStepUpUs = 0;
+    m_overBudgetSinceUs = 0;
+    m_headroomSinceUs = 0;
+    m_stepUpHoldUs = STEP_UP_HOLD_US;
+    m_history.clear();
+}
+
+PreviewGovernor::Level PreviewGovernor::level() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_level;
+}
+
+bool PreviewGovernor::shouldSkip()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (m_level != FrameSkip) {
+        return false;
+    }
+    // 每两帧显示一帧
+    return (m_skipCounter++ & 1) != 0;
+}
+
+bool PreviewGovernor::recordCost(Level level, qint64 costUs)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    // 调整前按旧级别处理的帧不计入
+    if (level != m_level) {
+        return false;
+    }
+    m_averageCostUs = m_samples == 0 ? costUs : m_averageCostUs * 0.8 + costUs * 0.2;
+    m_samples++;
+
+    const qint64 now = monotonicUs();
+    // 升级后稳定了足够久，下次升级恢复正常的等待时间
+    if (m_lastStepUpUs != 0 && now - m_lastStepUpUs > OSCILLATION_WINDOW_US) {
+        m_lastStepUpUs = 0;
+        m_stepUpHoldUs = STEP_UP_HOLD_US;
+    }
+    if (now - m_lastChangeUs < COOLDOWN_US || m_samples < MIN_SAMPLES) {
+        return false;
+    }
+
+    if (m_averageCostUs > m_budgetUs) {
+        m_headroomSinceUs = 0;
+        if (m_overBudgetSinceUs == 0) {
+            m_overBudgetSinceUs = now;
+        } else if (now - m_overBudgetSinceUs >= OVER_BUDGET_US && m_level < FrameSkip) {
+            changeLevel(Level(m_level + 1), now);
+            return true;
+        }
+    } else if (m_averageCostUs < m_budgetUs * HEADROOM_FRACTION) {
+        m_overBudgetSinceUs = 0;
+        if (m_headroomSinceUs == 0) {
+            m_headroomSinceUs = now;
+        } else if (now - m_headroomSinceUs >= m_stepUpHoldUs && m_level > Smooth) {
+            changeLevel(Level(m_level - 1), now);
+            return true;
+        }
+    } else {
+        // 在预算和余量之间：保持当前级别
+        m_overBudgetSinceUs = 0;
+        m_headroomSinceUs = 0;
+    }
+    return false;
+}
+
+void PreviewGovernor::changeLevel(Level to, qint64 nowUs)
+{
+    PreviewQualityChange change;
+    change.time = QTime::currentTime();
+    change.from = m_level;
+    change.to = to;
+    change.costUs = m_averageCostUs;
+    change.budgetUs = m_budgetUs;
+    m_history.append(change);
+    while (m_history.size() > MAX_HISTORY) {
+        m_history.removeFirst();
+    }
+
+    if (to > m_level) {
+        // 刚升级就降级：下次升级前要求更长的稳定时间
+        if (m_lastStepUpUs != 0) {
+            m_stepUpHoldUs = qMin(m_stepUpHoldUs * 2, MAX_STEP_UP_HOLD_US);
+        }
+        m_lastStepUpUs = 0;
+    } else {
+        m_lastStepUpUs = nowUs;
+    }
+
+    m_level = to;
+    m_averageCostUs = 0;
+    m_samples = 0;
+    m_skipCounter = 0;
+    m_lastChangeUs = nowUs;
+    m_overBudgetSinceUs = 0;
+    m_headroomSinceUs = 0;
+}
+
+double PreviewGovernor::averageCostUs() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_averageCostUs;
+}
+
+double PreviewGovernor::budgetUs() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_budgetUs;
+}
+
+QList<PreviewQualityChange> PreviewGovernor::history() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_history;
+}
+
+QString PreviewGovernor::levelName(int level)
+{
+    switch (level) {
+        case Smooth: return "平滑";
+        case Bilinear: return "双线性";
+        case Nearest: return "最近邻";
+        case FrameSkip: return "隔帧";
+    }
+    return QString();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QTime>
+#include <QtGlobal>
+
+// 预览质量调整记录
+struct PreviewQualityChange {
+    QTime time;
+    int from = 0;
+    int to = 0;
+    double costUs = 0;      // 调整时的平均每帧预览耗时
+    double budgetUs = 0;    // 调整时的每帧预算
+};
+
+// 预览质量调节器（不依赖界面控件）
+// 按帧间隔给每帧预览（转换+缩放）分配预算，平均耗时持续超出预算时逐级降低质量：
+// 平滑（面积平均）→ 双线性（SIMD）→ 最近邻 → 最近邻并隔帧显示；
+// 耗时持续低于预算的一半时逐级恢复。升降之间留有冷却时间，
+// 刚升级就又降级时加倍下次升级前需要的稳定时间，避免在两级之间来回切换。
+class PreviewGovernor {
+public:
+    enum Level {
+        Smooth,
+        Bilinear,
+        Nearest,
+        FrameSkip
+    };
+
+    PreviewGovernor();
+
+    // 摄像头帧率变化或重新打开时调用，同时回到最高质量
+    void reset(double frameRate);
+    Level level() const;
+    // 隔帧显示级别下，返回这一帧是否应跳过
+    bool shouldSkip();
+    // 预览分发线程每处理完一帧调用一次，质量级别改变时返回true
+    bool recordCost(Level level, qint64 costUs);
+
+    double averageCostUs() const;
+    double budgetUs() const;
+    // 最近的调整记录，最新的在最后
+    QList<PreviewQualityChange> history() const;
+
+    static QString levelName(int level);
+
+private:
+    void changeLevel(Level to, qint64 nowUs);
+
+    mutable QMutex m_mutex;
+    Level m_level;
+    double m_budgetUs;
+    double m_averageCostUs;
+    int m_samples;
+    quint64 m_skipCounter;
+    qint64 m_lastChangeUs;
+    qint64 m_lastStepUpUs;
+    qint64 m_overBudgetSinceUs;
+    qint64 m_headroomSinceUs;
+    qint64 m_stepUpHoldUs;
+    QList<PreviewQualityChange> m_history;
+};
@@ -0,0 +1,195 @@
+#include "PreviewPipeline.h"
+#include "DigitalZoom.h"
+#include "FocusMetric.h"
+#include "FrameConvert.h"
+#include "dbgout.h"
+#include <QMutexLocker>
+#include <memory>
+
+namespace {
+    // 峰值对焦阈值：亮度梯度|gx|+|gy|
+    const int PREVIEW_PEAKING_THRESHOLD = 40;
+}
+
+PreviewPipeline::PreviewPipeline(FrameBus *bus, LensCorrection *lens, ImageAdjust *adjust, QObject *parent)
+    : QObject(parent),
+      m_bus(bus),
+      m_subscription(0),
+      m_lens(lens),
+      m_adjust(adjust),
+      m_enabled(0),
+      m_peaking(false),
+      m_processUs(0),
+      m_pending(false)
+{
+    // 只保留最新一帧，预览来不及时丢弃旧帧，不影响录制和其他订阅者
+    m_subscription = m_bus->subscribe("预览", [this](const SharedFrame &frame) {
+        process(frame);
+    }, 1, RecordingPipeline::DropOldest);
+}
+
+PreviewPipeline::~PreviewPipeline()
+{
+    // 等待分发线程退出后才能释放本对象
+    m_bus->unsubscribe(m_subscription);
+}
+
+void PreviewPipeline::setEnabled(bool enabled)
+{
+    m_enabled.storeRelaxed(enabled ? 1 : 0);
+}
+
+bool PreviewPipeline::isEnabled() const
+{
+    return m_enabled.loadRelaxed() != 0;
+}
+
+void PreviewPipeline::setTargetSize(const QSize &size)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_targetSize = size;
+}
+
+void PreviewPipeline::setZoomRegion(const QRectF &roi)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_zoomRoi = roi;
+}
+
+void PreviewPipeline::setPeaking(bool enabled)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_peaking = enabled;
+}
+
+void PreviewPipeline::setDenoiseStrength(int strength)
+{
+    m_denoise.setStrength(strength);
+}
+
+PreviewThrottle *PreviewPipeline::throttle()
+{
+    return &m_throttle;
+}
+
+PreviewGovernor *PreviewPipeline::governor()
+{
+    return &m_governor;
+}
+
+QImage PreviewPipeline::latestImage(double *processUs)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_pending = false;
+    if (processUs) {
+        *processUs = m_processUs;
+    }
+    return m_image;
+}
+
+void PreviewPipeline::clear()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_image = QImage();
+    m_processUs = 0;
+}
+
+void PreviewPipeline::process(const SharedFrame &frame)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    // 窗口不可见时直接丢弃，失去焦点时按较低帧率放行
+    if (!m_throttle.admit(frame.captureUs())) {
+        return;
+    }
+    // 预览超出帧预算时按质量调节器的级别降低缩放质量，最低一级隔帧显示
+    const PreviewGovernor::Level level = m_governor.level();
+    if (m_governor.shouldSkip()) {
+        return;
+    }
+    const qint64 processBegin = monotonicUs();
+    QSize target;
+    bool peaking = false;
+    QRectF zoomRoi;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        target = m_targetSize;
+        peaking = m_peaking;
+        zoomRoi = m_zoomRoi;
+    }
+    QImage image = render(frame, level, target, zoomRoi);
+    if (image.isNull()) {
+        return;
+    }
+    // 时域降噪在缩放后的预览图上进行，缩放已经平均掉一部分噪声，耗时也与预览尺寸成正比；
+    // 变焦或窗口大小改变后尺寸变化，从下一帧重新累积
+    m_denoise.apply(&image);
+    // 软件图像调节在缩放后的预览图上进行，与录制使用同一组查找表
+    m_adjust->apply(&image);
+    // 峰值对焦在缩放后的预览图上计算，耗时与预览尺寸成正比
+    if (peaking) {
+        applyFocusPeaking(&image, PREVIEW_PEAKING_THRESHOLD, qRgb(255, 0, 0));
+    }
+    const qint64 processUs = monotonicUs() - processBegin;
+    m_throttle.recordProcessing(processUs);
+    if (m_governor.recordCost(level, processUs)) {
+        const PreviewQualityChange change = m_governor.history().last();
+        logToConsole(QString("预览质量: %1 -> %2（平均耗时 %3 ms，预算 %4 ms）")
+                         .arg(PreviewGovernor::levelName(change.from))
+                         .arg(PreviewGovernor::levelName(change.to))
+                         .arg(change.costUs / 1000.0, 0, 'f', 2)
+                         .arg(change.budgetUs / 1000.0, 0, 'f', 2));
+    }
+
+    bool notify = false;
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_image = image;
+        m_processUs = m_processUs == 0 ? processUs : m_processUs * 0.9 + processUs * 0.1;
+        notify = !m_pending;
+        m_pending = true;
+    }
+    // 界面还没取走上一帧时不重复通知
+    if (notify) {
+        emit imageReady();
+    }
+}
+
+QImage PreviewPipeline::render(const SharedFrame &frame, PreviewGovernor::Level level, const QSize &target,
+                               const QRectF &zoomRoi)
+{
+    // 畸变校正在全分辨率的帧上进行（与录制共用映射表），之后按原来的流程变焦、转换和缩放；
+    // MJPEG先整帧解码为RGB32再校正
+    FramePacket packet = frame.packet();
+    if (m_lens->isActive()) {
+        if (packet.format == FramePixelFormat::MJPEG) {
+            auto decoded = std::make_shared<QImage>(packetToImage(packet));
+            if (m_lens->apply(decoded.get())) {
+                packet.data = QByteArray::fromRawData(reinterpret_cast<const char*>(decoded->constBits()),
+                                                      decoded->sizeInBytes());
+                packet.format = FramePixelFormat::RGB32;
+                packet.size = decoded->size();
+                packet.bytesPerLine = int(decoded->bytesPerLine());
+                packet.owner = decoded;
+            }
+        } else {
+            m_lens->apply(&packet, &m_lensBuffer);
+        }
+    }
+    // 数字变焦时只转换/解码放大区域，放大倍数越高预览越省时
+    const QRect region = zoomRoi.isEmpty() ? QRect() : cropRegion(zoomRoi, packet.size, packet.format);
+    if (level == PreviewGovernor::Smooth || level == PreviewGovernor::Bilinear) {
+        const QImage image = packetToImage(packet, region);
+        if (image.isNull()) {
+            return QImage();
+        }
+        const QSize scaledSize = image.size().scaled(target, Qt::KeepAspectRatio);
+        // 面积平均放大时退化为最近邻（数字变焦或小分辨率放满窗口），放大一律用双线性
+        const bool enlarging = scaledSize.width() > image.width() || scaledSize.height() > image.height();
+        return level == PreviewGovernor::Smooth && !enlarging ? scaleImageParallel(image, scaledSize)
+                                                              : scaleImageBilinearParallel(image, scaledSize);
+    }
+    // 最近邻：YUYV隔点转换，MJPEG缩小解码，不生成全分辨率中间图像
+    return packetToPreview(packet, target, region);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <QAtomicInt>
+#include "FrameBus.h"
+#include "ImageAdjust.h"
+#include "LensCorrection.h"
+#include "PreviewGovernor.h"
+#include "PreviewThrottle.h"
+#include "TemporalDenoise.h"
+
+// 预览处理管线（不依赖界面控件）
+// 订阅帧总线，在自己的分发线程中依次做畸变校正、按变焦区域转换/解码、按质量级别缩放、时域降噪、
+// 软件图像调节和峰值对焦，只保留最新一帧；界面只负责显示结果和绘制叠加信息。
+// 没有启用时不做任何处理（无界面模式）。
+class PreviewPipeline : public QObject {
+    Q_OBJECT
+public:
+    // lens/adjust与录制共用（同一组映射表和查找表），由调用方保证比本对象存活得久
+    PreviewPipeline(FrameBus *bus, LensCorrection *lens, ImageAdjust *adjust, QObject *parent = nullptr);
+    ~PreviewPipeline();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // 以下设置可在任意线程调用，从下一帧起生效
+    // 缩放的目标尺寸（保持宽高比放入其中）
+    void setTargetSize(const QSize &size);
+    // 数字变焦区域（归一化），空矩形为整帧
+    void setZoomRegion(const QRectF &roi);
+    void setPeaking(bool enabled);
+    void setDenoiseStrength(int strength);
+
+    // 窗口可见性节流，界面线程设置模式
+    PreviewThrottle *throttle();
+    // 质量调节器，摄像头帧率变化时调用reset()
+    PreviewGovernor *governor();
+
+    // 最新一帧处理好的预览图，processUs返回平滑后的每帧处理耗时（微秒）；
+    // 调用后下一帧处理完成时会再次发出imageReady()
+    QImage latestImage(double *processUs = nullptr);
+    // 丢弃最后一帧和耗时统计（关闭摄像头后调用）
+    void clear();
+
+signals:
+    // 在预览分发线程中发出；界面调用latestImage()之前不会重复发出
+    void imageReady();
+
+private:
+    void process(const SharedFrame &frame);
+    QImage render(const SharedFrame &frame, PreviewGovernor::Level level, const QSize &target,
+                  const QRectF &zoomRoi);
+
+    FrameBus *m_bus;
+    int m_subscription;
+    LensCorrection *m_lens;
+    ImageAdjust *m_adjust;
+    QAtomicInt m_enabled;
+    PreviewThrottle m_throttle;
+    PreviewGovernor m_governor;
+    TemporalDenoise m_denoise;      // apply()只在预览分发线程中调用
+    QByteArray m_lensBuffer;        // 只在预览分发线程中使用，跨帧复用
+
+    mutable QMutex m_mutex;
+    QSize m_targetSize;
+    QRectF m_zoomRoi;
+    bool m_peaking;
+    QImage m_image;
+    double m_processUs;
+    bool m_pending;
+};
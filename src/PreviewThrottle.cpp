@@ -0,0 +1,98 @@
+#include "PreviewThrottle.h"
+#include <QMutexLocker>
+
+namespace {
+    // 失去焦点时的默认预览帧率
+    const double DEFAULT_THROTTLED_FPS = 5.0;
+}
+
+PreviewThrottle::PreviewThrottle()
+    : m_mode(Full),
+      m_throttledFps(DEFAULT_THROTTLED_FPS),
+      m_lastAdmittedUs(0),
+      m_averageProcessUs(0)
+{
+}
+
+void PreviewThrottle::setMode(Mode mode)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (m_mode != mode) {
+        m_mode = mode;
+        // 恢复显示后立即放行下一帧
+        m_lastAdmittedUs = 0;
+    }
+}
+
+PreviewThrottle::Mode PreviewThrottle::mode() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_mode;
+}
+
+void PreviewThrottle::setThrottledFps(double fps)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_throttledFps = qMax(0.5, fps);
+}
+
+double PreviewThrottle::throttledFps() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_throttledFps;
+}
+
+bool PreviewThrottle::admit(qint64 captureUs)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    bool admitted = true;
+    if (m_mode == Hidden) {
+        admitted = false;
+    } else if (m_mode == Throttled && m_lastAdmittedUs != 0) {
+        const qint64 intervalUs = qint64(1000000.0 / m_throttledFps);
+        admitted = captureUs - m_lastAdmittedUs >= intervalUs;
+    }
+
+    if (admitted) {
+        m_lastAdmittedUs = captureUs;
+        m_current.admitted++;
+        m_total.admitted++;
+    } else {
+        const qint64 savedUs = qint64(m_averageProcessUs);
+        m_current.skipped++;
+        m_current.savedUs += savedUs;
+        m_total.skipped++;
+        m_total.savedUs += savedUs;
+    }
+    return admitted;
+}
+
+void PreviewThrottle::recordProcessing(qint64 processUs)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_averageProcessUs = m_averageProcessUs == 0 ? processUs : m_averageProcessUs * 0.9 + processUs * 0.1;
+}
+
+PreviewThrottleStats PreviewThrottle::takeStats()
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    const PreviewThrottleStats stats = m_current;
+    m_current = PreviewThrottleStats();
+    return stats;
+}
+
+PreviewThrottleStats PreviewThrottle::totalStats() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_total;
+}
+
+QString PreviewThrottle::modeName(Mode mode)
+{
+    switch (mode) {
+        case Full: return "全速";
+        case Throttled: return "降频";
+        case Hidden: return "暂停";
+    }
+    return QString();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <QMutex>
+#include <QString>
+#include <QtGlobal>
+
+// 预览节流统计
+struct PreviewThrottleStats {
+    quint64 admitted = 0;       // 送去转换和显示的帧数
+    quint64 skipped = 0;        // 因窗口不可见或降频而跳过的帧数
+    qint64 savedUs = 0;         // 按平均每帧处理耗时估算的节省CPU时间（微秒）
+};
+
+// 预览节流（不依赖界面控件）
+// 界面线程根据窗口可见性设置模式，预览分发线程每帧调用admit()决定是否转换和显示；
+// 采集、录制和统计不经过这里，始终全速运行。
+class PreviewThrottle {
+public:
+    enum Mode {
+        Full,       // 每帧都显示
+        Throttled,  // 窗口失去焦点：按较低的帧率显示
+        Hidden      // 窗口最小化、隐藏或被完全遮挡：不转换不显示
+    };
+
+    PreviewThrottle();
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    void setThrottledFps(double fps);
+    double throttledFps() const;
+
+    // captureUs为帧进入管线的单调时钟时间；返回false时调用方直接丢弃这一帧
+    bool admit(qint64 captureUs);
+    // 记录一帧预览的实际处理耗时，用于估算跳过的帧节省了多少CPU时间
+    void recordProcessing(qint64 processUs);
+
+    // 取出上次调用以来的统计并清零，一般每秒调用一次
+    PreviewThrottleStats takeStats();
+    // 累计统计
+    PreviewThrottleStats totalStats() const;
+
+    static QString modeName(Mode mode);
+
+private:
+    mutable QMutex m_mutex;
+    Mode m_mode;
+    double m_throttledFps;
+    qint64 m_lastAdmittedUs;
+    double m_averageProcessUs;
+    PreviewThrottleStats m_current;
+    PreviewThrottleStats m_total;
+};
@@ -0,0 +1,65 @@
+#include "ProcessStats.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <QFile>
+#endif
+
+#ifdef Q_OS_WIN
+namespace {
+    // FILETIME单位为100纳秒
+    qint64 fileTimeToUs(const FILETIME &time)
+    {
+        ULARGE_INTEGER value;
+        value.LowPart = time.dwLowDateTime;
+        value.HighPart = time.dwHighDateTime;
+        return qint64(value.QuadPart / 10);
+    }
+}
+#endif
+
+ProcessUsage currentProcessUsage()
+{
+    ProcessUsage usage;
+#ifdef Q_OS_WIN
+    HANDLE process = GetCurrentProcess();
+    FILETIME creation, exitTime, kernel, user;
+    if (GetProcessTimes(process, &creation, &exitTime, &kernel, &user)) {
+        usage.userCpuUs = fileTimeToUs(user);
+        usage.systemCpuUs = fileTimeToUs(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(process, &memory, sizeof(memory))) {
+        usage.peakRssBytes = qint64(memory.PeakWorkingSetSize);
+    }
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(process, &io)) {
+        usage.ioWriteBytes = qint64(io.WriteTransferCount);
+    }
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0) {
+        usage.userCpuUs = qint64(ru.ru_utime.tv_sec) * 1000000 + ru.ru_utime.tv_usec;
+        usage.systemCpuUs = qint64(ru.ru_stime.tv_sec) * 1000000 + ru.ru_stime.tv_usec;
+#ifdef Q_OS_MACOS
+        usage.peakRssBytes = qint64(ru.ru_maxrss);          // macOS单位为字节
+#else
+        usage.peakRssBytes = qint64(ru.ru_maxrss) * 1024;   // Linux单位为KB
+#endif
+    }
+    // write_bytes是真正提交到块设备层的字节数，tmpfs上始终为0
+    QFile io("/proc/self/io");
+    if (io.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = io.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("write_bytes:")) {
+                usage.ioWriteBytes = line.mid(12).trimmed().toLongLong();
+            }
+        }
+    }
+#endif
+    return usage;
+}
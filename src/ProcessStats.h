@@ -0,0 +1,15 @@
+#pragma once
+#include <QtGlobal>
+
+// 进程资源占用快照，用于性能测试
+struct ProcessUsage {
+    qint64 userCpuUs = 0;      // 用户态CPU时间（微秒）
+    qint64 systemCpuUs = 0;    // 内核态CPU时间（微秒）
+    qint64 peakRssBytes = 0;   // 峰值常驻内存
+    qint64 ioWriteBytes = -1;  // 实际提交到存储层的写入字节数，平台不支持时为-1
+
+    qint64 cpuUs() const { return userCpuUs + systemCpuUs; }
+};
+
+// 读取当前进程的资源占用（Linux: getrusage + /proc/self/io，Windows: GetProcessTimes等）
+ProcessUsage currentProcessUsage();
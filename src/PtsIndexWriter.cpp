@@ -0,0 +1,59 @@
+#include "PtsIndexWriter.h"
+
+PtsIndexWriter::PtsIndexWriter()
+    : m_headerWritten(false)
+{
+}
+
+PtsIndexWriter::~PtsIndexWriter()
+{
+    close();
+}
+
+QString PtsIndexWriter::indexPathFor(const QString &mediaPath)
+{
+    return mediaPath + ".pts";
+}
+
+bool PtsIndexWriter::open(const QString &mediaPath)
+{
+    m_file.setFileName(indexPathFor(mediaPath));
+    m_headerWritten = false;
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+}
+
+bool PtsIndexWriter::append(const FramePacket &packet, qint64 offset, qint64 size)
+{
+    if (!m_headerWritten) {
+        const QByteArray header = QString("# format=%1 width=%2 height=%3 bytesPerLine=%4\n")
+                                      .arg(pixelFormatName(packet.format))
+                                      .arg(packet.size.width())
+                                      .arg(packet.size.height())
+                                      .arg(packet.bytesPerLine)
+                                      .toLatin1();
+        if (m_file.write(header) != header.size()) {
+            return false;
+        }
+        m_headerWritten = true;
+    }
+
+    const QByteArray line = QString("%1 %2 %3 %4\n")
+                                .arg(packet.sequence)
+                                .arg(packet.ptsUs)
+                                .arg(offset)
+                                .arg(size)
+                                .toLatin1();
+    return m_file.write(line) == line.size();
+}
+
+void PtsIndexWriter::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+QString PtsIndexWriter::errorString() const
+{
+    return m_file.errorString();
+}
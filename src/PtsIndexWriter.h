@@ -0,0 +1,24 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include "FramePacket.h"
+
+// 帧时间戳索引文件（.pts），与录制文件放在一起，用于事后校验帧数和时间戳：
+//   # format=YUYV width=1920 height=1080 bytesPerLine=3840
+//   <序号> <pts微秒> <偏移> <字节数>
+class PtsIndexWriter {
+public:
+    PtsIndexWriter();
+    ~PtsIndexWriter();
+
+    bool open(const QString &mediaPath);
+    bool append(const FramePacket &packet, qint64 offset, qint64 size);
+    void close();
+    QString errorString() const;
+
+    static QString indexPathFor(const QString &mediaPath);
+
+private:
+    QFile m_file;
+    bool m_headerWritten;
+};
@@ -0,0 +1,77 @@
+#include "RawFileSink.h"
+
+RawFileSink::RawFileSink(const QString &filePath)
+    : m_dataFile(filePath),
+      m_bytesWritten(0)
+{
+}
+
+RawFileSink::~RawFileSink()
+{
+    close();
+}
+
+bool RawFileSink::open()
+{
+    if (!m_dataFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_dataFile.errorString();
+        return false;
+    }
+    if (!m_index.open(m_dataFile.fileName())) {
+        m_error = m_index.errorString();
+        m_dataFile.close();
+        return false;
+    }
+    m_bytesWritten = 0;
+    return true;
+}
+
+bool RawFileSink::writeFrame(const FramePacket &packet)
+{
+    if (!m_dataFile.isOpen()) {
+        m_error = "文件未打开";
+        return false;
+    }
+
+    // 原始帧文件只保存视频
+    if (packet.isAudio()) {
+        return true;
+    }
+
+    const qint64 offset = m_bytesWritten;
+    const qint64 written = m_dataFile.write(packet.data);
+    if (written != packet.data.size()) {
+        m_error = m_dataFile.errorString();
+        return false;
+    }
+    m_bytesWritten += written;
+
+    if (!m_index.append(packet, offset, written)) {
+        m_error = m_index.errorString();
+        return false;
+    }
+    return true;
+}
+
+void RawFileSink::close()
+{
+    if (m_dataFile.isOpen()) {
+        m_dataFile.close();
+    }
+    m_index.close();
+}
+
+QString RawFileSink::errorString() const
+{
+    return m_error;
+}
+
+qint64 RawFileSink::bytesWritten() const
+{
+    return m_bytesWritten;
+}
+
+QStringList RawFileSink::outputFiles() const
+{
+    return QStringList() << m_dataFile.fileName() << PtsIndexWriter::indexPathFor(m_dataFile.fileName());
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <QFile>
+#include <QString>
+#include "FrameSink.h"
+#include "PtsIndexWriter.h"
+
+// 原始帧文件输出
+// 帧数据按顺序直接追加到数据文件，每帧的时间戳和偏移写入同名的 .pts 索引文件
+class RawFileSink : public FrameSink {
+public:
+    explicit RawFileSink(const QString &filePath);
+    ~RawFileSink() override;
+
+    bool open() override;
+    bool writeFrame(const FramePacket &packet) override;
+    void close() override;
+
+    QString errorString() const override;
+    qint64 bytesWritten() const override;
+    QStringList outputFiles() const override;
+
+private:
+    QFile m_dataFile;
+    PtsIndexWriter m_index;
+    QString m_error;
+    qint64 m_bytesWritten;
+};
@@ -0,0 +1,270 @@
+#include "RecordingPipeline.h"
+#include "dbgout.h"
+#include <QMutexLocker>
+
+RecordingPipeline::RecordingPipeline(QObject *parent)
+    : QObject(parent),
+      m_capacity(8),
+      m_policy(DropOldest),
+      m_running(false),
+      m_stopRequested(false),
+      m_sinkFailed(false),
+      m_sink(nullptr),
+      m_writerThread(nullptr),
+      m_totalWriteUs(0)
+{
+}
+
+RecordingPipeline::~RecordingPipeline()
+{
+    stop();
+}
+
+void RecordingPipeline::setQueueCapacity(int frames)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_capacity = qMax(1, frames);
+}
+
+int RecordingPipeline::queueCapacity() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_capacity;
+}
+
+void RecordingPipeline::setDropPolicy(DropPolicy policy)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_policy = policy;
+}
+
+RecordingPipeline::DropPolicy RecordingPipeline::dropPolicy() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_policy;
+}
+
+void RecordingPipeline::setFrameTransform(FrameTransform transform)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_transform = std::move(transform);
+}
+
+bool RecordingPipeline::start(FrameSink *sink, const QList<FramePacket> &preRoll)
+{
+    stop();
+
+    if (!sink) {
+        m_error = "未指定输出";
+        return false;
+    }
+    if (!sink->open()) {
+        m_error = sink->errorString();
+        delete sink;
+        return false;
+    }
+
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_queue.clear();
+        m_preRoll.clear();
+        for (const FramePacket &packet : preRoll) {
+            m_preRoll.enqueue(packet);
+        }
+        m_stats = RecordingStats();
+        m_stats.queueCapacity = m_capacity;
+        m_stats.queued = quint64(preRoll.size());
+        m_stats.preRollFrames = quint64(preRoll.size());
+        m_latency.clear();
+        m_totalWriteUs = 0;
+        m_stopRequested = false;
+        m_sinkFailed = false;
+        m_running = true;
+        m_sink = sink;
+        m_error.clear();
+    }
+
+    m_writerThread = QThread::create([this]() { writerLoop(); });
+    m_writerThread->setObjectName("RecordingWriter");
+    m_writerThread->start();
+
+    logToConsole(QString("录制管线已启动，队列容量: %1，丢帧策略: %2，预录帧: %3")
+                     .arg(m_capacity).arg(dropPolicyName(m_policy)).arg(preRoll.size()));
+    return true;
+}
+
+void RecordingPipeline::stop()
+{
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_stopRequested = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    m_writerThread->wait();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+
+    m_sink->close();
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_stats.bytesWritten = m_sink->bytesWritten();
+        m_running = false;
+    }
+    delete m_sink;
+    m_sink = nullptr;
+
+    const RecordingStats s = stats();
+    logToConsole(QString("录制管线已停止，入队: %1，写入: %2，丢弃: %3，峰值队列: %4")
+                     .arg(s.queued).arg(s.encoded).arg(s.dropped).arg(s.maxQueueDepth));
+}
+
+bool RecordingPipeline::isRunning() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_running;
+}
+
+QString RecordingPipeline::errorString() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_error;
+}
+
+bool RecordingPipeline::submit(const FramePacket &packet)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (!m_running || m_stopRequested || m_sinkFailed) {
+        return false;
+    }
+
+    if (m_queue.size() >= m_capacity) {
+        switch (m_policy) {
+            case DropOldest:
+                m_queue.dequeue();
+                m_stats.dropped++;
+                break;
+            case DropNewest:
+                m_stats.dropped++;
+                return false;
+            case Block:
+                while (m_queue.size() >= m_capacity && !m_stopRequested && !m_sinkFailed) {
+                    m_notFull.wait(&m_mutex);
+                }
+                if (m_stopRequested || m_sinkFailed) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    m_queue.enqueue(packet);
+    m_stats.queued++;
+    m_stats.queueDepth = int(m_queue.size());
+    m_stats.maxQueueDepth = qMax(m_stats.maxQueueDepth, m_stats.queueDepth);
+    m_notEmpty.wakeOne();
+    return true;
+}
+
+int RecordingPipeline::queueDepth() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return int(m_queue.size() + m_preRoll.size());
+}
+
+RecordingStats RecordingPipeline::stats() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_stats;
+}
+
+LatencyHistogram RecordingPipeline::latencyHistogram() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_latency;
+}
+
+QString RecordingPipeline::dropPolicyName(DropPolicy policy)
+{
+    switch (policy) {
+        case DropOldest:
+            return "丢弃最旧帧";
+        case DropNewest:
+            return "丢弃最新帧";
+        case Block:
+            return "阻塞等待";
+    }
+    return QString();
+}
+
+void RecordingPipeline::writerLoop()
+{
+    for (;;) {
+        FramePacket packet;
+        FrameTransform transform;
+        bool preRoll = false;
+        {
+            QMutexLocker<QMutex> locker(&m_mutex);
+            transform = m_transform;
+            // 预录帧优先写入，保证文件中预录内容与实时内容首尾相接
+            if (!m_preRoll.isEmpty()) {
+                packet = m_preRoll.dequeue();
+                preRoll = true;
+            } else {
+                while (m_queue.isEmpty() && !m_stopRequested) {
+                    m_notEmpty.wait(&m_mutex);
+                }
+                // 停止时先把队列写完再退出
+                if (m_queue.isEmpty()) {
+                    return;
+                }
+                packet = m_queue.dequeue();
+                m_stats.queueDepth = int(m_queue.size());
+                m_notFull.wakeOne();
+            }
+        }
+
+        const qint64 begin = monotonicUs();
+        if (transform) {
+            transform(&packet);
+        }
+        const bool ok = m_sink->writeFrame(packet);
+        const qint64 end = monotonicUs();
+
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (!ok) {
+            m_sinkFailed = true;
+            m_error = m_sink->errorString();
+            m_stats.dropped += m_queue.size() + m_preRoll.size() + 1;
+            m_queue.clear();
+            m_preRoll.clear();
+            m_stats.queueDepth = 0;
+            m_notFull.wakeAll();
+            const QString message = m_error;
+            locker.unlock();
+            emit sinkError(message);
+            return;
+        }
+
+        const qint64 writeUs = end - begin;
+        m_stats.encoded++;
+        m_stats.payloadBytes += packet.data.size();
+        m_stats.bytesWritten = m_sink->bytesWritten();
+        m_stats.lastWriteUs = writeUs;
+        m_stats.maxWriteUs = qMax(m_stats.maxWriteUs, writeUs);
+        m_totalWriteUs += writeUs;
+        m_stats.avgWriteUs = double(m_totalWriteUs) / double(m_stats.encoded);
+        // 预录帧在开始录制前就已采集，延迟是它在预录缓存中的时长，不计入端到端延迟
+        if (preRoll) {
+            m_stats.maxPreRollAgeUs = qMax(m_stats.maxPreRollAgeUs, end - packet.captureUs);
+            continue;
+        }
+        m_stats.lastLatencyUs = end - packet.captureUs;
+        m_stats.maxLatencyUs = qMax(m_stats.maxLatencyUs, m_stats.lastLatencyUs);
+        m_latency.add(m_stats.lastLatencyUs);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QThread>
+#include <functional>
+#include "FramePacket.h"
+#include "FrameSink.h"
+#include "LatencyHistogram.h"
+
+// 录制管线统计数据
+struct RecordingStats {
+    quint64 queued = 0;        // 成功入队的帧数
+    quint64 preRollFrames = 0; // 其中来自预录缓存的帧数
+    quint64 encoded = 0;       // 已写入输出端的帧数
+    quint64 dropped = 0;       // 因队列满被丢弃的帧数
+    qint64 bytesWritten = 0;   // 输出端实际写入的字节数
+    qint64 payloadBytes = 0;   // 写入的帧数据字节数
+    int queueDepth = 0;        // 当前队列深度
+    int maxQueueDepth = 0;     // 峰值队列深度
+    int queueCapacity = 0;
+    qint64 lastWriteUs = 0;    // 最近一帧的写入耗时
+    qint64 maxWriteUs = 0;
+    double avgWriteUs = 0;
+    qint64 lastLatencyUs = 0;  // 最近一帧从进入管线到写完的延迟（只统计实时帧）
+    qint64 maxLatencyUs = 0;
+    qint64 maxPreRollAgeUs = 0; // 预录帧写完时距采集的最长时间（预录缓存覆盖的时长加写入耗时）
+};
+
+// 录制管线
+// 捕获线程通过submit()把帧放入有界队列，写入线程从队列取帧交给FrameSink。
+// 磁盘变慢时队列按丢帧策略处理，不会阻塞预览。
+class RecordingPipeline : public QObject {
+    Q_OBJECT
+public:
+    enum DropPolicy {
+        DropOldest,   // 队列满时丢弃最旧的帧，保证录制内容最新
+        DropNewest,   // 队列满时丢弃新到的帧，保证已排队内容连续
+        Block         // 队列满时等待写入线程，不丢帧（仅用于离线测试，会阻塞调用者）
+    };
+
+    explicit RecordingPipeline(QObject *parent = nullptr);
+    ~RecordingPipeline();
+
+    void setQueueCapacity(int frames);
+    int queueCapacity() const;
+    void setDropPolicy(DropPolicy policy);
+    DropPolicy dropPolicy() const;
+
+    // 写入前在写入线程中对每帧做的处理（如软件图像调节），返回false表示不处理、按原样写入
+    using FrameTransform = std::function<bool(FramePacket *packet)>;
+    void setFrameTransform(FrameTransform transform);
+
+    // 启动管线，接管sink的所有权；sink打开失败时返回false并通过errorString()给出原因
+    // preRoll中的帧（预录缓存）在所有实时帧之前写入，且不受队列容量和丢帧策略限制
+    bool start(FrameSink *sink, const QList<FramePacket> &preRoll = QList<FramePacket>());
+    // 停止管线：写完队列中剩余的帧后关闭输出端
+    void stop();
+    bool isRunning() const;
+    QString errorString() const;
+
+    // 提交一帧，返回false表示该帧被丢弃
+    bool submit(const FramePacket &packet);
+
+    // 等待写入的帧数（含未写完的预录帧，不含写入线程正在处理的一帧），比stats()开销小，可以每帧调用
+    int queueDepth() const;
+    RecordingStats stats() const;
+    // 实时帧端到端延迟的分布（不含预录帧）
+    LatencyHistogram latencyHistogram() const;
+
+    static QString dropPolicyName(DropPolicy policy);
+
+signals:
+    void sinkError(const QString &message);
+
+private:
+    void writerLoop();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<FramePacket> m_queue;
+    QQueue<FramePacket> m_preRoll;
+    int m_capacity;
+    DropPolicy m_policy;
+    FrameTransform m_transform;
+    bool m_running;
+    bool m_stopRequested;
+    bool m_sinkFailed;
+
+    FrameSink *m_sink;
+    QThread *m_writerThread;
+    QString m_error;
+
+    RecordingStats m_stats;
+    LatencyHistogram m_latency;
+    qint64 m_totalWriteUs;
+};
@@ -0,0 +1,269 @@
+#include "SegmentedSink.h"
+#include "FileSync.h"
+#include "dbgout.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+
+// ---------------- SegmentCloser ----------------
+
+SegmentCloser::SegmentCloser(const QString &manifestPath)
+    : m_manifestPath(manifestPath),
+      m_thread(nullptr),
+      m_finishing(false),
+      m_busy(0),
+      m_closedBytes(0)
+{
+}
+
+SegmentCloser::~SegmentCloser()
+{
+    finish();
+}
+
+void SegmentCloser::start()
+{
+    finish();
+    m_finishing = false;
+    m_finished.clear();
+    m_closedBytes = 0;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("SegmentCloser");
+    m_thread->start();
+}
+
+void SegmentCloser::enqueue(const Segment &segment)
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    m_queue.enqueue(segment);
+    m_wake.wakeOne();
+}
+
+void SegmentCloser::finish()
+{
+    if (!m_thread) {
+        return;
+    }
+    {
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_finishing = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+qint64 SegmentCloser::closedBytes() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return m_closedBytes;
+}
+
+int SegmentCloser::pendingCount() const
+{
+    QMutexLocker<QMutex> locker(&m_mutex);
+    return int(m_queue.size()) + m_busy;
+}
+
+void SegmentCloser::run()
+{
+    for (;;) {
+        Segment segment;
+        {
+            QMutexLocker<QMutex> locker(&m_mutex);
+            while (m_queue.isEmpty() && !m_finishing) {
+                m_wake.wait(&m_mutex);
+            }
+            if (m_queue.isEmpty()) {
+                return;
+            }
+            segment = m_queue.dequeue();
+            m_busy = 1;
+        }
+
+        const qint64 begin = monotonicUs();
+        segment.sink->close();
+        const QStringList files = segment.sink->outputFiles();
+        for (const QString &file : files) {
+            if (!syncFileToDisk(file)) {
+                logToConsole("分段文件同步到磁盘失败: " + file);
+            }
+        }
+        const qint64 bytes = segment.sink->bytesWritten();
+        delete segment.sink;
+        segment.sink = nullptr;
+
+        m_finished.append(segment);
+        if (!writeManifest()) {
+            logToConsole("写入分段清单失败: " + m_manifestPath);
+        }
+
+        logToConsole(QString("分段已落盘: %1，收尾耗时 %2 ms")
+                         .arg(QFileInfo(segment.path).fileName())
+                         .arg((monotonicUs() - begin) / 1000.0, 0, 'f', 1));
+
+        QMutexLocker<QMutex> locker(&m_mutex);
+        m_closedBytes += bytes;
+        m_busy = 0;
+    }
+}
+
+bool SegmentCloser::writeManifest()
+{
+    // ffconcat清单：文件名相对清单所在目录，duration保证拼接后时间轴连续
+    QSaveFile file(m_manifestPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QByteArray content = "ffconcat version 1.0\n";
+    for (const Segment &segment : m_finished) {
+        content += "file '" + QFileInfo(segment.path).fileName().toUtf8() + "'\n";
+        content += "duration " + QByteArray::number(segment.durationUs / 1000000.0, 'f', 6) + "\n";
+    }
+    file.write(content);
+    if (!file.commit()) {
+        return false;
+    }
+    return syncFileToDisk(m_manifestPath);
+}
+
+// ---------------- SegmentedSink ----------------
+
+SegmentedSink::SegmentedSink(const QString &basePath, SinkFactory factory, qint64 maxDurationUs, qint64 maxBytes)
+    : m_basePath(basePath),
+      m_factory(factory),
+      m_maxDurationUs(maxDurationUs),
+      m_maxBytes(maxBytes),
+      m_current(nullptr),
+      m_segmentIndex(-1),
+      m_segmentStartPtsUs(-1),
+      m_lastVideoPtsUs(-1),
+      m_lastVideoIntervalUs(0),
+      m_closer(manifestPath(basePath))
+{
+}
+
+SegmentedSink::~SegmentedSink()
+{
+    close();
+}
+
+QString SegmentedSink::segmentPath(const QString &basePath, int index)
+{
+    // video_20250101_120000.avi -> video_20250101_120000_000.avi
+    const QFileInfo info(basePath);
+    const QString suffix = info.suffix().isEmpty() ? QString() : "." + info.suffix();
+    return info.dir().filePath(QString("%1_%2%3")
+                                   .arg(info.completeBaseName())
+                                   .arg(index, 3, 10, QChar('0'))
+                                   .arg(suffix));
+}
+
+QString SegmentedSink::manifestPath(const QString &basePath)
+{
+    const QFileInfo info(basePath);
+    return info.dir().filePath(info.completeBaseName() + ".ffconcat");
+}
+
+bool SegmentedSink::open()
+{
+    m_segmentIndex = -1;
+    m_files.clear();
+    m_closer.start();
+    return openSegment();
+}
+
+bool SegmentedSink::openSegment()
+{
+    m_segmentIndex++;
+    const QString path = segmentPath(m_basePath, m_segmentIndex);
+    FrameSink *sink = m_factory(path);
+    if (!sink || !sink->open()) {
+        m_error = sink ? sink->errorString() : QString("无法创建分段输出");
+        delete sink;
+        return false;
+    }
+    m_current = sink;
+    m_segmentStartPtsUs = -1;
+    m_files << sink->outputFiles();
+    logToConsole("开始录制分段: " + path);
+    return true;
+}
+
+void SegmentedSink::handOffSegment(qint64 endPtsUs)
+{
+    SegmentCloser::Segment segment;
+    segment.sink = m_current;
+    segment.path = segmentPath(m_basePath, m_segmentIndex);
+    segment.durationUs = m_segmentStartPtsUs >= 0 && endPtsUs > m_segmentStartPtsUs
+                             ? endPtsUs - m_segmentStartPtsUs : 0;
+    m_current = nullptr;
+    m_closer.enqueue(segment);
+}
+
+bool SegmentedSink::writeFrame(const FramePacket &packet)
+{
+    if (!m_current) {
+        m_error = "分段输出未打开";
+        return false;
+    }
+
+    if (!packet.isAudio()) {
+        // 只在视频关键帧处切换，新分段可独立解码
+        const bool durationReached = m_maxDurationUs > 0 && m_segmentStartPtsUs >= 0 &&
+                                     packet.ptsUs - m_segmentStartPtsUs >= m_maxDurationUs;
+        const bool sizeReached = m_maxBytes > 0 && m_current->bytesWritten() >= m_maxBytes;
+        if (packet.keyFrame && (durationReached || sizeReached)) {
+            // 本段时长取到下一段第一帧为止，拼接后时间轴无间隙
+            handOffSegment(packet.ptsUs);
+            if (!openSegment()) {
+                return false;
+            }
+        }
+
+        if (m_lastVideoPtsUs >= 0 && packet.ptsUs > m_lastVideoPtsUs) {
+            m_lastVideoIntervalUs = packet.ptsUs - m_lastVideoPtsUs;
+        }
+        m_lastVideoPtsUs = packet.ptsUs;
+        if (m_segmentStartPtsUs < 0) {
+            m_segmentStartPtsUs = packet.ptsUs;
+        }
+    }
+
+    if (!m_current->writeFrame(packet)) {
+        m_error = m_current->errorString();
+        return false;
+    }
+    return true;
+}
+
+void SegmentedSink::close()
+{
+    if (m_current) {
+        // 最后一段的时长包含最后一帧的显示时间
+        handOffSegment(m_lastVideoPtsUs + m_lastVideoIntervalUs);
+    }
+    m_closer.finish();
+}
+
+QString SegmentedSink::errorString() const
+{
+    return m_error;
+}
+
+qint64 SegmentedSink::bytesWritten() const
+{
+    return m_closer.closedBytes() + (m_current ? m_current->bytesWritten() : 0);
+}
+
+QStringList SegmentedSink::outputFiles() const
+{
+    return m_files + QStringList(manifestPath(m_basePath));
+}
+
+int SegmentedSink::segmentCount() const
+{
+    return m_segmentIndex + 1;
+}
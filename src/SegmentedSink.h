@@ -0,0 +1,92 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QThread>
+#include <functional>
+#include "FrameSink.h"
+
+// 分段文件的后台收尾线程
+// 已写满的分段交给该线程执行close()和fsync，再更新清单文件，写入线程不会因此等待磁盘
+class SegmentCloser {
+public:
+    struct Segment {
+        FrameSink *sink = nullptr;
+        QString path;
+        qint64 durationUs = 0;
+    };
+
+    explicit SegmentCloser(const QString &manifestPath);
+    ~SegmentCloser();
+
+    void start();
+    void enqueue(const Segment &segment);
+    // 等待所有分段收尾完成后退出线程
+    void finish();
+
+    qint64 closedBytes() const;
+    int pendingCount() const;
+
+private:
+    void run();
+    bool writeManifest();
+
+    QString m_manifestPath;
+    QThread *m_thread;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QQueue<Segment> m_queue;
+    bool m_finishing;
+    int m_busy;
+
+    // 仅收尾线程访问
+    QList<Segment> m_finished;
+    qint64 m_closedBytes;
+};
+
+// 分段录制输出
+// 按时长或大小在关键帧处切换到新文件，每段文件由工厂函数创建的FrameSink写入；
+// 同时维护ffconcat格式的清单文件，可用 ffmpeg -f concat -i <清单> -c copy 无损拼接。
+class SegmentedSink : public FrameSink {
+public:
+    using SinkFactory = std::function<FrameSink*(const QString &path)>;
+
+    // maxDurationUs/maxBytes为0表示不按该条件分段
+    SegmentedSink(const QString &basePath, SinkFactory factory, qint64 maxDurationUs, qint64 maxBytes);
+    ~SegmentedSink() override;
+
+    bool open() override;
+    bool writeFrame(const FramePacket &packet) override;
+    void close() override;
+
+    QString errorString() const override;
+    qint64 bytesWritten() const override;
+    QStringList outputFiles() const override;
+
+    int segmentCount() const;
+
+    static QString segmentPath(const QString &basePath, int index);
+    static QString manifestPath(const QString &basePath);
+
+private:
+    bool openSegment();
+    void handOffSegment(qint64 endPtsUs);
+
+    QString m_basePath;
+    SinkFactory m_factory;
+    qint64 m_maxDurationUs;
+    qint64 m_maxBytes;
+
+    FrameSink *m_current;
+    int m_segmentIndex;
+    qint64 m_segmentStartPtsUs;
+    qint64 m_lastVideoPtsUs;
+    qint64 m_lastVideoIntervalUs;
+    QStringList m_files;
+    QString m_error;
+
+    SegmentCloser m_closer;
+};
@@ -0,0 +1,90 @@
+#include "SimdSupport.h"
+#include <QAtomicInt>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+    // setSimdLevel()设置的上限，默认不限制
+    QAtomicInt simdLevelCap(int(SimdLevel::Avx512Vbmi));
+
+    SimdLevel probeSimdLevel()
+    {
+#if !defined(CAMERA_HAVE_SSE2)
+        return SimdLevel::Scalar;
+#elif !defined(CAMERA_HAVE_AVX2)
+        return SimdLevel::Sse2;
+#elif defined(__GNUC__) || defined(__clang__)
+        // __builtin_cpu_supports同时检查操作系统是否保存了对应的寄存器状态
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2")) {
+            return SimdLevel::Sse2;
+        }
+        if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi")) {
+            return SimdLevel::Avx512Vbmi;
+        }
+        return SimdLevel::Avx2;
+#else
+        int info[4];
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) {
+            return SimdLevel::Sse2;
+        }
+        // XCR0：YMM状态（位1、2），AVX-512还需要opmask和ZMM状态（位5~7）
+        const unsigned long long xcr0 = _xgetbv(0);
+        if ((xcr0 & 0x6) != 0x6) {
+            return SimdLevel::Sse2;
+        }
+        __cpuidex(info, 7, 0);
+        if ((info[1] & (1 << 5)) == 0) {
+            return SimdLevel::Sse2;
+        }
+        const bool avx512bw = (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 30)) != 0;
+        const bool vbmi = (info[2] & (1 << 1)) != 0;
+        if (avx512bw && vbmi && (xcr0 & 0xE0) == 0xE0) {
+            return SimdLevel::Avx512Vbmi;
+        }
+        return SimdLevel::Avx2;
+#endif
+    }
+}
+
+SimdLevel detectedSimdLevel()
+{
+    static const SimdLevel level = probeSimdLevel();
+    return level;
+}
+
+SimdLevel simdLevel()
+{
+    return SimdLevel(qMin(int(detectedSimdLevel()), simdLevelCap.loadRelaxed()));
+}
+
+void setSimdLevel(SimdLevel maxLevel)
+{
+    simdLevelCap.storeRelaxed(int(maxLevel));
+}
+
+QString simdLevelName(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::Sse2: return "sse2";
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Avx512Vbmi: return "avx512vbmi";
+    }
+    return "scalar";
+}
+
+bool simdLevelFromName(const QString &name, SimdLevel *level)
+{
+    for (SimdLevel candidate : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512Vbmi}) {
+        if (name.compare(simdLevelName(candidate), Qt::CaseInsensitive) == 0) {
+            *level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
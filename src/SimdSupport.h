@@ -0,0 +1,44 @@
+#pragma once
+#include <QString>
+
+// SSE2检测：GCC/Clang在x86-64下默认定义__SSE2__；MSVC不定义这个宏，
+// 但x64总是支持SSE2，32位编译时/arch:SSE2以上会把_M_IX86_FP设为2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CAMERA_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2/AVX-512指令不作为编译选项打开（目标机器不一定支持），只在单独的函数中使用，运行时按simdLevel()选择：
+// GCC/Clang用target属性为这些函数单独开启指令集，MSVC不需要编译选项就能使用这些intrinsic。
+// CAMERA_DISABLE_AVX由CMake在不能安全使用AVX的工具链上定义（见CMakeLists.txt中的MinGW说明）
+#if defined(CAMERA_HAVE_SSE2) && (defined(__x86_64__) || defined(_M_X64)) && !defined(CAMERA_DISABLE_AVX) && \
+    (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#define CAMERA_HAVE_AVX2 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define CAMERA_TARGET_AVX2 __attribute__((target("avx2")))
+#define CAMERA_TARGET_AVX512VBMI __attribute__((target("avx2,avx512f,avx512bw,avx512vbmi")))
+#else
+#define CAMERA_TARGET_AVX2
+#define CAMERA_TARGET_AVX512VBMI
+#endif
+#endif
+
+// 可以使用的指令集级别，后一级包含前一级
+enum class SimdLevel {
+    Scalar,         // 只用标量代码（与SIMD路径逐字节对照的参考实现）
+    Sse2,
+    Avx2,
+    Avx512Vbmi,     // AVX-512BW + VBMI（vpermi2b一条指令查128项字节表）
+};
+
+// 当前使用的级别：CPU支持的最高级别，不超过setSimdLevel()设置的上限
+SimdLevel simdLevel();
+// 限制使用的最高级别（性能测试和SIMD对照测试用），对之后的处理立即生效。按级别选择实现的有图像调节、
+// 镜头畸变校正、直方图和时域降噪，Scalar时它们全部走标量路径（见tools/simd_check.cpp）
+void setSimdLevel(SimdLevel maxLevel);
+// CPU支持的最高级别（不受setSimdLevel()限制）
+SimdLevel detectedSimdLevel();
+QString simdLevelName(SimdLevel level);
+// 按名称（scalar/sse2/avx2/avx512vbmi，不区分大小写）解析，无法识别时返回false
+bool simdLevelFromName(const QString &name, SimdLevel *level);
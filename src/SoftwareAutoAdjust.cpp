@@ -0,0 +1,255 @@
+#include "SoftwareAutoAdjust.h"
+#include <QStringList>
+#include <cmath>
+
+namespace {
+    // 曝光范围不超过这个档数时按log2秒处理
+    const long LOG2_EXPOSURE_MAX_SPAN = 20;
+    // log2曝光每档曝光量加倍，死区小于半档会在相邻两档间来回
+    const double LOG2_EXPOSURE_DEADBAND_STOPS = 0.75;
+    // 画面是gamma编码的，亮度差一倍约对应曝光差2.2档
+    const double DISPLAY_GAMMA = 2.2;
+    // 白平衡最小值不小于这个值时按色温处理
+    const long KELVIN_MINIMUM = 1000;
+    // 亮度在这个范围内、中性像素足够多时才调白平衡，否则颜色统计不可靠
+    const double WHITE_BALANCE_MIN_LUMA = 40;
+    const double WHITE_BALANCE_MAX_LUMA = 220;
+    const double WHITE_BALANCE_MIN_NEUTRAL = 0.05;
+    // 每次只修正一半的偏色（不同摄像头色温设置对R/B的影响不同，全量修正容易来回振荡），
+    // 色温每次最多变化20%~25%，其他单位每次最多变化范围的20%
+    const double WHITE_BALANCE_GAIN = 0.5;
+    const double WHITE_BALANCE_MAX_FACTOR = 1.25;
+    const double WHITE_BALANCE_MAX_RANGE = 0.2;
+}
+
+SoftwareAutoAdjust::SoftwareAutoAdjust()
+    : m_exposure(false),
+      m_whiteBalance(false),
+      m_exposureValue(0),
+      m_whiteBalanceValue(0),
+      m_nextExposureUs(0),
+      m_nextWhiteBalanceUs(0),
+      m_lastLuma(0),
+      m_lastRedBlue(1)
+{
+}
+
+bool SoftwareAutoAdjust::start(std::shared_ptr<CameraDeviceControl> control, bool exposure, bool whiteBalance,
+                               QString *error)
+{
+    stop();
+    if (!control) {
+        if (error) *error = "没有参数控制接口";
+        return false;
+    }
+    m_exposure = exposure && control->isSupported(CameraProperty::Exposure) &&
+                 control->range(CameraProperty::Exposure, &m_exposureRange) && m_exposureRange.canManual &&
+                 control->value(CameraProperty::Exposure, &m_exposureValue);
+    m_whiteBalance = whiteBalance && control->isSupported(CameraProperty::WhiteBalance) &&
+                     control->range(CameraProperty::WhiteBalance, &m_whiteBalanceRange) && m_whiteBalanceRange.canManual &&
+                     control->value(CameraProperty::WhiteBalance, &m_whiteBalanceValue);
+    if (!m_exposure && !m_whiteBalance) {
+        if (error) *error = "设备不支持手动设置曝光和白平衡";
+        return false;
+    }
+
+    // 切换为手动，之后由本类写入
+    if (m_exposure) {
+        control->setValue(CameraProperty::Exposure, m_exposureValue, false);
+    }
+    if (m_whiteBalance) {
+        control->setValue(CameraProperty::WhiteBalance, m_whiteBalanceValue, false);
+    }
+    m_control = std::move(control);
+    m_nextExposureUs = 0;
+    m_nextWhiteBalanceUs = 0;
+    m_lastLuma = 0;
+    m_lastRedBlue = 1;
+    m_exposureState.clear();
+    return true;
+}
+
+void SoftwareAutoAdjust::stop()
+{
+    m_control.reset();
+    m_exposure = false;
+    m_whiteBalance = false;
+}
+
+bool SoftwareAutoAdjust::isRunning() const
+{
+    return m_control != nullptr;
+}
+
+bool SoftwareAutoAdjust::controlsExposure() const
+{
+    return m_exposure;
+}
+
+bool SoftwareAutoAdjust::controlsWhiteBalance() const
+{
+    return m_whiteBalance;
+}
+
+void SoftwareAutoAdjust::setSettings(const Settings &settings)
+{
+    m_settings = settings;
+}
+
+SoftwareAutoAdjust::Settings SoftwareAutoAdjust::settings() const
+{
+    return m_settings;
+}
+
+QList<AutoAdjustStep> SoftwareAutoAdjust::update(const ExposureStats &stats)
+{
+    QList<AutoAdjustStep> steps;
+    if (!m_control || !stats.isValid()) {
+        return steps;
+    }
+    m_lastLuma = stats.meanLuma;
+    if (stats.meanBlue > 0 && stats.meanRed > 0) {
+        m_lastRedBlue = stats.meanRed / stats.meanBlue;
+    }
+
+    AutoAdjustStep step;
+    if (m_exposure && updateExposure(stats, &step)) {
+        steps.append(step);
+    }
+    if (m_whiteBalance && updateWhiteBalance(stats, &step)) {
+        steps.append(step);
+    }
+    return steps;
+}
+
+bool SoftwareAutoAdjust::updateExposure(const ExposureStats &stats, AutoAdjustStep *step)
+{
+    if (stats.captureUs < m_nextExposureUs) {
+        return false;
+    }
+
+    // 需要调整的曝光档数，过曝时优先降低
+    double errorStops = DISPLAY_GAMMA * std::log2(m_settings.targetLuma / qMax(1.0, stats.meanLuma));
+    if (stats.clippedHighPercent > m_settings.clipHighPercent) {
+        errorStops = qMin(errorStops, -1.0);
+    } else if (stats.clippedHighPercent > m_settings.clipHoldPercent) {
+        errorStops = qMin(errorStops, 0.0);
+    }
+
+    const CameraPropertyRange &range = m_exposureRange;
+    const long unit = qMax(1L, range.step);
+    long target = m_exposureValue;
+    if (range.maximum - range.minimum <= LOG2_EXPOSURE_MAX_SPAN) {
+        if (std::abs(errorStops) < LOG2_EXPOSURE_DEADBAND_STOPS) {
+            m_exposureState = "稳定";
+            return false;
+        }
+        target = m_exposureValue + (errorStops > 0 ? unit : -unit);
+    } else {
+        if (std::abs(errorStops) < m_settings.exposureDeadbandStops) {
+            m_exposureState = "稳定";
+            return false;
+        }
+        const double stops = qBound(-m_settings.maxExposureStops, errorStops, m_settings.maxExposureStops);
+        target = snap(qRound64(m_exposureValue * std::exp2(stops)), range);
+        if (target == m_exposureValue) {
+            target = m_exposureValue + (errorStops > 0 ? unit : -unit);
+        }
+    }
+    target = qBound(range.minimum, target, range.maximum);
+    if (target == m_exposureValue) {
+        m_exposureState = errorStops > 0 ? "已到最长曝光" : "已到最短曝光";
+        return false;
+    }
+
+    // 写入失败时也等一个间隔再试，避免每帧都访问设备
+    m_nextExposureUs = stats.captureUs + m_settings.exposureIntervalUs;
+    if (!m_control->setValue(CameraProperty::Exposure, target, false)) {
+        m_exposureState = "写入失败";
+        return false;
+    }
+    step->property = CameraProperty::Exposure;
+    step->from = m_exposureValue;
+    step->to = target;
+    step->measured = stats.meanLuma;
+    m_exposureValue = target;
+    m_exposureState = errorStops > 0 ? "增加" : "减少";
+    return true;
+}
+
+bool SoftwareAutoAdjust::updateWhiteBalance(const ExposureStats &stats, AutoAdjustStep *step)
+{
+    if (stats.captureUs < m_nextWhiteBalanceUs) {
+        return false;
+    }
+    if (stats.meanLuma < WHITE_BALANCE_MIN_LUMA || stats.meanLuma > WHITE_BALANCE_MAX_LUMA ||
+        stats.neutralSamples < stats.samples * WHITE_BALANCE_MIN_NEUTRAL ||
+        stats.meanRed <= 0 || stats.meanBlue <= 0) {
+        return false;
+    }
+
+    // 灰世界：中性像素的R和B应当相等。偏红时降低色温设置（摄像头按更暖的光源补偿，画面变蓝），偏蓝时提高
+    const double cast = std::log(stats.meanRed / stats.meanBlue);
+    if (std::abs(cast) < m_settings.whiteBalanceDeadband) {
+        return false;
+    }
+    const CameraPropertyRange &range = m_whiteBalanceRange;
+    const long unit = qMax(1L, range.step);
+    double target = 0;
+    if (range.minimum >= KELVIN_MINIMUM) {
+        const double factor = qBound(1.0 / WHITE_BALANCE_MAX_FACTOR, std::exp(-WHITE_BALANCE_GAIN * cast), WHITE_BALANCE_MAX_FACTOR);
+        target = m_whiteBalanceValue * factor;
+    } else {
+        const double span = range.maximum - range.minimum;
+        const double maxDelta = qMax(double(unit), span * WHITE_BALANCE_MAX_RANGE);
+        target = m_whiteBalanceValue + qBound(-maxDelta, -WHITE_BALANCE_GAIN * cast * span, maxDelta);
+    }
+    long value = snap(qRound64(target), range);
+    if (value == m_whiteBalanceValue) {
+        value = m_whiteBalanceValue + (cast > 0 ? -unit : unit);
+    }
+    value = qBound(range.minimum, value, range.maximum);
+    if (value == m_whiteBalanceValue) {
+        return false;
+    }
+
+    m_nextWhiteBalanceUs = stats.captureUs + m_settings.whiteBalanceIntervalUs;
+    if (!m_control->setValue(CameraProperty::WhiteBalance, value, false)) {
+        return false;
+    }
+    step->property = CameraProperty::WhiteBalance;
+    step->from = m_whiteBalanceValue;
+    step->to = value;
+    step->measured = stats.meanRed / stats.meanBlue;
+    m_whiteBalanceValue = value;
+    return true;
+}
+
+// 按设备步长取整
+long SoftwareAutoAdjust::snap(long value, const CameraPropertyRange &range) const
+{
+    const long unit = qMax(1L, range.step);
+    return range.minimum + qRound64(double(value - range.minimum) / unit) * unit;
+}
+
+QString SoftwareAutoAdjust::statusText() const
+{
+    if (!m_control) {
+        return QString();
+    }
+    QStringList parts;
+    if (m_exposure) {
+        parts << QString("曝光 %1（亮度 %2%3）").arg(m_exposureValue).arg(m_lastLuma, 0, 'f', 0)
+                     .arg(m_exposureState.isEmpty() ? QString() : "，" + m_exposureState);
+    }
+    if (m_whiteBalance) {
+        parts << QString("白平衡 %1（R/B %2）").arg(m_whiteBalanceValue).arg(m_lastRedBlue, 0, 'f', 2);
+    }
+    return "软件自动: " + parts.join("  ");
+}
+
+bool SoftwareAutoAdjust::needsSoftwareAuto(const CameraDeviceControl &control, CameraProperty property)
+{
+    CameraPropertyRange range;
+    return control.isSupported(property) && control.range(property, &range) && !range.canAuto && range.canManual;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <QList>
+#include <QString>
+#include <memory>
+#include "CameraDeviceControl.h"
+#include "ExposureStats.h"
+
+// 一次参数调整，用于日志
+struct AutoAdjustStep {
+    CameraProperty property = CameraProperty::Exposure;
+    long from = 0;
+    long to = 0;
+    double measured = 0;    // 曝光为平均亮度，白平衡为R/B比值
+};
+
+// 软件自动曝光/白平衡（闭环）
+// 给没有硬件自动模式的摄像头用：根据ExposureStats计算修正量，通过CameraDeviceControl写Exposure和WhiteBalance。
+// 每个参数写入后，要等到比触发这次调整的帧晚一个间隔（默认曝光0.3秒、白平衡0.6秒）进入管线的帧才会再次调整，
+// 既限制了写入频率，也避免根据参数生效前的画面重复修正；每次最多调整1档曝光，白平衡每次修正一半的偏色（色温最多变化25%）。
+// 曝光范围不超过20档时按DirectShow的log2秒处理（每档曝光量加倍），否则按线性曝光时间处理；
+// 白平衡最小值不小于1000时按色温（K）处理，否则按范围比例处理。
+// 不依赖线程和事件循环，update()在哪个线程调用就在哪个线程写参数（DirectShow要求在界面线程）。
+class SoftwareAutoAdjust {
+public:
+    struct Settings {
+        double targetLuma = 118;            // 约为18%灰
+        double exposureDeadbandStops = 0.2; // 线性曝光的死区（档）；log2曝光的死区固定为0.75档，避免在相邻两档间来回
+        double maxExposureStops = 1.0;      // 线性曝光每次最多调整的档数
+        double clipHighPercent = 5.0;       // 过曝超过这个比例时优先降低曝光
+        double clipHoldPercent = 2.0;       // 过曝超过这个比例时不再增加曝光
+        double whiteBalanceDeadband = 0.04; // |ln(R/B)|
+        qint64 exposureIntervalUs = 300000;
+        qint64 whiteBalanceIntervalUs = 600000;
+    };
+
+    SoftwareAutoAdjust();
+
+    // 开始接管参数：exposure/whiteBalance为false或设备不支持的参数不接管；被接管的参数切换为手动。
+    // 没有可接管的参数或读取失败时返回false，原因写入error
+    bool start(std::shared_ptr<CameraDeviceControl> control, bool exposure, bool whiteBalance, QString *error = nullptr);
+    // 停止后参数保持最后的值
+    void stop();
+    bool isRunning() const;
+    bool controlsExposure() const;
+    bool controlsWhiteBalance() const;
+
+    void setSettings(const Settings &settings);
+    Settings settings() const;
+
+    // 处理一次统计，返回本次写入的参数（多数时候为空）
+    QList<AutoAdjustStep> update(const ExposureStats &stats);
+
+    // 当前状态，用于界面显示
+    QString statusText() const;
+
+    // 设备支持该参数但没有硬件自动模式，需要软件自动
+    static bool needsSoftwareAuto(const CameraDeviceControl &control, CameraProperty property);
+
+private:
+    bool updateExposure(const ExposureStats &stats, AutoAdjustStep *step);
+    bool updateWhiteBalance(const ExposureStats &stats, AutoAdjustStep *step);
+    long snap(long value, const CameraPropertyRange &range) const;
+
+    std::shared_ptr<CameraDeviceControl> m_control;
+    Settings m_settings;
+    bool m_exposure;
+    bool m_whiteBalance;
+    CameraPropertyRange m_exposureRange;
+    CameraPropertyRange m_whiteBalanceRange;
+    long m_exposureValue;
+    long m_whiteBalanceValue;
+    qint64 m_nextExposureUs;        // 帧的captureUs不小于这个时间才处理
+    qint64 m_nextWhiteBalanceUs;
+    double m_lastLuma;
+    double m_lastRedBlue;
+    QString m_exposureState;
+};
@@ -0,0 +1,153 @@
+#include "StreamWatchdog.h"
+#include "FramePacket.h"
+#include "dbgout.h"
+
+namespace {
+    const qint64 STARTUP_TIMEOUT_US = 5000000;
+    const qint64 MIN_STALL_US = 200000;
+    const qint64 FIRST_BACKOFF_US = 1000000;
+    const qint64 MAX_BACKOFF_US = 30000000;
+}
+
+StreamWatchdog::StreamWatchdog(QObject *parent)
+    : QObject(parent),
+      m_fps(30.0),
+      m_missedIntervals(10),
+      m_running(false),
+      m_gotFirstFrame(false),
+      m_stalled(false),
+      m_startUs(0),
+      m_lastFrameUs(0),
+      m_stallBeginUs(0),
+      m_nextRestartUs(0),
+      m_attempts(0)
+{
+    connect(&m_timer, &QTimer::timeout, this, &StreamWatchdog::check);
+}
+
+void StreamWatchdog::setFrameRate(double fps)
+{
+    m_fps = fps > 0 ? fps : 30.0;
+    if (m_running) {
+        m_timer.start(qMax(20, stallThresholdMs() / 4));
+    }
+}
+
+void StreamWatchdog::setMissedIntervals(int intervals)
+{
+    m_missedIntervals = qMax(1, intervals);
+    if (m_running) {
+        m_timer.start(qMax(20, stallThresholdMs() / 4));
+    }
+}
+
+int StreamWatchdog::missedIntervals() const
+{
+    return m_missedIntervals;
+}
+
+int StreamWatchdog::stallThresholdMs() const
+{
+    const qint64 us = qMax(MIN_STALL_US, qint64(m_missedIntervals * 1000000.0 / m_fps));
+    return int(us / 1000);
+}
+
+void StreamWatchdog::start()
+{
+    m_running = true;
+    m_gotFirstFrame = false;
+    m_stalled = false;
+    m_attempts = 0;
+    m_startUs = monotonicUs();
+    m_lastFrameUs = 0;
+    // 检查周期为判定时长的1/4，卡顿最多晚25%被发现
+    m_timer.start(qMax(20, stallThresholdMs() / 4));
+}
+
+void StreamWatchdog::stop()
+{
+    m_running = false;
+    m_stalled = false;
+    m_timer.stop();
+}
+
+bool StreamWatchdog::isRunning() const
+{
+    return m_running;
+}
+
+void StreamWatchdog::frameArrived()
+{
+    m_lastFrameUs = monotonicUs();
+    m_gotFirstFrame = true;
+    if (!m_stalled) {
+        return;
+    }
+
+    m_stalled = false;
+    const qint64 recoveryMs = (m_lastFrameUs - m_stallBeginUs) / 1000;
+    m_stats.recoveries++;
+    m_stats.lastRecoveryMs = recoveryMs;
+    m_stats.maxRecoveryMs = qMax(m_stats.maxRecoveryMs, recoveryMs);
+    m_stats.totalRecoveryMs += recoveryMs;
+    const int attempts = m_attempts;
+    m_attempts = 0;
+    emit recovered(recoveryMs, attempts);
+}
+
+bool StreamWatchdog::isStalled() const
+{
+    return m_stalled;
+}
+
+qint64 StreamWatchdog::stalledForMs() const
+{
+    return m_stalled ? (monotonicUs() - m_stallBeginUs) / 1000 : 0;
+}
+
+StreamWatchdogStats StreamWatchdog::stats() const
+{
+    return m_stats;
+}
+
+void StreamWatchdog::resetStats()
+{
+    m_stats = StreamWatchdogStats();
+}
+
+void StreamWatchdog::check()
+{
+    if (!m_running) {
+        return;
+    }
+    const qint64 now = monotonicUs();
+
+    if (!m_stalled) {
+        // 收到第一帧前用启动超时，之后用帧间隔判定
+        const bool timedOut = m_gotFirstFrame
+                                  ? now - m_lastFrameUs > qint64(stallThresholdMs()) * 1000
+                                  : now - m_startUs > STARTUP_TIMEOUT_US;
+        if (!timedOut) {
+            return;
+        }
+        m_stalled = true;
+        m_stallBeginUs = m_gotFirstFrame ? m_lastFrameUs : m_startUs;
+        m_attempts = 0;
+        m_nextRestartUs = now;
+        m_stats.stalls++;
+        logToConsole(QString("视频流卡顿: %1 ms 未收到帧").arg((now - m_stallBeginUs) / 1000));
+        emit stalled();
+    }
+
+    if (now < m_nextRestartUs) {
+        return;
+    }
+    m_attempts++;
+    m_stats.restarts++;
+    // 下一次重启前等待的时间按尝试次数加倍
+    const qint64 backoff = qMin(MAX_BACKOFF_US, FIRST_BACKOFF_US << qMin(m_attempts - 1, 16));
+    m_nextRestartUs = now + backoff;
+    logToConsole(QString("视频流卡顿: 第 %1 次重启摄像头，%2 ms 后仍未恢复将再次重启")
+                     .arg(m_attempts).arg(backoff / 1000));
+    emit restartRequested(m_attempts);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+
+// 卡顿统计
+struct StreamWatchdogStats {
+    int stalls = 0;              // 检测到的卡顿次数
+    int recoveries = 0;          // 恢复出帧的次数
+    int restarts = 0;            // 请求重启摄像头的总次数
+    qint64 lastRecoveryMs = 0;   // 最近一次从卡顿到恢复出帧的时间
+    qint64 maxRecoveryMs = 0;
+    qint64 totalRecoveryMs = 0;
+};
+
+// 视频流看门狗
+// 按摄像头格式的帧间隔判断是否卡顿：连续missedIntervals个帧间隔没有收到帧即认为卡顿，
+// 随后请求重启摄像头，仍未恢复时按指数退避（1秒起，最长30秒）再次请求，收到帧后记录恢复耗时。
+class StreamWatchdog : public QObject {
+    Q_OBJECT
+public:
+    explicit StreamWatchdog(QObject *parent = nullptr);
+
+    // fps来自当前的QCameraFormat，不大于0时按30 FPS计算
+    void setFrameRate(double fps);
+    void setMissedIntervals(int intervals);
+    int missedIntervals() const;
+    // 判定卡顿的时长（毫秒），不小于200毫秒，避免低帧率抖动误判
+    int stallThresholdMs() const;
+
+    // 开始监视，收到第一帧前按启动超时（5秒）判断
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // 每收到一帧调用一次，只记录时间
+    void frameArrived();
+
+    bool isStalled() const;
+    // 当前卡顿已持续的时间（毫秒），未卡顿时为0
+    qint64 stalledForMs() const;
+    StreamWatchdogStats stats() const;
+    void resetStats();
+
+signals:
+    void stalled();
+    // attempt从1开始
+    void restartRequested(int attempt);
+    void recovered(qint64 recoveryMs, int attempts);
+
+private slots:
+    void check();
+
+private:
+    QTimer m_timer;
+    double m_fps;
+    int m_missedIntervals;
+    bool m_running;
+    bool m_gotFirstFrame;
+    bool m_stalled;
+    qint64 m_startUs;
+    qint64 m_lastFrameUs;
+    qint64 m_stallBeginUs;
+    qint64 m_nextRestartUs;
+    int m_attempts;
+    StreamWatchdogStats m_stats;
+};
@@ -0,0 +1,326 @@
+#include "TaskPool.h"
+#include "FramePacket.h"
+#include <QMutexLocker>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+    // 当前线程所属的线程池和工作线程序号，非工作线程为nullptr/-1
+    thread_local TaskPool *t_pool = nullptr;
+    thread_local int t_workerIndex = -1;
+}
+
+// ---------------- TaskGroup ----------------
+
+TaskGroup::TaskGroup(TaskPool *pool)
+    : m_pool(pool),
+      m_pending(0)
+{
+}
+
+void TaskGroup::add()
+{
+    m_pending.ref();
+}
+
+void TaskGroup::finishOne()
+{
+    // 计数在锁内减少：wait()返回前要拿到这把锁，最后一个任务唤醒之后才可能销毁TaskGroup
+    QMutexLocker<QMutex> locker(&m_mutex);
+    if (!m_pending.deref()) {
+        m_done.wakeAll();
+    }
+}
+
+void TaskGroup::wait()
+{
+    for (;;) {
+        if (m_pending.loadAcquire() == 0) {
+            break;
+        }
+        // 先帮忙执行排队的任务，队列里没有任务时说明剩余任务都在执行中
+        if (m_pool->runPendingTask()) {
+            continue;
+        }
+        QMutexLocker<QMutex> locker(&m_mutex);
+        if (m_pending.loadAcquire() > 0) {
+            m_done.wait(&m_mutex);
+        }
+    }
+    // 等最后一个任务的finishOne()释放锁，之后调用者才能销毁TaskGroup
+    QMutexLocker<QMutex> locker(&m_mutex);
+}
+
+// ---------------- TaskPool ----------------
+
+TaskPool::TaskPool(int threadCount)
+    : m_queued(0),
+      m_nextQueue(0),
+      m_stopping(false),
+      m_helped(0),
+      m_countersSinceUs(monotonicUs())
+{
+    const int count = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < count; ++i) {
+        m_workers.emplace_back(new Worker);
+    }
+    for (int i = 0; i < count; ++i) {
+        Worker *worker = m_workers[i].get();
+        worker->thread = QThread::create([this, i]() { workerLoop(i); });
+        worker->thread->setObjectName(QString("TaskPool%1").arg(i));
+        worker->thread->start();
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        QMutexLocker<QMutex> locker(&m_sleepMutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    for (auto &worker : m_workers) {
+        worker->thread->wait();
+        delete worker->thread;
+        worker->thread = nullptr;
+    }
+}
+
+TaskPool *TaskPool::shared()
+{
+    static TaskPool pool;
+    return &pool;
+}
+
+int TaskPool::threadCount() const
+{
+    return int(m_workers.size());
+}
+
+void TaskPool::submit(const char *name, std::function<void()> task, TaskGroup *group)
+{
+    if (group) {
+        group->add();
+    }
+
+    // 工作线程内提交的任务放进自己的队列，其他线程提交的轮流分配
+    int index = (t_pool == this) ? t_workerIndex : -1;
+    if (index < 0) {
+        index = int(quint32(m_nextQueue.fetchAndAddRelaxed(1)) % quint32(m_workers.size()));
+    }
+    {
+        Worker *worker = m_workers[index].get();
+        QMutexLocker<QMutex> locker(&worker->mutex);
+        Task entry;
+        entry.name = name;
+        entry.fn = std::move(task);
+        entry.group = group;
+        worker->tasks.push_back(std::move(entry));
+    }
+    m_queued.ref();
+
+    QMutexLocker<QMutex> locker(&m_sleepMutex);
+    m_wake.wakeOne();
+}
+
+void TaskPool::parallelStripes(const char *name, int rows, const std::function<void(int, int)> &fn, int minRows)
+{
+    if (rows <= 0) {
+        return;
+    }
+    const int maxStripes = qMax(1, rows / qMax(1, minRows));
+    const int stripes = qMin(maxStripes, threadCount() * 2);
+    if (stripes <= 1) {
+        const qint64 begin = monotonicUs();
+        fn(0, rows);
+        const qint64 elapsed = monotonicUs() - begin;
+        QMutexLocker<QMutex> locker(&m_counterMutex);
+        TaskCounter &counter = m_counters[QByteArray(name)];
+        counter.name = name;
+        counter.count++;
+        counter.totalUs += elapsed;
+        counter.maxUs = qMax(counter.maxUs, elapsed);
+        return;
+    }
+
+    TaskGroup group(this);
+    for (int i = 0; i < stripes; ++i) {
+        const int first = int(qint64(rows) * i / stripes);
+        const int last = int(qint64(rows) * (i + 1) / stripes);
+        submit(name, [&fn, first, last]() { fn(first, last - first); }, &group);
+    }
+    group.wait();
+}
+
+bool TaskPool::popLocal(int index, Task &task)
+{
+    Worker *worker = m_workers[index].get();
+    QMutexLocker<QMutex> locker(&worker->mutex);
+    if (worker->tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker->tasks.back());
+    worker->tasks.pop_back();
+    m_queued.deref();
+    return true;
+}
+
+bool TaskPool::steal(int thief, Task &task)
+{
+    const int count = int(m_workers.size());
+    for (int offset = 1; offset <= count; ++offset) {
+        const int victim = (qMax(0, thief) + offset) % count;
+        if (victim == thief) {
+            continue;
+        }
+        Worker *worker = m_workers[victim].get();
+        QMutexLocker<QMutex> locker(&worker->mutex);
+        if (worker->tasks.empty()) {
+            continue;
+        }
+        // 从队首窃取，拿到的是最早提交、通常也是最大块的任务
+        task = std::move(worker->tasks.front());
+        worker->tasks.pop_front();
+        m_queued.deref();
+        return true;
+    }
+    return false;
+}
+
+bool TaskPool::runPendingTask()
+{
+    Task task;
+    const bool inPool = t_pool == this && t_workerIndex >= 0;
+    if (inPool) {
+        if (!popLocal(t_workerIndex, task) && !steal(t_workerIndex, task)) {
+            return false;
+        }
+        runTask(task, m_workers[t_workerIndex].get());
+        return true;
+    }
+
+    if (!steal(-1, task)) {
+        return false;
+    }
+    {
+        QMutexLocker<QMutex> locker(&m_counterMutex);
+        m_helped++;
+    }
+    runTask(task, nullptr);
+    return true;
+}
+
+void TaskPool::runTask(Task &task, Worker *worker)
+{
+    const qint64 begin = monotonicUs();
+    task.fn();
+    const qint64 elapsed = monotonicUs() - begin;
+
+    {
+        QMutexLocker<QMutex> locker(&m_counterMutex);
+        if (worker) {
+            worker->busyUs += elapsed;
+            worker->executed++;
+        }
+        if (task.name) {
+            TaskCounter &counter = m_counters[QByteArray(task.name)];
+            counter.name = task.name;
+            counter.count++;
+            counter.totalUs += elapsed;
+            counter.maxUs = qMax(counter.maxUs, elapsed);
+        }
+    }
+
+    if (task.group) {
+        task.group->finishOne();
+    }
+}
+
+void TaskPool::workerLoop(int index)
+{
+    t_pool = this;
+    t_workerIndex = index;
+
+    for (;;) {
+        Task task;
+        if (popLocal(index, task)) {
+            runTask(task, m_workers[index].get());
+            continue;
+        }
+        if (steal(index, task)) {
+            {
+                QMutexLocker<QMutex> locker(&m_counterMutex);
+                m_workers[index]->stolen++;
+            }
+            runTask(task, m_workers[index].get());
+            continue;
+        }
+
+        QMutexLocker<QMutex> locker(&m_sleepMutex);
+        if (m_stopping) {
+            return;
+        }
+        if (m_queued.loadAcquire() == 0) {
+            m_wake.wait(&m_sleepMutex);
+        }
+    }
+}
+
+TaskPoolStats TaskPool::stats() const
+{
+    QMutexLocker<QMutex> locker(&m_counterMutex);
+    TaskPoolStats stats;
+    stats.threads = int(m_workers.size());
+    qint64 busyUs = 0;
+    for (const auto &worker : m_workers) {
+        stats.executed += worker->executed;
+        stats.stolen += worker->stolen;
+        busyUs += worker->busyUs;
+    }
+    stats.helped = m_helped;
+    const qint64 elapsed = monotonicUs() - m_countersSinceUs;
+    if (elapsed > 0) {
+        stats.utilization = double(busyUs) / (double(elapsed) * stats.threads);
+    }
+    return stats;
+}
+
+QList<TaskCounter> TaskPool::counters() const
+{
+    QMutexLocker<QMutex> locker(&m_counterMutex);
+    QList<TaskCounter> list = m_counters.values();
+    std::sort(list.begin(), list.end(), [](const TaskCounter &a, const TaskCounter &b) {
+        return a.totalUs > b.totalUs;
+    });
+    return list;
+}
+
+void TaskPool::resetCounters()
+{
+    QMutexLocker<QMutex> locker(&m_counterMutex);
+    m_counters.clear();
+    for (auto &worker : m_workers) {
+        worker->busyUs = 0;
+        worker->executed = 0;
+        worker->stolen = 0;
+    }
+    m_helped = 0;
+    m_countersSinceUs = monotonicUs();
+}
+
+QString TaskPool::countersSummary() const
+{
+    QStringList lines;
+    for (const TaskCounter &counter : counters()) {
+        lines << QString("%1: %2 次，平均 %3 ms，最大 %4 ms")
+                     .arg(QString::fromLatin1(counter.name))
+                     .arg(counter.count)
+                     .arg(counter.avgUs() / 1000.0, 0, 'f', 3)
+                     .arg(counter.maxUs / 1000.0, 0, 'f', 3);
+    }
+    const TaskPoolStats s = stats();
+    lines << QString("线程池: %1 线程，执行 %2，窃取 %3，等待线程协助 %4，利用率 %5%")
+                 .arg(s.threads).arg(s.executed).arg(s.stolen).arg(s.helped)
+                 .arg(s.utilization * 100.0, 0, 'f', 1);
+    return lines.join('\n');
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QThread>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class TaskPool;
+
+// 一组任务的完成计数，wait()返回时组内任务全部执行完毕
+// 等待的线程会帮忙执行池中排队的任务，在工作线程内等待也不会死锁
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool *pool);
+
+    void wait();
+
+private:
+    friend class TaskPool;
+    void add();
+    void finishOne();
+
+    TaskPool *m_pool;
+    QAtomicInt m_pending;
+    QMutex m_mutex;
+    QWaitCondition m_done;
+};
+
+// 按名称汇总的任务耗时
+struct TaskCounter {
+    QByteArray name;
+    quint64 count = 0;
+    qint64 totalUs = 0;
+    qint64 maxUs = 0;
+
+    double avgUs() const { return count > 0 ? double(totalUs) / double(count) : 0.0; }
+};
+
+struct TaskPoolStats {
+    int threads = 0;
+    quint64 executed = 0;   // 工作线程执行的任务数
+    quint64 stolen = 0;     // 其中从其他线程队列窃取的任务数
+    quint64 helped = 0;     // 等待线程帮忙执行的任务数
+    double utilization = 0; // 工作线程忙碌时间占比（自上次resetCounters起）
+};
+
+// 工作窃取线程池
+// 每个工作线程有自己的双端队列：本线程提交的任务压入队尾并从队尾取（缓存局部性好），
+// 空闲线程从其他队列的队首窃取。预览、录制和分析共用TaskPool::shared()。
+class TaskPool {
+public:
+    // threadCount为0时使用CPU核数
+    explicit TaskPool(int threadCount = 0);
+    ~TaskPool();
+
+    static TaskPool *shared();
+
+    int threadCount() const;
+
+    // name用于按名称统计耗时，须为静态字符串；group不为空时计入该组
+    void submit(const char *name, std::function<void()> task, TaskGroup *group = nullptr);
+
+    // 把[0, rows)分成若干水平条带并行执行fn(firstRow, rowCount)，返回时全部完成
+    // 条带数不超过线程数的2倍，每条至少minRows行；调用线程也参与执行
+    void parallelStripes(const char *name, int rows, const std::function<void(int, int)> &fn, int minRows = 16);
+
+    TaskPoolStats stats() const;
+    QList<TaskCounter> counters() const;
+    void resetCounters();
+
+    // 形如 "名称 次数 平均/最大 ms" 的计数器摘要，每项一行
+    QString countersSummary() const;
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        const char *name = nullptr;
+        std::function<void()> fn;
+        TaskGroup *group = nullptr;
+    };
+
+    struct Worker {
+        QMutex mutex;
+        std::deque<Task> tasks;
+        QThread *thread = nullptr;
+        qint64 busyUs = 0;
+        quint64 executed = 0;
+        quint64 stolen = 0;
+    };
+
+    void workerLoop(int index);
+    bool popLocal(int index, Task &task);
+    bool steal(int thief, Task &task);
+    // 供等待线程调用：取出任意一个排队的任务执行，没有任务时返回false
+    bool runPendingTask();
+    void runTask(Task &task, Worker *worker);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    QAtomicInt m_queued;
+    QAtomicInt m_nextQueue;
+
+    QMutex m_sleepMutex;
+    QWaitCondition m_wake;
+    bool m_stopping;
+
+    mutable QMutex m_counterMutex;
+    QHash<QByteArray, TaskCounter> m_counters;
+    quint64 m_helped;
+    qint64 m_countersSinceUs;
+};
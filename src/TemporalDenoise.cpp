@@ -0,0 +1,349 @@
+#include "TemporalDenoise.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SimdSupport.h"
+
+namespace {
+    // 混合权重以1/64为单位：64为完全取当前值
+    const int DENOISE_WEIGHT_SHIFT = 6;
+    const int DENOISE_WEIGHT_UNITY = 1 << DENOISE_WEIGHT_SHIFT;
+    // 历史值的小数位数
+    const int DENOISE_HISTORY_SHIFT = 6;
+    // 两帧采集时间相差超过这个值时认为画面不连续
+    const qint64 DENOISE_RESET_GAP_US = 500000;
+    const int DENOISE_MIN_STRIPE_ROWS = 16;
+
+    // 噪声估计的采样组数上限（稀疏网格）
+    const int DENOISE_NOISE_SAMPLES = 4096;
+    const int DENOISE_MIN_THRESHOLD = 2;
+    const int DENOISE_MAX_THRESHOLD = 48;
+
+    // 由强度和噪声水平换算的定点参数
+    struct DenoiseParams {
+        int minWeight = DENOISE_WEIGHT_UNITY;   // 静止处当前值的权重
+        int threshold = 0;                      // 移动量（0~255）不超过时按静止处理
+        int slope = 0;                          // 超过阈值后每级增加的权重
+    };
+
+    DenoiseParams denoiseParams(int strength, int noise)
+    {
+        // 强度100时静止处只取1/16的当前值（噪声标准差约降为1/4），强度50时约取30%
+        DenoiseParams params;
+        const int weak = 100 - strength;
+        params.minWeight = 4 + weak * weak * 60 / 10000;
+        // 阈值为噪声移动量中位数的1~3倍，光线越暗噪声越大阈值越高
+        params.threshold = qBound(DENOISE_MIN_THRESHOLD, (noise * (50 + strength) + 25) / 50, DENOISE_MAX_THRESHOLD);
+        // 超过阈值约8级后完全取当前值
+        params.slope = qMax(1, (DENOISE_WEIGHT_UNITY - params.minWeight + 7) / 8);
+        return params;
+    }
+
+    inline int denoiseWeight(const DenoiseParams &params, int motion)
+    {
+        const int excess = motion > params.threshold ? motion - params.threshold : 0;
+        return qMin(DENOISE_WEIGHT_UNITY, params.minWeight + excess * params.slope);
+    }
+
+    // 混合一个字节：history为8.6定点，返回输出字节并更新history
+    inline uchar blendByte(int value, int weight, quint16 *history)
+    {
+        const int mixed = (*history * (DENOISE_WEIGHT_UNITY - weight) + (value << DENOISE_HISTORY_SHIFT) * weight + 32)
+                          >> DENOISE_WEIGHT_SHIFT;
+        *history = quint16(mixed);
+        return uchar((mixed + 32) >> DENOISE_HISTORY_SHIFT);
+    }
+
+    inline int historyByte(quint16 history)
+    {
+        return (history + 32) >> DENOISE_HISTORY_SHIFT;
+    }
+
+    inline int absDiff(int a, int b)
+    {
+        return a > b ? a - b : b - a;
+    }
+
+    // 一组4字节的亮度移动量：YUYV为两个亮度差的平均，RGB32为四个字节差之和的约1/3
+    inline int groupMotion(bool yuyv, const uchar *s, const quint16 *h)
+    {
+        if (yuyv) {
+            return (absDiff(s[0], historyByte(h[0])) + absDiff(s[2], historyByte(h[2]))) >> 1;
+        }
+        int sum = 0;
+        for (int c = 0; c < 4; ++c) {
+            sum += absDiff(s[c], historyByte(h[c]));
+        }
+        return (sum * 21) >> 6;
+    }
+
+    // 按稀疏网格采样移动量，取中位数作为噪声水平（画面中移动的部分不超过一半时不受影响）
+    int estimateNoise(bool yuyv, const uchar *src, const quint16 *history, const QSize &size, int bytesPerLine,
+                      std::vector<int> *samples)
+    {
+        const int groupsPerRow = size.width() * (yuyv ? 2 : 4) / 4;
+        const double groups = double(groupsPerRow) * size.height();
+        const int step = qMax(1, int(std::sqrt(groups / DENOISE_NOISE_SAMPLES)));
+        samples->clear();
+        for (int y = step / 2; y < size.height(); y += step) {
+            const qsizetype row = qsizetype(y) * bytesPerLine;
+            for (int g = step / 2; g < groupsPerRow; g += step) {
+                samples->push_back(groupMotion(yuyv, src + row + g * 4, history + row + g * 4));
+            }
+        }
+        if (samples->empty()) {
+            return 0;
+        }
+        std::nth_element(samples->begin(), samples->begin() + samples->size() / 2, samples->end());
+        return (*samples)[samples->size() / 2];
+    }
+
+    // YUYV每4字节（Y0 U Y1 V）：亮度按两个亮度差的平均，色度取亮度差与色差平均的一半中较大的
+    void denoiseYuyvGroupsScalar(const DenoiseParams &params, const uchar *src, uchar *dst, quint16 *history, int groups)
+    {
+        for (int i = 0; i < groups; ++i) {
+            const uchar *s = src + i * 4;
+            quint16 *h = history + i * 4;
+            const int lumaMotion = groupMotion(true, s, h);
+            const int chromaDiff = absDiff(s[1], historyByte(h[1])) + absDiff(s[3], historyByte(h[3]));
+            const int chromaMotion = qMax(lumaMotion, chromaDiff >> 2);
+            const int lumaWeight = denoiseWeight(params, lumaMotion);
+            const int chromaWeight = denoiseWeight(params, chromaMotion);
+            dst[i * 4 + 0] = blendByte(s[0], lumaWeight, &h[0]);
+            dst[i * 4 + 1] = blendByte(s[1], chromaWeight, &h[1]);
+            dst[i * 4 + 2] = blendByte(s[2], lumaWeight, &h[2]);
+            dst[i * 4 + 3] = blendByte(s[3], chromaWeight, &h[3]);
+        }
+    }
+
+    // RGB32每像素按四个字节差之和的约1/3（alpha不变，差为0）
+    void denoiseRgb32GroupsScalar(const DenoiseParams &params, const uchar *src, uchar *dst, quint16 *history, int groups)
+    {
+        for (int i = 0; i < groups; ++i) {
+            const uchar *s = src + i * 4;
+            quint16 *h = history + i * 4;
+            const int weight = denoiseWeight(params, groupMotion(false, s, h));
+            for (int c = 0; c < 4; ++c) {
+                dst[i * 4 + c] = blendByte(s[c], weight, &h[c]);
+            }
+        }
+    }
+
+#ifdef CAMERA_HAVE_SSE2
+    // 8个16位通道（两组4字节）的差别，按格式换算为每个通道的移动量
+    inline __m128i yuyvMotion(__m128i diff)
+    {
+        // 每组低两个通道变为Y0+Y1、U+V
+        const __m128i sums = _mm_add_epi16(diff, _mm_srli_epi64(diff, 32));
+        const __m128i luma = _mm_srli_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(sums, 0x00), 0x00), 1);
+        const __m128i chroma = _mm_srli_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(sums, 0x55), 0x55), 2);
+        const __m128i chromaLanes = _mm_set_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+        return _mm_max_epi16(luma, _mm_and_si128(chroma, chromaLanes));
+    }
+
+    inline __m128i rgb32Motion(__m128i diff)
+    {
+        __m128i sums = _mm_add_epi16(diff, _mm_srli_epi64(diff, 32));
+        sums = _mm_add_epi16(sums, _mm_srli_epi64(sums, 16));
+        const __m128i total = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sums, 0x00), 0x00);
+        return _mm_srli_epi16(_mm_mullo_epi16(total, _mm_set1_epi16(21)), 6);
+    }
+
+    // 混合8个字节（16位通道），返回新的历史值
+    template<bool Yuyv>
+    inline __m128i blendLanes(__m128i value, __m128i history, __m128i minWeight, __m128i threshold, __m128i slope)
+    {
+        const __m128i unity = _mm_set1_epi16(DENOISE_WEIGHT_UNITY);
+        const __m128i previous = _mm_srli_epi16(_mm_add_epi16(history, _mm_set1_epi16(32)), DENOISE_HISTORY_SHIFT);
+        const __m128i diff = _mm_or_si128(_mm_subs_epu16(value, previous), _mm_subs_epu16(previous, value));
+        const __m128i motion = Yuyv ? yuyvMotion(diff) : rgb32Motion(diff);
+        const __m128i excess = _mm_subs_epu16(motion, threshold);
+        const __m128i weight = _mm_min_epi16(unity, _mm_add_epi16(minWeight, _mm_mullo_epi16(excess, slope)));
+        const __m128i keep = _mm_sub_epi16(unity, weight);
+        const __m128i scaled = _mm_slli_epi16(value, DENOISE_HISTORY_SHIFT);
+        // history * (64 - w) + value * 64 * w，两两相乘相加到32位
+        const __m128i rounding = _mm_set1_epi32(32);
+        const __m128i lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(history, scaled),
+                                                                       _mm_unpacklo_epi16(keep, weight)), rounding),
+                                         DENOISE_WEIGHT_SHIFT);
+        const __m128i hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(history, scaled),
+                                                                       _mm_unpackhi_epi16(keep, weight)), rounding),
+                                         DENOISE_WEIGHT_SHIFT);
+        return _mm_packs_epi32(lo, hi);
+    }
+
+    // 每次处理16字节，返回处理的4字节组数
+    template<bool Yuyv>
+    int denoiseGroupsSse2(const DenoiseParams &params, const uchar *src, uchar *dst, quint16 *history, int groups)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i minWeight = _mm_set1_epi16(short(params.minWeight));
+        const __m128i threshold = _mm_set1_epi16(short(params.threshold));
+        const __m128i slope = _mm_set1_epi16(short(params.slope));
+        const __m128i half = _mm_set1_epi16(32);
+        int i = 0;
+        for (; i + 4 <= groups; i += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            __m128i *h = reinterpret_cast<__m128i*>(history + i * 4);
+            const __m128i lo = blendLanes<Yuyv>(_mm_unpacklo_epi8(pixels, zero), _mm_loadu_si128(h),
+                                                minWeight, threshold, slope);
+            const __m128i hi = blendLanes<Yuyv>(_mm_unpackhi_epi8(pixels, zero), _mm_loadu_si128(h + 1),
+                                                minWeight, threshold, slope);
+            _mm_storeu_si128(h, lo);
+            _mm_storeu_si128(h + 1, hi);
+            const __m128i out = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, half), DENOISE_HISTORY_SHIFT),
+                                                 _mm_srli_epi16(_mm_add_epi16(hi, half), DENOISE_HISTORY_SHIFT));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), out);
+        }
+        return i;
+    }
+#endif
+
+    // 一行的前groups组（每组4字节）
+    void denoiseRow(const DenoiseParams &params, bool yuyv, SimdLevel level, const uchar *src, uchar *dst,
+                    quint16 *history, int groups)
+    {
+        int done = 0;
+#ifdef CAMERA_HAVE_SSE2
+        if (level >= SimdLevel::Sse2) {
+            done = yuyv ? denoiseGroupsSse2<true>(params, src, dst, history, groups)
+                        : denoiseGroupsSse2<false>(params, src, dst, history, groups);
+        }
+#endif
+        const int offset = done * 4;
+        if (yuyv) {
+            denoiseYuyvGroupsScalar(params, src + offset, dst + offset, history + offset, groups - done);
+        } else {
+            denoiseRgb32GroupsScalar(params, src + offset, dst + offset, history + offset, groups - done);
+        }
+    }
+}
+
+TemporalDenoise::TemporalDenoise()
+    : m_strength(0),
+      m_resetPending(0),
+      m_parallel(true),
+      m_bytesPerLine(0),
+      m_format(FramePixelFormat::Unknown),
+      m_lastCaptureUs(0),
+      m_noiseLevel(0)
+{
+}
+
+void TemporalDenoise::setStrength(int strength)
+{
+    m_strength.storeRelaxed(qBound(0, strength, 100));
+    if (strength <= 0) {
+        m_resetPending.storeRelaxed(1);
+    }
+}
+
+int TemporalDenoise::strength() const
+{
+    return m_strength.loadRelaxed();
+}
+
+bool TemporalDenoise::isActive() const
+{
+    return m_strength.loadRelaxed() > 0;
+}
+
+void TemporalDenoise::reset()
+{
+    m_resetPending.storeRelaxed(1);
+}
+
+int TemporalDenoise::noiseLevel() const
+{
+    return m_noiseLevel;
+}
+
+void TemporalDenoise::setParallel(bool parallel)
+{
+    m_parallel = parallel;
+}
+
+bool TemporalDenoise::apply(FramePacket *packet, QByteArray *buffer)
+{
+    if (!packet || !buffer || !isActive()) {
+        return false;
+    }
+    const bool yuyv = packet->format == FramePixelFormat::YUYV;
+    if ((!yuyv && packet->format != FramePixelFormat::RGB32) || packet->size.isEmpty()) {
+        return false;
+    }
+    const qsizetype stride = packet->bytesPerLine;
+    const qsizetype frameBytes = stride * packet->size.height();
+    if (packet->data.size() < frameBytes || stride < packet->size.width() * (yuyv ? 2 : 4)) {
+        return false;
+    }
+
+    buffer->resize(frameBytes);
+    if (!process(reinterpret_cast<const uchar*>(packet->data.constData()), reinterpret_cast<uchar*>(buffer->data()),
+                 packet->size, packet->bytesPerLine, packet->format, packet->captureUs)) {
+        return false;
+    }
+    packet->data = *buffer;
+    packet->owner.reset();
+    return true;
+}
+
+bool TemporalDenoise::apply(QImage *image)
+{
+    if (!image || image->isNull() || !isActive()) {
+        return false;
+    }
+    if (image->format() != QImage::Format_RGB32 && image->format() != QImage::Format_ARGB32) {
+        *image = image->convertToFormat(QImage::Format_RGB32);
+    }
+    // 每个字节先读后写，可以原地处理；图像没有时间戳，只按尺寸判断是否连续
+    uchar *data = image->bits();
+    return process(data, data, image->size(), int(image->bytesPerLine()), FramePixelFormat::RGB32, 0);
+}
+
+bool TemporalDenoise::process(const uchar *src, uchar *dst, const QSize &size, int bytesPerLine,
+                              FramePixelFormat format, qint64 captureUs)
+{
+    const bool gap = captureUs > 0 && m_lastCaptureUs > 0 &&
+                     (captureUs < m_lastCaptureUs || captureUs - m_lastCaptureUs > DENOISE_RESET_GAP_US);
+    m_lastCaptureUs = captureUs;
+    const qsizetype frameBytes = qsizetype(bytesPerLine) * size.height();
+    if (m_resetPending.fetchAndStoreRelaxed(0) || gap || size != m_size || bytesPerLine != m_bytesPerLine ||
+        format != m_format || m_history.size() != size_t(frameBytes)) {
+        // 第一帧只建立历史，原样输出
+        m_size = size;
+        m_bytesPerLine = bytesPerLine;
+        m_format = format;
+        m_history.resize(size_t(frameBytes));
+        for (qsizetype i = 0; i < frameBytes; ++i) {
+            m_history[size_t(i)] = quint16(src[i] << DENOISE_HISTORY_SHIFT);
+        }
+        return false;
+    }
+
+    // 行尾填充不足一组的字节原样复制
+    const bool yuyv = format == FramePixelFormat::YUYV;
+    m_noiseLevel = estimateNoise(yuyv, src, m_history.data(), size, bytesPerLine, &m_noiseSamples);
+    const DenoiseParams params = denoiseParams(strength(), m_noiseLevel);
+    const int groups = bytesPerLine / 4;
+    const int tail = bytesPerLine - groups * 4;
+    quint16 *history = m_history.data();
+    const SimdLevel level = simdLevel();
+    auto rows = [=](int firstRow, int rowCount) {
+        for (int y = firstRow; y < firstRow + rowCount; ++y) {
+            const qsizetype offset = qsizetype(y) * bytesPerLine;
+            denoiseRow(params, yuyv, level, src + offset, dst + offset, history + offset, groups);
+            if (tail > 0 && src != dst) {
+                std::memcpy(dst + offset + groups * 4, src + offset + groups * 4, size_t(tail));
+            }
+        }
+    };
+    if (m_parallel) {
+        TaskPool::shared()->parallelStripes("temporal_denoise", size.height(), rows, DENOISE_MIN_STRIPE_ROWS);
+    } else {
+        rows(0, size.height());
+    }
+    return true;
+}
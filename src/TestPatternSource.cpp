@@ -0,0 +1,179 @@
+#include "TestPatternSource.h"
+#include <QImage>
+#include <QBuffer>
+#include <cmath>
+
+namespace {
+    // 75%彩条（白、黄、青、绿、品红、红、蓝、黑），BT.601有限范围YUV
+    struct YuvColor {
+        quint8 y, u, v;
+    };
+    const YuvColor BAR_COLORS[8] = {
+        {180, 128, 128}, {162, 44, 142}, {131, 156, 44}, {112, 72, 58},
+        {84, 184, 198}, {65, 100, 212}, {35, 212, 114}, {16, 128, 128}
+    };
+    const QRgb BAR_RGB[8] = {
+        qRgb(191, 191, 191), qRgb(191, 191, 0), qRgb(0, 191, 191), qRgb(0, 191, 0),
+        qRgb(191, 0, 191), qRgb(191, 0, 0), qRgb(0, 0, 191), qRgb(0, 0, 0)
+    };
+
+    // 线性同余随机数，结果可复现
+    inline int nextNoise(quint32 &state, int amplitude)
+    {
+        state = state * 1664525u + 1013904223u;
+        return int((state >> 16) % quint32(2 * amplitude + 1)) - amplitude;
+    }
+
+    inline quint8 clampByte(int v)
+    {
+        return quint8(qBound(0, v, 255));
+    }
+}
+
+TestPatternSource::TestPatternSource(QObject *parent)
+    : QObject(parent),
+      m_format(FramePixelFormat::YUYV),
+      m_size(1280, 720),
+      m_fps(30.0),
+      m_jpegQuality(85),
+      m_noise(0),
+      m_frameIndex(0),
+      m_startUs(0)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &TestPatternSource::onTimeout);
+}
+
+void TestPatternSource::setFormat(FramePixelFormat format, const QSize &size, double fps)
+{
+    // YUYV要求宽度为偶数
+    m_format = format;
+    m_size = QSize(size.width() & ~1, size.height());
+    m_fps = fps > 0 ? fps : 30.0;
+    m_patternCache.clear();
+}
+
+FramePixelFormat TestPatternSource::format() const
+{
+    return m_format;
+}
+
+QSize TestPatternSource::size() const
+{
+    return m_size;
+}
+
+double TestPatternSource::fps() const
+{
+    return m_fps;
+}
+
+void TestPatternSource::setJpegQuality(int quality)
+{
+    m_jpegQuality = qBound(1, quality, 100);
+    m_patternCache.clear();
+}
+
+void TestPatternSource::setNoiseAmplitude(int amplitude)
+{
+    m_noise = qBound(0, amplitude, 64);
+    m_patternCache.clear();
+}
+
+void TestPatternSource::start()
+{
+    m_frameIndex = 0;
+    m_startUs = monotonicUs();
+    m_timer.start(qMax(1, qRound(1000.0 / m_fps)));
+}
+
+void TestPatternSource::stop()
+{
+    m_timer.stop();
+}
+
+bool TestPatternSource::isActive() const
+{
+    return m_timer.isActive();
+}
+
+void TestPatternSource::onTimeout()
+{
+    emit frameReady(generateFrame(m_frameIndex++));
+}
+
+FramePacket TestPatternSource::generateFrame(quint64 index)
+{
+    if (m_patternCache.isEmpty()) {
+        for (int i = 0; i < PATTERN_PERIOD; ++i) {
+            const int barX = (m_size.width() * i / PATTERN_PERIOD) & ~1;
+            const quint32 seed = quint32(i + 1) * 2654435761u;
+            m_patternCache.append(m_format == FramePixelFormat::MJPEG ? renderJpeg(barX, seed) : renderYuyv(barX, seed));
+        }
+    }
+
+    FramePacket packet;
+    packet.format = m_format == FramePixelFormat::MJPEG ? FramePixelFormat::MJPEG : FramePixelFormat::YUYV;
+    packet.size = m_size;
+    packet.bytesPerLine = packet.format == FramePixelFormat::YUYV ? m_size.width() * 2 : 0;
+    packet.data = m_patternCache.at(int(index % PATTERN_PERIOD));
+    packet.sequence = index;
+    packet.ptsUs = qint64(std::llround(double(index) * 1000000.0 / m_fps));
+    packet.captureUs = monotonicUs();
+    return packet;
+}
+
+QByteArray TestPatternSource::renderYuyv(int barX, quint32 seed) const
+{
+    const int width = m_size.width();
+    const int height = m_size.height();
+    const int barWidth = qMax(2, width / 40) & ~1;
+    QByteArray data(qsizetype(width) * height * 2, Qt::Uninitialized);
+
+    for (int y = 0; y < height; ++y) {
+        quint8 *line = reinterpret_cast<quint8*>(data.data()) + qsizetype(y) * width * 2;
+        for (int x = 0; x < width; x += 2) {
+            YuvColor c = BAR_COLORS[qMin(7, x * 8 / width)];
+            if (x >= barX && x < barX + barWidth) {
+                c = {235, 128, 128};
+            }
+            if (m_noise > 0) {
+                line[x * 2 + 0] = clampByte(c.y + nextNoise(seed, m_noise));
+                line[x * 2 + 1] = c.u;
+                line[x * 2 + 2] = clampByte(c.y + nextNoise(seed, m_noise));
+                line[x * 2 + 3] = c.v;
+                continue;
+            }
+            line[x * 2 + 0] = c.y;
+            line[x * 2 + 1] = c.u;
+            line[x * 2 + 2] = c.y;
+            line[x * 2 + 3] = c.v;
+        }
+    }
+    return data;
+}
+
+QByteArray TestPatternSource::renderJpeg(int barX, quint32 seed) const
+{
+    const int width = m_size.width();
+    const int height = m_size.height();
+    const int barWidth = qMax(2, width / 40);
+    QImage image(m_size, QImage::Format_RGB32);
+
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            line[x] = (x >= barX && x < barX + barWidth) ? qRgb(255, 255, 255) : BAR_RGB[qMin(7, x * 8 / width)];
+            if (m_noise > 0) {
+                const int n = nextNoise(seed, m_noise);
+                line[x] = qRgb(clampByte(qRed(line[x]) + n), clampByte(qGreen(line[x]) + n), clampByte(qBlue(line[x]) + n));
+            }
+        }
+    }
+
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG", m_jpegQuality);
+    return jpeg;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QSize>
+#include <QList>
+#include "FramePacket.h"
+
+// 测试图案帧源
+// 生成带移动竖条的彩条图案（YUYV或MJPEG），用于在没有摄像头的环境下驱动录制管线
+class TestPatternSource : public QObject {
+    Q_OBJECT
+public:
+    explicit TestPatternSource(QObject *parent = nullptr);
+
+    void setFormat(FramePixelFormat format, const QSize &size, double fps);
+    FramePixelFormat format() const;
+    QSize size() const;
+    double fps() const;
+
+    // MJPEG压缩质量（1~100）
+    void setJpegQuality(int quality);
+    // 叠加的随机噪声幅度（0~64），纯色彩条压缩率过高，加噪声后MJPEG码率接近真实摄像头
+    void setNoiseAmplitude(int amplitude);
+
+    // 按固定帧率定时发出frameReady
+    void start();
+    void stop();
+    bool isActive() const;
+
+    // 生成第index帧，PTS按名义帧率递增；可在循环中直接调用（不经过定时器）
+    FramePacket generateFrame(quint64 index);
+
+signals:
+    void frameReady(const FramePacket &packet);
+
+private slots:
+    void onTimeout();
+
+private:
+    QByteArray renderYuyv(int barX, quint32 seed) const;
+    QByteArray renderJpeg(int barX, quint32 seed) const;
+
+    FramePixelFormat m_format;
+    QSize m_size;
+    double m_fps;
+    int m_jpegQuality;
+    int m_noise;
+    QTimer m_timer;
+    quint64 m_frameIndex;
+    qint64 m_startUs;
+
+    // 图案按周期循环，预先生成的帧共享同一块内存，避免测试源本身成为瓶颈
+    static const int PATTERN_PERIOD = 30;
+    QList<QByteArray> m_patternCache;
+};
@@ -0,0 +1,120 @@
+#include "TiledPreviewWidget.h"
+#include "MultiCameraManager.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <cmath>
+
+TiledPreviewWidget::TiledPreviewWidget(QWidget *parent)
+    : QWidget(parent),
+      m_manager(nullptr),
+      m_dirty(false),
+      m_idleTicks(0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(320, 180);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &TiledPreviewWidget::refresh);
+    m_refreshTimer.start(33);
+}
+
+void TiledPreviewWidget::setManager(MultiCameraManager *manager)
+{
+    if (m_manager) {
+        disconnect(m_manager, nullptr, this, nullptr);
+    }
+    m_manager = manager;
+    if (m_manager) {
+        connect(m_manager, &MultiCameraManager::previewUpdated, this, &TiledPreviewWidget::markDirty);
+        updatePreviewSize();
+    }
+    update();
+}
+
+void TiledPreviewWidget::setRefreshRate(int fps)
+{
+    m_refreshTimer.start(qMax(1, 1000 / qMax(1, fps)));
+}
+
+QRect TiledPreviewWidget::tileRect(const QRect &area, int count, int index)
+{
+    if (count <= 0) {
+        return area;
+    }
+    const int columns = int(std::ceil(std::sqrt(double(count))));
+    const int rows = (count + columns - 1) / columns;
+    const int width = area.width() / columns;
+    const int height = area.height() / rows;
+    return QRect(area.x() + (index % columns) * width, area.y() + (index / columns) * height, width, height);
+}
+
+void TiledPreviewWidget::markDirty()
+{
+    m_dirty = true;
+}
+
+void TiledPreviewWidget::refresh()
+{
+    // 统计文字每秒也要刷新，没有新帧时降低到约每秒一次
+    if (m_dirty || ++m_idleTicks >= 30) {
+        m_dirty = false;
+        m_idleTicks = 0;
+        update();
+    }
+}
+
+void TiledPreviewWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updatePreviewSize();
+}
+
+void TiledPreviewWidget::updatePreviewSize()
+{
+    // 预览图按分格大小转换，避免绘制时再缩放
+    if (m_manager && m_manager->streamCount() > 0) {
+        m_manager->setPreviewSize(tileRect(rect(), m_manager->streamCount(), 0).size() - QSize(2, 2));
+    }
+}
+
+void TiledPreviewWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(240, 240, 240));
+
+    const int count = m_manager ? m_manager->streamCount() : 0;
+    if (count == 0) {
+        painter.setPen(Qt::black);
+        painter.setFont(QFont("Arial", 12));
+        painter.drawText(rect(), Qt::AlignCenter, "No Camera");
+        return;
+    }
+
+    painter.setFont(QFont("Arial", 8));
+    for (int i = 0; i < count; ++i) {
+        const CameraStream *stream = m_manager->stream(i);
+        const QRect tile = tileRect(rect(), count, i).adjusted(1, 1, -1, -1);
+        painter.fillRect(tile, Qt::white);
+
+        const QImage image = stream->latestPreview();
+        if (!image.isNull()) {
+            const QSize size = image.size().scaled(tile.size(), Qt::KeepAspectRatio);
+            const QRect target(tile.x() + (tile.width() - size.width()) / 2,
+                               tile.y() + (tile.height() - size.height()) / 2,
+                               size.width(), size.height());
+            painter.drawImage(target, image);
+        }
+
+        const CameraStreamStats stats = stream->stats();
+        QString text = QString("%1  %2 FPS  预览丢帧: %3  转换: %4 ms")
+                           .arg(stream->name())
+                           .arg(stats.fps, 0, 'f', 1)
+                           .arg(stats.previewDropped)
+                           .arg(stats.avgConvertUs / 1000.0, 0, 'f', 2);
+        if (stats.recording) {
+            text += QString("  录制: %1 帧 丢弃 %2").arg(stats.recorder.encoded).arg(stats.recorder.dropped);
+        }
+        painter.setPen(Qt::gray);
+        painter.drawText(tile.adjusted(6, 0, -6, -6), Qt::AlignLeft | Qt::AlignBottom, text);
+        painter.setPen(QColor(192, 192, 192));
+        painter.drawRect(tile);
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <QWidget>
+#include <QTimer>
+#include <QRect>
+
+class MultiCameraManager;
+
+// 多路拼接预览
+// 各路只提交转换好的预览图，本控件按固定节拍在一次paintEvent中绘制所有分格，
+// 多路同时出帧时不会引起多次重绘
+class TiledPreviewWidget : public QWidget {
+    Q_OBJECT
+public:
+    explicit TiledPreviewWidget(QWidget *parent = nullptr);
+
+    void setManager(MultiCameraManager *manager);
+    // 重绘节拍（帧/秒）
+    void setRefreshRate(int fps);
+
+    // count路时第index路的分格位置
+    static QRect tileRect(const QRect &area, int count, int index);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void markDirty();
+    void refresh();
+
+private:
+    void updatePreviewSize();
+
+    MultiCameraManager *m_manager;
+    QTimer m_refreshTimer;
+    bool m_dirty;
+    int m_idleTicks;
+};
@@ -2,6 +2,14 @@
 #include "dbgout.h"
 #include "AudioPanel.h"
 #include "CameraControlDialog.h"
+#include "HistogramWidget.h"
+#include "SegmentedSink.h"
+#include "MultiCameraWindow.h"
+#include "FocusMetric.h"
+#include "TaskPool.h"
+#ifdef Q_OS_WIN
+#include "CameraUtils.h"
+#endif
 #include <QMessageBox>
 #include <QDebug>
 #include <QDateTime>
@@ -39,21 +47,25 @@
 #include <QTime>
 #include <QCoreApplication>
 #include <QFileDialog>
-
-// Windows特定头文件，用于获取USB设备信息
-#include <Windows.h>
-#include <SetupAPI.h>
-#include <devguid.h>
-#include <initguid.h>
-#include <dbt.h>
-
-#pragma comment(lib, "setupapi.lib")
+#include <QFileInfo>
+#include <QSignalBlocker>
+#include <QWindow>
+#include <QEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
 
 // 主窗口构造函数
 cam_qt::cam_qt(QWidget* parent)
-    : QMainWindow(parent), ui(new Ui_cam_qt), camera(nullptr), 
-      frameCount(0), currentFPS(0), lastFrameTime(0), cameraControlDialog(nullptr),
-      audioPanel(nullptr), mediaRecorder(nullptr), isRecording(false), recordingDuration(0)
+    : QMainWindow(parent), ui(new Ui_cam_qt), capture(nullptr), cameraControlDialog(nullptr),
+      audioPanel(nullptr), mediaRecorder(nullptr), isRecording(false), recordingDuration(0),
+      spinPreRoll(nullptr), labelPreRoll(nullptr),
+      spinSegmentMinutes(nullptr), spinSegmentSizeMB(nullptr),
+      burstCapture(nullptr), spinBurstFrames(nullptr), comboBurstEncoding(nullptr), btnBurst(nullptr),
+      deviceMonitor(nullptr), reconnectTimer(nullptr),
+      spinStallIntervals(nullptr), checkHistogram(nullptr),
+      checkFocusAssist(nullptr), checkSoftwareAuto(nullptr),
+      spinDigitalZoom(nullptr), checkRecordCrop(nullptr), checkLensCorrection(nullptr),
+      spinDenoise(nullptr), checkMotionRecord(nullptr), spinMotionSensitivity(nullptr), spinMotionPostRoll(nullptr)
 {
     ui->setupUi(this);
     
@@ -75,22 +87,17 @@ cam_qt::cam_qt(QWidget* parent)
     // 设置窗口标题
     setWindowTitle("摄像头及音频测试工具");
     
-    // 初始化视频显示
-    videoSink = new QVideoSink(this);
-    if (!videoSink) {
-        logToConsole("错误：创建VideoSink失败");
-    } else {
-        // 连接视频帧信号
-        connect(videoSink, &QVideoSink::videoFrameChanged, this, &cam_qt::handleVideoFrame);
-        logToConsole("VideoSink创建成功并连接信号");
-    }
+    // 初始化采集控制器，帧的接收、分发和录制都在其中完成
+    capture = new CaptureController(this);
+    connect(capture, &CaptureController::formatChanged, this, &cam_qt::handleFormatChanged);
+    connect(capture, &CaptureController::recordingError, this, &cam_qt::handlePipelineError);
+    connect(capture, &CaptureController::errorOccurred, this, [](const QString &message) {
+        logToConsole(message);
+    });
     
-    // 初始化媒体捕获会话
-    captureSession.setVideoSink(videoSink);
-    
-    // 初始化录制相关对象
+    // 初始化录制相关对象，MP4录制挂在采集控制器的捕获会话上
     mediaRecorder = new QMediaRecorder(this);
-    captureSession.setRecorder(mediaRecorder);
+    capture->captureSession()->setRecorder(mediaRecorder);
     
     // 连接录制相关信号
     connect(mediaRecorder, &QMediaRecorder::recorderStateChanged, 
@@ -103,17 +110,47 @@ cam_qt::cam_qt(QWidget* parent)
     // 初始化录制计时器
     recordingTimer = new QTimer(this);
     
-    // 初始化FPS计时器
-    fpsTimer.start();
-    frameCount = 0;
-    currentFPS = 0;
+    // 每秒更新一次FPS显示
     fpsUpdateTimer = new QTimer(this);
     connect(fpsUpdateTimer, &QTimer::timeout, this, &cam_qt::updateFPSDisplay);
-    fpsUpdateTimer->start(1000); // 每秒更新一次FPS显示
+    fpsUpdateTimer->start(1000);
     
     // 设置音频面板
     setupAudioPanel();
     
+    // 设置预录控件
+    setupPreRollControls();
+    
+    // 设置连拍控件
+    setupBurstControls();
+    
+    // 设置视频流看门狗
+    setupWatchdog();
+    
+    // 设置直方图叠加
+    setupHistogramControls();
+    
+    // 设置对焦辅助
+    setupFocusAssistControls();
+    
+    // 设置软件自动曝光/白平衡
+    setupSoftwareAutoControls();
+    
+    // 设置数字变焦
+    setupDigitalZoomControls();
+    
+    // 设置镜头畸变校正
+    setupLensCorrectionControls();
+    
+    // 设置时域降噪
+    setupDenoiseControls();
+    
+    // 设置移动触发录制
+    setupMotionRecordingControls();
+    
+    // 设置帧分发总线
+    setupFrameBus();
+    
     // 初始化预览图像
     QSize labelSize = ui->labelPreview->size();
     QImage background(labelSize, QImage::Format_RGB32);
@@ -126,6 +163,16 @@ cam_qt::cam_qt(QWidget* parent)
     
     ui->labelPreview->setPixmap(QPixmap::fromImage(background));
     
+    // 设备热插拔监视：只处理新增和移除的设备，不重新枚举
+    deviceMonitor = new DeviceMonitor(this);
+    connect(deviceMonitor, &DeviceMonitor::camerasAdded, this, &cam_qt::handleCamerasAdded);
+    connect(deviceMonitor, &DeviceMonitor::camerasRemoved, this, &cam_qt::handleCamerasRemoved);
+    connect(deviceMonitor, &DeviceMonitor::audioInputsAdded, this, &cam_qt::handleAudioInputsChanged);
+    connect(deviceMonitor, &DeviceMonitor::audioInputsRemoved, this, &cam_qt::handleAudioInputsChanged);
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, &cam_qt::handleReconnectTimeout);
+    
     // 更新摄像头列表
     updateCameraList();
     
@@ -141,6 +188,14 @@ cam_qt::~cam_qt()
     stopCamera();
     stopRecording();
     
+    // 控制对话框引用采集控制器的画面分析器，先于采集控制器删除
+    delete cameraControlDialog;
+    cameraControlDialog = nullptr;
+    
+    // 先删除采集控制器（同时停止帧总线的分发线程），订阅者回调会访问本对象的成员
+    delete capture;
+    capture = nullptr;
+    
     if (recordingTimer) {
         recordingTimer->stop();
         delete recordingTimer;
@@ -164,15 +219,341 @@ void cam_qt::setupAudioPanel()
     // 添加到主窗口布局
     ui->verticalLayout->addWidget(audioPanel);
     
+    // 采集到的音频送入录制管线或预录缓存
+    connect(audioPanel, &AudioPanel::audioCaptured, this, &cam_qt::handleAudioCaptured);
+    
     // 音频面板初始化完成，但显示状态将在updateCameraList中设置
     logToConsole("音频面板初始化完成");
 }
 
+// 预录控件设置
+void cam_qt::setupPreRollControls()
+{
+    QLabel* label = new QLabel("预录时长:", ui->groupBox);
+    spinPreRoll = new QSpinBox(ui->groupBox);
+    spinPreRoll->setRange(0, 30);
+    spinPreRoll->setValue(0);
+    spinPreRoll->setSuffix(" 秒");
+    spinPreRoll->setToolTip("开始录制时先写入录制前N秒的画面和声音（仅原始帧和MJPEG直通录制），0表示关闭");
+    labelPreRoll = new QLabel("预录缓存: 关闭", ui->groupBox);
+    labelPreRoll->setStyleSheet("font-weight: normal;");
+    
+    // 放在"设置格式"按钮之前
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, label);
+    ui->verticalLayout_4->insertWidget(index + 1, spinPreRoll);
+    ui->verticalLayout_4->insertWidget(index + 2, labelPreRoll);
+    
+    connect(spinPreRoll, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &cam_qt::configurePreRoll);
+    
+    // 分段录制设置，两项都为0时不分段
+    QLabel* labelSegment = new QLabel("分段录制:", ui->groupBox);
+    spinSegmentMinutes = new QSpinBox(ui->groupBox);
+    spinSegmentMinutes->setRange(0, 240);
+    spinSegmentMinutes->setValue(0);
+    spinSegmentMinutes->setSuffix(" 分钟");
+    spinSegmentMinutes->setSpecialValueText("不按时长分段");
+    spinSegmentMinutes->setToolTip("原始帧和MJPEG直通录制每段的最长时长，0表示不按时长分段");
+    spinSegmentSizeMB = new QSpinBox(ui->groupBox);
+    spinSegmentSizeMB->setRange(0, 1900);
+    spinSegmentSizeMB->setValue(0);
+    spinSegmentSizeMB->setSuffix(" MB");
+    spinSegmentSizeMB->setSpecialValueText("不按大小分段");
+    spinSegmentSizeMB->setToolTip("每段文件的最大大小，0表示不按大小分段；AVI单文件不能超过2GB，总是在约1.75GB时切换到新文件");
+    
+    index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, labelSegment);
+    ui->verticalLayout_4->insertWidget(index + 1, spinSegmentMinutes);
+    ui->verticalLayout_4->insertWidget(index + 2, spinSegmentSizeMB);
+}
+
+// 根据预录时长和当前格式分配预录缓存
+void cam_qt::configurePreRoll()
+{
+    capture->configurePreRoll(spinPreRoll->value());
+    updatePreRollStatus();
+}
+
+// 视频流看门狗设置
+void cam_qt::setupWatchdog()
+{
+    // 卡顿和每次重启时刷新预览上的提示条
+    StreamWatchdog* streamWatchdog = capture->watchdog();
+    connect(streamWatchdog, &StreamWatchdog::stalled, this, &cam_qt::presentPreview);
+    connect(streamWatchdog, &StreamWatchdog::restartRequested, this, &cam_qt::presentPreview);
+    
+    QLabel* label = new QLabel("卡顿判定:", ui->groupBox);
+    spinStallIntervals = new QSpinBox(ui->groupBox);
+    spinStallIntervals->setRange(3, 300);
+    spinStallIntervals->setValue(streamWatchdog->missedIntervals());
+    spinStallIntervals->setSuffix(" 个帧间隔");
+    spinStallIntervals->setToolTip("连续这么多个帧间隔（按当前格式的帧率计算）没有收到画面时判定为卡顿并自动重启摄像头");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, label);
+    ui->verticalLayout_4->insertWidget(index + 1, spinStallIntervals);
+    
+    connect(spinStallIntervals, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            streamWatchdog, &StreamWatchdog::setMissedIntervals);
+}
+
+// 直方图叠加设置
+void cam_qt::setupHistogramControls()
+{
+    checkHistogram = new QCheckBox("直方图叠加", ui->groupBox);
+    checkHistogram->setToolTip("在预览右上角显示亮度和RGB直方图以及过曝/欠曝比例");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, checkHistogram);
+    
+    // 只在勾选期间计算直方图
+    connect(checkHistogram, &QCheckBox::toggled, this, [this](bool checked) {
+        if (checked) {
+            capture->analyzer()->addHistogramUser();
+        } else {
+            capture->analyzer()->removeHistogramUser();
+        }
+        presentPreview();
+    });
+}
+
+// 对焦辅助设置
+void cam_qt::setupFocusAssistControls()
+{
+    checkFocusAssist = new QCheckBox("对焦辅助", ui->groupBox);
+    checkFocusAssist->setToolTip("预览中清晰的边缘着红色（峰值对焦），并显示画面中央区域的清晰度；"
+                                 "自动对焦扫描在\"图像控制\"对话框的对焦滑块下方");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, checkFocusAssist);
+    
+    connect(checkFocusAssist, &QCheckBox::toggled, this, [this](bool checked) {
+        if (checked) {
+            capture->analyzer()->addFocusUser();
+        } else {
+            capture->analyzer()->removeFocusUser();
+        }
+        capture->previewPipeline()->setPeaking(checked);
+        presentPreview();
+    });
+}
+
+// 软件自动曝光/白平衡设置
+void cam_qt::setupSoftwareAutoControls()
+{
+    checkSoftwareAuto = new QCheckBox("软件自动曝光/白平衡", ui->groupBox);
+    checkSoftwareAuto->setToolTip("摄像头没有硬件自动曝光或自动白平衡时，根据画面亮度和颜色统计自动调节这两个参数");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, checkSoftwareAuto);
+    
+    // 勾选期间登记为曝光统计的使用者（启动失败时取消勾选，同时取消登记）
+    connect(checkSoftwareAuto, &QCheckBox::toggled, this, [this](bool checked) {
+        if (!checked) {
+            capture->analyzer()->removeExposureUser();
+            if (softwareAuto.isRunning()) {
+                softwareAuto.stop();
+                logToConsole("软件自动曝光/白平衡已关闭");
+            }
+            return;
+        }
+        capture->analyzer()->addExposureUser();
+        if (!capture->isActive()) {
+            QMessageBox::warning(this, tr("警告"), tr("请先打开摄像头"));
+            checkSoftwareAuto->setChecked(false);
+            return;
+        }
+        QString error;
+        if (!startSoftwareAuto(&error)) {
+            QMessageBox::warning(this, tr("软件自动曝光/白平衡"), error);
+            checkSoftwareAuto->setChecked(false);
+            return;
+        }
+    });
+    
+    // 统计在分析线程中计算，调整在GUI线程进行（DirectShow参数接口在GUI线程创建）
+    connect(capture->analyzer(), &FrameAnalyzer::exposureStatsUpdated, this, [this]() {
+        if (!softwareAuto.isRunning()) {
+            return;
+        }
+        const QList<AutoAdjustStep> steps = softwareAuto.update(capture->analyzer()->exposureStats());
+        for (const AutoAdjustStep &step : steps) {
+            logToConsole(QString("软件自动: %1 %2 -> %3（%4 %5）")
+                             .arg(CameraDeviceControl::propertyName(step.property))
+                             .arg(step.from).arg(step.to)
+                             .arg(step.property == CameraProperty::Exposure ? "平均亮度" : "R/B")
+                             .arg(step.measured, 0, 'f', 2));
+        }
+    });
+}
+
+// 按当前设备开始软件自动调节，有硬件自动模式的参数不接管
+bool cam_qt::startSoftwareAuto(QString *error)
+{
+    std::shared_ptr<CameraDeviceControl> control = capture->deviceControl();
+    if (!control) {
+        *error = "无法访问摄像头参数：" + capture->errorString();
+        return false;
+    }
+    const bool exposure = SoftwareAutoAdjust::needsSoftwareAuto(*control, CameraProperty::Exposure);
+    const bool whiteBalance = SoftwareAutoAdjust::needsSoftwareAuto(*control, CameraProperty::WhiteBalance);
+    if (!exposure && !whiteBalance) {
+        *error = "摄像头支持硬件自动曝光和自动白平衡（或不支持调节这两个参数），请在\"图像控制\"中勾选自动";
+        return false;
+    }
+    if (!softwareAuto.start(control, exposure, whiteBalance, error)) {
+        return false;
+    }
+    logToConsole(QString("软件自动曝光/白平衡已开启，接管: %1%2")
+                     .arg(exposure ? "曝光 " : "").arg(whiteBalance ? "白平衡" : ""));
+    return true;
+}
+
+// 连拍控件设置
+void cam_qt::setupBurstControls()
+{
+    burstCapture = new BurstCapture(this);
+    connect(burstCapture, &BurstCapture::progress, this, &cam_qt::handleBurstProgress);
+    connect(burstCapture, &BurstCapture::finished, this, &cam_qt::handleBurstFinished);
+    
+    QLabel* label = new QLabel("连拍:", ui->groupBox);
+    spinBurstFrames = new QSpinBox(ui->groupBox);
+    spinBurstFrames->setRange(1, 600);
+    spinBurstFrames->setValue(60);
+    spinBurstFrames->setSuffix(" 帧");
+    spinBurstFrames->setToolTip("按摄像头原始分辨率和帧率连续抓取的帧数");
+    comboBurstEncoding = new QComboBox(ui->groupBox);
+    comboBurstEncoding->addItem("PNG（无损）", int(BurstCapture::Png));
+    comboBurstEncoding->addItem("JPEG", int(BurstCapture::Jpeg));
+    comboBurstEncoding->addItem("原始YUYV", int(BurstCapture::Raw));
+    comboBurstEncoding->setToolTip("YUYV帧的保存格式；MJPEG帧总是直接保存摄像头输出的JPEG，不重新编码");
+    btnBurst = new QPushButton("连拍", ui->groupBox);
+    btnBurst->setEnabled(false);
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, label);
+    ui->verticalLayout_4->insertWidget(index + 1, spinBurstFrames);
+    ui->verticalLayout_4->insertWidget(index + 2, comboBurstEncoding);
+    ui->verticalLayout_4->insertWidget(index + 3, btnBurst);
+    
+    connect(spinBurstFrames, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &cam_qt::configureBurst);
+    connect(btnBurst, &QPushButton::clicked, this, &cam_qt::startBurst);
+}
+
+// 按连拍帧数和当前格式预分配连拍缓存，触发连拍时不再分配内存
+void cam_qt::configureBurst()
+{
+    if (!capture->isActive()) {
+        btnBurst->setEnabled(false);
+        if (!burstCapture->isActive()) {
+            burstCapture->release();
+        }
+        return;
+    }
+    
+    // 每槽按格式的最大帧大小：YUYV每像素2字节（行按64字节对齐留余量），MJPEG按每像素1字节，其他格式转为RGB32
+    const QCameraFormat format = capture->cameraFormat();
+    const QSize resolution = format.resolution().isValid() ? format.resolution() : QSize(1920, 1080);
+    qint64 slotBytes = 0;
+    if (format.pixelFormat() == QVideoFrameFormat::Format_YUYV) {
+        slotBytes = qint64((resolution.width() * 2 + 63) & ~63) * resolution.height();
+    } else if (format.pixelFormat() == QVideoFrameFormat::Format_Jpeg) {
+        slotBytes = qint64(resolution.width()) * resolution.height();
+    } else {
+        slotBytes = qint64(resolution.width()) * resolution.height() * 4;
+    }
+    
+    // 缓存上限512MB，帧数更多时槽位循环使用，编码跟不上时才会丢帧
+    const qint64 maxArena = qint64(512) * 1024 * 1024;
+    const int slots = int(qBound<qint64>(1, maxArena / slotBytes, spinBurstFrames->value()));
+    if (slots != burstCapture->slotCount() || slotBytes != burstCapture->slotBytes()) {
+        burstCapture->reserve(slots, slotBytes);
+        logToConsole(QString("连拍缓存已分配: %1 帧，%2 MB")
+                         .arg(slots).arg(burstCapture->capacityBytes() / (1024.0 * 1024.0), 0, 'f', 1));
+    }
+    btnBurst->setEnabled(!burstCapture->isActive());
+}
+
+// 开始连拍
+void cam_qt::startBurst()
+{
+    if (!capture->isActive()) {
+        QMessageBox::warning(this, tr("警告"), tr("请先打开摄像头"));
+        return;
+    }
+    configureBurst();
+    
+    const QString directory = QDir(QStandardPaths::writableLocation(QStandardPaths::PicturesLocation)).filePath("cam_qt_burst");
+    const BurstCapture::Encoding encoding = BurstCapture::Encoding(comboBurstEncoding->currentData().toInt());
+    if (!burstCapture->start(spinBurstFrames->value(), directory, encoding)) {
+        QMessageBox::warning(this, tr("连拍失败"), burstCapture->errorString());
+        return;
+    }
+    btnBurst->setEnabled(false);
+    btnBurst->setText("连拍中...");
+    logToConsole(QString("开始连拍 %1 帧，格式 %2，保存到 %3")
+                     .arg(spinBurstFrames->value()).arg(BurstCapture::encodingName(encoding)).arg(directory));
+}
+
+// 连拍进度
+void cam_qt::handleBurstProgress(int captured, int saved, int total)
+{
+    btnBurst->setText(QString("连拍 采集 %1/%3 保存 %2").arg(captured).arg(saved).arg(total));
+}
+
+// 连拍完成
+void cam_qt::handleBurstFinished(const QStringList &files, int dropped, int failed, qint64 elapsedMs)
+{
+    btnBurst->setText("连拍");
+    
+    // 摄像头已关闭时释放缓存，否则保留给下一次连拍
+    if (!capture->isActive()) {
+        burstCapture->release();
+        btnBurst->setEnabled(false);
+    } else {
+        btnBurst->setEnabled(true);
+    }
+    
+    QString message = QString("已保存 %1 帧，用时 %2 ms").arg(files.size()).arg(elapsedMs);
+    if (dropped > 0 || failed > 0) {
+        message += QString("，丢弃 %1 帧，保存失败 %2 帧").arg(dropped).arg(failed);
+    }
+    if (!files.isEmpty()) {
+        message += "\n保存位置: " + QFileInfo(files.first()).absolutePath();
+    }
+    logToConsole("连拍: " + message);
+}
+
+// 更新预录缓存状态显示
+void cam_qt::updatePreRollStatus()
+{
+    if (!labelPreRoll) {
+        return;
+    }
+    const PreRollBuffer &preRollBuffer = capture->preRollBuffer();
+    if (!preRollBuffer.isEnabled()) {
+        labelPreRoll->setText("预录缓存: 关闭");
+        return;
+    }
+    labelPreRoll->setText(QString("预录缓存: %1 / %2 MB，%3 秒")
+                              .arg(preRollBuffer.usedBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                              .arg(preRollBuffer.capacityBytes() / (1024.0 * 1024.0), 0, 'f', 1)
+                              .arg(preRollBuffer.spanUs() / 1000000.0, 0, 'f', 1));
+}
+
+// 处理采集到的音频数据
+void cam_qt::handleAudioCaptured(const QByteArray &pcm, int sampleRate, int channelCount)
+{
+    capture->submitAudio(pcm, sampleRate, channelCount);
+}
+
 // 检查是否有关联的音频设备
 bool cam_qt::hasAudioDevice(const QString &cameraName)
 {
     // 获取所有音频输入设备
-    const QList<QAudioDevice> audioInputs = QMediaDevices::audioInputs();
+    const QList<QAudioDevice> audioInputs = deviceMonitor->audioInputs();
     if (audioInputs.isEmpty()) {
         return false;
     }
@@ -276,7 +657,7 @@ void cam_qt::updateCameraList()
 {
     ui->comboCamera->clear();
     
-    const QList<QCameraDevice> cameras = QMediaDevices::videoInputs();
+    const QList<QCameraDevice> cameras = deviceMonitor->cameras();
     for (const QCameraDevice &cameraDevice : cameras) {
         ui->comboCamera->addItem(cameraDevice.description(), QVariant::fromValue(cameraDevice));
     }
@@ -312,33 +693,14 @@ void cam_qt::updateResolutionList()
     
     QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
     
-    // 创建格式到分辨率的映射
-    QMap<QString, QList<QSize>> formats;
-    
     // 只收集YUY2和MJPEG格式
-    for (const QCameraFormat &format : device.videoFormats()) {
-        QString formatStr;
-        switch(format.pixelFormat()) {
-            case QVideoFrameFormat::Format_YUYV:
-                formatStr = "YUY2";
-                break;
-            case QVideoFrameFormat::Format_Jpeg:
-                formatStr = "MJPEG";
-                break;
-            default:
-                continue;  // 跳过其他格式
-        }
-        
-        if (!formats.contains(formatStr)) {
-            formats[formatStr] = QList<QSize>();
-        }
-        formats[formatStr].append(format.resolution());
-    }
+    const QStringList formats = deviceMonitor->formatIndex(device).pixelFormatLabels();
     
-    // 添加到格式下拉列表
-    for (auto it = formats.begin(); it != formats.end(); ++it) {
-        ui->comboFormat->addItem(it.key());
+    // 添加到格式下拉列表，"自动"按预计吞吐量在所有格式中选择
+    if (!formats.isEmpty()) {
+        ui->comboFormat->addItem("自动");
     }
+    ui->comboFormat->addItems(formats);
     
     // 如果有支持的格式，选择第一个并更新分辨率列表
     if (!formats.isEmpty()) {
@@ -353,39 +715,14 @@ void cam_qt::on_comboFormat_currentIndexChanged(int index)
     if (index >= 0 && ui->comboCamera->count() > 0) {
         QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
         QString selectedFormat = ui->comboFormat->currentText();
+        const FormatIndex formats = deviceMonitor->formatIndex(device);
         
         // 清空分辨率列表
         ui->comboResolution->clear();
         
-        // 获取选中格式支持的分辨率，使用QSet去重
-        QSet<QSize> uniqueResolutions;
-        int maxFps = 0;
-        
-        for (const QCameraFormat &format : device.videoFormats()) {
-            QString formatStr;
-            switch(format.pixelFormat()) {
-                case QVideoFrameFormat::Format_YUYV:
-                    formatStr = "YUY2";
-                    break;
-                case QVideoFrameFormat::Format_Jpeg:
-                    formatStr = "MJPEG";
-                    break;
-                default:
-                    continue;
-            }
-            
-            if (formatStr == selectedFormat) {
-                uniqueResolutions.insert(format.resolution());
-                maxFps = qMax(maxFps, qRound(format.maxFrameRate()));
-            }
-        }
-        
-        // 转换为列表并排序
-        QList<QSize> supportedResolutions(uniqueResolutions.begin(), uniqueResolutions.end());
-        std::sort(supportedResolutions.begin(), supportedResolutions.end(),
-                 [](const QSize &a, const QSize &b) {
-                     return a.width() * a.height() > b.width() * b.height();
-                 });
+        // 选中格式支持的分辨率（已去重，按面积从大到小）
+        const QList<QSize> supportedResolutions = formats.resolutions(selectedFormat);
+        const int maxFps = formats.maxFrameRate(selectedFormat);
         
         // 添加到分辨率下拉列表
         for (const QSize &size : supportedResolutions) {
@@ -412,13 +749,8 @@ void cam_qt::on_comboResolution_currentIndexChanged(int index)
         QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
         QSize resolution = ui->comboResolution->itemData(index).value<QSize>();
         
-        // 查找该分辨率下的最大帧率
-        int maxFps = 0;
-        for (const QCameraFormat &format : device.videoFormats()) {
-            if (format.resolution() == resolution) {
-                maxFps = qMax(maxFps, qRound(format.maxFrameRate()));
-            }
-        }
+        // 查找选中格式在该分辨率下的最大帧率
+        const int maxFps = deviceMonitor->formatIndex(device).maxFrameRate(ui->comboFormat->currentText(), resolution);
         
         // 更新帧率范围
         if (maxFps > 0) {
@@ -430,28 +762,45 @@ void cam_qt::on_comboResolution_currentIndexChanged(int index)
     }
 }
 
-// 更新FPS显示
+// 更新FPS显示（帧率在采集控制器中统计）
 void cam_qt::updateFPSDisplay()
 {
-    if (camera && camera->isActive()) {
-        qint64 elapsed = fpsTimer.elapsed();
-        if (elapsed > 0) {
-            // 计算实时帧率
-            double instantFPS = frameCount * 1000.0 / elapsed;
-            
-            // 平滑处理
-            if (currentFPS == 0) {
-                currentFPS = instantFPS;
-            } else {
-                currentFPS = (currentFPS * 0.7) + (instantFPS * 0.3);
-            }
-            
-            // 重置计数器
-            frameCount = 0;
-            fpsTimer.restart();
+    updatePreRollStatus();
+    
+    // 被其他窗口遮挡时没有对应的窗口事件，每秒检查一次
+    updatePreviewVisibility();
+    PreviewThrottle* throttle = capture->previewPipeline()->throttle();
+    const PreviewThrottleStats throttleStats = throttle->takeStats();
+    if (throttleStats.skipped > 0 || throttle->mode() != PreviewThrottle::Full) {
+        previewSavingText = QString("预览%1: 跳过 %2 帧/秒，节省CPU %3 ms/秒（累计 %4 秒）")
+                                .arg(PreviewThrottle::modeName(throttle->mode()))
+                                .arg(throttleStats.skipped)
+                                .arg(throttleStats.savedUs / 1000.0, 0, 'f', 1)
+                                .arg(throttle->totalStats().savedUs / 1000000.0, 0, 'f', 1);
+    } else {
+        previewSavingText.clear();
+    }
+    
+    // 卡顿期间没有新帧触发重绘，定时刷新提示条
+    StreamWatchdog* streamWatchdog = capture->watchdog();
+    if (streamWatchdog->isStalled()) {
+        presentPreview();
+    }
+    
+    // 状态栏显示各订阅者的丢帧和处理耗时，以及卡顿恢复统计
+    if (capture->isActive()) {
+        QString message = "帧总线: " + capture->frameBus()->statsSummary();
+        const StreamWatchdogStats watchdogStats = streamWatchdog->stats();
+        if (watchdogStats.stalls > 0) {
+            message += QString("  卡顿 %1 次，最近恢复 %2 ms，最长 %3 ms")
+                           .arg(watchdogStats.stalls).arg(watchdogStats.lastRecoveryMs).arg(watchdogStats.maxRecoveryMs);
         }
+        if (!previewSavingText.isEmpty()) {
+            message += "  " + previewSavingText;
+        }
+        ui->statusbar->showMessage(message);
     } else {
-        currentFPS = 0;
+        ui->statusbar->clearMessage();
     }
 }
 
@@ -483,28 +832,38 @@ void cam_qt::stopCamera()
         audioPanel->stopAudio();
     }
     
-    // 停止摄像头
-    if (camera && camera->isActive()) {
-        try {
-            camera->stop();
-            logToConsole("摄像头已停止");
-        } catch (...) {
-            logToConsole("停止摄像头时出错");
-        }
-    }
+    // 停止连拍采集，已采集的帧保存完成后再释放连拍缓存
+    burstCapture->cancel();
     
-    // 清理资源前先清空会话
-    captureSession.setCamera(nullptr);
+    // 参数控制接口随摄像头一起释放
+    checkSoftwareAuto->setChecked(false);
+    checkMotionRecord->setChecked(false);
     
-    // 删除并重置摄像头对象
-    if (camera) {
-        delete camera;
-        camera = nullptr;
-        logToConsole("摄像头资源已释放");
-    }
+    // 关闭摄像头，同时释放预录缓存并输出卡顿统计
+    const bool wasDisconnected = capture->isSuspended();
+    capture->close();
     
     ui->btnOpenCamera->setText("打开摄像头");
     
+    // 输出本次预览的逐任务耗时统计
+    if (TaskPool::shared()->stats().executed > 0) {
+        logToConsole("帧处理统计:\n" + TaskPool::shared()->countersSummary());
+        TaskPool::shared()->resetCounters();
+    }
+    updatePreRollStatus();
+    
+    // 放弃等待断开的摄像头，去掉列表中已不存在的条目
+    reconnectTimer->stop();
+    if (wasDisconnected && deviceMonitor->camera(activeCameraId).isNull()) {
+        removeCameraComboEntry(activeCameraId);
+    }
+    activeCameraId.clear();
+    
+    if (!burstCapture->isActive()) {
+        burstCapture->release();
+    }
+    btnBurst->setEnabled(false);
+    
     // 更新录制按钮状态
     updateRecordButton();
     
@@ -524,8 +883,8 @@ void cam_qt::stopCamera()
 // 打开摄像头按钮点击处理
 void cam_qt::on_btnOpenCamera_clicked()
 {
-    // 如果摄像头已经打开，则关闭它
-    if (camera && camera->isActive()) {
+    // 如果摄像头已经打开（或断开后正在等待重新连接），则关闭它
+    if (capture->isOpen()) {
         stopCamera();
         return;
     }
@@ -536,225 +895,698 @@ void cam_qt::on_btnOpenCamera_clicked()
         return;
     }
     
-    // 先停止可能存在的旧摄像头
-    stopCamera();
-    
     QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
     logToConsole("尝试打开摄像头：" + device.description());
     
-    // 创建摄像头对象
-    camera = new QCamera(device, this);
-    if (!camera) {
-        QMessageBox::warning(this, tr("错误"), tr("创建摄像头对象失败"));
-        return;
-    }
-    
-    // 设置预览
-    captureSession.setCamera(camera);
-    
-    // 确保VideoSink已经设置
-    if (!videoSink) {
-        videoSink = new QVideoSink(this);
-        connect(videoSink, &QVideoSink::videoFrameChanged, this, &cam_qt::handleVideoFrame);
-    }
-    captureSession.setVideoSink(videoSink);
-    
-    // 设置格式
+    // 设置格式，没有可选格式时使用设备默认格式
+    QString selectedFormat;
+    QSize resolution;
+    int fps = ui->spinFrameRate->value();
     if (ui->comboResolution->count() > 0 && ui->comboFormat->count() > 0) {
-        QSize resolution = ui->comboResolution->itemData(ui->comboResolution->currentIndex()).value<QSize>();
-        int fps = ui->spinFrameRate->value();
-        QString selectedFormat = ui->comboFormat->currentText();
-        
+        resolution = ui->comboResolution->itemData(ui->comboResolution->currentIndex()).value<QSize>();
+        selectedFormat = ui->comboFormat->currentText();
         logToConsole(QString("设置格式: %1, 分辨率: %2x%3, 帧率: %4").arg(
             selectedFormat).arg(resolution.width()).arg(resolution.height()).arg(fps));
-        
-        // 查找匹配的格式
-        QCameraFormat bestFormat;
-        int bestFpsDiff = INT_MAX;
-        
-        for (const QCameraFormat &format : device.videoFormats()) {
-            QString formatStr;
-            switch(format.pixelFormat()) {
-                case QVideoFrameFormat::Format_YUYV:
-                    formatStr = "YUY2";
-                    break;
-                case QVideoFrameFormat::Format_Jpeg:
-                    formatStr = "MJPEG";
-                    break;
-                default:
-                    continue;
-            }
-            
-            if (formatStr == selectedFormat && format.resolution() == resolution) {
-                int fpsDiff = qAbs(qRound(format.maxFrameRate()) - fps);
-                if (fpsDiff < bestFpsDiff) {
-                    bestFpsDiff = fpsDiff;
-                    bestFormat = format;
-                }
-            }
-        }
-        
-        if (bestFormat.resolution().isValid()) {
-            logToConsole("找到匹配的格式，设置摄像头格式");
-            camera->setCameraFormat(bestFormat);
-        } else {
-            logToConsole("警告：未找到匹配的摄像头格式");
-        }
     }
-
-    try {
-        // 启动摄像头
-        logToConsole("开始启动摄像头...");
-        camera->start();
-        logToConsole("摄像头启动完成");
-        ui->btnOpenCamera->setText("关闭摄像头");
-        
-        // 更新录制按钮状态
-        updateRecordButton();
-        
-        // 如果有关联的音频设备，也启动音频捕获
-        if (audioPanel && audioPanel->isVisible() && audioPanel->hasAudioSupport()) {
-            audioPanel->startAudio();
-        }
-    } catch (const std::exception& e) {
-        logToConsole("摄像头启动异常: " + QString(e.what()));
-        QMessageBox::critical(this, tr("错误"), tr("摄像头启动失败：%1").arg(e.what()));
-        stopCamera();
-    } catch (...) {
-        logToConsole("摄像头启动时发生未知异常");
-        QMessageBox::critical(this, tr("错误"), tr("摄像头启动时发生未知错误"));
+    
+    // 打开后按格式分配预录缓存和连拍缓存（handleFormatChanged），自动格式在收到第一帧后开始校验实际帧率
+    if (!capture->open(device, selectedFormat, resolution, fps)) {
+        logToConsole("摄像头启动失败: " + capture->errorString());
+        QMessageBox::critical(this, tr("错误"), tr("摄像头启动失败：%1").arg(capture->errorString()));
         stopCamera();
+        return;
+    }
+    activeCameraId = device.id();
+    activeCameraDescription = device.description();
+    ui->btnOpenCamera->setText("关闭摄像头");
+    loadLensCalibration(device);
+    
+    // 更新录制按钮状态
+    updateRecordButton();
+    
+    // 如果有关联的音频设备，也启动音频捕获
+    if (audioPanel && audioPanel->isVisible() && audioPanel->hasAudioSupport()) {
+        audioPanel->startAudio();
     }
 }
 
 // 设置格式按钮点击处理
 void cam_qt::on_btnSetFormat_clicked()
 {
-    if (camera && camera->isActive() && ui->comboResolution->count() > 0) {
-        QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
+    if (capture->isActive() && ui->comboResolution->count() > 0) {
         QSize resolution = ui->comboResolution->itemData(ui->comboResolution->currentIndex()).value<QSize>();
         int fps = ui->spinFrameRate->value();
         QString selectedFormat = ui->comboFormat->currentText();
         
-        // 查找匹配的格式
-        QCameraFormat bestFormat;
-        int bestFpsDiff = INT_MAX;
-        
-        for (const QCameraFormat &format : device.videoFormats()) {
-            QString formatStr;
-            switch(format.pixelFormat()) {
-                case QVideoFrameFormat::Format_YUYV:
-                    formatStr = "YUY2";
-                    break;
-                case QVideoFrameFormat::Format_Jpeg:
-                    formatStr = "MJPEG";
-                    break;
-                default:
-                    continue;
-            }
-            
-            if (formatStr == selectedFormat && format.resolution() == resolution) {
-                int fpsDiff = qAbs(qRound(format.maxFrameRate()) - fps);
-                if (fpsDiff < bestFpsDiff) {
-                    bestFpsDiff = fpsDiff;
-                    bestFormat = format;
-                }
-            }
-        }
-        
-        if (bestFormat.resolution().isValid()) {
-            // 需要重新启动摄像头
-            camera->stop();
-            camera->setCameraFormat(bestFormat);
-            camera->start();
-            
+        // 需要重新启动摄像头，预录缓存和连拍缓存在handleFormatChanged中重新分配
+        if (capture->setFormat(selectedFormat, resolution, fps)) {
+            const QCameraFormat format = capture->cameraFormat();
             QMessageBox::information(this, tr("信息"), 
                                     tr("已设置格式为 %1x%2 @ %3 FPS\n视频格式: %4")
-                                    .arg(resolution.width())
-                                    .arg(resolution.height())
+                                    .arg(format.resolution().width())
+                                    .arg(format.resolution().height())
                                     .arg(fps)
-                                    .arg(selectedFormat));
+                                    .arg(FormatSelector::pixelFormatLabel(format.pixelFormat())));
+        } else {
+            QMessageBox::warning(this, tr("错误"), capture->errorString());
         }
     }
 }
 
+// 格式变化后按新的帧大小重新分配预录缓存和连拍缓存
+void cam_qt::handleFormatChanged(const QCameraFormat &format)
+{
+    logToConsole("当前格式: " + formatToString(format));
+    configurePreRoll();
+    configureBurst();
+}
+
 // 查找摄像头按钮点击处理
 void cam_qt::on_btnDetectCameras_clicked()
 {
-    updateCameraList();
+    // 重新枚举设备，新增和移除的设备按热插拔处理，再刷新当前摄像头的格式列表
+    deviceMonitor->refresh();
+    updateResolutionList();
     QMessageBox::information(this, tr("信息"), 
                             tr("已检测到 %1 个摄像头设备").arg(ui->comboCamera->count()));
 }
 
-// 处理视频帧
-void cam_qt::handleVideoFrame(const QVideoFrame &frame)
+// 摄像头列表中按设备ID查找条目
+int cam_qt::cameraComboIndex(const QByteArray &id) const
 {
-    if (frame.isValid()) {
-        // 更新帧计数
-        frameCount++;
-        
-        // 计算帧间隔
-        qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-        if (lastFrameTime > 0) {
-            qint64 frameInterval = currentTime - lastFrameTime;
-            // 可以用于更精确的帧率计算或其他目的
+    for (int i = 0; i < ui->comboCamera->count(); ++i) {
+        if (ui->comboCamera->itemData(i).value<QCameraDevice>().id() == id) {
+            return i;
         }
-        lastFrameTime = currentTime;
-        
-        // 转换为QImage并显示
-        QImage image = frame.toImage();
-        if (!image.isNull()) {
-            // 获取标签大小
-            QSize labelSize = ui->labelPreview->size();
+    }
+    return -1;
+}
+
+// 删除摄像头列表中的条目，删除的不是当前选择时不触发选择改变处理（当前设备没有变化）
+void cam_qt::removeCameraComboEntry(const QByteArray &id)
+{
+    const int index = cameraComboIndex(id);
+    if (index < 0) {
+        return;
+    }
+    if (index == ui->comboCamera->currentIndex()) {
+        ui->comboCamera->removeItem(index);
+        if (ui->comboCamera->count() == 0) {
+            updateResolutionList();
+            if (audioPanel) {
+                audioPanel->setVisible(false);
+            }
+        }
+    } else {
+        QSignalBlocker blocker(ui->comboCamera);
+        ui->comboCamera->removeItem(index);
+    }
+}
+
+// 新插入的摄像头：追加到列表；正在等待重新连接的摄像头回来时恢复采集
+void cam_qt::handleCamerasAdded(const QList<QCameraDevice> &devices)
+{
+    for (const QCameraDevice &device : devices) {
+        // 重新插入后设备ID通常不变；换了USB口时ID会变，按名称匹配
+        const bool sameDevice = device.id() == activeCameraId
+                                || (device.description() == activeCameraDescription && cameraComboIndex(device.id()) < 0);
+        if (capture->isSuspended() && sameDevice) {
+            const qint64 waitedMs = reconnectTimer->interval() - reconnectTimer->remainingTime();
+            reconnectTimer->stop();
             
-            // 创建背景图像
-            QImage background(labelSize, QImage::Format_RGB32);
-            background.fill(Qt::white);  // 改为白色背景
+            const int index = cameraComboIndex(activeCameraId);
+            if (index >= 0) {
+                ui->comboCamera->setItemText(index, device.description());
+                ui->comboCamera->setItemData(index, QVariant::fromValue(device));
+            }
+            activeCameraId = device.id();
             
-            // 按比例缩放图像以适应标签
-            QImage scaledImage = image.scaled(labelSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            // 按断开前的格式重新打开，格式变化时由handleFormatChanged重新分配缓存
+            capture->resume(device);
+            logToConsole(QString("摄像头在 %1 ms 后重新连接，继续采集%2")
+                             .arg(waitedMs).arg(capture->isRecording() ? "，录制未中断" : ""));
             
-            // 在背景中央绘制缩放后的图像
-            QPainter painter(&background);
-            int x = (labelSize.width() - scaledImage.width()) / 2;
-            int y = (labelSize.height() - scaledImage.height()) / 2;
-            painter.drawImage(x, y, scaledImage);
-
-            // 绘制实时帧率文本
-            painter.setPen(Qt::gray); // 设置文本颜色
-            painter.setFont(QFont("Arial", 8)); // 设置字体
-            painter.drawText(10, labelSize.height() - 10, QString("实时帧率: %1 FPS").arg(currentFPS, 0, 'f', 1)); // 在左下角绘制文本
+            // 参数控制接口已随断开释放，按新的接口重新接管
+            QString error;
+            if (checkSoftwareAuto->isChecked() && !startSoftwareAuto(&error)) {
+                logToConsole("软件自动曝光/白平衡无法恢复: " + error);
+                checkSoftwareAuto->setChecked(false);
+            }
             
-            // 显示图像
-            ui->labelPreview->setPixmap(QPixmap::fromImage(background));
+            if (audioPanel && audioPanel->isVisible() && audioPanel->hasAudioSupport()) {
+                audioPanel->startAudio();
+            }
+            continue;
+        }
+        
+        if (cameraComboIndex(device.id()) < 0) {
+            // 列表为空时addItem会选中该条目并触发选择改变处理
+            ui->comboCamera->addItem(device.description(), QVariant::fromValue(device));
         }
     }
 }
 
-// 打开摄像头控制面板
-void cam_qt::on_btnCameraControl_clicked()
+// 摄像头被拔出：正在使用的摄像头进入宽限期等待重新连接，其他设备直接从列表中删除
+void cam_qt::handleCamerasRemoved(const QList<QCameraDevice> &devices)
 {
-    if (camera && camera->isActive()) {
-        QCameraDevice device = ui->comboCamera->currentData().value<QCameraDevice>();
-        
-        // 删除旧的对话框实例，确保每次都创建新的
-        if (cameraControlDialog) {
-            delete cameraControlDialog;
-            cameraControlDialog = nullptr;
+    for (const QCameraDevice &device : devices) {
+        if (capture->isOpen() && !capture->isSuspended() && device.id() == activeCameraId) {
+            capture->suspend();
+            softwareAuto.stop();
+            if (audioPanel) {
+                audioPanel->stopAudio();
+            }
+            
+            const int index = cameraComboIndex(activeCameraId);
+            if (index >= 0) {
+                ui->comboCamera->setItemText(index, device.description() + " (已断开)");
+            }
+            
+            // 录制中给更长的宽限期，尽量不让一次接触不良打断录制
+            const int graceMs = capture->isRecording() ? 15000 : 5000;
+            reconnectTimer->start(graceMs);
+            logToConsole(QString("正在使用的摄像头已断开，等待 %1 秒重新连接").arg(graceMs / 1000));
+            continue;
         }
-        
-        // 创建新的对话框实例
-        cameraControlDialog = new CameraControlDialog(device.id(), this);
-        
-        // 显示对话框
-        if (cameraControlDialog) {
-            cameraControlDialog->show();
-        } else {
-            QMessageBox::warning(this, tr("错误"), tr("无法创建图像控制对话框"));
+        removeCameraComboEntry(device.id());
+    }
+}
+
+// 宽限期内没有重新连接，关闭摄像头
+void cam_qt::handleReconnectTimeout()
+{
+    if (!capture->isSuspended()) {
+        return;
+    }
+    const QString description = activeCameraDescription;
+    logToConsole("摄像头未在宽限期内重新连接，已关闭: " + description);
+    stopCamera();
+    QMessageBox::warning(this, tr("摄像头已断开"), tr("摄像头 %1 已断开连接").arg(description));
+}
+
+// 音频设备变化：只在当前摄像头的音频设备消失、或之前没有匹配到音频设备时重新匹配
+void cam_qt::handleAudioInputsChanged()
+{
+    if (ui->comboCamera->count() == 0 || !audioPanel) {
+        return;
+    }
+    bool currentPresent = false;
+    if (!currentAudioDevice.isNull()) {
+        for (const QAudioDevice &device : deviceMonitor->audioInputs()) {
+            if (device.id() == currentAudioDevice.id()) {
+                currentPresent = true;
+                break;
+            }
         }
+        if (currentPresent) {
+            return;
+        }
+        audioPanel->stopAudio();
+    }
+    
+    checkForAudioDevice(ui->comboCamera->currentText());
+    if (capture->isActive() && audioPanel->isVisible() && audioPanel->hasAudioSupport()) {
+        audioPanel->startAudio();
+    }
+}
+
+// 数字变焦设置
+void cam_qt::setupDigitalZoomControls()
+{
+    QLabel* label = new QLabel("数字变焦:", ui->groupBox);
+    spinDigitalZoom = new QDoubleSpinBox(ui->groupBox);
+    spinDigitalZoom->setRange(1.0, 8.0);
+    spinDigitalZoom->setSingleStep(0.25);
+    spinDigitalZoom->setDecimals(2);
+    spinDigitalZoom->setSuffix(" x");
+    spinDigitalZoom->setToolTip("摄像头不支持变焦时在预览中裁剪放大，只转换/解码放大的区域；"
+                                "也可以在预览上用滚轮缩放、按住左键拖动平移、双击复位");
+    checkRecordCrop = new QCheckBox("按变焦区域录制", ui->groupBox);
+    checkRecordCrop->setToolTip("原始帧/MJPEG录制只保存变焦区域（MJPEG需要重新编码），从下次开始录制时生效");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, label);
+    ui->verticalLayout_4->insertWidget(index + 1, spinDigitalZoom);
+    ui->verticalLayout_4->insertWidget(index + 2, checkRecordCrop);
+    
+    connect(spinDigitalZoom, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
+            this, [this](double value) {
+        digitalZoom.setFactor(value);
+        updateDigitalZoom();
+    });
+    connect(checkRecordCrop, &QCheckBox::toggled, this, [this]() {
+        updateDigitalZoom();
+    });
+    ui->labelPreview->installEventFilter(this);
+}
+
+// 变焦区域改变后同步数值框、预览和录制裁剪区域
+void cam_qt::updateDigitalZoom()
+{
+    {
+        QSignalBlocker blocker(spinDigitalZoom);
+        spinDigitalZoom->setValue(digitalZoom.factor());
+    }
+    const QRectF roi = digitalZoom.roi();
+    capture->previewPipeline()->setZoomRegion(roi);
+    capture->setRecordingCrop(checkRecordCrop->isChecked() ? roi : QRectF());
+    presentPreview();
+}
+
+// 镜头畸变校正设置，打开有标定的摄像头后才可以勾选
+void cam_qt::setupLensCorrectionControls()
+{
+    checkLensCorrection = new QCheckBox("镜头畸变校正", ui->groupBox);
+    checkLensCorrection->setEnabled(false);
+    checkLensCorrection->setToolTip("按程序目录下lens_calibration.json中该摄像头的标定校正广角镜头的桶形畸变");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, checkLensCorrection);
+    
+    connect(checkLensCorrection, &QCheckBox::toggled, this, [this](bool checked) {
+        capture->lensCorrection()->setEnabled(checked);
+        logToConsole(checked ? "镜头畸变校正已开启" : "镜头畸变校正已关闭");
+    });
+}
+
+// 时域降噪设置，预览和录制使用同一强度
+void cam_qt::setupDenoiseControls()
+{
+    QLabel* label = new QLabel("时域降噪:", ui->groupBox);
+    spinDenoise = new QSpinBox(ui->groupBox);
+    spinDenoise->setRange(0, 100);
+    spinDenoise->setValue(0);
+    spinDenoise->setSpecialValueText("关闭");
+    spinDenoise->setToolTip("弱光下逐帧累积降低噪声，移动的部分按差别自动减弱；"
+                            "预览和原始帧录制都降噪（MJPEG直通录制不降噪），0表示关闭");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, label);
+    ui->verticalLayout_4->insertWidget(index + 1, spinDenoise);
+    
+    connect(spinDenoise, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, [this](int value) {
+        capture->previewPipeline()->setDenoiseStrength(value);
+        capture->temporalDenoise()->setStrength(value);
+    });
+}
+
+// 移动触发录制设置
+void cam_qt::setupMotionRecordingControls()
+{
+    checkMotionRecord = new QCheckBox("移动侦测录制", ui->groupBox);
+    checkMotionRecord->setToolTip("检测到画面中有移动时自动录制（原始帧或MJPEG直通），每次事件一个文件，"
+                                  "开头包含预录时长内的画面");
+    spinMotionSensitivity = new QSpinBox(ui->groupBox);
+    spinMotionSensitivity->setRange(1, 100);
+    spinMotionSensitivity->setValue(50);
+    spinMotionSensitivity->setPrefix("灵敏度 ");
+    spinMotionSensitivity->setToolTip("越大越灵敏，误触发时调小；日志中每分钟输出最大块差和阈值供参考");
+    spinMotionPostRoll = new QSpinBox(ui->groupBox);
+    spinMotionPostRoll->setRange(1, 600);
+    spinMotionPostRoll->setValue(10);
+    spinMotionPostRoll->setPrefix("延录 ");
+    spinMotionPostRoll->setSuffix(" 秒");
+    spinMotionPostRoll->setToolTip("最后一次检测到移动后继续录制的时长，下次开启侦测时生效");
+    
+    int index = ui->verticalLayout_4->indexOf(ui->btnSetFormat);
+    ui->verticalLayout_4->insertWidget(index, checkMotionRecord);
+    ui->verticalLayout_4->insertWidget(index + 1, spinMotionSensitivity);
+    ui->verticalLayout_4->insertWidget(index + 2, spinMotionPostRoll);
+    
+    connect(checkMotionRecord, &QCheckBox::toggled, this, &cam_qt::armMotionRecording);
+    // 灵敏度可以在侦测期间调整，下一次检测时生效
+    connect(spinMotionSensitivity, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, [this](int value) {
+        capture->analyzer()->setMotionSensitivity(value);
+    });
+    connect(capture, &CaptureController::motionRecordingChanged, this, [this](bool recording, const QString &path) {
+        checkMotionRecord->setText(recording ? "移动侦测录制（录制中）" : "移动侦测录制");
+        if (!recording) {
+            logToConsole("移动事件录制完成: " + path + "，" + recordingStatsText());
+        }
+    });
+}
+
+// 开启或停止移动触发录制
+void cam_qt::armMotionRecording(bool checked)
+{
+    if (!checked) {
+        capture->stopMotionRecording();
+        checkMotionRecord->setText("移动侦测录制");
+        updateRecordButton();
+        return;
+    }
+    
+    QString error;
+    if (!capture->isActive()) {
+        error = tr("摄像头未激活");
+    } else if (isRecording) {
+        error = tr("请先停止当前的录制");
+    }
+    
+    QString basePath;
+    if (error.isEmpty()) {
+        // 每次事件的文件名在此基础上加时间
+        const bool mjpeg = capture->cameraFormat().pixelFormat() == QVideoFrameFormat::Format_Jpeg;
+        const QString defaultPath = QDir(QCoreApplication::applicationDirPath()).filePath(mjpeg ? "motion.avi" : "motion.raw");
+        basePath = QFileDialog::getSaveFileName(this, tr("移动事件录制文件"), defaultPath,
+                                                tr("MJPEG直通 (*.avi);;原始帧 (*.raw)"));
+        if (basePath.isEmpty()) {
+            logToConsole("用户取消了移动侦测录制");
+        } else if (!capture->startMotionRecording(basePath, spinMotionSensitivity->value(), spinMotionPostRoll->value())) {
+            error = capture->errorString();
+        }
+    }
+    
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, tr("移动侦测录制"), tr("无法开启移动侦测录制：%1").arg(error));
+    }
+    if (!capture->isMotionRecordingArmed()) {
+        QSignalBlocker blocker(checkMotionRecord);
+        checkMotionRecord->setChecked(false);
+        return;
+    }
+    updateRecordButton();
+}
+
+// 按VID/PID读取摄像头的镜头标定，没有VID/PID（非Windows平台）或没有对应条目时按设备名称查找
+void cam_qt::loadLensCalibration(const QCameraDevice &device)
+{
+    const QString path = QDir(QCoreApplication::applicationDirPath()).filePath("lens_calibration.json");
+    QStringList keys;
+#ifdef Q_OS_WIN
+    const CameraDeviceInfo info = getDeviceVidPid(device.description());
+    if (!info.vid.isEmpty() && !info.pid.isEmpty()) {
+        keys << LensCalibration::deviceKey(info.vid, info.pid);
+    }
+#endif
+    keys << device.description();
+    
+    LensCalibration calibration;
+    QString matchedKey;
+    if (QFile::exists(path)) {
+        for (const QString &key : keys) {
+            QString error;
+            if (LensCalibration::load(path, key, &calibration, &error)) {
+                matchedKey = key;
+                break;
+            }
+            if (!error.isEmpty()) {
+                logToConsole(error);
+                break;
+            }
+        }
+    }
+    
+    capture->lensCorrection()->setCalibration(calibration);
+    checkLensCorrection->setEnabled(calibration.isValid());
+    if (calibration.isValid()) {
+        logToConsole(QString("镜头标定: %1（%2x%3，k1=%4 k2=%5）").arg(matchedKey)
+                         .arg(calibration.size.width()).arg(calibration.size.height())
+                         .arg(calibration.k1).arg(calibration.k2));
+        checkLensCorrection->setToolTip(QString("按%1的标定校正广角镜头的桶形畸变").arg(matchedKey));
     } else {
+        checkLensCorrection->setChecked(false);
+        checkLensCorrection->setToolTip(QString("%1中没有该摄像头（%2）的标定").arg(path, keys.join("、")));
+    }
+}
+
+// 预览上的数字变焦操作：滚轮以鼠标位置为中心缩放，按住左键拖动平移，双击复位
+bool cam_qt::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == ui->labelPreview && capture->isActive() && !previewImageRect.isEmpty()) {
+        switch (event->type()) {
+            case QEvent::Wheel: {
+                const QWheelEvent* wheel = static_cast<QWheelEvent*>(event);
+                const QPointF pos = wheel->position() - QPointF(previewImageRect.topLeft());
+                const QPointF viewPoint(qBound(0.0, pos.x() / previewImageRect.width(), 1.0),
+                                        qBound(0.0, pos.y() / previewImageRect.height(), 1.0));
+                const double step = wheel->angleDelta().y() > 0 ? 1.25 : 0.8;
+                digitalZoom.zoomAt(digitalZoom.factor() * step, viewPoint);
+                updateDigitalZoom();
+                return true;
+            }
+            case QEvent::MouseButtonPress: {
+                const QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+                if (mouse->button() == Qt::LeftButton) {
+                    zoomDragPos = mouse->position().toPoint();
+                }
+                break;
+            }
+            case QEvent::MouseMove: {
+                const QMouseEvent* mouse = static_cast<QMouseEvent*>(event);
+                if ((mouse->buttons() & Qt::LeftButton) && digitalZoom.isZoomed()) {
+                    const QPoint pos = mouse->position().toPoint();
+                    const QPoint delta = pos - zoomDragPos;
+                    zoomDragPos = pos;
+                    digitalZoom.pan(QPointF(double(delta.x()) / previewImageRect.width(),
+                                            double(delta.y()) / previewImageRect.height()));
+                    updateDigitalZoom();
+                    return true;
+                }
+                break;
+            }
+            case QEvent::MouseButtonDblClick:
+                digitalZoom.reset();
+                updateDigitalZoom();
+                return true;
+            default:
+                break;
+        }
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+// 帧总线订阅者设置（录制、预录和预览的订阅者在采集控制器中）
+void cam_qt::setupFrameBus()
+{
+    FrameBus* frameBus = capture->frameBus();
+    
+    // 连拍：只把帧拷贝到预分配的环形缓存，编码在线程池中进行，不阻塞预览
+    frameBus->subscribe("连拍", [this](const SharedFrame &frame) {
+        burstCapture->capture(frame.packet());
+    }, 0);
+    
+    // 预览：采集控制器的预览管线在自己的分发线程中校正、转换、缩放和调节，完成后通知GUI线程显示
+    PreviewPipeline* preview = capture->previewPipeline();
+    preview->setTargetSize(ui->labelPreview->size());
+    connect(preview, &PreviewPipeline::imageReady, this, &cam_qt::presentPreview, Qt::QueuedConnection);
+    preview->setEnabled(true);
+}
+
+// 在GUI线程显示最新的预览帧
+void cam_qt::presentPreview()
+{
+    PreviewPipeline* preview = capture->previewPipeline();
+    double processUs = 0;
+    const QImage scaledImage = preview->latestImage(&processUs);
+    preview->setTargetSize(ui->labelPreview->size());
+    if (scaledImage.isNull() || !capture->isActive() || preview->throttle()->mode() == PreviewThrottle::Hidden) {
+        return;
+    }
+    
+    // 获取标签大小
+    QSize labelSize = ui->labelPreview->size();
+    
+    // 创建背景图像
+    QImage background(labelSize, QImage::Format_RGB32);
+    background.fill(Qt::white);  // 改为白色背景
+    
+    // 在背景中央绘制缩放后的图像
+    QPainter painter(&background);
+    int x = (labelSize.width() - scaledImage.width()) / 2;
+    int y = (labelSize.height() - scaledImage.height()) / 2;
+    painter.drawImage(x, y, scaledImage);
+    previewImageRect = QRect(x, y, scaledImage.width(), scaledImage.height());
+
+    // 绘制实时帧率文本
+    painter.setPen(Qt::gray); // 设置文本颜色
+    painter.setFont(QFont("Arial", 8)); // 设置字体
+    painter.drawText(10, labelSize.height() - 10, QString("实时帧率: %1 FPS  处理: %2 ms  线程池利用率: %3%")
+                                                      .arg(capture->smoothedFps(), 0, 'f', 1)
+                                                      .arg(processUs / 1000.0, 0, 'f', 2)
+                                                      .arg(TaskPool::shared()->stats().utilization * 100.0, 0, 'f', 0)); // 在左下角绘制文本
+    int textY = labelSize.height() - 25;
+    if (capture->isRecording()) {
+        painter.drawText(10, textY, recordingStatsText());
+        textY -= 15;
+    }
+    if (!previewSavingText.isEmpty()) {
+        painter.drawText(10, textY, previewSavingText);
+        textY -= 15;
+    }
+    painter.drawText(10, textY, previewQualityText());
+    if (softwareAuto.isRunning()) {
+        textY -= 15;
+        painter.drawText(10, textY, softwareAuto.statusText());
+    }
+    if (digitalZoom.isZoomed()) {
+        textY -= 15;
+        painter.drawText(10, textY, QString("数字变焦 %1x%2").arg(digitalZoom.factor(), 0, 'f', 2)
+                                        .arg(checkRecordCrop->isChecked() ? "（录制裁剪）" : ""));
+    }
+    
+    // 直方图叠加在右上角，避开卡顿提示条
+    if (checkHistogram->isChecked()) {
+        const QRect histogramRect(labelSize.width() - 290, 34, 280, 110);
+        HistogramWidget::paintHistogram(painter, histogramRect, capture->analyzer()->histogram());
+    }
+    
+    // 对焦辅助：标出统计区域并显示清晰度
+    if (checkFocusAssist->isChecked()) {
+        FrameAnalyzer* analyzer = capture->analyzer();
+        // 统计区域按整帧定义，数字变焦时换算到放大区域并裁到预览图内
+        const QRectF roi = digitalZoom.mapToView(effectiveFocusRoi(analyzer->focusRoi()));
+        const QRect roiRect = QRect(x + qRound(roi.x() * scaledImage.width()), y + qRound(roi.y() * scaledImage.height()),
+                                    qRound(roi.width() * scaledImage.width()), qRound(roi.height() * scaledImage.height()))
+                                  .intersected(previewImageRect);
+        const FocusMeasure focus = analyzer->focus();
+        painter.setPen(QPen(QColor(255, 255, 0, 200), 1, Qt::DashLine));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(roiRect);
+        painter.setPen(QColor(255, 255, 0));
+        painter.setFont(QFont("Arial", 9, QFont::Bold));
+        painter.drawText(roiRect.left(), roiRect.top() - 4,
+                         focus.isValid() ? QString("清晰度 %1  统计 %2 ms").arg(focus.sharpness, 0, 'f', 1)
+                                                                         .arg(focus.computeUs / 1000.0, 0, 'f', 2)
+                                         : QString("清晰度 --"));
+    }
+    
+    // 卡顿时保留最后一帧，在顶部显示提示条
+    StreamWatchdog* streamWatchdog = capture->watchdog();
+    if (streamWatchdog->isStalled()) {
+        painter.fillRect(0, 0, labelSize.width(), 28, QColor(200, 0, 0, 180));
+        painter.setPen(Qt::white);
+        painter.setFont(QFont("Arial", 10, QFont::Bold));
+        painter.drawText(QRect(0, 0, labelSize.width(), 28), Qt::AlignCenter,
+                         QString("视频流中断 %1 秒，正在自动恢复（已重启 %2 次）")
+                             .arg(streamWatchdog->stalledForMs() / 1000.0, 0, 'f', 1)
+                             .arg(streamWatchdog->stats().restarts));
+    }
+    
+    // 显示图像
+    ui->labelPreview->setPixmap(QPixmap::fromImage(background));
+}
+
+// 预览质量级别和最近几次调整
+QString cam_qt::previewQualityText() const
+{
+    const PreviewGovernor* governor = capture->previewPipeline()->governor();
+    QString text = QString("预览质量: %1（%2 / %3 ms）")
+                       .arg(PreviewGovernor::levelName(governor->level()))
+                       .arg(governor->averageCostUs() / 1000.0, 0, 'f', 1)
+                       .arg(governor->budgetUs() / 1000.0, 0, 'f', 1);
+    const QList<PreviewQualityChange> history = governor->history();
+    for (int i = qMax(0, int(history.size()) - 3); i < history.size(); ++i) {
+        const PreviewQualityChange &change = history.at(i);
+        text += QString("  %1 %2→%3").arg(change.time.toString("HH:mm:ss"))
+                                     .arg(PreviewGovernor::levelName(change.from))
+                                     .arg(PreviewGovernor::levelName(change.to));
+    }
+    return text;
+}
+
+// 根据窗口状态设置预览节流模式
+void cam_qt::updatePreviewVisibility()
+{
+    if (!capture) {
+        return;
+    }
+    PreviewThrottle::Mode mode = PreviewThrottle::Full;
+    const QWindow* window = windowHandle();
+    if (!isVisible() || isMinimized() || !window || !window->isExposed()
+        || ui->labelPreview->visibleRegion().isEmpty()) {
+        mode = PreviewThrottle::Hidden;
+    } else if (!isActiveWindow()) {
+        mode = PreviewThrottle::Throttled;
+    }
+    
+    PreviewThrottle* throttle = capture->previewPipeline()->throttle();
+    const PreviewThrottle::Mode previous = throttle->mode();
+    if (mode == previous) {
+        return;
+    }
+    throttle->setMode(mode);
+    logToConsole(QString("预览模式: %1 -> %2").arg(PreviewThrottle::modeName(previous))
+                                             .arg(PreviewThrottle::modeName(mode)));
+    // 重新可见时先显示暂停前的最后一帧，下一帧到来后再更新
+    if (previous == PreviewThrottle::Hidden) {
+        presentPreview();
+    }
+}
+
+void cam_qt::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange || event->type() == QEvent::ActivationChange) {
+        updatePreviewVisibility();
+    }
+}
+
+void cam_qt::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    updatePreviewVisibility();
+}
+
+void cam_qt::hideEvent(QHideEvent *event)
+{
+    QMainWindow::hideEvent(event);
+    updatePreviewVisibility();
+}
+
+// 打开摄像头控制面板
+void cam_qt::on_btnCameraControl_clicked()
+{
+    if (!capture->isActive()) {
         QMessageBox::warning(this, tr("错误"), tr("请先打开摄像头"));
+        return;
+    }
+    
+    // 参数控制接口由采集控制器按当前设备创建；平台不支持时只显示软件调节
+    std::shared_ptr<CameraDeviceControl> control = capture->deviceControl();
+    if (!control) {
+        logToConsole(QString("图像控制: 设备参数控制不可用（%1），只提供软件调节").arg(capture->errorString()));
+    }
+    
+    // 删除旧的对话框实例，确保每次都创建新的
+    if (cameraControlDialog) {
+        delete cameraControlDialog;
+        cameraControlDialog = nullptr;
+    }
+    
+    // 创建新的对话框实例并显示
+    cameraControlDialog = new CameraControlDialog(control, capture->analyzer(), capture->imageAdjust(), this);
+    cameraControlDialog->show();
+}
+
+// 打开多路预览窗口
+void cam_qt::on_btnMultiCamera_clicked()
+{
+    const QList<QCameraDevice> devices = deviceMonitor->cameras();
+    if (devices.isEmpty()) {
+        QMessageBox::warning(this, tr("错误"), tr("没有可用的摄像头设备"));
+        return;
+    }
+    
+    // 同一设备不能被两个会话同时打开，先关闭主窗口中的摄像头
+    if (capture->isOpen()) {
+        stopCamera();
+    }
+    
+    // 各路使用主窗口当前选择的格式、分辨率和帧率，设备不支持时选最接近的格式
+    const QVideoFrameFormat::PixelFormat pixelFormat = ui->comboFormat->currentText() == "YUY2"
+                                                           ? QVideoFrameFormat::Format_YUYV
+                                                           : QVideoFrameFormat::Format_Jpeg;
+    QSize resolution = ui->comboResolution->currentData().value<QSize>();
+    if (!resolution.isValid()) {
+        resolution = QSize(1280, 720);
     }
+    
+    MultiCameraWindow* window = new MultiCameraWindow(this);
+    const int opened = window->openDevices(devices, pixelFormat, resolution, ui->spinFrameRate->value());
+    window->show();
+    logToConsole(QString("多路预览: 打开 %1/%2 个摄像头").arg(opened).arg(devices.size()));
 }
 
 // 格式转字符串
@@ -787,7 +1619,10 @@ QString cam_qt::getDefaultSavePath()
     
     // 创建当前时间戳作为文件名
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
-    QString filename = QString("video_%1.mp4").arg(timestamp);
+    // MJPEG格式默认使用直通录制
+    const bool mjpeg = capture->cameraFormat().pixelFormat() == QVideoFrameFormat::Format_Jpeg;
+    QString extension = mjpeg ? "avi" : "mp4";
+    QString filename = QString("video_%1.%2").arg(timestamp).arg(extension);
     
     return QDir(appPath).filePath(filename);
 }
@@ -795,12 +1630,12 @@ QString cam_qt::getDefaultSavePath()
 // 开始录制视频
 void cam_qt::startRecording()
 {
-    if (!camera || !camera->isActive() || !mediaRecorder) {
+    if (!capture->isActive() || !mediaRecorder) {
         logToConsole("错误：无法开始录制，摄像头未激活或录制器未初始化");
         return;
     }
     
-    if (mediaRecorder->recorderState() == QMediaRecorder::RecordingState) {
+    if (mediaRecorder->recorderState() == QMediaRecorder::RecordingState || capture->isRecording()) {
         logToConsole("录制已经在进行中");
         return;
     }
@@ -824,13 +1659,41 @@ void cam_qt::startRecording()
     QString defaultPath = getDefaultSavePath();
     QString filePath = QFileDialog::getSaveFileName(this, tr("保存录制文件"),
                                                    defaultPath,
-                                                   tr("MP4文件 (*.mp4)"));
+                                                   tr("MP4文件 (*.mp4);;MJPEG直通 (*.avi);;原始帧 (*.raw)"));
     
     if (filePath.isEmpty()) {
         logToConsole("用户取消了录制");
         return;
     }
     
+    // 原始帧和MJPEG直通录制走采集控制器的录制管线，不经过QMediaRecorder
+    if (filePath.endsWith(".raw", Qt::CaseInsensitive) || filePath.endsWith(".avi", Qt::CaseInsensitive)) {
+        // 分段录制：按时长或大小滚动到新文件，旧文件在后台收尾
+        const qint64 segmentUs = qint64(spinSegmentMinutes->value()) * 60 * 1000000;
+        const qint64 segmentBytes = qint64(spinSegmentSizeMB->value()) * 1024 * 1024;
+        if (segmentUs > 0 || segmentBytes > 0) {
+            logToConsole(QString("分段录制: 每段 %1 分钟 / %2 MB，清单文件 %3")
+                             .arg(spinSegmentMinutes->value())
+                             .arg(spinSegmentSizeMB->value())
+                             .arg(SegmentedSink::manifestPath(filePath)));
+        }
+        
+        // 预录缓存中的帧先写入，随后的实时帧紧接其后
+        if (!capture->startRecording(filePath, segmentUs, segmentBytes)) {
+            QMessageBox::critical(this, tr("录制错误"),
+                                 tr("无法创建录制文件：%1").arg(capture->errorString()));
+            return;
+        }
+        logToConsole("开始管线录制到: " + filePath);
+        isRecording = true;
+        updateRecordButton();
+        return;
+    }
+    
+    if (capture->preRollBuffer().packetCount() > 0) {
+        logToConsole("MP4录制不支持预录，预录缓存中的帧不会写入");
+    }
+    
     mediaRecorder->setOutputLocation(QUrl::fromLocalFile(filePath));
     
     // 重置录制时长
@@ -847,6 +1710,11 @@ void cam_qt::startRecording()
 // 停止录制视频
 void cam_qt::stopRecording()
 {
+    if (capture && capture->isRecording()) {
+        capture->stopRecording();
+        logToConsole("停止管线录制，" + recordingStatsText());
+    }
+    
     if (mediaRecorder && mediaRecorder->recorderState() == QMediaRecorder::RecordingState) {
         mediaRecorder->stop();
         logToConsole("停止录制视频");
@@ -860,8 +1728,8 @@ void cam_qt::stopRecording()
 void cam_qt::updateRecordButton()
 {
     // 只有在摄像头活动时才启用录制按钮
-    bool cameraActive = camera && camera->isActive();
-    ui->btnRecordVideo->setEnabled(cameraActive);
+    bool cameraActive = capture->isActive();
+    ui->btnRecordVideo->setEnabled(cameraActive && !capture->isMotionRecordingArmed());
     
     // 根据录制状态更新按钮文本
     if (isRecording) {
@@ -936,3 +1804,25 @@ void cam_qt::handleRecordingError(QMediaRecorder::Error error, const QString &er
     // 停止录制
     stopRecording();
 }
+
+// 处理录制管线写入错误
+void cam_qt::handlePipelineError(const QString &message)
+{
+    logToConsole(QString("录制管线写入错误: %1").arg(message));
+    QMessageBox::critical(this, tr("录制错误"),
+                         tr("写入录制文件失败：%1").arg(message));
+    
+    stopRecording();
+}
+
+// 录制管线统计信息
+QString cam_qt::recordingStatsText()
+{
+    const RecordingStats stats = capture->pipeline()->stats();
+    return QString("录制队列: %1/%2  已写: %3  丢弃: %4  写入: %5 ms")
+            .arg(stats.queueDepth)
+            .arg(stats.queueCapacity)
+            .arg(stats.encoded)
+            .arg(stats.dropped)
+            .arg(stats.avgWriteUs / 1000.0, 0, 'f', 2);
+}
@@ -15,13 +15,24 @@
 #include <QMediaRecorder>
 #include <QMediaFormat>
 #include <QFileDialog>
+#include <QSpinBox>
+#include <QComboBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QCheckBox>
+#include <QDoubleSpinBox>
 
 // 前向声明
 class CameraControlDialog;
 class AudioPanel;
 
 #include "CameraDeviceInfo.h"
-#include "CameraUtils.h"
+#include "CaptureController.h"
+#include "BurstCapture.h"
+#include "DeviceMonitor.h"
+#include "DigitalZoom.h"
+#include "SoftwareAutoAdjust.h"
+#include <QImage>
 
 // 不需要前向声明，因为已经包含了头文件
 // class Ui_cam_qt;
@@ -37,33 +48,50 @@ private slots:
     void on_btnDetectCameras_clicked();
     void on_btnOpenCamera_clicked();
     void on_btnSetFormat_clicked();
-    void handleVideoFrame(const QVideoFrame &frame);
     void on_comboCamera_currentIndexChanged(int index);
     void on_comboResolution_currentIndexChanged(int index);
     void on_comboFormat_currentIndexChanged(int index);
     void updateFPSDisplay();
     void on_btnCameraControl_clicked();  // 打开摄像头控制面板
+    void on_btnMultiCamera_clicked();    // 打开多路预览窗口
     void on_btnRecordVideo_clicked();    // 开始/停止录制视频
     void handleRecordingStateChanged(QMediaRecorder::RecorderState state);
     void handleRecordingDurationChanged(qint64 duration);
     void handleRecordingError(QMediaRecorder::Error error, const QString &errorString);
+    void handlePipelineError(const QString &message);
+    void handleAudioCaptured(const QByteArray &pcm, int sampleRate, int channelCount);
+    void configurePreRoll();
+    void presentPreview();
+    void configureBurst();
+    void startBurst();
+    void handleBurstProgress(int captured, int saved, int total);
+    void handleBurstFinished(const QStringList &files, int dropped, int failed, qint64 elapsedMs);
+    void handleFormatChanged(const QCameraFormat &format);
+    void handleCamerasAdded(const QList<QCameraDevice> &devices);
+    void handleCamerasRemoved(const QList<QCameraDevice> &devices);
+    void handleAudioInputsChanged();
+    void handleReconnectTimeout();
+    
+protected:
+    // 窗口最小化、隐藏、被遮挡或失去焦点时调整预览节流
+    void changeEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    // 预览上的滚轮缩放、拖动平移和双击复位（数字变焦）
+    bool eventFilter(QObject *watched, QEvent *event) override;
     
 private:
     Ui_cam_qt* ui;
-    QCamera* camera;
-    QMediaCaptureSession captureSession;
-    QVideoSink* videoSink;
+    
+    // 采集控制器：摄像头、格式选择、帧总线、录制管线、预录和卡顿重启，界面只负责显示和操作
+    CaptureController* capture;
     void updateCameraList();
     void updateResolutionList();
     void stopCamera();
     QString formatToString(const QCameraFormat &format);
     
-    // FPS计算相关
-    QElapsedTimer fpsTimer;
-    int frameCount;
-    double currentFPS;
+    // 每秒刷新帧率、预录和帧总线统计
     QTimer* fpsUpdateTimer;
-    qint64 lastFrameTime;  // 用于精确计算帧率
     
     // 摄像头控制对话框
     CameraControlDialog* cameraControlDialog;
@@ -84,5 +112,84 @@ private:
     QString getDefaultSavePath();
     QTimer* recordingTimer;
     qint64 recordingDuration;
+    
+    // 原始帧/MJPEG直通录制的统计
+    QString recordingStatsText();
+    
+    // 预录缓存（在采集控制器中）：未录制时保留最近N秒的帧，开始录制时先写入文件
+    QSpinBox* spinPreRoll;
+    QLabel* labelPreRoll;
+    QSpinBox* spinSegmentMinutes;
+    QSpinBox* spinSegmentSizeMB;
+    void setupPreRollControls();
+    void updatePreRollStatus();
+    
+    // 连拍订阅采集控制器的帧总线，预览显示采集控制器中预览管线的结果
+    void setupFrameBus();
+    
+    // 预览不可见时不转换不绘制，失去焦点时降低预览帧率（节流在预览管线中）；采集和录制不受影响
+    QString previewSavingText;
+    void updatePreviewVisibility();
+    
+    // 预览质量：每帧耗时超出帧间隔预算时预览管线逐级降低缩放质量，有余量时恢复
+    QString previewQualityText() const;
+    
+    // 连拍：全分辨率帧拷贝到预分配的环形缓存，在线程池中编码保存
+    BurstCapture* burstCapture;
+    QSpinBox* spinBurstFrames;
+    QComboBox* comboBurstEncoding;
+    QPushButton* btnBurst;
+    void setupBurstControls();
+    
+    // 设备热插拔：当前摄像头断开后在宽限期内重新插入时只重建摄像头，录制管线、预录和帧总线不受影响
+    DeviceMonitor* deviceMonitor;
+    QByteArray activeCameraId;
+    QString activeCameraDescription;
+    QTimer* reconnectTimer;
+    int cameraComboIndex(const QByteArray &id) const;
+    void removeCameraComboEntry(const QByteArray &id);
+    
+    // 视频流看门狗（在采集控制器中）：卡顿期间预览保留最后一帧并显示提示
+    QSpinBox* spinStallIntervals;
+    void setupWatchdog();
+    
+    // 直方图叠加（画面分析器在采集控制器中，只在勾选或控制对话框打开时计算）
+    QCheckBox* checkHistogram;
+    void setupHistogramControls();
+    
+    // 对焦辅助：预览上的峰值对焦着色（由预览管线处理）和中央区域的清晰度
+    QCheckBox* checkFocusAssist;
+    void setupFocusAssistControls();
+    
+    // 软件自动曝光/白平衡：只接管设备没有硬件自动模式的参数，在GUI线程写参数
+    SoftwareAutoAdjust softwareAuto;
+    QCheckBox* checkSoftwareAuto;
+    void setupSoftwareAutoControls();
+    bool startSoftwareAuto(QString *error);
+    
+    // 数字变焦：预览管线只转换/解码放大区域，可选按同一区域录制
+    DigitalZoom digitalZoom;
+    QDoubleSpinBox* spinDigitalZoom;
+    QCheckBox* checkRecordCrop;
+    QRect previewImageRect;     // 最近一帧预览图在标签中的位置，用于换算鼠标坐标
+    QPoint zoomDragPos;
+    void setupDigitalZoomControls();
+    void updateDigitalZoom();
+    
+    // 镜头畸变校正：打开摄像头时按VID/PID（其他平台按设备名称）读取程序目录下的标定文件
+    QCheckBox* checkLensCorrection;
+    void setupLensCorrectionControls();
+    void loadLensCalibration(const QCameraDevice &device);
+    
+    // 时域降噪：预览管线在缩放后的图像上降噪，录制由采集控制器按同一强度降噪
+    QSpinBox* spinDenoise;
+    void setupDenoiseControls();
+    
+    // 移动触发录制：预录时长使用上面的预录设置，侦测期间不能手动录制
+    QCheckBox* checkMotionRecord;
+    QSpinBox* spinMotionSensitivity;
+    QSpinBox* spinMotionPostRoll;
+    void setupMotionRecordingControls();
+    void armMotionRecording(bool checked);
 }; 
 
@@ -1,11 +1,22 @@
 #include "cam_qt.h"
+#include "HeadlessCapture.h"
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QStyleFactory>
+#include <cstring>
 #pragma comment(lib, "user32.lib")
 
 int main(int argc, char *argv[])
 {
+    // 无界面模式：只创建QCoreApplication，不加载任何窗口控件和样式表
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            QCoreApplication app(argc, argv);
+            return runHeadless(app);
+        }
+    }
+
     QApplication a(argc, argv);
     
     // 设置应用程序样式为Fusion，更适合自定义样式
@@ -16,4 +27,4 @@ int main(int argc, char *argv[])
     w.show();
     
     return a.exec();
-}
\ No newline at end of file
+}
@@ -0,0 +1,175 @@
+// 软件图像调节性能测试：用测试图案帧测量单核和线程池并行的逐帧调节耗时，不需要摄像头
+// 用法示例：
+//   adjust_bench
+//   adjust_bench --format rgb32 --size 1280x720 --gamma 180
+//   adjust_bench --brightness 20 --contrast 140 --saturation 100 --budget 1
+//   adjust_bench --simd avx2
+// 分别测量线性调节（伽马100，定点运算）和--gamma指定的伽马（查表），并以整帧内存拷贝作为带宽基准；
+// --simd限制使用的指令集，用来比较同一台机器上各级实现的耗时。
+// 任一项线程池并行的平均耗时超过--budget（毫秒）时返回码为3
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "FrameConvert.h"
+#include "ImageAdjust.h"
+#include "SimdSupport.h"
+#include "TaskPool.h"
+#include "TestPatternSource.h"
+
+namespace {
+    struct FrameTimes {
+        double avgMs = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    FrameTimes summarize(std::vector<qint64> samplesUs)
+    {
+        FrameTimes times;
+        if (samplesUs.empty()) {
+            return times;
+        }
+        std::sort(samplesUs.begin(), samplesUs.end());
+        qint64 total = 0;
+        for (qint64 us : samplesUs) {
+            total += us;
+        }
+        times.avgMs = total / 1000.0 / samplesUs.size();
+        times.p99Ms = samplesUs[qMin(samplesUs.size() - 1, samplesUs.size() * 99 / 100)] / 1000.0;
+        times.maxMs = samplesUs.back() / 1000.0;
+        return times;
+    }
+
+    QString describe(const FrameTimes &times)
+    {
+        return QString("平均 %1 ms  p99 %2 ms  最大 %3 ms  （%4 FPS）")
+            .arg(times.avgMs, 0, 'f', 2).arg(times.p99Ms, 0, 'f', 2).arg(times.maxMs, 0, 'f', 2)
+            .arg(times.avgMs > 0 ? 1000.0 / times.avgMs : 0, 0, 'f', 0);
+    }
+
+    // 与录制写入线程相同的调用方式：每帧从原始帧开始，结果写入复用的buffer
+    FrameTimes measure(const ImageAdjust &adjust, const FramePacket &packet, int frames)
+    {
+        QByteArray buffer;
+        QElapsedTimer timer;
+        std::vector<qint64> samples;
+        samples.reserve(frames);
+        FramePacket input = packet;
+        adjust.apply(&input, &buffer);
+        for (int i = 0; i < frames; ++i) {
+            input = packet;
+            timer.restart();
+            adjust.apply(&input, &buffer);
+            samples.push_back(timer.nsecsElapsed() / 1000);
+        }
+        return summarize(samples);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("软件图像调节性能测试");
+    parser.addHelpOption();
+    parser.addOption({"format", "帧格式：yuyv 或 rgb32", "format", "yuyv"});
+    parser.addOption({"size", "分辨率，如 1920x1080", "size", "1920x1080"});
+    parser.addOption({"frames", "每项测量的帧数", "count", "300"});
+    parser.addOption({"brightness", "亮度（-100~100）", "value", "10"});
+    parser.addOption({"contrast", "对比度（0~200）", "value", "120"});
+    parser.addOption({"saturation", "饱和度（0~200）", "value", "130"});
+    parser.addOption({"gamma", "查表测量使用的伽马（20~300，不为100）", "value", "150"});
+    parser.addOption({"budget", "每帧耗时上限（毫秒）", "ms", "0.5"});
+    parser.addOption({"simd", "最高使用的指令集：scalar、sse2、avx2或avx512vbmi（默认为CPU支持的最高级别）", "level"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const QStringList parts = parser.value("size").split('x');
+    const QSize size = parts.size() == 2 ? QSize(parts[0].toInt(), parts[1].toInt()) : QSize();
+    const FramePixelFormat format = pixelFormatFromName(parser.value("format"));
+    if (!size.isValid() || size.isEmpty()) {
+        out << "无效的分辨率" << Qt::endl;
+        return 1;
+    }
+    if (format != FramePixelFormat::YUYV && format != FramePixelFormat::RGB32) {
+        out << "只支持yuyv和rgb32" << Qt::endl;
+        return 1;
+    }
+    if (parser.isSet("simd")) {
+        SimdLevel level;
+        if (!simdLevelFromName(parser.value("simd"), &level)) {
+            out << "无效的指令集：" << parser.value("simd") << Qt::endl;
+            return 1;
+        }
+        setSimdLevel(level);
+    }
+    const int frames = qMax(1, parser.value("frames").toInt());
+    const double budgetMs = parser.value("budget").toDouble();
+
+    // 测试图案（带噪声）作为输入；RGB32由YUYV转换得到
+    TestPatternSource source;
+    source.setFormat(FramePixelFormat::YUYV, size, 30);
+    source.setNoiseAmplitude(8);
+    FramePacket packet = source.generateFrame(0);
+    QImage rgbImage;
+    if (format == FramePixelFormat::RGB32) {
+        rgbImage = packetToImage(packet).convertToFormat(QImage::Format_RGB32);
+        packet.data = QByteArray(reinterpret_cast<const char*>(rgbImage.constBits()), rgbImage.sizeInBytes());
+        packet.format = FramePixelFormat::RGB32;
+        packet.bytesPerLine = int(rgbImage.bytesPerLine());
+        packet.owner.reset();
+    }
+    const qsizetype frameBytes = qsizetype(packet.bytesPerLine) * size.height();
+
+    ImageAdjustSettings settings;
+    settings.brightness = parser.value("brightness").toInt();
+    settings.contrast = parser.value("contrast").toInt();
+    settings.saturation = parser.value("saturation").toInt();
+    out << QString("%1 %2x%3  亮度 %4  对比度 %5  饱和度 %6  线程池 %7 线程  指令集 %8（CPU支持 %9）")
+               .arg(pixelFormatName(format)).arg(size.width()).arg(size.height())
+               .arg(settings.brightness).arg(settings.contrast).arg(settings.saturation)
+               .arg(TaskPool::shared()->threadCount())
+               .arg(simdLevelName(simdLevel())).arg(simdLevelName(detectedSimdLevel())) << Qt::endl;
+
+    // 内存拷贝作为带宽基准
+    const uchar *src = reinterpret_cast<const uchar*>(packet.data.constData());
+    std::vector<uchar> dst(frameBytes);
+    std::vector<qint64> samples;
+    samples.reserve(frames);
+    QElapsedTimer timer;
+    for (int i = 0; i < frames; ++i) {
+        timer.restart();
+        std::memcpy(dst.data(), src, frameBytes);
+        samples.push_back(timer.nsecsElapsed() / 1000);
+    }
+    out << "内存拷贝:         " << describe(summarize(samples)) << Qt::endl;
+
+    bool withinBudget = true;
+    for (const int gamma : {100, qBound(20, parser.value("gamma").toInt(), 300)}) {
+        settings.gamma = gamma;
+        ImageAdjust adjust;
+        adjust.setSettings(settings);
+        if (!adjust.isActive()) {
+            out << "设置为默认值，不需要调节" << Qt::endl;
+            return 1;
+        }
+        const QString label = gamma == 100 ? QString("线性（伽马100）") : QString("伽马%1（查表）").arg(gamma);
+        adjust.setParallel(false);
+        out << label << " 单核:   " << describe(measure(adjust, packet, frames)) << Qt::endl;
+        adjust.setParallel(true);
+        const FrameTimes parallel = measure(adjust, packet, frames);
+        const bool ok = parallel.avgMs <= budgetMs;
+        withinBudget = withinBudget && ok;
+        out << label << " 线程池: " << describe(parallel)
+            << QString("  %1 %2 ms预算").arg(ok ? "满足" : "超出").arg(budgetMs) << Qt::endl;
+        if (gamma == 100 && parser.value("gamma").toInt() == 100) {
+            break;
+        }
+    }
+    return withinBudget ? 0 : 3;
+}
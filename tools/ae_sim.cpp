@@ -0,0 +1,334 @@
+// 软件自动曝光/白平衡仿真：用模拟摄像头驱动SoftwareAutoAdjust，检查收敛时间、稳态误差和参数写入频率，不需要摄像头
+// 用法示例：
+//   ae_sim
+//   ae_sim --exposure linear --delay 4 --fps 60
+// 模拟摄像头按场景亮度、光源色温、曝光时间和白平衡设置渲染YUYV帧（线性传感器+2.2 gamma），参数写入后延迟若干帧生效。
+// 场景分四段，每段5秒：偏暗的日光（6500K）→ 亮度变为8倍 → 光源变为钨丝灯（3000K）→ 亮度降为1/20
+// 每段结束前亮度稳定在目标±25%、R/B稳定在0.9~1.1以内算收敛，全部收敛时返回0
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "CameraDeviceControl.h"
+#include "ExposureStats.h"
+#include "SoftwareAutoAdjust.h"
+
+namespace {
+    const int SCENE_WIDTH = 640;
+    const int SCENE_HEIGHT = 360;
+    const double SEGMENT_SECONDS = 5.0;
+    // 分析器计算曝光统计的间隔，与FrameAnalyzer一致
+    const qint64 STATS_INTERVAL_US = 100000;
+    // 亮度1、曝光1/64秒时18%反射率的灰卡正好是18%的线性输出
+    const double SENSOR_GAIN = 64.0;
+
+    struct SceneSegment {
+        double luminance;
+        double kelvin;
+        const char *name;
+    };
+
+    const SceneSegment SEGMENTS[] = {
+        {0.25, 6500, "偏暗日光"},
+        {2.0, 6500, "亮度x8"},
+        {2.0, 3000, "钨丝灯"},
+        {0.1, 3000, "亮度/20"}
+    };
+
+    // 光源和摄像头白平衡按色温相对6500K的比例改变R/B，设置等于光源色温时画面中性
+    double redFactor(double kelvin)
+    {
+        return std::pow(6500.0 / kelvin, 0.8);
+    }
+
+    double blueFactor(double kelvin)
+    {
+        return std::pow(kelvin / 6500.0, 0.8);
+    }
+
+    // 模拟摄像头：只支持曝光和白平衡（都没有硬件自动），写入的值在delayFrames帧之后生效
+    class SimulatedCamera : public CameraDeviceControl {
+    public:
+        SimulatedCamera(bool logExposure, int delayFrames)
+            : m_logExposure(logExposure), m_delayFrames(delayFrames), m_frame(0), m_writes(0)
+        {
+            if (m_logExposure) {
+                // DirectShow：log2秒，1/8192秒到1/2秒
+                m_exposureRange.minimum = -13;
+                m_exposureRange.maximum = -1;
+                m_exposureRange.defaultValue = -6;
+            } else {
+                // V4L2 exposure_absolute：100微秒为单位，最长1秒
+                m_exposureRange.minimum = 1;
+                m_exposureRange.maximum = 10000;
+                m_exposureRange.defaultValue = 156;
+            }
+            m_exposureRange.step = 1;
+            m_whiteBalanceRange.minimum = 2800;
+            m_whiteBalanceRange.maximum = 6500;
+            m_whiteBalanceRange.step = 10;
+            m_whiteBalanceRange.defaultValue = 4600;
+            m_exposure = m_appliedExposure = m_exposureRange.defaultValue;
+            m_whiteBalance = m_appliedWhiteBalance = m_whiteBalanceRange.defaultValue;
+        }
+
+        bool isSupported(CameraProperty property) const override
+        {
+            return property == CameraProperty::Exposure || property == CameraProperty::WhiteBalance;
+        }
+
+        bool range(CameraProperty property, CameraPropertyRange *range) const override
+        {
+            if (!isSupported(property)) {
+                return false;
+            }
+            *range = property == CameraProperty::Exposure ? m_exposureRange : m_whiteBalanceRange;
+            return true;
+        }
+
+        bool value(CameraProperty property, long *value, bool *autoMode) const override
+        {
+            if (!isSupported(property)) {
+                return false;
+            }
+            *value = property == CameraProperty::Exposure ? m_exposure : m_whiteBalance;
+            if (autoMode) {
+                *autoMode = false;
+            }
+            return true;
+        }
+
+        bool setValue(CameraProperty property, long value, bool autoMode) override
+        {
+            if (!isSupported(property) || autoMode) {
+                return false;
+            }
+            const CameraPropertyRange &range = property == CameraProperty::Exposure ? m_exposureRange : m_whiteBalanceRange;
+            if (value < range.minimum || value > range.maximum) {
+                return false;
+            }
+            (property == CameraProperty::Exposure ? m_exposure : m_whiteBalance) = value;
+            m_pending.push_back({m_frame + m_delayFrames, property, value});
+            m_writes++;
+            m_writeTimes.push_back(m_frame);
+            return true;
+        }
+
+        // 进入下一帧，到期的写入生效
+        void advance(quint64 frame)
+        {
+            m_frame = frame;
+            for (size_t i = 0; i < m_pending.size();) {
+                if (m_pending[i].frame <= frame) {
+                    (m_pending[i].property == CameraProperty::Exposure ? m_appliedExposure : m_appliedWhiteBalance) = m_pending[i].value;
+                    m_pending.erase(m_pending.begin() + i);
+                } else {
+                    ++i;
+                }
+            }
+        }
+
+        double exposureSeconds() const
+        {
+            return m_logExposure ? std::exp2(double(m_appliedExposure)) : m_appliedExposure * 0.0001;
+        }
+
+        long appliedWhiteBalance() const { return m_appliedWhiteBalance; }
+        long exposure() const { return m_exposure; }
+        int writes() const { return m_writes; }
+
+        // 任意1秒内的最大写入次数
+        int maxWritesPerSecond(double fps) const
+        {
+            int best = 0;
+            size_t first = 0;
+            for (size_t i = 0; i < m_writeTimes.size(); ++i) {
+                while (m_writeTimes[i] - m_writeTimes[first] >= fps) {
+                    first++;
+                }
+                best = qMax(best, int(i - first + 1));
+            }
+            return best;
+        }
+
+    private:
+        struct PendingWrite {
+            quint64 frame;
+            CameraProperty property;
+            long value;
+        };
+
+        bool m_logExposure;
+        int m_delayFrames;
+        quint64 m_frame;
+        CameraPropertyRange m_exposureRange;
+        CameraPropertyRange m_whiteBalanceRange;
+        long m_exposure;
+        long m_whiteBalance;
+        long m_appliedExposure;
+        long m_appliedWhiteBalance;
+        std::vector<PendingWrite> m_pending;
+        std::vector<quint64> m_writeTimes;
+        int m_writes;
+    };
+
+    // 场景：4x8的色块，大部分是不同反射率的灰，另有几块彩色
+    void patchReflectance(int x, int y, double *r, double *g, double *b)
+    {
+        const int column = x * 8 / SCENE_WIDTH;
+        const int row = y * 4 / SCENE_HEIGHT;
+        const int index = row * 8 + column;
+        const double grey = 0.03 + 0.87 * (index % 11) / 10.0;
+        *r = *g = *b = grey;
+        switch (index) {
+            case 5: *r = 0.6; *g = 0.15; *b = 0.1; break;
+            case 14: *r = 0.1; *g = 0.45; *b = 0.15; break;
+            case 23: *r = 0.1; *g = 0.2; *b = 0.55; break;
+            case 30: *r = 0.7; *g = 0.6; *b = 0.1; break;
+            default: break;
+        }
+    }
+
+    inline int encode(double linear)
+    {
+        return int(std::lround(255.0 * std::pow(qBound(0.0, linear, 1.0), 1.0 / 2.2)));
+    }
+
+    inline uchar limitedByte(double value)
+    {
+        return uchar(qBound(0L, std::lround(value), 255L));
+    }
+
+    // 按当前生效的参数渲染一帧YUYV（BT.601有限范围），带少量噪声
+    FramePacket renderFrame(const SimulatedCamera &camera, const SceneSegment &segment, quint64 index, double fps)
+    {
+        FramePacket packet;
+        packet.format = FramePixelFormat::YUYV;
+        packet.size = QSize(SCENE_WIDTH, SCENE_HEIGHT);
+        packet.bytesPerLine = SCENE_WIDTH * 2;
+        packet.sequence = index;
+        packet.captureUs = qint64(index * 1000000.0 / fps);
+        packet.ptsUs = packet.captureUs;
+        packet.data.resize(packet.bytesPerLine * SCENE_HEIGHT);
+
+        const double exposure = segment.luminance * camera.exposureSeconds() * SENSOR_GAIN;
+        const double gainR = redFactor(segment.kelvin) / redFactor(camera.appliedWhiteBalance());
+        const double gainB = blueFactor(segment.kelvin) / blueFactor(camera.appliedWhiteBalance());
+        quint32 seed = quint32(index * 2654435761u + 1);
+        uchar *data = reinterpret_cast<uchar*>(packet.data.data());
+        for (int y = 0; y < SCENE_HEIGHT; ++y) {
+            uchar *row = data + y * packet.bytesPerLine;
+            for (int x = 0; x < SCENE_WIDTH; x += 2) {
+                double reflectR, reflectG, reflectB;
+                patchReflectance(x, y, &reflectR, &reflectG, &reflectB);
+                seed = seed * 1664525u + 1013904223u;
+                const int noise = int(seed >> 29) - 4;
+                const int r = qBound(0, encode(reflectR * exposure * gainR) + noise, 255);
+                const int g = qBound(0, encode(reflectG * exposure) + noise, 255);
+                const int b = qBound(0, encode(reflectB * exposure * gainB) + noise, 255);
+                const double luma = 16 + (65.481 * r + 128.553 * g + 24.966 * b) / 255.0;
+                row[x * 2] = row[x * 2 + 2] = limitedByte(luma);
+                row[x * 2 + 1] = limitedByte(128 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255.0);
+                row[x * 2 + 3] = limitedByte(128 + (112.0 * r - 93.786 * g - 18.214 * b) / 255.0);
+            }
+        }
+        return packet;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("软件自动曝光/白平衡仿真");
+    parser.addHelpOption();
+    parser.addOption({"exposure", "曝光参数的单位：log2（DirectShow，log2秒）或 linear（100微秒）", "mode", "log2"});
+    parser.addOption({"fps", "帧率", "fps", "30"});
+    parser.addOption({"delay", "参数写入后生效的帧数", "frames", "3"});
+    parser.addOption({"verbose", "输出每次参数调整"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const bool logExposure = parser.value("exposure") != "linear";
+    const double fps = qMax(1.0, parser.value("fps").toDouble());
+    const int delay = qMax(0, parser.value("delay").toInt());
+
+    std::shared_ptr<SimulatedCamera> camera = std::make_shared<SimulatedCamera>(logExposure, delay);
+    SoftwareAutoAdjust autoAdjust;
+    QString error;
+    if (!autoAdjust.start(camera, true, true, &error)) {
+        out << "无法启动: " << error << Qt::endl;
+        return 1;
+    }
+    const SoftwareAutoAdjust::Settings settings = autoAdjust.settings();
+
+    const int segmentCount = int(sizeof(SEGMENTS) / sizeof(SEGMENTS[0]));
+    const quint64 framesPerSegment = quint64(SEGMENT_SECONDS * fps);
+    bool allConverged = true;
+    qint64 totalStatsUs = 0;
+    int statsCount = 0;
+    qint64 lastStatsUs = -STATS_INTERVAL_US;
+
+    out << QString("曝光单位: %1  帧率: %2  生效延迟: %3 帧").arg(logExposure ? "log2秒" : "100微秒").arg(fps).arg(delay) << Qt::endl;
+    for (int s = 0; s < segmentCount; ++s) {
+        const SceneSegment &segment = SEGMENTS[s];
+        qint64 lastUnsettledUs = -1;
+        ExposureStats last;
+        const quint64 firstFrame = quint64(s) * framesPerSegment;
+        const qint64 segmentStartUs = qint64(firstFrame * 1000000.0 / fps);
+        for (quint64 i = firstFrame; i < firstFrame + framesPerSegment; ++i) {
+            camera->advance(i);
+            const FramePacket packet = renderFrame(*camera, segment, i, fps);
+            if (packet.captureUs - lastStatsUs < STATS_INTERVAL_US) {
+                continue;
+            }
+            lastStatsUs = packet.captureUs;
+            ExposureStats stats;
+            if (!computeExposureStats(packet, &stats)) {
+                continue;
+            }
+            totalStatsUs += stats.computeUs;
+            statsCount++;
+            last = stats;
+
+            const double redBlue = stats.meanBlue > 0 ? stats.meanRed / stats.meanBlue : 0;
+            const bool settled = std::abs(stats.meanLuma / settings.targetLuma - 1.0) <= 0.25 &&
+                                 redBlue >= 0.9 && redBlue <= 1.1;
+            if (!settled) {
+                lastUnsettledUs = packet.captureUs;
+            }
+            for (const AutoAdjustStep &step : autoAdjust.update(stats)) {
+                if (parser.isSet("verbose")) {
+                    out << QString("  %1 s  %2: %3 -> %4（%5 %6）")
+                               .arg(packet.captureUs / 1000000.0, 0, 'f', 2)
+                               .arg(CameraDeviceControl::propertyName(step.property))
+                               .arg(step.from).arg(step.to)
+                               .arg(step.property == CameraProperty::Exposure ? "亮度" : "R/B")
+                               .arg(step.measured, 0, 'f', 2) << Qt::endl;
+                }
+            }
+        }
+
+        const qint64 segmentEndUs = qint64((firstFrame + framesPerSegment) * 1000000.0 / fps);
+        const bool converged = lastUnsettledUs < segmentEndUs - STATS_INTERVAL_US * 5;
+        allConverged = allConverged && converged;
+        const QString convergence = converged
+            ? QString("%1 s").arg(qMax<qint64>(0, lastUnsettledUs - segmentStartUs) / 1000000.0, 0, 'f', 2)
+            : QString("未收敛");
+        out << QString("%1（亮度 %2，%3K）: 收敛 %4  结束时亮度 %5  R/B %6  曝光 %7  白平衡 %8")
+                   .arg(segment.name).arg(segment.luminance).arg(segment.kelvin)
+                   .arg(convergence)
+                   .arg(last.meanLuma, 0, 'f', 1)
+                   .arg(last.meanBlue > 0 ? last.meanRed / last.meanBlue : 0, 0, 'f', 3)
+                   .arg(camera->exposure()).arg(camera->appliedWhiteBalance()) << Qt::endl;
+    }
+
+    out << QString("参数写入 %1 次，任意1秒内最多 %2 次；统计平均耗时 %3 us")
+               .arg(camera->writes()).arg(camera->maxWritesPerSecond(fps))
+               .arg(statsCount > 0 ? totalStatsUs / statsCount : 0) << Qt::endl;
+    out << (allConverged ? "全部收敛" : "存在未收敛的场景") << Qt::endl;
+    return allConverged ? 0 : 1;
+}
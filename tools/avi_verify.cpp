@@ -0,0 +1,229 @@
+// MJPEG AVI录制文件校验工具
+// 检查movi中的帧数、JPEG完整性、idx1索引与数据块是否一致，并根据 .pts 索引检查时间戳
+// 用法：avi_verify <file.avi> [--fps 30]
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QtEndian>
+#include <QList>
+#include <QPair>
+#include <algorithm>
+
+namespace {
+    struct ChunkHeader {
+        QByteArray fourcc;
+        quint32 size = 0;
+    };
+
+    bool readChunkHeader(QFile &file, ChunkHeader &header)
+    {
+        const QByteArray bytes = file.read(8);
+        if (bytes.size() != 8) {
+            return false;
+        }
+        header.fourcc = bytes.left(4);
+        header.size = qFromLittleEndian<quint32>(bytes.constData() + 4);
+        return true;
+    }
+
+    // 检查JPEG数据的SOI/EOI标记（EOI之后允许少量填充字节）
+    bool checkJpeg(QFile &file, qint64 offset, quint32 size)
+    {
+        if (size < 4) {
+            return false;
+        }
+        file.seek(offset);
+        const QByteArray head = file.read(2);
+        const int tailLength = int(qMin<quint32>(size, 16));
+        file.seek(offset + size - tailLength);
+        const QByteArray tail = file.read(tailLength);
+        return head == QByteArray("\xFF\xD8", 2) && tail.contains(QByteArray("\xFF\xD9", 2));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("校验MJPEG AVI录制文件");
+    parser.addHelpOption();
+    parser.addOption({"fps", "名义帧率（默认取文件头中的帧间隔）", "fps"});
+    parser.addPositionalArgument("file", "AVI文件");
+    parser.process(app);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    const QString path = parser.positionalArguments().first();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "无法打开文件: " << file.errorString() << Qt::endl;
+        return 1;
+    }
+
+    int errors = 0;
+    ChunkHeader riff;
+    const QByteArray riffType = (readChunkHeader(file, riff) && riff.fourcc == "RIFF") ? file.read(4) : QByteArray();
+    if (riffType != "AVI ") {
+        out << "不是AVI文件" << Qt::endl;
+        return 1;
+    }
+    if (qint64(riff.size) + 8 != file.size()) {
+        out << "错误: RIFF大小 " << riff.size + 8 << " 与文件大小 " << file.size() << " 不一致" << Qt::endl;
+        errors++;
+    }
+
+    quint32 usPerFrame = 0;
+    quint32 totalFrames = 0;
+    qint64 moviFourccPos = -1;
+    QList<QPair<qint64, quint32>> frames;      // 数据块偏移（块头位置）和大小
+    QList<QPair<quint32, quint32>> indexEntries;
+    int badJpeg = 0;
+
+    while (file.pos() + 8 <= file.size()) {
+        ChunkHeader chunk;
+        if (!readChunkHeader(file, chunk)) {
+            break;
+        }
+        const qint64 dataPos = file.pos();
+        const qint64 next = dataPos + chunk.size + (chunk.size & 1);
+
+        if (chunk.fourcc == "LIST") {
+            const QByteArray listType = file.read(4);
+            if (listType == "hdrl") {
+                ChunkHeader avih;
+                if (readChunkHeader(file, avih) && avih.fourcc == "avih") {
+                    const QByteArray body = file.read(avih.size);
+                    usPerFrame = qFromLittleEndian<quint32>(body.constData());
+                    totalFrames = qFromLittleEndian<quint32>(body.constData() + 16);
+                }
+            } else if (listType == "movi") {
+                moviFourccPos = dataPos;
+                while (file.pos() + 8 <= next) {
+                    ChunkHeader frame;
+                    const qint64 framePos = file.pos();
+                    if (!readChunkHeader(file, frame)) {
+                        break;
+                    }
+                    if (frame.fourcc == "00dc" || frame.fourcc == "00db") {
+                        frames.append(qMakePair(framePos, frame.size));
+                        if (!checkJpeg(file, framePos + 8, frame.size)) {
+                            badJpeg++;
+                        }
+                    }
+                    file.seek(framePos + 8 + frame.size + (frame.size & 1));
+                }
+            }
+        } else if (chunk.fourcc == "idx1") {
+            const QByteArray body = file.read(chunk.size);
+            for (int i = 0; i + 16 <= body.size(); i += 16) {
+                if (body.mid(i, 2) != "00") {
+                    continue;
+                }
+                indexEntries.append(qMakePair(qFromLittleEndian<quint32>(body.constData() + i + 8),
+                                              qFromLittleEndian<quint32>(body.constData() + i + 12)));
+            }
+        }
+        file.seek(next);
+    }
+
+    out << "文件: " << path << Qt::endl;
+    out << "movi帧数: " << frames.size() << "  文件头帧数: " << totalFrames
+        << "  idx1条目: " << indexEntries.size() << Qt::endl;
+
+    if (quint32(frames.size()) != totalFrames) {
+        out << "错误: 文件头帧数与实际帧数不一致" << Qt::endl;
+        errors++;
+    }
+    if (badJpeg > 0) {
+        out << "错误: " << badJpeg << " 帧缺少JPEG SOI/EOI标记" << Qt::endl;
+        errors++;
+    }
+    if (indexEntries.size() != frames.size()) {
+        out << "错误: idx1条目数与实际帧数不一致" << Qt::endl;
+        errors++;
+    } else {
+        // idx1偏移可能相对'movi'或文件起始，两种约定都接受
+        int mismatched = 0;
+        for (int i = 0; i < frames.size(); ++i) {
+            const qint64 relative = frames[i].first - moviFourccPos;
+            const bool offsetOk = indexEntries[i].first == quint32(relative) ||
+                                  indexEntries[i].first == quint32(frames[i].first);
+            if (!offsetOk || indexEntries[i].second != frames[i].second) {
+                mismatched++;
+            }
+        }
+        if (mismatched > 0) {
+            out << "错误: " << mismatched << " 条idx1索引与数据块不一致" << Qt::endl;
+            errors++;
+        }
+    }
+
+    // 时间戳检查
+    double nominalUs = usPerFrame;
+    if (parser.isSet("fps") && parser.value("fps").toDouble() > 0) {
+        nominalUs = 1000000.0 / parser.value("fps").toDouble();
+    }
+
+    QFile ptsFile(path + ".pts");
+    if (!ptsFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        out << "未找到时间戳索引 " << ptsFile.fileName() << "，跳过时间戳检查" << Qt::endl;
+    } else {
+        QList<qint64> pts;
+        while (!ptsFile.atEnd()) {
+            const QByteArray line = ptsFile.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            const QList<QByteArray> fields = line.split(' ');
+            if (fields.size() >= 2) {
+                pts.append(fields[1].toLongLong());
+            }
+        }
+
+        out << "时间戳条目: " << pts.size() << Qt::endl;
+        if (pts.size() != frames.size()) {
+            out << "错误: 时间戳条目数与帧数不一致" << Qt::endl;
+            errors++;
+        }
+
+        int nonMonotonic = 0;
+        int gaps = 0;
+        QList<qint64> intervals;
+        for (int i = 1; i < pts.size(); ++i) {
+            const qint64 interval = pts[i] - pts[i - 1];
+            if (interval <= 0) {
+                nonMonotonic++;
+            }
+            if (nominalUs > 0 && interval > nominalUs * 1.5) {
+                gaps++;
+            }
+            intervals.append(interval);
+        }
+        if (!intervals.isEmpty()) {
+            std::sort(intervals.begin(), intervals.end());
+            const double duration = double(pts.last() - pts.first()) / 1000000.0;
+            out << QString("时长: %1 s  平均帧率: %2 FPS")
+                       .arg(duration, 0, 'f', 3)
+                       .arg(duration > 0 ? (pts.size() - 1) / duration : 0.0, 0, 'f', 2) << Qt::endl;
+            out << QString("帧间隔(ms) 最小/中位/最大: %1 / %2 / %3")
+                       .arg(intervals.first() / 1000.0, 0, 'f', 2)
+                       .arg(intervals[intervals.size() / 2] / 1000.0, 0, 'f', 2)
+                       .arg(intervals.last() / 1000.0, 0, 'f', 2) << Qt::endl;
+        }
+        if (nonMonotonic > 0) {
+            out << "错误: " << nonMonotonic << " 处时间戳不递增" << Qt::endl;
+            errors++;
+        }
+        if (gaps > 0) {
+            out << "警告: " << gaps << " 处帧间隔超过名义间隔的1.5倍（可能丢帧）" << Qt::endl;
+        }
+    }
+
+    out << (errors == 0 ? "校验通过" : "校验失败") << Qt::endl;
+    return errors == 0 ? 0 : 1;
+}
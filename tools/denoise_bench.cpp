@@ -0,0 +1,445 @@
+// 时域降噪的画质和吞吐量测试：回放录制的原始帧文件（.raw和同名.pts索引），或用带噪声的测试图案，不需要摄像头
+// 用法示例：
+//   denoise_bench --input lowlight.raw --strength 60
+//   denoise_bench --input lowlight.raw --strength 100 --output denoised.raw
+//   denoise_bench --size 1920x1080 --noise 16 --frames 120
+// 画质：按16x16的块把画面分为静止和移动区域（块的帧间亮度差超过中位数的2倍加2级为移动），
+// 静止区域比较降噪前后的帧间亮度差（噪声闪烁），移动区域统计输出与当前输入的差（拖影）；
+// 测试图案另有无噪声的原图，输出降噪前后的亮度PSNR。
+// 吞吐量：单核与线程池并行的逐帧耗时，单核平均耗时超过帧间隔（即单核达不到--fps）时返回码为3
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "FrameConvert.h"
+#include "PtsIndexWriter.h"
+#include "RawFileSink.h"
+#include "TaskPool.h"
+#include "TemporalDenoise.h"
+#include "TestPatternSource.h"
+
+namespace {
+    const int QUALITY_BLOCK_SIZE = 16;
+
+    // 原始帧文件：数据按顺序存放，.pts索引的每行为"<序号> <pts微秒> <偏移> <字节数>"
+    struct RawClip {
+        struct Entry {
+            quint64 sequence = 0;
+            qint64 ptsUs = 0;
+            qint64 offset = 0;
+            qint64 size = 0;
+        };
+
+        QFile data;
+        FramePixelFormat format = FramePixelFormat::Unknown;
+        QSize size;
+        int bytesPerLine = 0;
+        QList<Entry> entries;
+    };
+
+    bool openClip(const QString &path, RawClip *clip, QString *error)
+    {
+        QFile index(PtsIndexWriter::indexPathFor(path));
+        if (!index.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            *error = "无法打开时间戳索引 " + index.fileName();
+            return false;
+        }
+        while (!index.atEnd()) {
+            const QByteArray line = index.readLine().trimmed();
+            if (line.startsWith('#')) {
+                // # format=YUYV width=1920 height=1080 bytesPerLine=3840
+                for (const QByteArray &field : line.mid(1).trimmed().split(' ')) {
+                    const QList<QByteArray> pair = field.split('=');
+                    if (pair.size() != 2) {
+                        continue;
+                    }
+                    if (pair[0] == "format") {
+                        clip->format = pixelFormatFromName(QString::fromLatin1(pair[1]));
+                    } else if (pair[0] == "width") {
+                        clip->size.setWidth(pair[1].toInt());
+                    } else if (pair[0] == "height") {
+                        clip->size.setHeight(pair[1].toInt());
+                    } else if (pair[0] == "bytesPerLine") {
+                        clip->bytesPerLine = pair[1].toInt();
+                    }
+                }
+                continue;
+            }
+            const QList<QByteArray> fields = line.split(' ');
+            if (fields.size() < 4) {
+                continue;
+            }
+            RawClip::Entry entry;
+            entry.sequence = fields[0].toULongLong();
+            entry.ptsUs = fields[1].toLongLong();
+            entry.offset = fields[2].toLongLong();
+            entry.size = fields[3].toLongLong();
+            clip->entries.append(entry);
+        }
+        if (clip->size.isEmpty() || clip->entries.isEmpty()) {
+            *error = "时间戳索引中没有帧格式或帧: " + index.fileName();
+            return false;
+        }
+        if (clip->format != FramePixelFormat::YUYV && clip->format != FramePixelFormat::RGB32 &&
+            clip->format != FramePixelFormat::MJPEG) {
+            *error = "只支持YUYV、RGB32和MJPEG的原始帧文件";
+            return false;
+        }
+        clip->data.setFileName(path);
+        if (!clip->data.open(QIODevice::ReadOnly)) {
+            *error = clip->data.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    // 读取第index帧，MJPEG解码为RGB32（解码不计入降噪耗时）
+    bool readClipFrame(RawClip *clip, int index, FramePacket *packet)
+    {
+        const RawClip::Entry &entry = clip->entries.at(index);
+        if (!clip->data.seek(entry.offset)) {
+            return false;
+        }
+        *packet = FramePacket();
+        packet->data = clip->data.read(entry.size);
+        if (packet->data.size() != entry.size) {
+            return false;
+        }
+        packet->format = clip->format;
+        packet->size = clip->size;
+        packet->bytesPerLine = clip->bytesPerLine;
+        packet->sequence = entry.sequence;
+        packet->ptsUs = entry.ptsUs;
+        // 采集时间按pts换算，降噪据此判断画面是否连续
+        packet->captureUs = entry.ptsUs - clip->entries.first().ptsUs + 1;
+        if (packet->format == FramePixelFormat::MJPEG) {
+            const QImage image = packetToImage(*packet).convertToFormat(QImage::Format_RGB32);
+            if (image.isNull()) {
+                return false;
+            }
+            packet->data = QByteArray(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
+            packet->format = FramePixelFormat::RGB32;
+            packet->size = image.size();
+            packet->bytesPerLine = int(image.bytesPerLine());
+        }
+        return true;
+    }
+
+    // 整帧亮度平面
+    std::vector<quint8> extractLuma(const FramePacket &packet)
+    {
+        const int width = packet.size.width();
+        const int height = packet.size.height();
+        std::vector<quint8> luma(size_t(width) * height);
+        const uchar *data = reinterpret_cast<const uchar*>(packet.data.constData());
+        for (int y = 0; y < height; ++y) {
+            const uchar *row = data + qsizetype(y) * packet.bytesPerLine;
+            quint8 *out = luma.data() + size_t(y) * width;
+            for (int x = 0; x < width; ++x) {
+                if (packet.format == FramePixelFormat::YUYV) {
+                    out[x] = row[x * 2];
+                } else {
+                    const uchar *p = row + x * 4;
+                    out[x] = quint8((29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8);
+                }
+            }
+        }
+        return luma;
+    }
+
+    struct QualityStats {
+        double staticInput = 0;     // 静止区域降噪前的帧间亮度差之和
+        double staticOutput = 0;
+        quint64 staticPixels = 0;
+        double movingLag = 0;       // 移动区域输出与当前输入的亮度差之和
+        double movingInput = 0;     // 移动区域降噪前的帧间亮度差之和
+        quint64 movingPixels = 0;
+        double inputSquaredError = 0;   // 测试图案：与无噪声原图的平方误差
+        double outputSquaredError = 0;
+        quint64 referencePixels = 0;
+        double noiseLevelSum = 0;
+        int frames = 0;
+    };
+
+    void accumulateQuality(const std::vector<quint8> &input, const std::vector<quint8> &previousInput,
+                           const std::vector<quint8> &output, const std::vector<quint8> &previousOutput,
+                           const QSize &size, QualityStats *stats)
+    {
+        const int blocksX = size.width() / QUALITY_BLOCK_SIZE;
+        const int blocksY = size.height() / QUALITY_BLOCK_SIZE;
+        if (blocksX == 0 || blocksY == 0) {
+            return;
+        }
+        const int blockPixels = QUALITY_BLOCK_SIZE * QUALITY_BLOCK_SIZE;
+        std::vector<double> blockChange(size_t(blocksX) * blocksY);
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                int sum = 0;
+                for (int y = by * QUALITY_BLOCK_SIZE; y < (by + 1) * QUALITY_BLOCK_SIZE; ++y) {
+                    const size_t row = size_t(y) * size.width();
+                    for (int x = bx * QUALITY_BLOCK_SIZE; x < (bx + 1) * QUALITY_BLOCK_SIZE; ++x) {
+                        sum += std::abs(int(input[row + x]) - int(previousInput[row + x]));
+                    }
+                }
+                blockChange[size_t(by) * blocksX + bx] = double(sum) / blockPixels;
+            }
+        }
+        std::vector<double> sorted = blockChange;
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        const double movingThreshold = sorted[sorted.size() / 2] * 2.0 + 2.0;
+
+        for (int by = 0; by < blocksY; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                const bool moving = blockChange[size_t(by) * blocksX + bx] > movingThreshold;
+                for (int y = by * QUALITY_BLOCK_SIZE; y < (by + 1) * QUALITY_BLOCK_SIZE; ++y) {
+                    const size_t row = size_t(y) * size.width();
+                    for (int x = bx * QUALITY_BLOCK_SIZE; x < (bx + 1) * QUALITY_BLOCK_SIZE; ++x) {
+                        const size_t i = row + x;
+                        if (moving) {
+                            stats->movingLag += std::abs(int(output[i]) - int(input[i]));
+                            stats->movingInput += std::abs(int(input[i]) - int(previousInput[i]));
+                        } else {
+                            stats->staticInput += std::abs(int(input[i]) - int(previousInput[i]));
+                            stats->staticOutput += std::abs(int(output[i]) - int(previousOutput[i]));
+                        }
+                    }
+                }
+                if (moving) {
+                    stats->movingPixels += blockPixels;
+                } else {
+                    stats->staticPixels += blockPixels;
+                }
+            }
+        }
+    }
+
+    void accumulateReference(const std::vector<quint8> &input, const std::vector<quint8> &output,
+                             const std::vector<quint8> &reference, QualityStats *stats)
+    {
+        for (size_t i = 0; i < reference.size(); ++i) {
+            const double inputError = double(input[i]) - reference[i];
+            const double outputError = double(output[i]) - reference[i];
+            stats->inputSquaredError += inputError * inputError;
+            stats->outputSquaredError += outputError * outputError;
+        }
+        stats->referencePixels += reference.size();
+    }
+
+    double psnr(double squaredError, quint64 pixels)
+    {
+        if (pixels == 0 || squaredError <= 0) {
+            return 99.0;
+        }
+        return 10.0 * std::log10(255.0 * 255.0 / (squaredError / pixels));
+    }
+
+    struct FrameTimes {
+        double avgMs = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    FrameTimes summarize(std::vector<qint64> samplesUs)
+    {
+        FrameTimes times;
+        if (samplesUs.empty()) {
+            return times;
+        }
+        std::sort(samplesUs.begin(), samplesUs.end());
+        qint64 total = 0;
+        for (qint64 us : samplesUs) {
+            total += us;
+        }
+        times.avgMs = total / 1000.0 / samplesUs.size();
+        times.p99Ms = samplesUs[qMin(samplesUs.size() - 1, samplesUs.size() * 99 / 100)] / 1000.0;
+        times.maxMs = samplesUs.back() / 1000.0;
+        return times;
+    }
+
+    QString describe(const FrameTimes &times)
+    {
+        return QString("平均 %1 ms  p99 %2 ms  最大 %3 ms  （%4 FPS）")
+            .arg(times.avgMs, 0, 'f', 2).arg(times.p99Ms, 0, 'f', 2).arg(times.maxMs, 0, 'f', 2)
+            .arg(times.avgMs > 0 ? 1000.0 / times.avgMs : 0, 0, 'f', 0);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("时域降噪画质和吞吐量测试");
+    parser.addHelpOption();
+    parser.addOption({"input", "回放的原始帧文件（.raw，需要同名.pts索引），不指定时使用带噪声的测试图案", "path"});
+    parser.addOption({"strength", "降噪强度（1~100）", "value", "50"});
+    parser.addOption({"frames", "最多处理的帧数，0表示整个文件", "count", "0"});
+    parser.addOption({"fps", "要求单核达到的帧率", "fps", "30"});
+    parser.addOption({"output", "把降噪后的帧写入原始帧文件，便于逐帧查看", "path"});
+    parser.addOption({"size", "测试图案的分辨率", "size", "1920x1080"});
+    parser.addOption({"noise", "测试图案的噪声幅度（0~64）", "amplitude", "16"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const int strength = qBound(1, parser.value("strength").toInt(), 100);
+    const double fps = qMax(1.0, parser.value("fps").toDouble());
+
+    // 帧源：回放文件，或同一组测试图案的带噪声和无噪声版本
+    RawClip clip;
+    TestPatternSource noisySource;
+    TestPatternSource cleanSource;
+    const bool synthetic = !parser.isSet("input");
+    int frames = parser.value("frames").toInt();
+    if (synthetic) {
+        const QStringList parts = parser.value("size").split('x');
+        const QSize size = parts.size() == 2 ? QSize(parts[0].toInt(), parts[1].toInt()) : QSize();
+        if (!size.isValid() || size.isEmpty()) {
+            out << "无效的分辨率" << Qt::endl;
+            return 1;
+        }
+        noisySource.setFormat(FramePixelFormat::YUYV, size, fps);
+        noisySource.setNoiseAmplitude(parser.value("noise").toInt());
+        cleanSource.setFormat(FramePixelFormat::YUYV, size, fps);
+        if (frames <= 0) {
+            frames = 120;
+        }
+        out << QString("测试图案 YUYV %1x%2，噪声幅度 %3").arg(size.width()).arg(size.height())
+                   .arg(parser.value("noise")) << Qt::endl;
+    } else {
+        QString error;
+        if (!openClip(parser.value("input"), &clip, &error)) {
+            out << error << Qt::endl;
+            return 1;
+        }
+        frames = frames > 0 ? qMin(frames, int(clip.entries.size())) : int(clip.entries.size());
+        out << QString("%1 %2 %3x%4，%5 帧").arg(parser.value("input")).arg(pixelFormatName(clip.format))
+                   .arg(clip.size.width()).arg(clip.size.height()).arg(frames) << Qt::endl;
+    }
+    const qint64 frameIntervalUs = qint64(1000000.0 / fps);
+    auto readFrame = [&](int index, FramePacket *packet, FramePacket *reference) {
+        if (synthetic) {
+            *packet = noisySource.generateFrame(quint64(index));
+            *reference = cleanSource.generateFrame(quint64(index));
+            packet->captureUs = 1 + index * frameIntervalUs;
+            return true;
+        }
+        return readClipFrame(&clip, index, packet);
+    };
+
+    RawFileSink *sink = nullptr;
+    if (parser.isSet("output")) {
+        sink = new RawFileSink(parser.value("output"));
+        if (!sink->open()) {
+            out << "无法创建输出文件: " << sink->errorString() << Qt::endl;
+            delete sink;
+            return 1;
+        }
+    }
+
+    // 第一遍单核：测量耗时并统计画质（单核和并行的输出逐字节相同）
+    TemporalDenoise denoise;
+    denoise.setStrength(strength);
+    denoise.setParallel(false);
+    QByteArray buffer;
+    QualityStats quality;
+    std::vector<qint64> samples;
+    std::vector<quint8> previousInput;
+    std::vector<quint8> previousOutput;
+    QElapsedTimer timer;
+    for (int i = 0; i < frames; ++i) {
+        FramePacket packet;
+        FramePacket reference;
+        if (!readFrame(i, &packet, &reference)) {
+            out << "读取第 " << i << " 帧失败" << Qt::endl;
+            break;
+        }
+        const std::vector<quint8> input = extractLuma(packet);
+        timer.restart();
+        const bool denoised = denoise.apply(&packet, &buffer);
+        const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+        const std::vector<quint8> output = extractLuma(packet);
+        // 第一帧只建立历史
+        if (denoised) {
+            samples.push_back(elapsedUs);
+            quality.noiseLevelSum += denoise.noiseLevel();
+            quality.frames++;
+            accumulateQuality(input, previousInput, output, previousOutput, packet.size, &quality);
+            if (synthetic) {
+                accumulateReference(input, output, extractLuma(reference), &quality);
+            }
+        }
+        if (sink && !sink->writeFrame(packet)) {
+            out << "写入输出文件失败: " << sink->errorString() << Qt::endl;
+            delete sink;
+            sink = nullptr;
+        }
+        previousInput = input;
+        previousOutput = output;
+    }
+    if (sink) {
+        sink->close();
+        delete sink;
+    }
+    if (quality.frames == 0) {
+        out << "帧数不足，至少需要2帧" << Qt::endl;
+        return 1;
+    }
+    const FrameTimes single = summarize(samples);
+
+    // 第二遍线程池并行：与预览和录制相同的调用路径，只测量耗时（先读入内存，不计读文件的时间）
+    const int parallelFrames = qMin(frames, 60);
+    QList<FramePacket> packets;
+    for (int i = 0; i < parallelFrames; ++i) {
+        FramePacket packet;
+        FramePacket reference;
+        if (!readFrame(i, &packet, &reference)) {
+            break;
+        }
+        packets.append(packet);
+    }
+    TemporalDenoise parallel;
+    parallel.setStrength(strength);
+    samples.clear();
+    for (const FramePacket &source : packets) {
+        FramePacket packet = source;
+        timer.restart();
+        if (parallel.apply(&packet, &buffer)) {
+            samples.push_back(timer.nsecsElapsed() / 1000);
+        }
+    }
+
+    out << QString("强度 %1，噪声水平平均 %2（帧间亮度差中位数）")
+               .arg(strength).arg(quality.noiseLevelSum / quality.frames, 0, 'f', 1) << Qt::endl;
+    if (quality.staticPixels > 0) {
+        const double input = quality.staticInput / quality.staticPixels;
+        const double output = quality.staticOutput / quality.staticPixels;
+        out << QString("静止区域帧间亮度差: %1 -> %2（闪烁降低 %3%）")
+                   .arg(input, 0, 'f', 2).arg(output, 0, 'f', 2)
+                   .arg(input > 0 ? (1.0 - output / input) * 100.0 : 0, 0, 'f', 0) << Qt::endl;
+    }
+    if (quality.movingPixels > 0) {
+        out << QString("移动区域（%1%）: 输出与当前输入平均相差 %2，输入帧间平均变化 %3")
+                   .arg(quality.movingPixels * 100.0 / (quality.movingPixels + quality.staticPixels), 0, 'f', 1)
+                   .arg(quality.movingLag / quality.movingPixels, 0, 'f', 2)
+                   .arg(quality.movingInput / quality.movingPixels, 0, 'f', 2) << Qt::endl;
+    }
+    if (quality.referencePixels > 0) {
+        out << QString("亮度PSNR: 降噪前 %1 dB，降噪后 %2 dB")
+                   .arg(psnr(quality.inputSquaredError, quality.referencePixels), 0, 'f', 2)
+                   .arg(psnr(quality.outputSquaredError, quality.referencePixels), 0, 'f', 2) << Qt::endl;
+    }
+    out << "单核降噪:   " << describe(single) << Qt::endl;
+    out << QString("线程池降噪: %1（%2 线程）").arg(describe(summarize(samples)))
+               .arg(TaskPool::shared()->threadCount()) << Qt::endl;
+
+    const double budgetMs = 1000.0 / fps;
+    const bool sustained = single.avgMs <= budgetMs;
+    out << QString("单核%1 %2 FPS（帧间隔 %3 ms，单核占用 %4%）")
+               .arg(sustained ? "可以达到" : "达不到").arg(fps)
+               .arg(budgetMs, 0, 'f', 2).arg(single.avgMs / budgetMs * 100.0, 0, 'f', 0) << Qt::endl;
+    return sustained ? 0 : 3;
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env bash
+# 构建耗时测量：先构建拆分camera_core之前的版本作为基准，再分别以"不加速"、"预编译头"、
+# "预编译头+合并编译"三种配置构建当前版本，测量完整构建和修改单个文件后的增量构建时间，
+# 输出一张对比表，同时写入构建根目录下的build_times.txt。
+#
+# 用法: tools/measure_build.sh [构建根目录] [额外的cmake参数...]
+# 例如: tools/measure_build.sh /c/build_time -G "MinGW Makefiles"
+# 基准版本的CMakeLists.txt写死了Windows下的Qt路径，Qt的位置要用环境变量CMAKE_PREFIX_PATH或Qt6_DIR指定；
+# 它无条件链接DirectShow/SetupAPI并包含<Windows.h>，只能在Windows上构建，其他系统上基准行记为"构建失败"，
+# 其余三种配置照常测量。
+# BASELINE_REF可以指定其他基准版本，默认为引入CameraDeviceControl（拆分主窗口）之前的提交。
+set -euo pipefail
+
+SOURCE_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+BUILD_ROOT="${1:-$SOURCE_DIR/_build_time}"
+shift || true
+JOBS="$(nproc 2>/dev/null || echo 4)"
+BASELINE_REF="${BASELINE_REF:-$(git -C "$SOURCE_DIR" log --diff-filter=A --format=%H -- src/CameraDeviceControl.h | tail -n 1)^}"
+RESULT_FILE="$BUILD_ROOT/build_times.txt"
+
+# 增量构建时修改的文件：界面主窗口、核心库实现、被多个文件包含的头文件
+TOUCH_FILES=(src/cam_qt.cpp src/CaptureController.cpp src/FramePacket.h)
+
+now() { date +%s.%N; }
+elapsed() { awk -v a="$1" -v b="$2" 'BEGIN { printf "%.1f", b - a }'; }
+
+measure() {
+    local name="$1" source="$2"; shift 2
+    local dir="$BUILD_ROOT/$name"
+    rm -rf "$dir"
+    mkdir -p "$dir"
+
+    # 配置或构建失败时记一行并继续测量其他配置，输出保存在该配置的build.log中
+    local begin end ok=1
+    if cmake -S "$source" -B "$dir" -DCMAKE_BUILD_TYPE=Debug "$@" > "$dir/build.log" 2>&1; then
+        begin=$(now)
+        cmake --build "$dir" -j"$JOBS" >> "$dir/build.log" 2>&1 || ok=0
+        end=$(now)
+    else
+        ok=0
+    fi
+    if [ "$ok" = 0 ]; then
+        printf '%-22s %8s\n' "$name" "构建失败" | tee -a "$RESULT_FILE"
+        return 0
+    fi
+    local row
+    row="$(printf '%-22s %8s' "$name" "$(elapsed "$begin" "$end")")"
+
+    for file in "${TOUCH_FILES[@]}"; do
+        touch "$source/$file"
+        begin=$(now)
+        cmake --build "$dir" -j"$JOBS" >> "$dir/build.log" 2>&1
+        end=$(now)
+        row+="$(printf ' %22s' "$(elapsed "$begin" "$end")")"
+    done
+    echo "$row" | tee -a "$RESULT_FILE"
+}
+
+mkdir -p "$BUILD_ROOT"
+# 基准版本检出到独立的工作树，不影响当前目录
+BASELINE_DIR="$BUILD_ROOT/baseline_src"
+git -C "$SOURCE_DIR" worktree remove --force "$BASELINE_DIR" > /dev/null 2>&1 || true
+git -C "$SOURCE_DIR" worktree add --detach "$BASELINE_DIR" "$BASELINE_REF" > /dev/null
+trap 'git -C "$SOURCE_DIR" worktree remove --force "$BASELINE_DIR" > /dev/null 2>&1 || true' EXIT
+
+{
+    echo "# $(date '+%Y-%m-%d %H:%M')  $(uname -sm)  $JOBS 线程  $(c++ --version 2>/dev/null | head -n 1)"
+    echo "# 基准: $(git -C "$SOURCE_DIR" log -1 --format='%h %s' "$BASELINE_REF")"
+    printf '%-22s %8s' "配置" "完整(s)"
+    for file in "${TOUCH_FILES[@]}"; do
+        printf ' %22s' "$(basename "$file")(s)"
+    done
+    echo
+} | tee "$RESULT_FILE"
+
+measure baseline "$BASELINE_DIR" "$@"
+measure plain     "$SOURCE_DIR" -DCAMERA_USE_PCH=OFF -DCAMERA_UNITY_BUILD=OFF "$@"
+measure pch       "$SOURCE_DIR" -DCAMERA_USE_PCH=ON  -DCAMERA_UNITY_BUILD=OFF "$@"
+measure pch_unity "$SOURCE_DIR" -DCAMERA_USE_PCH=ON  -DCAMERA_UNITY_BUILD=ON "$@"
@@ -0,0 +1,144 @@
+// 多路采集扩展性测试：用N路测试图案代替摄像头，测量每路CPU占用是否随路数线性增长
+// 用法示例：
+//   multicam_bench --format mjpeg --size 1920x1080 --fps 30 --streams 1,2,4,8 --duration 10
+//   multicam_bench --format yuyv --size 1280x720 --streams 4 --record /dev/shm
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTimer>
+#include <QDir>
+#include <QTextStream>
+#include "MultiCameraManager.h"
+#include "ProcessStats.h"
+
+namespace {
+    void runEventLoop(int ms)
+    {
+        QEventLoop loop;
+        QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    struct Totals {
+        quint64 received = 0;
+        quint64 previewed = 0;
+        quint64 previewDropped = 0;
+        quint64 recorded = 0;
+        quint64 recordDropped = 0;
+    };
+
+    Totals collect(const MultiCameraManager &manager)
+    {
+        Totals totals;
+        for (int i = 0; i < manager.streamCount(); ++i) {
+            const CameraStreamStats s = manager.stream(i)->stats();
+            totals.received += s.received;
+            totals.previewed += s.previewed;
+            totals.previewDropped += s.previewDropped;
+            totals.recorded += s.recorder.encoded;
+            totals.recordDropped += s.recorder.dropped;
+        }
+        return totals;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("多路采集扩展性测试");
+    parser.addHelpOption();
+    parser.addOption({"format", "帧格式：yuyv 或 mjpeg", "format", "mjpeg"});
+    parser.addOption({"size", "每路分辨率", "size", "1920x1080"});
+    parser.addOption({"fps", "每路帧率", "fps", "30"});
+    parser.addOption({"streams", "依次测试的路数，逗号分隔", "list", "1,2,4,8"});
+    parser.addOption({"duration", "每组测量时长（秒）", "seconds", "5"});
+    parser.addOption({"preview", "预览分格大小", "size", "640x360"});
+    parser.addOption({"threads", "转换线程数，0表示CPU核数", "count", "0"});
+    parser.addOption({"record", "同时录制到该目录（不指定则不录制）", "dir"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    auto parseSize = [](const QString &text) {
+        const QStringList parts = text.split('x');
+        return parts.size() == 2 ? QSize(parts[0].toInt(), parts[1].toInt()) : QSize();
+    };
+    const QSize size = parseSize(parser.value("size"));
+    const QSize previewSize = parseSize(parser.value("preview"));
+    const FramePixelFormat format = pixelFormatFromName(parser.value("format"));
+    if (!size.isValid() || !previewSize.isValid()) {
+        out << "无效的分辨率" << Qt::endl;
+        return 1;
+    }
+    if (format != FramePixelFormat::YUYV && format != FramePixelFormat::MJPEG) {
+        out << "不支持的格式: " << parser.value("format") << Qt::endl;
+        return 1;
+    }
+    const double fps = parser.value("fps").toDouble();
+    const int durationMs = qRound(parser.value("duration").toDouble() * 1000);
+
+    out << "格式: " << pixelFormatName(format) << " " << size.width() << "x" << size.height()
+        << " @ " << fps << " FPS  预览: " << previewSize.width() << "x" << previewSize.height()
+        << "  CPU核数: " << QThread::idealThreadCount() << Qt::endl << Qt::endl;
+    out << "路数  输入帧率  预览帧率  预览丢帧  录制丢帧  CPU占用  每路CPU  相对单路" << Qt::endl;
+
+    double singleStreamCpu = 0;
+    const QStringList counts = parser.value("streams").split(',', Qt::SkipEmptyParts);
+    for (const QString &countText : counts) {
+        const int count = countText.toInt();
+        if (count <= 0) {
+            continue;
+        }
+
+        MultiCameraManager manager;
+        if (parser.value("threads").toInt() > 0) {
+            manager.setConverterThreads(parser.value("threads").toInt());
+        }
+        manager.setPreviewSize(previewSize);
+        for (int i = 0; i < count; ++i) {
+            manager.addTestPattern(format, size, fps);
+        }
+        if (parser.isSet("record") && !manager.startRecording(parser.value("record"))) {
+            out << "无法开始录制: " << manager.errorString() << Qt::endl;
+            return 1;
+        }
+
+        // 预热：测试图案缓存在第一帧时生成，不计入测量
+        runEventLoop(1000);
+
+        const Totals before = collect(manager);
+        const ProcessUsage usageBefore = currentProcessUsage();
+        const qint64 begin = monotonicUs();
+        runEventLoop(durationMs);
+        const qint64 elapsedUs = monotonicUs() - begin;
+        const ProcessUsage usageAfter = currentProcessUsage();
+        const Totals after = collect(manager);
+
+        manager.closeAll();
+
+        const double seconds = elapsedUs / 1000000.0;
+        const double cpuPercent = (usageAfter.cpuUs() - usageBefore.cpuUs()) * 100.0 / double(elapsedUs);
+        const double perStream = cpuPercent / count;
+        if (singleStreamCpu <= 0) {
+            singleStreamCpu = perStream;
+        }
+        out << QString("%1  %2  %3  %4  %5  %6%  %7%  %8")
+                   .arg(count, -4)
+                   .arg(QString::number((after.received - before.received) / seconds, 'f', 1), -8)
+                   .arg(QString::number((after.previewed - before.previewed) / seconds, 'f', 1), -8)
+                   .arg(after.previewDropped - before.previewDropped, -8)
+                   .arg(after.recordDropped - before.recordDropped, -8)
+                   .arg(QString::number(cpuPercent, 'f', 1), 6)
+                   .arg(QString::number(perStream, 'f', 1), 6)
+                   .arg(singleStreamCpu > 0 ? QString::number(perStream / singleStreamCpu, 'f', 2) : QString("-"))
+            << Qt::endl;
+    }
+
+    out << Qt::endl << "相对单路为每路CPU占用与1路时之比，接近1.00说明随路数线性扩展" << Qt::endl;
+    if (parser.isSet("record")) {
+        out << "录制文件位于: " << QDir(parser.value("record")).absolutePath() << Qt::endl;
+    }
+    return 0;
+}
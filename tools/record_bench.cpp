@@ -0,0 +1,231 @@
+// 录制吞吐量测试：不依赖摄像头，用生成的YUYV/MJPEG帧驱动录制管线，测量可持续的路数、分辨率和码率
+// 用法示例：
+//   record_bench --format mjpeg --size 1920x1080 --fps 30 --duration 20 --streams 4 --dir /dev/shm
+//   record_bench --format yuyv --size 3840x2160 --fps 0 --duration 10 --policy block --dir /data/bench
+// --fps 0 表示不限速，测量写入路径的最大吞吐；--dir 指向tmpfs时只测CPU和内存开销，指向磁盘时包含存储开销
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QTextStream>
+#include <memory>
+#include <vector>
+#include "TestPatternSource.h"
+#include "RecordingPipeline.h"
+#include "RawFileSink.h"
+#include "AviMjpegSink.h"
+#include "FileSync.h"
+#include "LatencyHistogram.h"
+#include "ProcessStats.h"
+#include "TaskPool.h"
+
+namespace {
+    struct BenchStream {
+        std::unique_ptr<TestPatternSource> source;
+        std::unique_ptr<RecordingPipeline> pipeline;
+        QStringList files;
+        quint64 submitted = 0;
+        RecordingStats stats;
+    };
+
+    QString megabytes(qint64 bytes)
+    {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 1) + " MB";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("录制路径吞吐量测试");
+    parser.addHelpOption();
+    parser.addOption({"format", "帧格式：yuyv 或 mjpeg", "format", "mjpeg"});
+    parser.addOption({"size", "分辨率，如 1920x1080", "size", "1920x1080"});
+    parser.addOption({"fps", "每路帧率，0表示不限速", "fps", "30"});
+    parser.addOption({"duration", "测试时长（秒）", "seconds", "10"});
+    parser.addOption({"streams", "同时录制的路数", "count", "1"});
+    parser.addOption({"quality", "MJPEG压缩质量（1~100），控制码率", "quality", "85"});
+    parser.addOption({"noise", "测试图案噪声幅度（0~64），越大MJPEG码率越高", "amplitude", "8"});
+    parser.addOption({"queue", "每路录制队列容量（帧）", "frames", "8"});
+    parser.addOption({"policy", "丢帧策略：oldest、newest 或 block", "policy", "oldest"});
+    parser.addOption({"container", "输出格式：raw 或 avi", "container", "avi"});
+    parser.addOption({"dir", "输出目录（tmpfs或磁盘）", "path", QDir::tempPath()});
+    parser.addOption({"keep", "测试结束后保留输出文件"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    const QStringList sizeParts = parser.value("size").split('x');
+    if (sizeParts.size() != 2) {
+        out << "无效的分辨率: " << parser.value("size") << Qt::endl;
+        return 1;
+    }
+    const QSize size(sizeParts[0].toInt(), sizeParts[1].toInt());
+    const FramePixelFormat format = pixelFormatFromName(parser.value("format"));
+    if (format != FramePixelFormat::YUYV && format != FramePixelFormat::MJPEG) {
+        out << "不支持的格式: " << parser.value("format") << Qt::endl;
+        return 1;
+    }
+    RecordingPipeline::DropPolicy policy = RecordingPipeline::DropOldest;
+    if (parser.value("policy") == "newest") {
+        policy = RecordingPipeline::DropNewest;
+    } else if (parser.value("policy") == "block") {
+        policy = RecordingPipeline::Block;
+    }
+
+    const double fps = parser.value("fps").toDouble();
+    const qint64 durationUs = qint64(parser.value("duration").toDouble() * 1000000);
+    const int streamCount = qMax(1, parser.value("streams").toInt());
+    const bool avi = parser.value("container") == "avi";
+    const QDir dir(parser.value("dir"));
+    if (!dir.exists()) {
+        out << "输出目录不存在: " << dir.path() << Qt::endl;
+        return 1;
+    }
+
+    // 先生成各路的测试图案，避免渲染耗时计入测试
+    std::vector<BenchStream> streams(streamCount);
+    for (int i = 0; i < streamCount; ++i) {
+        BenchStream &stream = streams[i];
+        stream.source.reset(new TestPatternSource);
+        stream.source->setFormat(format, size, fps > 0 ? fps : 30.0);
+        stream.source->setJpegQuality(parser.value("quality").toInt());
+        stream.source->setNoiseAmplitude(parser.value("noise").toInt());
+        stream.source->generateFrame(0);
+
+        const QString path = dir.filePath(QString("record_bench_%1.%2").arg(i).arg(avi ? "avi" : "raw"));
+        FrameSink *sink = nullptr;
+        if (avi) {
+            sink = new AviMjpegSink(path, stream.source->fps());
+        } else {
+            sink = new RawFileSink(path);
+        }
+        stream.files = sink->outputFiles();
+
+        stream.pipeline.reset(new RecordingPipeline);
+        stream.pipeline->setQueueCapacity(parser.value("queue").toInt());
+        stream.pipeline->setDropPolicy(policy);
+        if (!stream.pipeline->start(sink)) {
+            out << "无法打开输出: " << stream.pipeline->errorString() << Qt::endl;
+            return 1;
+        }
+    }
+
+    const qint64 frameBytes = streams[0].source->generateFrame(0).data.size();
+    out << "格式: " << pixelFormatName(format) << " " << size.width() << "x" << size.height()
+        << "  路数: " << streamCount << "  帧率: " << (fps > 0 ? QString::number(fps) : QString("不限速"))
+        << "  单帧约 " << QString::number(frameBytes / 1024.0, 'f', 1) << " KB"
+        << "  输出目录: " << dir.absolutePath() << Qt::endl;
+
+    // 主线程按截止时间节拍提交帧，各路在同一时刻提交，模拟多个摄像头同时出帧
+    const ProcessUsage usageBefore = currentProcessUsage();
+    const qint64 begin = monotonicUs();
+    quint64 tick = 0;
+    for (;;) {
+        const qint64 now = monotonicUs();
+        if (now - begin >= durationUs) {
+            break;
+        }
+        if (fps > 0) {
+            const qint64 deadline = begin + qint64(double(tick) * 1000000.0 / fps);
+            if (deadline > now) {
+                QThread::usleep(quint64(deadline - now));
+            }
+        }
+        for (BenchStream &stream : streams) {
+            stream.pipeline->submit(stream.source->generateFrame(tick));
+            stream.submitted++;
+        }
+        tick++;
+    }
+    const qint64 submitEnd = monotonicUs();
+
+    // 写完队列中的剩余帧后关闭文件，再同步到磁盘
+    for (BenchStream &stream : streams) {
+        stream.pipeline->stop();
+        stream.stats = stream.pipeline->stats();
+    }
+    const qint64 closeEnd = monotonicUs();
+    for (const BenchStream &stream : streams) {
+        for (const QString &file : stream.files) {
+            syncFileToDisk(file);
+        }
+    }
+    const qint64 syncEnd = monotonicUs();
+    const ProcessUsage usageAfter = currentProcessUsage();
+
+    // 汇总
+    const double elapsedSec = (closeEnd - begin) / 1000000.0;
+    quint64 submitted = 0;
+    quint64 encoded = 0;
+    quint64 dropped = 0;
+    qint64 payloadBytes = 0;
+    qint64 fileBytes = 0;
+    LatencyHistogram latency;
+    out << Qt::endl << "路  提交    写入    丢弃   实际帧率  峰值队列  平均写入 ms" << Qt::endl;
+    for (int i = 0; i < streamCount; ++i) {
+        const BenchStream &stream = streams[i];
+        const RecordingStats &s = stream.stats;
+        out << QString("%1  %2  %3  %4  %5  %6/%7  %8")
+                   .arg(i, -2)
+                   .arg(stream.submitted, -6)
+                   .arg(s.encoded, -6)
+                   .arg(s.dropped, -5)
+                   .arg(QString::number(s.encoded / elapsedSec, 'f', 1), -9)
+                   .arg(s.maxQueueDepth).arg(s.queueCapacity, -6)
+                   .arg(QString::number(s.avgWriteUs / 1000.0, 'f', 2))
+            << Qt::endl;
+        submitted += stream.submitted;
+        encoded += s.encoded;
+        dropped += s.dropped;
+        payloadBytes += s.payloadBytes;
+        latency.merge(stream.pipeline->latencyHistogram());
+        for (const QString &file : stream.files) {
+            fileBytes += QFile(file).size();
+        }
+    }
+
+    const qint64 cpuUs = usageAfter.cpuUs() - usageBefore.cpuUs();
+    out << Qt::endl;
+    out << "总计: 提交 " << submitted << "  写入 " << encoded << "  丢弃 " << dropped
+        << "  实际总帧率 " << QString::number(encoded / elapsedSec, 'f', 1) << " fps" << Qt::endl;
+    out << "耗时: 提交 " << QString::number((submitEnd - begin) / 1000.0, 'f', 0) << " ms"
+        << "  排空关闭 " << QString::number((closeEnd - submitEnd) / 1000.0, 'f', 1) << " ms"
+        << "  fsync " << QString::number((syncEnd - closeEnd) / 1000.0, 'f', 1) << " ms" << Qt::endl;
+    out << "吞吐: 帧数据 " << QString::number(payloadBytes / (1024.0 * 1024.0) / elapsedSec, 'f', 1) << " MB/s" << Qt::endl;
+    out << "CPU: 用户 " << QString::number((usageAfter.userCpuUs - usageBefore.userCpuUs) / 1000.0, 'f', 0) << " ms"
+        << "  内核 " << QString::number((usageAfter.systemCpuUs - usageBefore.systemCpuUs) / 1000.0, 'f', 0) << " ms"
+        << "  每帧 " << (encoded > 0 ? QString::number(double(cpuUs) / encoded, 'f', 1) : QString("-")) << " us"
+        << "  占用 " << QString::number(cpuUs / 10000.0 / elapsedSec, 'f', 1) << "%" << Qt::endl;
+    out << "峰值内存: " << megabytes(usageAfter.peakRssBytes) << Qt::endl;
+
+    // 写放大：文件大小（含容器头、索引和.pts）以及存储层实际写入量相对帧数据的倍数
+    if (payloadBytes > 0) {
+        out << "写放大: 文件/帧数据 " << QString::number(double(fileBytes) / payloadBytes, 'f', 3);
+        if (usageBefore.ioWriteBytes >= 0 && usageAfter.ioWriteBytes >= 0) {
+            const qint64 ioBytes = usageAfter.ioWriteBytes - usageBefore.ioWriteBytes;
+            out << "  存储层写入/帧数据 " << QString::number(double(ioBytes) / payloadBytes, 'f', 3)
+                << " (" << megabytes(ioBytes) << "，tmpfs上为0)";
+        }
+        out << Qt::endl;
+    }
+    out << "端到端延迟: " << latency.summary()
+        << "  平均 " << QString::number(latency.meanUs() / 1000.0, 'f', 2) << " ms" << Qt::endl;
+
+    // 非MJPEG帧写入AVI时需要转码，转码中的并行转换计入线程池计数器
+    if (TaskPool::shared()->stats().executed > 0) {
+        out << TaskPool::shared()->countersSummary() << Qt::endl;
+    }
+
+    if (!parser.isSet("keep")) {
+        for (const BenchStream &stream : streams) {
+            for (const QString &file : stream.files) {
+                QFile::remove(file);
+            }
+        }
+    }
+    return dropped > 0 ? 3 : 0;
+}
@@ -0,0 +1,379 @@
+// SIMD对照测试：把图像调节、镜头畸变校正、直方图和时域降噪的SIMD实现（SSE2/AVX2/AVX-512 VBMI中CPU支持的各级）
+// 与SimdLevel::Scalar的标量参考实现逐字节比较，不需要摄像头
+// 用法示例：
+//   simd_check
+//   simd_check --seed 7 --frames 12
+// 输入为随机数据和只含0/1/127/128/254/255的极值数据，尺寸覆盖奇数宽度、带行尾填充的行距、不是SIMD宽度整数倍的行，
+// 镜头校正另外用枕形畸变让映射落到画面边缘之外（取边缘像素）。各级结果都应与标量路径完全一致，
+// 有不一致时输出第一个不同的位置并返回1
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+#include "FrameHistogram.h"
+#include "ImageAdjust.h"
+#include "LensCorrection.h"
+#include "SimdSupport.h"
+#include "TemporalDenoise.h"
+
+namespace {
+    enum class Fill {
+        Random,
+        Extremes,
+    };
+
+    struct FrameLayout {
+        FramePixelFormat format;
+        QSize size;
+        int bytesPerLine;
+    };
+
+    // 奇数宽度、行尾填充（含不是4的倍数的行距）、小于一次SIMD宽度的行和整帧1080p
+    const FrameLayout CHECK_LAYOUTS[] = {
+        {FramePixelFormat::YUYV, QSize(1920, 1080), 3840},
+        {FramePixelFormat::YUYV, QSize(642, 37), 1288},
+        {FramePixelFormat::YUYV, QSize(333, 9), 676},
+        {FramePixelFormat::YUYV, QSize(66, 5), 134},
+        {FramePixelFormat::YUYV, QSize(8, 2), 16},
+        {FramePixelFormat::RGB32, QSize(1920, 1080), 7680},
+        {FramePixelFormat::RGB32, QSize(333, 17), 1344},
+        {FramePixelFormat::RGB32, QSize(97, 3), 388},
+        {FramePixelFormat::RGB32, QSize(5, 2), 20},
+    };
+
+    const uchar EXTREME_BYTES[] = {0, 1, 127, 128, 254, 255};
+
+    // 亮度、对比度、饱和度、伽马：线性、线性+饱和度、查表、查表+饱和度和各参数的边界
+    const ImageAdjustSettings CHECK_ADJUSTMENTS[] = {
+        {10, 120, 130, 100},
+        {10, 120, 100, 150},
+        {10, 120, 130, 150},
+        {-40, 60, 0, 40},
+        {100, 200, 200, 300},
+        {-100, 0, 100, 20},
+    };
+
+    struct Report {
+        int checks = 0;
+        int failures = 0;
+    };
+
+    QString layoutName(const FrameLayout &layout)
+    {
+        return QString("%1 %2x%3/%4").arg(pixelFormatName(layout.format))
+            .arg(layout.size.width()).arg(layout.size.height()).arg(layout.bytesPerLine);
+    }
+
+    QString fillName(Fill fill)
+    {
+        return fill == Fill::Random ? QString("随机") : QString("极值");
+    }
+
+    FramePacket makePacket(const FrameLayout &layout, Fill fill, std::mt19937 *rng)
+    {
+        FramePacket packet;
+        packet.format = layout.format;
+        packet.size = layout.size;
+        packet.bytesPerLine = layout.bytesPerLine;
+        packet.data.resize(qsizetype(layout.bytesPerLine) * layout.size.height());
+        uchar *data = reinterpret_cast<uchar*>(packet.data.data());
+        for (qsizetype i = 0; i < packet.data.size(); ++i) {
+            data[i] = fill == Fill::Random ? uchar((*rng)()) : EXTREME_BYTES[(*rng)() % sizeof(EXTREME_BYTES)];
+        }
+        return packet;
+    }
+
+    // 第一个不同的字节，一致时返回-1
+    qsizetype firstMismatch(const uchar *expected, const uchar *actual, qsizetype size)
+    {
+        for (qsizetype i = 0; i < size; ++i) {
+            if (expected[i] != actual[i]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // 记录一次比较；不一致时输出位置（行、行内字节）和两边的值
+    void record(Report *report, QTextStream &out, const QString &kernel, SimdLevel level, const QString &name,
+                const uchar *expected, const uchar *actual, qsizetype size, int bytesPerLine)
+    {
+        report->checks++;
+        const qsizetype index = firstMismatch(expected, actual, size);
+        if (index < 0) {
+            return;
+        }
+        report->failures++;
+        out << QString("不一致: %1 %2 %3：第%4行第%5字节，标量 %6，SIMD %7")
+                   .arg(kernel, simdLevelName(level), name)
+                   .arg(index / bytesPerLine).arg(index % bytesPerLine)
+                   .arg(expected[index]).arg(actual[index]) << Qt::endl;
+    }
+
+    // 结果不是图像的比较（返回值、统计量）
+    void recordValue(Report *report, QTextStream &out, const QString &kernel, SimdLevel level, const QString &name,
+                     const QString &what, bool equal)
+    {
+        report->checks++;
+        if (!equal) {
+            report->failures++;
+            out << QString("不一致: %1 %2 %3：%4").arg(kernel, simdLevelName(level), name, what) << Qt::endl;
+        }
+    }
+
+    QImage packetImage(const FramePacket &packet)
+    {
+        QImage image(packet.size, QImage::Format_RGB32);
+        for (int y = 0; y < packet.size.height(); ++y) {
+            std::memcpy(image.scanLine(y), packet.data.constData() + qsizetype(y) * packet.bytesPerLine,
+                        size_t(packet.size.width()) * 4);
+        }
+        return image;
+    }
+
+    QByteArray imageBytes(const QImage &image)
+    {
+        return QByteArray(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
+    }
+
+    void checkImageAdjust(const QList<SimdLevel> &levels, std::mt19937 *rng, Report *report, QTextStream &out)
+    {
+        for (const ImageAdjustSettings &settings : CHECK_ADJUSTMENTS) {
+            ImageAdjust adjust;
+            adjust.setSettings(settings);
+            const QString settingsName = QString("亮度%1 对比度%2 饱和度%3 伽马%4")
+                .arg(settings.brightness).arg(settings.contrast).arg(settings.saturation).arg(settings.gamma);
+            for (const FrameLayout &layout : CHECK_LAYOUTS) {
+                for (Fill fill : {Fill::Random, Fill::Extremes}) {
+                    const FramePacket packet = makePacket(layout, fill, rng);
+                    const QString name = QString("%1 %2 %3").arg(layoutName(layout), fillName(fill), settingsName);
+                    setSimdLevel(SimdLevel::Scalar);
+                    QByteArray expected;
+                    FramePacket reference = packet;
+                    adjust.apply(&reference, &expected);
+                    const QImage image = layout.format == FramePixelFormat::RGB32 ? packetImage(packet) : QImage();
+                    QImage expectedImage = image;
+                    adjust.apply(&expectedImage);
+                    for (SimdLevel level : levels) {
+                        setSimdLevel(level);
+                        QByteArray actual;
+                        FramePacket result = packet;
+                        adjust.apply(&result, &actual);
+                        record(report, out, "图像调节", level, name,
+                               reinterpret_cast<const uchar*>(expected.constData()),
+                               reinterpret_cast<const uchar*>(actual.constData()), expected.size(), layout.bytesPerLine);
+                        if (!image.isNull()) {
+                            QImage actualImage = image;
+                            adjust.apply(&actualImage);
+                            const QByteArray a = imageBytes(expectedImage);
+                            const QByteArray b = imageBytes(actualImage);
+                            record(report, out, "图像调节(QImage)", level, name,
+                                   reinterpret_cast<const uchar*>(a.constData()),
+                                   reinterpret_cast<const uchar*>(b.constData()), a.size(),
+                                   int(expectedImage.bytesPerLine()));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void checkLensCorrection(const QList<SimdLevel> &levels, std::mt19937 *rng, Report *report, QTextStream &out)
+    {
+        // 桶形畸变（按视野缩放，映射都在画面内）和枕形畸变（映射超出画面，取边缘像素）
+        const double distortions[][2] = {{-0.3, 0.08}, {0.35, 0.1}};
+        for (const FrameLayout &layout : CHECK_LAYOUTS) {
+            for (const auto &distortion : distortions) {
+                LensCalibration calibration;
+                calibration.size = layout.size;
+                calibration.fx = calibration.fy = layout.size.width() * 0.6;
+                calibration.cx = (layout.size.width() - 1) / 2.0;
+                calibration.cy = (layout.size.height() - 1) / 2.0;
+                calibration.k1 = distortion[0];
+                calibration.k2 = distortion[1];
+                const std::shared_ptr<const LensRemapTable> table =
+                    LensCorrection::buildTable(calibration, layout.size, layout.bytesPerLine, layout.format);
+                if (!table) {
+                    // 布局不支持校正（YUYV奇数宽度或行距不是4的倍数）
+                    continue;
+                }
+                for (Fill fill : {Fill::Random, Fill::Extremes}) {
+                    const FramePacket packet = makePacket(layout, fill, rng);
+                    const QString name = QString("%1 %2 k1=%3").arg(layoutName(layout), fillName(fill)).arg(distortion[0]);
+                    const uchar *src = reinterpret_cast<const uchar*>(packet.data.constData());
+                    const size_t frameBytes = size_t(packet.data.size());
+                    // 行尾填充不写入，两边预先填成相同的值
+                    std::vector<uchar> expected(frameBytes, 0);
+                    setSimdLevel(SimdLevel::Scalar);
+                    table->remap(src, expected.data(), 0, table->bands());
+                    for (SimdLevel level : levels) {
+                        setSimdLevel(level);
+                        std::vector<uchar> actual(frameBytes, 0);
+                        table->remap(src, actual.data(), 0, table->bands());
+                        record(report, out, "镜头校正", level, name, expected.data(), actual.data(),
+                               qsizetype(frameBytes), layout.bytesPerLine);
+                    }
+                }
+            }
+        }
+    }
+
+    bool sameHistogram(const FrameHistogram &a, const FrameHistogram &b)
+    {
+        return std::memcmp(a.luma, b.luma, sizeof(a.luma)) == 0 && std::memcmp(a.red, b.red, sizeof(a.red)) == 0 &&
+               std::memcmp(a.green, b.green, sizeof(a.green)) == 0 && std::memcmp(a.blue, b.blue, sizeof(a.blue)) == 0 &&
+               a.samples == b.samples && a.meanLuma == b.meanLuma &&
+               a.clippedHighPercent == b.clippedHighPercent && a.clippedLowPercent == b.clippedLowPercent;
+    }
+
+    void checkHistogram(const QList<SimdLevel> &levels, std::mt19937 *rng, Report *report, QTextStream &out)
+    {
+        for (const FrameLayout &layout : CHECK_LAYOUTS) {
+            // 只有YUYV有SIMD路径
+            if (layout.format != FramePixelFormat::YUYV) {
+                continue;
+            }
+            for (Fill fill : {Fill::Random, Fill::Extremes}) {
+                const FramePacket packet = makePacket(layout, fill, rng);
+                // 默认采样数（隔行）和统计所有行
+                for (int maxSamples : {131072, 1 << 30}) {
+                    const QString name = QString("%1 %2 最多%3个采样").arg(layoutName(layout), fillName(fill)).arg(maxSamples);
+                    setSimdLevel(SimdLevel::Scalar);
+                    FrameHistogram expected;
+                    const bool expectedOk = computeHistogram(packet, &expected, maxSamples);
+                    for (SimdLevel level : levels) {
+                        setSimdLevel(level);
+                        FrameHistogram actual;
+                        const bool ok = computeHistogram(packet, &actual, maxSamples);
+                        recordValue(report, out, "直方图", level, name, "直方图或统计量不同",
+                                    ok == expectedOk && sameHistogram(expected, actual));
+                    }
+                }
+            }
+        }
+    }
+
+    // 带噪声的连续帧：固定背景加逐帧噪声，中间有一个每帧移动的亮块（触发按移动量加权的分支）
+    std::vector<FramePacket> makeSequence(const FrameLayout &layout, Fill fill, int frames, std::mt19937 *rng)
+    {
+        const FramePacket background = makePacket(layout, fill, rng);
+        std::vector<FramePacket> sequence;
+        std::uniform_int_distribution<int> noise(-6, 6);
+        const int bytesPerPixel = layout.format == FramePixelFormat::YUYV ? 2 : 4;
+        const int block = qMax(2, layout.size.width() / 8);
+        for (int i = 0; i < frames; ++i) {
+            FramePacket packet = background;
+            packet.captureUs = 1000 + qint64(i) * 33333;
+            packet.sequence = quint64(i);
+            uchar *data = reinterpret_cast<uchar*>(packet.data.data());
+            for (qsizetype j = 0; j < packet.data.size(); ++j) {
+                data[j] = uchar(qBound(0, data[j] + noise(*rng), 255));
+            }
+            const int left = (i * block / 2) % qMax(1, layout.size.width() - block);
+            for (int y = 0; y < layout.size.height(); y += 2) {
+                std::memset(data + qsizetype(y) * layout.bytesPerLine + left * bytesPerPixel, 235,
+                            size_t(block) * bytesPerPixel);
+            }
+            sequence.push_back(packet);
+        }
+        return sequence;
+    }
+
+    void checkTemporalDenoise(const QList<SimdLevel> &levels, int frames, std::mt19937 *rng, Report *report,
+                              QTextStream &out)
+    {
+        for (const FrameLayout &layout : CHECK_LAYOUTS) {
+            for (Fill fill : {Fill::Random, Fill::Extremes}) {
+                const std::vector<FramePacket> sequence = makeSequence(layout, fill, frames, rng);
+                for (int strength : {30, 100}) {
+                    const QString name = QString("%1 %2 强度%3").arg(layoutName(layout), fillName(fill)).arg(strength);
+                    // 历史随帧累积，每一级用自己的对象从第一帧开始处理整个序列
+                    setSimdLevel(SimdLevel::Scalar);
+                    TemporalDenoise reference;
+                    reference.setStrength(strength);
+                    std::vector<QByteArray> expected;
+                    std::vector<bool> expectedOk;
+                    for (const FramePacket &frame : sequence) {
+                        FramePacket packet = frame;
+                        QByteArray buffer;
+                        expectedOk.push_back(reference.apply(&packet, &buffer));
+                        expected.push_back(packet.data);
+                    }
+                    for (SimdLevel level : levels) {
+                        setSimdLevel(level);
+                        TemporalDenoise denoise;
+                        denoise.setStrength(strength);
+                        for (size_t i = 0; i < sequence.size(); ++i) {
+                            FramePacket packet = sequence[i];
+                            QByteArray buffer;
+                            const bool ok = denoise.apply(&packet, &buffer);
+                            const QString frameName = QString("%1 第%2帧").arg(name).arg(i);
+                            recordValue(report, out, "时域降噪", level, frameName, "返回值不同", ok == expectedOk[i]);
+                            record(report, out, "时域降噪", level, frameName,
+                                   reinterpret_cast<const uchar*>(expected[i].constData()),
+                                   reinterpret_cast<const uchar*>(packet.data.constData()),
+                                   qMin(expected[i].size(), packet.data.size()), layout.bytesPerLine);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SIMD实现与标量参考实现的对照测试");
+    parser.addHelpOption();
+    parser.addOption({"seed", "随机数种子", "value", "1"});
+    parser.addOption({"frames", "时域降噪的序列帧数", "count", "6"});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const SimdLevel detected = detectedSimdLevel();
+    QList<SimdLevel> levels;
+    for (SimdLevel level : {SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512Vbmi}) {
+        if (level <= detected) {
+            levels << level;
+        }
+    }
+    QStringList names;
+    for (SimdLevel level : levels) {
+        names << simdLevelName(level);
+    }
+    out << QString("CPU支持 %1，对照 %2").arg(simdLevelName(detected), names.isEmpty() ? QString("无") : names.join("、"))
+        << Qt::endl;
+    if (levels.isEmpty()) {
+        out << "没有可以对照的SIMD实现" << Qt::endl;
+        return 0;
+    }
+
+    std::mt19937 rng(parser.value("seed").toUInt());
+    const int frames = qMax(2, parser.value("frames").toInt());
+    struct Kernel {
+        const char *name;
+        std::function<void(Report*)> run;
+    };
+    const Kernel kernels[] = {
+        {"图像调节", [&](Report *report) { checkImageAdjust(levels, &rng, report, out); }},
+        {"镜头校正", [&](Report *report) { checkLensCorrection(levels, &rng, report, out); }},
+        {"直方图", [&](Report *report) { checkHistogram(levels, &rng, report, out); }},
+        {"时域降噪", [&](Report *report) { checkTemporalDenoise(levels, frames, &rng, report, out); }},
+    };
+    int failures = 0;
+    for (const Kernel &kernel : kernels) {
+        Report report;
+        kernel.run(&report);
+        out << QString("%1: %2 项比较，%3 项不一致").arg(kernel.name).arg(report.checks).arg(report.failures) << Qt::endl;
+        failures += report.failures;
+    }
+    setSimdLevel(detected);
+    out << (failures == 0 ? "全部一致" : "有不一致的结果") << Qt::endl;
+    return failures == 0 ? 0 : 1;
+}